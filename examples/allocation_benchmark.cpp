@@ -0,0 +1,440 @@
+/**
+ * @file allocation_benchmark.cpp
+ * @brief Heap allocation count for connect/disconnect churn
+ *
+ * Replaces the global operator new, plain and aligned, with a counting version and
+ * measures how many heap allocations the server side performs per connection once
+ * warmed up:
+ *   1. Socket::AcceptBatch() + close on a bare listener
+ *   2. HttpWsServer accept -> worker -> disconnect, clients closing without a request
+ *   3. HttpWsServer WebSocket upgrade, one echoed message, then disconnect
+ * Client sockets are plain BSD sockets on an uncounted thread, so only library
+ * allocations show up. The steady-state target is 0 allocations per connection
+ * in every scenario, including reading and parsing the request, the handshake
+ * and one message; the benchmark fails if any scenario allocates or its BufferPool
+ * has to grow from the heap.
+ */
+
+#include "WebSocket/Socket.h"
+#include "WebSocket/HttpWsServer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Counting allocator
+// ---------------------------------------------------------------------------
+
+static std::atomic<size_t> g_allocationCount{0};
+static thread_local bool t_countAllocations = true;
+
+void* operator new(size_t size) {
+    if (t_countAllocations) {
+        g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* block = std::malloc(size ? size : 1);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    std::free(block);
+}
+
+// BufferPool blocks are cache-line aligned, so the aligned forms must be counted too
+static void* AlignedAllocate(size_t size, std::align_val_t alignment) noexcept {
+    if (t_countAllocations) {
+        g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    void* block = nullptr;
+    return posix_memalign(&block, align, size ? size : 1) == 0 ? block : nullptr;
+#endif
+}
+
+static void AlignedFree(void* block) noexcept {
+#ifdef _WIN32
+    _aligned_free(block);
+#else
+    std::free(block);
+#endif
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* block = AlignedAllocate(size, alignment);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return AlignedAllocate(size, alignment);
+}
+
+void operator delete(void* block, std::align_val_t) noexcept {
+    AlignedFree(block);
+}
+
+void operator delete(void* block, size_t, std::align_val_t) noexcept {
+    AlignedFree(block);
+}
+
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+    AlignedFree(block);
+}
+
+using namespace WebSocket;
+
+// ---------------------------------------------------------------------------
+// Raw client helpers (kept out of the library so they do not skew the count)
+// ---------------------------------------------------------------------------
+
+#ifdef _WIN32
+using ClientHandle = SOCKET;
+static const ClientHandle INVALID_CLIENT = INVALID_SOCKET;
+static void CloseClient(ClientHandle handle) { closesocket(handle); }
+#else
+using ClientHandle = int;
+static const ClientHandle INVALID_CLIENT = -1;
+static void CloseClient(ClientHandle handle) { close(handle); }
+#endif
+
+static ClientHandle ConnectClient(uint16_t port) {
+    ClientHandle handle = socket(AF_INET, SOCK_STREAM, 0);
+    if (handle == INVALID_CLIENT) {
+        return INVALID_CLIENT;
+    }
+
+    struct sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+
+    if (connect(handle, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        CloseClient(handle);
+        return INVALID_CLIENT;
+    }
+    return handle;
+}
+
+// Upgrades with a fixed key, sends one masked text frame and reads its echo
+static bool UpgradeAndEcho(ClientHandle handle, uint16_t port) {
+    char request[256];
+    int requestLength = snprintf(request, sizeof(request),
+        "GET / HTTP/1.1\r\nHost: 127.0.0.1:%u\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n", port);
+    if (send(handle, request, requestLength, 0) != requestLength) {
+        return false;
+    }
+
+    // The server sends nothing after the 101 until it has a message to answer
+    char response[512];
+    size_t received = 0;
+    while (received < 4 || memcmp(response + received - 4, "\r\n\r\n", 4) != 0) {
+        if (received == sizeof(response) || recv(handle, response + received, 1, 0) != 1) {
+            return false;
+        }
+        received++;
+    }
+    if (memcmp(response, "HTTP/1.1 101", 12) != 0) {
+        return false;
+    }
+
+    const unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    unsigned char frame[2 + 4 + 4] = {0x81, 0x80 | 4, mask[0], mask[1], mask[2], mask[3]};
+    for (int i = 0; i < 4; i++) {
+        frame[6 + i] = static_cast<unsigned char>("ping"[i] ^ mask[i]);
+    }
+    if (send(handle, reinterpret_cast<const char*>(frame), sizeof(frame), 0) != static_cast<int>(sizeof(frame))) {
+        return false;
+    }
+
+    unsigned char echo[6];
+    size_t echoed = 0;
+    while (echoed < sizeof(echo)) {
+        int n = recv(handle, reinterpret_cast<char*>(echo) + echoed, static_cast<int>(sizeof(echo) - echoed), 0);
+        if (n <= 0) {
+            return false;
+        }
+        echoed += n;
+    }
+    return echo[0] == 0x81 && echo[1] == 4 && memcmp(echo + 2, "ping", 4) == 0;
+}
+
+static bool WaitFor(const std::atomic<size_t>& counter, size_t target, int timeoutMs = 5000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (counter.load() < target) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+struct ChurnResult {
+    size_t connections = 0;
+    size_t allocations = 0;
+    uint64_t bufferHeapAllocations = 0;     // BufferPool misses, already part of allocations
+    double seconds = 0.0;
+    bool success = false;
+};
+
+static void PrintResult(const char* name, const ChurnResult& result) {
+    printf("  %s:\n", name);
+    if (!result.success) {
+        printf("    FAILED (connections did not complete)\n\n");
+        return;
+    }
+    printf("    Connections:          %zu\n", result.connections);
+    printf("    Heap allocations:     %zu\n", result.allocations);
+    printf("    BufferPool misses:    %llu\n", static_cast<unsigned long long>(result.bufferHeapAllocations));
+    printf("    Allocations/conn:     %.3f\n", static_cast<double>(result.allocations) / result.connections);
+    printf("    Connections/sec:      %.0f\n\n", result.connections / result.seconds);
+}
+
+static void PrintPoolStats(const char* name, const SlabPoolStats& stats) {
+    printf("  %-18s block=%zuB slabs=%zu inUse=%zu free=%zu handedOut=%zu\n",
+           name, stats.BlockSize, stats.SlabCount, stats.BlocksInUse, stats.BlocksFree, stats.Allocations);
+}
+
+// ---------------------------------------------------------------------------
+// Scenario 1: bare listener, AcceptBatch into a reused vector, close
+// ---------------------------------------------------------------------------
+
+static ChurnResult MeasureAcceptChurn(size_t batches, size_t batchSize, size_t warmupBatches) {
+    ChurnResult result;
+
+    Socket listener;
+    if (listener.Create(SOCKET_FAMILY::IPV4, SOCKET_TYPE::TCP).IsError() ||
+        listener.ReuseAddress(true).IsError() ||
+        listener.Bind("127.0.0.1", 0).IsError() ||
+        listener.Listen(1024).IsError() ||
+        listener.Blocking(false).IsError()) {
+        return result;
+    }
+    uint16_t port = listener.LocalPort();
+
+    std::atomic<size_t> accepted{0};
+    std::atomic<bool> stop{false};
+    std::thread acceptThread([&]() {
+        std::vector<std::unique_ptr<Socket>> sockets;
+        sockets.reserve(64);
+        while (!stop) {
+            auto [waitResult, readable] = listener.WaitReadable(50);
+            if (waitResult.IsError() || !readable) {
+                continue;
+            }
+            listener.AcceptBatch(sockets, 64, true);
+            accepted += sockets.size();
+            sockets.clear(); // Closes the connections and returns them to the slab
+        }
+    });
+
+    std::vector<ClientHandle> clients(batchSize);
+    size_t target = 0;
+    size_t countAtStart = 0;
+    uint64_t bufferMissesAtStart = 0;
+    auto start = std::chrono::steady_clock::now();
+    result.success = true;
+
+    for (size_t batch = 0; batch < warmupBatches + batches; batch++) {
+        if (batch == warmupBatches) {
+            countAtStart = g_allocationCount.load();
+            bufferMissesAtStart = BufferPool::Stats().HeapAllocations;
+            start = std::chrono::steady_clock::now();
+        }
+        for (auto& client : clients) {
+            client = ConnectClient(port);
+        }
+        target += batchSize;
+        if (!WaitFor(accepted, target)) {
+            result.success = false;
+        }
+        for (auto& client : clients) {
+            if (client != INVALID_CLIENT) {
+                CloseClient(client);
+            }
+        }
+        if (!result.success) {
+            break;
+        }
+    }
+
+    result.allocations = g_allocationCount.load() - countAtStart;
+    result.bufferHeapAllocations = BufferPool::Stats().HeapAllocations - bufferMissesAtStart;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.connections = batches * batchSize;
+
+    stop = true;
+    acceptThread.join();
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Scenario 2: HttpWsServer lifecycle for clients that close without a request
+// ---------------------------------------------------------------------------
+
+static ChurnResult MeasureServerChurn(size_t batches, size_t batchSize, size_t warmupBatches) {
+    ChurnResult result;
+
+    const uint16_t port = 18492;
+    HttpWsServer server(port, "127.0.0.1");
+    std::atomic<size_t> disconnected{0};
+    // The handle callback runs once the connection's slot is free again
+    server.OnDisconnect([&disconnected](ConnectionHandle, const std::string&) { disconnected++; });
+    if (server.Start().IsError()) {
+        return result;
+    }
+
+    std::vector<ClientHandle> clients(batchSize);
+    size_t target = 0;
+    size_t countAtStart = 0;
+    uint64_t bufferMissesAtStart = 0;
+    auto start = std::chrono::steady_clock::now();
+    result.success = true;
+
+    for (size_t batch = 0; batch < warmupBatches + batches; batch++) {
+        if (batch == warmupBatches) {
+            countAtStart = g_allocationCount.load();
+            bufferMissesAtStart = BufferPool::Stats().HeapAllocations;
+            start = std::chrono::steady_clock::now();
+        }
+        for (auto& client : clients) {
+            client = ConnectClient(port);
+        }
+        for (auto& client : clients) {
+            if (client != INVALID_CLIENT) {
+                CloseClient(client);
+            }
+        }
+        target += batchSize;
+        if (!WaitFor(disconnected, target)) {
+            result.success = false;
+            break;
+        }
+        // Let workers park again before the next wave arrives
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    result.allocations = g_allocationCount.load() - countAtStart;
+    result.bufferHeapAllocations = BufferPool::Stats().HeapAllocations - bufferMissesAtStart;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.connections = batches * batchSize;
+
+    server.Stop();
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Scenario 3: WebSocket upgrade, one echoed message, disconnect
+// ---------------------------------------------------------------------------
+
+static ChurnResult MeasureUpgradeChurn(size_t batches, size_t batchSize, size_t warmupBatches) {
+    ChurnResult result;
+
+    const uint16_t port = 18493;
+    HttpWsServer server(port, "127.0.0.1");
+    std::atomic<size_t> disconnected{0};
+    // The handle callback runs once the connection's slot is free again
+    server.OnDisconnect([&disconnected](ConnectionHandle, const std::string&) { disconnected++; });
+    // The view handler borrows the payload; a short reply fits in the string itself
+    server.OnWebSocketMessageView([](const WebSocketMessageView& message) { return std::string(message.Text()); });
+    if (server.Start().IsError()) {
+        return result;
+    }
+
+    std::vector<ClientHandle> clients(batchSize);
+    size_t target = 0;
+    size_t countAtStart = 0;
+    uint64_t bufferMissesAtStart = 0;
+    auto start = std::chrono::steady_clock::now();
+    result.success = true;
+
+    for (size_t batch = 0; batch < warmupBatches + batches; batch++) {
+        if (batch == warmupBatches) {
+            countAtStart = g_allocationCount.load();
+            bufferMissesAtStart = BufferPool::Stats().HeapAllocations;
+            start = std::chrono::steady_clock::now();
+        }
+        for (auto& client : clients) {
+            client = ConnectClient(port);
+        }
+        for (auto& client : clients) {
+            if (client == INVALID_CLIENT || !UpgradeAndEcho(client, port)) {
+                result.success = false;
+            }
+        }
+        for (auto& client : clients) {
+            if (client != INVALID_CLIENT) {
+                CloseClient(client);
+            }
+        }
+        target += batchSize;
+        if (!result.success || !WaitFor(disconnected, target)) {
+            result.success = false;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    result.allocations = g_allocationCount.load() - countAtStart;
+    result.bufferHeapAllocations = BufferPool::Stats().HeapAllocations - bufferMissesAtStart;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.connections = batches * batchSize;
+
+    server.Stop();
+    return result;
+}
+
+int main() {
+    // The benchmark driver (clients, timing, printing) is not what we measure
+    t_countAllocations = false;
+
+    printf("Connection Churn Allocation Benchmark\n");
+    printf("=====================================\n\n");
+
+    ChurnResult acceptChurn = MeasureAcceptChurn(200, 32, 10);
+    PrintResult("AcceptBatch + close", acceptChurn);
+
+    ChurnResult serverChurn = MeasureServerChurn(100, 16, 10);
+    PrintResult("HttpWsServer connect/disconnect (idle)", serverChurn);
+
+    ChurnResult upgradeChurn = MeasureUpgradeChurn(100, 16, 10);
+    PrintResult("HttpWsServer upgrade + one message", upgradeChurn);
+
+    printf("Slab pools:\n");
+    PrintPoolStats("Socket", Socket::PoolStats());
+    PrintPoolStats("ClientConnection", ClientConnection::PoolStats());
+
+    BufferPoolStats buffers = BufferPool::Stats();
+    printf("  %-18s handedOut=%llu hitRate=%.1f%% heap=%llu outstanding=%lluB\n", "BufferPool",
+           static_cast<unsigned long long>(buffers.Allocations), buffers.HitRate() * 100.0,
+           static_cast<unsigned long long>(buffers.HeapAllocations),
+           static_cast<unsigned long long>(buffers.BytesOutstanding));
+
+    bool success = true;
+    for (const ChurnResult* result : {&acceptChurn, &serverChurn, &upgradeChurn}) {
+        success = success && result->success && result->allocations == 0 && result->bufferHeapAllocations == 0;
+    }
+    if (!success) {
+        printf("\nFAILED: expected every scenario to complete with 0 allocations per connection\n");
+    }
+    return success ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file client_throughput_benchmark.cpp
+ * @brief WebSocketClientLite throughput against a local HttpWsServer echo
+ *
+ * Measures:
+ *   1. Payload masking speed (WebSocketProtocol::ApplyMask vs a byte-at-a-time loop)
+ *   2. Round-trip echo throughput for several message sizes, both lock-step
+ *      (one message in flight) and pipelined (a window of messages in flight)
+ */
+
+#include "WebSocket/HttpWsServer.h"
+#include "WebSocket/WebSocketClientLite.h"
+#include "WebSocket/WebSocketProtocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace WebSocket;
+
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ---------------------------------------------------------------------------
+// Masking
+// ---------------------------------------------------------------------------
+
+static void BenchmarkMasking() {
+    printf("Masking (1 MiB payload):\n");
+
+    std::vector<uint8_t> payload(1024 * 1024, 0x5A);
+    const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+    const int rounds = 200;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < payload.size(); i++) {
+            payload[i] ^= mask[i % 4];
+        }
+    }
+    double byteLoop = SecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        WebSocketProtocol::ApplyMask(payload.data(), payload.size(), mask);
+    }
+    double wordLoop = SecondsSince(start);
+
+    double megabytes = static_cast<double>(rounds) * payload.size() / (1024.0 * 1024.0);
+    printf("  Byte loop:            %8.0f MiB/s\n", megabytes / byteLoop);
+    printf("  ApplyMask:            %8.0f MiB/s\n", megabytes / wordLoop);
+    printf("  (checksum %u)\n\n", static_cast<unsigned>(payload[0] + payload[payload.size() - 1]));
+}
+
+// ---------------------------------------------------------------------------
+// Echo round trips
+// ---------------------------------------------------------------------------
+
+struct EchoResult {
+    size_t messages = 0;
+    double seconds = 0.0;
+    bool success = false;
+};
+
+static EchoResult RunEcho(WebSocketClientLite& client, size_t messageSize, size_t messageCount, size_t window) {
+    EchoResult result;
+    std::string message(messageSize, 'a');
+
+    size_t sent = 0;
+    size_t received = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (received < messageCount) {
+        while (sent < messageCount && sent - received < window) {
+            if (client.SendMessage(message).IsError()) {
+                return result;
+            }
+            sent++;
+        }
+
+        auto [receiveResult, reply] = client.ReceiveMessage(5000);
+        if (receiveResult.IsError() || reply.size() != messageSize) {
+            return result;
+        }
+        received++;
+    }
+
+    result.seconds = SecondsSince(start);
+    result.messages = received;
+    result.success = true;
+    return result;
+}
+
+static void PrintEcho(const char* mode, size_t messageSize, const EchoResult& result) {
+    if (!result.success) {
+        printf("  %-10s %8zu B   FAILED\n", mode, messageSize);
+        return;
+    }
+    double rate = result.messages / result.seconds;
+    double megabytes = 2.0 * rate * messageSize / (1024.0 * 1024.0); // Both directions
+    printf("  %-10s %8zu B   %10.0f msg/s   %8.1f MiB/s\n", mode, messageSize, rate, megabytes);
+}
+
+int main() {
+    printf("WebSocketClientLite Throughput Benchmark\n");
+    printf("========================================\n\n");
+
+    BenchmarkMasking();
+
+    const uint16_t port = 18493;
+    HttpWsServer server(port, "127.0.0.1");
+    server.OnWebSocketMessage([](const WebSocketMessageWithIP& message) {
+        return std::string(message.message.Data.begin(), message.message.Data.end());
+    });
+    if (server.Start().IsError()) {
+        printf("Failed to start echo server\n");
+        return 1;
+    }
+
+    WebSocketClientLite client("127.0.0.1", port);
+    if (client.Connect().IsError()) {
+        printf("Failed to connect\n");
+        server.Stop();
+        return 1;
+    }
+
+    struct Case {
+        size_t size;
+        size_t count;
+    };
+    const Case cases[] = {{64, 20000}, {4 * 1024, 10000}, {64 * 1024, 2000}, {1024 * 1024, 100}};
+
+    bool success = true;
+    printf("Echo round trips:\n");
+    for (const Case& testCase : cases) {
+        EchoResult lockStep = RunEcho(client, testCase.size, testCase.count, 1);
+        PrintEcho("lock-step", testCase.size, lockStep);
+        // Cap bytes in flight: the client does not read while it sends, so a window
+        // larger than the socket buffers can stall both directions
+        size_t window = std::max<size_t>(1, std::min<size_t>(32, (2 * 1024 * 1024) / testCase.size));
+        char mode[32];
+        snprintf(mode, sizeof(mode), "window=%zu", window);
+        EchoResult pipelined = RunEcho(client, testCase.size, testCase.count, window);
+        PrintEcho(mode, testCase.size, pipelined);
+        success = success && lockStep.success && pipelined.success;
+    }
+    printf("\n");
+
+    client.Disconnect();
+    server.Stop();
+    return success ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file coroutine_echo_server.cpp
+ * @brief WebSocket echo server written with the C++20 coroutine API
+ *
+ * A single IoContext runs the accept loop and one coroutine per connection on
+ * the main thread, so handler code reads top to bottom without callbacks.
+ *
+ * Usage:
+ *   coroutine_echo_server [--port PORT] [--bind ADDRESS]
+ *
+ * Build with -DAIWEBSOCKETS_CXX20=ON; a C++17 build prints a notice and exits.
+ */
+
+#include "WebSocket/Coroutine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if WEBSOCKET_HAS_COROUTINES
+
+using namespace WebSocket;
+
+namespace {
+
+Task<void> Echo(std::unique_ptr<AsyncSocket> socket) {
+    auto [result, connection] = co_await AsyncWebSocket::Accept(std::move(socket));
+    if (result.IsError()) {
+        co_return;
+    }
+    for (;;) {
+        auto [readResult, message] = co_await connection->ReadMessage();
+        if (readResult.IsError()) {
+            break;
+        }
+        if ((co_await connection->Send(message)).IsError()) {
+            break;
+        }
+    }
+}
+
+Task<void> AcceptLoop(IoContext& context, std::unique_ptr<AsyncSocket> listener) {
+    for (;;) {
+        auto [result, socket] = co_await listener->Accept();
+        if (result.IsError()) {
+            std::fprintf(stderr, "Accept failed: %s\n", result.GetErrorMessage().c_str());
+            co_return;
+        }
+        context.Spawn(Echo(std::move(socket)));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string bindAddress = "0.0.0.0";
+    uint16_t port = 8080;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--bind") == 0 && i + 1 < argc) {
+            bindAddress = argv[++i];
+        } else {
+            std::fprintf(stderr, "Usage: %s [--port PORT] [--bind ADDRESS]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    IoContext context;
+    if (!context.Valid()) {
+        std::fprintf(stderr, "Failed to create the event loop\n");
+        return 1;
+    }
+    auto [listenResult, listener] = AsyncSocket::Listen(context, bindAddress, port);
+    if (listenResult.IsError()) {
+        std::fprintf(stderr, "Listen on %s:%u failed: %s\n", bindAddress.c_str(), port,
+                     listenResult.GetErrorMessage().c_str());
+        return 1;
+    }
+
+    std::printf("Coroutine echo server listening on ws://%s:%u/\n", bindAddress.c_str(), port);
+    context.Spawn(AcceptLoop(context, std::move(listener)));
+    context.Run();
+    return 0;
+}
+
+#else
+
+int main() {
+    std::printf("coroutine_echo_server requires C++20: configure with -DAIWEBSOCKETS_CXX20=ON\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,1039 @@
+/**
+ * @file load_generator.cpp
+ * @brief Multi-connection WebSocket load generator
+ *
+ * Opens thousands of WebSocket connections from a few event loop threads (epoll
+ * on Linux, WSAPoll on Windows) and drives echo traffic against an in-process
+ * HttpWsServer or WebSocketServerLite, or against an external server. Every
+ * message carries its send time, so round trips are timed from the echo alone
+ * and any number of messages can be in flight per connection.
+ *
+ * Reports connect + handshake latency, p50/p99/p999 round-trip time, msgs/sec
+ * and CPU time per message (whole process, and the client threads alone).
+ *
+ * Usage:
+ *   load_generator [--server http|lite|none] [--host HOST] [--port PORT]
+ *                  [--connections N] [--threads N] [--size BYTES]
+ *                  [--rate MSGS_PER_SEC_PER_CONNECTION] [--window N]
+ *                  [--duration SECONDS] [--warmup SECONDS]
+ *                  [--connect-concurrency N] [--one-way]
+ *                  [--dispatch-workers N]
+ *
+ * --rate 0 (the default) is closed-loop: each connection keeps --window messages
+ * in flight and sends the next one as each echo arrives. --rate R is open-loop:
+ * messages leave on a fixed schedule and round trips are timed from the
+ * scheduled send time, so a stalled server shows up as latency instead of as a
+ * lower send rate.
+ *
+ * --dispatch-workers N runs the in-process HttpWsServer's handlers on an N-thread
+ * worker pool (MESSAGE_DISPATCH::WORKER_POOL) instead of the connection threads.
+ *
+ * WebSocketServerLite never replies, so --server lite (or --one-way) measures
+ * one-way send throughput and connect latency only.
+ *
+ * Above 25000 connections to a 127.x address the sockets are spread across
+ * extra loopback source addresses (127.0.0.2, ...) so the client does not run
+ * out of ephemeral ports. The in-process servers use a thread per connection;
+ * for 10k+ connections run the server as a separate process (--server none)
+ * and raise the file descriptor limit (ulimit -n).
+ */
+
+#include "WebSocket/Connector.h"
+#include "WebSocket/HttpWsServer.h"
+#include "WebSocket/WebSocketProtocol.h"
+#include "WebSocket/WebSocketServerLite.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+using namespace WebSocket;
+
+namespace {
+
+struct LoadOptions {
+    std::string server = "http";            // http, lite or none (external server)
+    std::string host = "127.0.0.1";
+    uint16_t port = 18600;
+    size_t connections = 1000;
+    size_t threads = 2;
+    size_t messageSize = 64;
+    double rate = 0.0;                      // Messages per second per connection; 0 = closed-loop
+    size_t window = 1;                      // Closed-loop messages in flight per connection
+    double durationSeconds = 10.0;
+    double warmupSeconds = 2.0;
+    size_t connectConcurrency = 128;        // Handshakes in progress across all threads
+    bool oneWay = false;
+    size_t dispatchWorkers = 0;             // 0 runs handlers on the connection threads
+};
+
+constexpr size_t kTimestampDigits = 16;     // Hex send time at the start of every payload
+constexpr size_t kReadChunk = 64 * 1024;
+constexpr size_t kMaxHandshakeSize = 16 * 1024;
+constexpr size_t kConnectionsPerSourceAddress = 25000;
+constexpr uint64_t kConnectTimeoutNs = 10ull * 1000 * 1000 * 1000;
+constexpr int kMaxWaitMs = 10;
+
+uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#ifdef _WIN32
+double FileTimeSeconds(const FILETIME& time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return static_cast<double>(value.QuadPart) / 1e7;
+}
+#endif
+
+double ProcessCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    return FileTimeSeconds(kernel) + FileTimeSeconds(user);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#endif
+}
+
+double ThreadCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+    return FileTimeSeconds(kernel) + FileTimeSeconds(user);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
+
+bool IsWouldBlock(const Result& result) {
+    int systemError = result.GetSystemErrorCode();
+#ifdef _WIN32
+    return systemError == WSAEWOULDBLOCK;
+#else
+    return systemError == EAGAIN || systemError == EWOULDBLOCK;
+#endif
+}
+
+void WriteTimestamp(uint8_t* out, uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = kTimestampDigits; i > 0; i--) {
+        out[i - 1] = static_cast<uint8_t>(digits[value & 0xF]);
+        value >>= 4;
+    }
+}
+
+bool ReadTimestamp(const uint8_t* in, uint64_t& value) {
+    value = 0;
+    for (size_t i = 0; i < kTimestampDigits; i++) {
+        uint8_t c = in[i];
+        uint64_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        value = (value << 4) | digit;
+    }
+    return true;
+}
+
+uint64_t Percentile(const std::vector<uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void PrintLatency(const char* label, std::vector<uint64_t>& samples) {
+    if (samples.empty()) {
+        printf("  %-22s no samples\n", label);
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    printf("  %-22s p50 %9.1f us   p99 %9.1f us   p999 %9.1f us   max %9.1f us\n", label,
+           Percentile(samples, 0.50) / 1e3, Percentile(samples, 0.99) / 1e3,
+           Percentile(samples, 0.999) / 1e3, samples.back() / 1e3);
+}
+
+enum class ConnectionState { Idle, Connecting, Handshaking, Open, Closed };
+
+struct LoadConnection {
+    std::unique_ptr<Socket> socket;
+    ConnectionState state = ConnectionState::Idle;
+    std::string expectedAccept;
+    std::vector<uint8_t> input;             // Tail of an incomplete handshake or frame
+    std::vector<uint8_t> output;            // Bytes the socket has not accepted yet
+    size_t outputStart = 0;
+    bool writeWatched = false;
+    size_t inFlight = 0;
+    uint64_t connectStartNs = 0;
+};
+
+struct WorkerResults {
+    std::vector<uint64_t> roundTripsNs;     // Echoes received during the measurement window
+    std::vector<uint64_t> connectNs;        // Connect + handshake time of every connection
+    uint64_t sent = 0;                      // Messages sent during the measurement window
+    uint64_t received = 0;                  // Echoes received during the measurement window
+    uint64_t connectFailures = 0;
+    uint64_t errors = 0;                    // Connections lost after the handshake
+    double cpuSeconds = 0.0;                // Worker thread CPU during the measurement window
+};
+
+struct SharedState {
+    std::atomic<bool> stop{false};
+    std::atomic<bool> measuring{false};
+    std::atomic<size_t> open{0};
+    std::atomic<size_t> settled{0};         // Connections that completed or failed their handshake
+};
+
+/**
+ * @brief One event loop thread driving a slice of the connections
+ */
+class LoadWorker {
+public:
+    LoadWorker(const LoadOptions& options, const ResolvedAddress& target, bool expectEcho,
+               size_t firstConnection, size_t connectionCount, SharedState& shared)
+        : m_options(options)
+        , m_target(target)
+        , m_expectEcho(expectEcho)
+        , m_firstConnection(firstConnection)
+        , m_connections(connectionCount)
+        , m_shared(shared)
+        , m_connectLimit(std::max<size_t>(1, options.connectConcurrency / std::max<size_t>(1, options.threads)))
+        , m_scratch(kReadChunk)
+        , m_payload(options.messageSize, 'x')
+        , m_maskState(0x9E3779B97F4A7C15ull ^ (firstConnection + 1) * 0xBF58476D1CE4E5B9ull) {
+        if (options.rate > 0.0) {
+            m_intervalNs = static_cast<uint64_t>(1e9 / options.rate);
+        }
+#ifndef _WIN32
+        m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+#endif
+    }
+
+    ~LoadWorker() {
+#ifndef _WIN32
+        if (m_epollFd >= 0) {
+            close(m_epollFd);
+        }
+#endif
+    }
+
+    LoadWorker(const LoadWorker&) = delete;
+    LoadWorker& operator=(const LoadWorker&) = delete;
+
+    void Run() {
+        bool wasMeasuring = false;
+        double cpuStart = 0.0;
+        uint64_t lastExpiryScan = NowNs();
+
+        while (!m_shared.stop.load(std::memory_order_relaxed)) {
+            uint64_t now = NowNs();
+            bool measuring = m_shared.measuring.load(std::memory_order_relaxed);
+            if (measuring != wasMeasuring) {
+                if (measuring) {
+                    cpuStart = ThreadCpuSeconds();
+                } else {
+                    m_results.cpuSeconds += ThreadCpuSeconds() - cpuStart;
+                }
+                wasMeasuring = measuring;
+            }
+
+            OpenConnections(now);
+            if (m_connecting > 0 && now - lastExpiryScan > 100 * 1000 * 1000) {
+                ExpireConnects(now);
+                lastExpiryScan = now;
+            }
+            ServiceTimers(now);
+
+            int timeoutMs = kMaxWaitMs;
+            if (!m_timers.empty()) {
+                uint64_t due = m_timers.top().first;
+                // Round up: a zero timeout before the timer is due would spin
+                timeoutMs = due <= now ? 0 : static_cast<int>(std::min<uint64_t>((due - now + 999999) / 1000000, kMaxWaitMs));
+            }
+
+            size_t readyCount = WaitForEvents(timeoutMs);
+            for (size_t i = 0; i < readyCount; i++) {
+                HandleEvent(m_ready[i]);
+            }
+        }
+
+        if (wasMeasuring) {
+            m_results.cpuSeconds += ThreadCpuSeconds() - cpuStart;
+        }
+
+        for (uint32_t index = 0; index < m_connections.size(); index++) {
+            if (m_connections[index].socket) {
+                Unwatch(index);
+                m_connections[index].socket->Close();
+                m_connections[index].socket.reset();
+            }
+        }
+    }
+
+    const WorkerResults& Results() const { return m_results; }
+
+private:
+    struct ReadyEvent {
+        uint32_t Index;
+        bool Readable;
+        bool Writable;
+        bool Failed;
+    };
+
+    bool Measuring() const { return m_shared.measuring.load(std::memory_order_relaxed); }
+
+    // ---------------------------------------------------------------------
+    // Connection setup
+    // ---------------------------------------------------------------------
+
+    void OpenConnections(uint64_t now) {
+        while (m_nextToOpen < m_connections.size() && m_connecting < m_connectLimit) {
+            StartConnect(static_cast<uint32_t>(m_nextToOpen++), now);
+        }
+    }
+
+    void StartConnect(uint32_t index, uint64_t now) {
+        LoadConnection& connection = m_connections[index];
+        connection.state = ConnectionState::Connecting;
+        connection.connectStartNs = now;
+        m_connecting++;
+
+        connection.socket = std::make_unique<Socket>();
+        Result result = connection.socket->Create(m_target.Family, SOCKET_TYPE::TCP);
+        if (result.IsSuccess()) {
+            result = connection.socket->Blocking(false);
+        }
+        if (result.IsSuccess()) {
+            connection.socket->NoDelay(true);
+            std::string source = SourceAddress(m_firstConnection + index);
+            if (!source.empty()) {
+                result = connection.socket->Bind(source, 0);
+            }
+        }
+        if (result.IsSuccess()) {
+            result = connection.socket->Connect(reinterpret_cast<const struct sockaddr*>(&m_target.Address), m_target.Length);
+            if (Socket::ConnectPending(result)) {
+                if (Watch(index, true)) {
+                    return;
+                }
+                result = Result(ERROR_CODE::SOCKET_CONNECT_FAILED, "Failed to watch socket");
+            } else if (result.IsSuccess()) {
+                if (Watch(index, true)) {
+                    CompleteConnect(index);
+                    return;
+                }
+                result = Result(ERROR_CODE::SOCKET_CONNECT_FAILED, "Failed to watch socket");
+            }
+        }
+        Fail(index);
+    }
+
+    // Spread large loopback runs over 127.0.0.x sources; each source has its own ephemeral port range
+    std::string SourceAddress(size_t connection) const {
+        if (m_options.connections <= kConnectionsPerSourceAddress ||
+            m_target.Family != SOCKET_FAMILY::IPV4 || m_options.host.compare(0, 4, "127.") != 0) {
+            return std::string();
+        }
+        return "127.0.0." + std::to_string(1 + connection / kConnectionsPerSourceAddress);
+    }
+
+    void CompleteConnect(uint32_t index) {
+        LoadConnection& connection = m_connections[index];
+        if (connection.socket->ConnectComplete().IsError()) {
+            Fail(index);
+            return;
+        }
+
+        std::string key = WebSocketProtocol::GenerateClientKey();
+        connection.expectedAccept = WebSocketProtocol::GenerateWebSocketKey(key);
+        std::string request = "GET / HTTP/1.1\r\n"
+                              "Host: " + m_options.host + ":" + std::to_string(m_options.port) + "\r\n"
+                              "Upgrade: websocket\r\n"
+                              "Connection: Upgrade\r\n"
+                              "Sec-WebSocket-Key: " + key + "\r\n"
+                              "Sec-WebSocket-Version: 13\r\n\r\n";
+        connection.state = ConnectionState::Handshaking;
+        connection.output.insert(connection.output.end(), request.begin(), request.end());
+        Flush(index);
+    }
+
+    void ExpireConnects(uint64_t now) {
+        for (uint32_t index = 0; index < m_nextToOpen; index++) {
+            LoadConnection& connection = m_connections[index];
+            if ((connection.state == ConnectionState::Connecting || connection.state == ConnectionState::Handshaking) &&
+                now - connection.connectStartNs > kConnectTimeoutNs) {
+                Fail(index);
+            }
+        }
+    }
+
+    bool ProcessHandshake(uint32_t index, const uint8_t* data, size_t length, size_t& consumed) {
+        LoadConnection& connection = m_connections[index];
+        static const char terminator[] = "\r\n\r\n";
+        const uint8_t* end = std::search(data, data + length, terminator, terminator + 4);
+        if (end == data + length) {
+            if (length > kMaxHandshakeSize) {
+                Fail(index);
+            }
+            return false;
+        }
+
+        std::string response(reinterpret_cast<const char*>(data), end - data);
+        if (response.compare(0, 12, "HTTP/1.1 101") != 0 ||
+            response.find(connection.expectedAccept) == std::string::npos) {
+            Fail(index);
+            return false;
+        }
+
+        consumed = (end - data) + 4;
+        OnOpen(index);
+        return connection.state == ConnectionState::Open;
+    }
+
+    void OnOpen(uint32_t index) {
+        LoadConnection& connection = m_connections[index];
+        uint64_t now = NowNs();
+        connection.state = ConnectionState::Open;
+        connection.expectedAccept.clear();
+        m_connecting--;
+        m_results.connectNs.push_back(now - connection.connectStartNs);
+        m_shared.open.fetch_add(1, std::memory_order_relaxed);
+        m_shared.settled.fetch_add(1, std::memory_order_relaxed);
+
+        if (m_intervalNs > 0) {
+            // Stagger the first send across one interval so connections do not fire in lockstep
+            m_timers.emplace(now + NextRandom() % m_intervalNs, index);
+        } else if (m_expectEcho) {
+            SendMessages(index, m_options.window, 0);
+        } else {
+            SetWriteInterest(index, true);     // One-way flood refills on every writable event
+        }
+    }
+
+    void Fail(uint32_t index) {
+        LoadConnection& connection = m_connections[index];
+        if (connection.state == ConnectionState::Open) {
+            m_shared.open.fetch_sub(1, std::memory_order_relaxed);
+            if (!m_shared.stop.load(std::memory_order_relaxed)) {
+                m_results.errors++;
+            }
+        } else if (connection.state == ConnectionState::Connecting || connection.state == ConnectionState::Handshaking) {
+            m_connecting--;
+            m_results.connectFailures++;
+            m_shared.settled.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (connection.socket) {
+            Unwatch(index);
+            connection.socket->Close();
+            connection.socket.reset();
+        }
+        connection.state = ConnectionState::Closed;
+        connection.output.clear();
+        connection.outputStart = 0;
+        connection.inFlight = 0;
+    }
+
+    // ---------------------------------------------------------------------
+    // Traffic
+    // ---------------------------------------------------------------------
+
+    void HandleEvent(const ReadyEvent& event) {
+        LoadConnection& connection = m_connections[event.Index];
+        if (!connection.socket) {
+            return;
+        }
+
+        if (connection.state == ConnectionState::Connecting) {
+            if (event.Writable || event.Failed) {
+                CompleteConnect(event.Index);
+            }
+            return;
+        }
+
+        if (event.Writable) {
+            if (!Flush(event.Index)) {
+                return;
+            }
+            if (!m_expectEcho && m_intervalNs == 0 && connection.state == ConnectionState::Open &&
+                connection.output.empty()) {
+                SendMessages(event.Index, m_options.window, 0);
+            }
+        }
+        if ((event.Readable || event.Failed) && connection.socket) {
+            HandleReadable(event.Index);
+        }
+    }
+
+    void HandleReadable(uint32_t index) {
+        LoadConnection& connection = m_connections[index];
+        auto [result, received] = connection.socket->ReceiveInto(m_scratch.data(), m_scratch.size());
+        if (result.IsError()) {
+            if (!IsWouldBlock(result)) {
+                Fail(index);
+            }
+            return;
+        }
+        if (received == 0) {
+            Fail(index);
+            return;
+        }
+
+        // Parse straight out of the shared scratch buffer unless a partial frame is waiting
+        bool buffered = !connection.input.empty();
+        if (buffered) {
+            connection.input.insert(connection.input.end(), m_scratch.data(), m_scratch.data() + received);
+        }
+        const uint8_t* data = buffered ? connection.input.data() : m_scratch.data();
+        size_t length = buffered ? connection.input.size() : received;
+        size_t consumed = 0;
+
+        if (connection.state == ConnectionState::Handshaking) {
+            if (!ProcessHandshake(index, data, length, consumed)) {
+                if (connection.state == ConnectionState::Handshaking && !buffered) {
+                    connection.input.assign(data, data + length);
+                } else if (connection.state == ConnectionState::Closed) {
+                    connection.input.clear();
+                }
+                return;
+            }
+        }
+        consumed += ProcessFrames(index, data + consumed, length - consumed);
+
+        if (connection.state != ConnectionState::Open) {
+            connection.input.clear();
+        } else if (buffered) {
+            connection.input.erase(connection.input.begin(), connection.input.begin() + consumed);
+        } else if (consumed < length) {
+            connection.input.assign(data + consumed, data + length);
+        }
+    }
+
+    size_t ProcessFrames(uint32_t index, const uint8_t* data, size_t length) {
+        LoadConnection& connection = m_connections[index];
+        size_t offset = 0;
+        WebSocketFrame frame;
+
+        while (connection.state == ConnectionState::Open && offset < length) {
+            size_t headerSize = 0;
+            if (WebSocketProtocol::ParseFrameHeader(data + offset, length - offset, frame, headerSize).IsError() ||
+                frame.PayloadLength > length - offset - headerSize) {
+                break;
+            }
+            const uint8_t* payload = data + offset + headerSize;
+            size_t payloadLength = static_cast<size_t>(frame.PayloadLength);
+            offset += headerSize + payloadLength;
+
+            switch (frame.Opcode) {
+                case WEBSOCKET_OPCODE::TEXT:
+                case WEBSOCKET_OPCODE::BINARY:
+                    OnEcho(index, payload, payloadLength);
+                    break;
+                case WEBSOCKET_OPCODE::PING:
+                    QueueFrame(connection, WEBSOCKET_OPCODE::PONG, payload, payloadLength);
+                    Flush(index);
+                    break;
+                case WEBSOCKET_OPCODE::CLOSE:
+                    Fail(index);
+                    break;
+                default:
+                    break;
+            }
+        }
+        return offset;
+    }
+
+    void OnEcho(uint32_t index, const uint8_t* payload, size_t length) {
+        LoadConnection& connection = m_connections[index];
+        uint64_t now = NowNs();
+        uint64_t sentAt = 0;
+        if (Measuring() && length >= kTimestampDigits && ReadTimestamp(payload, sentAt) && sentAt <= now) {
+            m_results.roundTripsNs.push_back(now - sentAt);
+            m_results.received++;
+        }
+        if (connection.inFlight > 0) {
+            connection.inFlight--;
+        }
+        if (m_intervalNs == 0 && !m_shared.stop.load(std::memory_order_relaxed)) {
+            SendMessages(index, 1, 0);
+        }
+    }
+
+    void ServiceTimers(uint64_t now) {
+        while (!m_timers.empty() && m_timers.top().first <= now) {
+            auto [due, index] = m_timers.top();
+            m_timers.pop();
+            if (m_connections[index].state != ConnectionState::Open) {
+                continue;
+            }
+            SendMessages(index, 1, due);
+            m_timers.emplace(due + m_intervalNs, index);
+        }
+    }
+
+    // sentAt of 0 stamps the current time; open-loop sends stamp their scheduled time
+    void SendMessages(uint32_t index, size_t count, uint64_t sentAt) {
+        LoadConnection& connection = m_connections[index];
+        for (size_t i = 0; i < count; i++) {
+            WriteTimestamp(m_payload.data(), sentAt != 0 ? sentAt : NowNs());
+            QueueFrame(connection, WEBSOCKET_OPCODE::TEXT, m_payload.data(), m_payload.size());
+            connection.inFlight++;
+            if (Measuring()) {
+                m_results.sent++;
+            }
+        }
+        Flush(index);
+    }
+
+    void QueueFrame(LoadConnection& connection, WEBSOCKET_OPCODE opcode, const uint8_t* payload, size_t length) {
+        std::vector<uint8_t>& output = connection.output;
+        output.push_back(static_cast<uint8_t>(0x80 | static_cast<uint8_t>(opcode)));
+        if (length < 126) {
+            output.push_back(static_cast<uint8_t>(0x80 | length));
+        } else if (length <= 0xFFFF) {
+            output.push_back(0x80 | 126);
+            output.push_back(static_cast<uint8_t>(length >> 8));
+            output.push_back(static_cast<uint8_t>(length));
+        } else {
+            output.push_back(0x80 | 127);
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                output.push_back(static_cast<uint8_t>(static_cast<uint64_t>(length) >> shift));
+            }
+        }
+
+        uint32_t maskValue = static_cast<uint32_t>(NextRandom() >> 32);
+        uint8_t mask[4];
+        memcpy(mask, &maskValue, sizeof(mask));
+        output.insert(output.end(), mask, mask + 4);
+
+        size_t payloadStart = output.size();
+        output.insert(output.end(), payload, payload + length);
+        WebSocketProtocol::ApplyMask(output.data() + payloadStart, length, mask);
+    }
+
+    // Returns false when the connection failed
+    bool Flush(uint32_t index) {
+        LoadConnection& connection = m_connections[index];
+        if (!connection.socket) {
+            return false;
+        }
+        if (connection.outputStart < connection.output.size()) {
+            auto [result, sent] = connection.socket->SendRaw(connection.output.data() + connection.outputStart,
+                                                              connection.output.size() - connection.outputStart);
+            connection.outputStart += sent;
+            if (result.IsError() && !IsWouldBlock(result)) {
+                Fail(index);
+                return false;
+            }
+        }
+
+        bool drained = connection.outputStart == connection.output.size();
+        if (drained) {
+            connection.output.clear();
+            connection.outputStart = 0;
+        }
+        // One-way flood keeps write interest so every writable event can refill the socket
+        bool flood = !m_expectEcho && m_intervalNs == 0 && connection.state == ConnectionState::Open;
+        SetWriteInterest(index, !drained || flood);
+        return true;
+    }
+
+    uint64_t NextRandom() {
+        // xorshift64*
+        m_maskState ^= m_maskState >> 12;
+        m_maskState ^= m_maskState << 25;
+        m_maskState ^= m_maskState >> 27;
+        return m_maskState * 0x2545F4914F6CDD1Dull;
+    }
+
+    // ---------------------------------------------------------------------
+    // Poller
+    // ---------------------------------------------------------------------
+
+#ifdef _WIN32
+    bool Watch(uint32_t index, bool writable) {
+        m_connections[index].writeWatched = writable;
+        m_watched.push_back(index);
+        return true;
+    }
+
+    void Unwatch(uint32_t index) {
+        auto it = std::find(m_watched.begin(), m_watched.end(), index);
+        if (it != m_watched.end()) {
+            *it = m_watched.back();
+            m_watched.pop_back();
+        }
+    }
+
+    void SetWriteInterest(uint32_t index, bool writable) {
+        m_connections[index].writeWatched = writable;
+    }
+
+    size_t WaitForEvents(int timeoutMs) {
+        m_ready.clear();
+        if (m_watched.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+            return 0;
+        }
+
+        m_pollFds.clear();
+        for (uint32_t index : m_watched) {
+            WSAPOLLFD pfd;
+            pfd.fd = static_cast<SOCKET>(m_connections[index].socket->NativeHandle());
+            pfd.events = POLLRDNORM | (m_connections[index].writeWatched ? POLLWRNORM : 0);
+            pfd.revents = 0;
+            m_pollFds.push_back(pfd);
+        }
+
+        int count = WSAPoll(m_pollFds.data(), static_cast<ULONG>(m_pollFds.size()), timeoutMs);
+        for (size_t i = 0; count > 0 && i < m_pollFds.size(); i++) {
+            short revents = m_pollFds[i].revents;
+            if (revents != 0) {
+                m_ready.push_back({m_watched[i], (revents & POLLRDNORM) != 0, (revents & POLLWRNORM) != 0,
+                                   (revents & (POLLERR | POLLHUP)) != 0});
+            }
+        }
+        return m_ready.size();
+    }
+#else
+    bool Watch(uint32_t index, bool writable) {
+        struct epoll_event event;
+        event.events = writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.u64 = index;
+        int handle = static_cast<int>(m_connections[index].socket->NativeHandle());
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, handle, &event) != 0) {
+            return false;
+        }
+        m_connections[index].writeWatched = writable;
+        return true;
+    }
+
+    void Unwatch(uint32_t index) {
+        int handle = static_cast<int>(m_connections[index].socket->NativeHandle());
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, handle, nullptr);
+    }
+
+    void SetWriteInterest(uint32_t index, bool writable) {
+        LoadConnection& connection = m_connections[index];
+        if (connection.writeWatched == writable || !connection.socket) {
+            return;
+        }
+        struct epoll_event event;
+        event.events = writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.u64 = index;
+        epoll_ctl(m_epollFd, EPOLL_CTL_MOD, static_cast<int>(connection.socket->NativeHandle()), &event);
+        connection.writeWatched = writable;
+    }
+
+    size_t WaitForEvents(int timeoutMs) {
+        m_ready.clear();
+
+        struct epoll_event events[256];
+        int count = epoll_wait(m_epollFd, events, 256, timeoutMs);
+        for (int i = 0; i < count; i++) {
+            uint32_t flags = events[i].events;
+            m_ready.push_back({static_cast<uint32_t>(events[i].data.u64), (flags & EPOLLIN) != 0,
+                               (flags & EPOLLOUT) != 0, (flags & (EPOLLERR | EPOLLHUP)) != 0});
+        }
+        return m_ready.size();
+    }
+#endif
+
+    const LoadOptions& m_options;
+    const ResolvedAddress m_target;
+    const bool m_expectEcho;
+    const size_t m_firstConnection;
+    std::vector<LoadConnection> m_connections;
+    SharedState& m_shared;
+    const size_t m_connectLimit;
+
+    size_t m_nextToOpen = 0;
+    size_t m_connecting = 0;
+    uint64_t m_intervalNs = 0;
+    std::priority_queue<std::pair<uint64_t, uint32_t>, std::vector<std::pair<uint64_t, uint32_t>>,
+                        std::greater<std::pair<uint64_t, uint32_t>>> m_timers;
+
+    std::vector<uint8_t> m_scratch;         // Shared by every connection for reads
+    std::vector<uint8_t> m_payload;         // Message template; the timestamp is rewritten per send
+    uint64_t m_maskState;
+    std::vector<ReadyEvent> m_ready;
+    WorkerResults m_results;
+
+#ifdef _WIN32
+    std::vector<uint32_t> m_watched;
+    std::vector<WSAPOLLFD> m_pollFds;
+#else
+    int m_epollFd = -1;
+#endif
+};
+
+// ---------------------------------------------------------------------------
+// Command line
+// ---------------------------------------------------------------------------
+
+void PrintUsage() {
+    printf("Usage: load_generator [--server http|lite|none] [--host HOST] [--port PORT]\n"
+           "                      [--connections N] [--threads N] [--size BYTES]\n"
+           "                      [--rate MSGS_PER_SEC_PER_CONNECTION] [--window N]\n"
+           "                      [--duration SECONDS] [--warmup SECONDS]\n"
+           "                      [--connect-concurrency N] [--one-way]\n"
+           "                      [--dispatch-workers N]\n");
+}
+
+bool ParseOptions(int argc, char* argv[], LoadOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string name = argv[i];
+        if (name == "--one-way") {
+            options.oneWay = true;
+            continue;
+        }
+        if (name == "--help" || i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (name == "--server") {
+            options.server = value;
+        } else if (name == "--host") {
+            options.host = value;
+        } else if (name == "--port") {
+            options.port = static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (name == "--connections") {
+            options.connections = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--threads") {
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--size") {
+            options.messageSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--rate") {
+            options.rate = std::strtod(value.c_str(), nullptr);
+        } else if (name == "--window") {
+            options.window = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--duration") {
+            options.durationSeconds = std::strtod(value.c_str(), nullptr);
+        } else if (name == "--warmup") {
+            options.warmupSeconds = std::strtod(value.c_str(), nullptr);
+        } else if (name == "--connect-concurrency") {
+            options.connectConcurrency = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--dispatch-workers") {
+            options.dispatchWorkers = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+
+    options.messageSize = std::max(options.messageSize, kTimestampDigits);
+    options.connections = std::max<size_t>(options.connections, 1);
+    options.threads = std::max<size_t>(1, std::min(options.threads, options.connections));
+    options.window = std::max<size_t>(options.window, 1);
+    return options.server == "http" || options.server == "lite" || options.server == "none";
+}
+
+void RaiseFileLimit(size_t needed) {
+#ifndef _WIN32
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        if (limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+            getrlimit(RLIMIT_NOFILE, &limit);
+        }
+        if (limit.rlim_cur < needed) {
+            printf("Warning: file descriptor limit %llu is below the %zu this run needs (ulimit -n)\n",
+                   static_cast<unsigned long long>(limit.rlim_cur), needed);
+        }
+    }
+#else
+    (void)needed;
+#endif
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+    bool expectEcho = options.server != "lite" && !options.oneWay;
+
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    RaiseFileLimit(options.connections * (options.server == "none" ? 1 : 2) + 64);
+
+    printf("WebSocket Load Generator\n");
+    printf("========================\n");
+    printf("Server:      %s (%s:%u)\n", options.server.c_str(), options.host.c_str(), options.port);
+    printf("Connections: %zu on %zu threads\n", options.connections, options.threads);
+    printf("Messages:    %zu bytes, %s\n", options.messageSize,
+           options.rate > 0.0 ? (std::to_string(options.rate) + " msg/s per connection (open loop)").c_str()
+                              : (std::to_string(options.window) + " in flight per connection (closed loop)").c_str());
+    printf("Traffic:     %s\n\n", expectEcho ? "echo round trips" : "one-way");
+
+    // In-process targets
+    std::unique_ptr<HttpWsServer> httpServer;
+    std::unique_ptr<WebSocketServerLite> liteServer;
+    if (options.server == "http") {
+        SecurityConfig config;
+        config.maxConnectionsPerIP = static_cast<int>(options.connections) + 16;
+        config.maxConnectionsTotal = static_cast<int>(options.connections) + 16;
+        config.maxMessageSize = std::max<size_t>(options.messageSize, config.maxMessageSize);
+        config.enableRateLimiting = false;
+        config.enableConnectionTimeout = false;
+        httpServer = std::make_unique<HttpWsServer>(options.port, options.host, config);
+        httpServer->OnWebSocketMessageView([](const WebSocketMessageView& message) {
+            return std::string(message.Text());
+        });
+        if (options.dispatchWorkers > 0) {
+            httpServer->SetMessageDispatch(MESSAGE_DISPATCH::WORKER_POOL, options.dispatchWorkers);
+        }
+        Result startResult = httpServer->Start();
+        if (startResult.IsError()) {
+            printf("Failed to start HttpWsServer: %s\n", startResult.GetErrorMessage().c_str());
+            return 1;
+        }
+    } else if (options.server == "lite") {
+        liteServer = std::make_unique<WebSocketServerLite>(options.port, options.host);
+        liteServer->EnableSecurity(false).SetMaxConnections(static_cast<int>(options.connections) + 16);
+        Result startResult = liteServer->Start();
+        if (startResult.IsError()) {
+            printf("Failed to start WebSocketServerLite: %s\n", startResult.GetErrorMessage().c_str());
+            return 1;
+        }
+    }
+
+    // WebSocketServerLite is driven from the caller's loop
+    auto waitFor = [&](double seconds, const std::function<bool()>& done) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < deadline && !(done && done())) {
+            if (liteServer) {
+                liteServer->ProcessEvents();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+    };
+
+    auto [resolveResult, addresses] = Connector::Shared().Resolver().Resolve(options.host, options.port);
+    if (resolveResult.IsError() || addresses.empty()) {
+        printf("Failed to resolve %s: %s\n", options.host.c_str(), resolveResult.GetErrorMessage().c_str());
+        return 1;
+    }
+
+    SharedState shared;
+    std::vector<std::unique_ptr<LoadWorker>> workers;
+    size_t first = 0;
+    for (size_t i = 0; i < options.threads; i++) {
+        size_t count = options.connections / options.threads + (i < options.connections % options.threads ? 1 : 0);
+        workers.push_back(std::make_unique<LoadWorker>(options, addresses.front(), expectEcho, first, count, shared));
+        first += count;
+    }
+
+    // Connect phase
+    auto connectStart = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        threads.emplace_back([&worker]() { worker->Run(); });
+    }
+    waitFor(120.0, [&]() { return shared.settled.load() >= options.connections; });
+    double connectSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - connectStart).count();
+
+    size_t opened = shared.open.load();
+    printf("Connect phase:\n");
+    printf("  Established:           %zu / %zu in %.2f s (%.0f conn/s)\n", opened, options.connections,
+           connectSeconds, opened / connectSeconds);
+
+    // Measurement
+    waitFor(options.warmupSeconds, nullptr);
+    double cpuStart = ProcessCpuSeconds();
+    auto measureStart = std::chrono::steady_clock::now();
+    shared.measuring = true;
+    waitFor(options.durationSeconds, nullptr);
+    shared.measuring = false;
+    double measuredSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - measureStart).count();
+    double cpuSeconds = ProcessCpuSeconds() - cpuStart;
+
+    shared.stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Aggregate
+    WorkerResults total;
+    for (auto& worker : workers) {
+        const WorkerResults& results = worker->Results();
+        total.roundTripsNs.insert(total.roundTripsNs.end(), results.roundTripsNs.begin(), results.roundTripsNs.end());
+        total.connectNs.insert(total.connectNs.end(), results.connectNs.begin(), results.connectNs.end());
+        total.sent += results.sent;
+        total.received += results.received;
+        total.connectFailures += results.connectFailures;
+        total.errors += results.errors;
+        total.cpuSeconds += results.cpuSeconds;
+    }
+
+    printf("  Failed:                %llu\n", static_cast<unsigned long long>(total.connectFailures));
+    PrintLatency("Connect + handshake:", total.connectNs);
+    printf("\n");
+
+    uint64_t messages = expectEcho ? total.received : total.sent;
+    printf("Traffic (%.1f s):\n", measuredSeconds);
+    printf("  Messages sent:         %llu\n", static_cast<unsigned long long>(total.sent));
+    if (expectEcho) {
+        printf("  Echoes received:       %llu\n", static_cast<unsigned long long>(total.received));
+    }
+    printf("  Throughput:            %.0f msg/s (%.1f MiB/s)\n", messages / measuredSeconds,
+           messages * options.messageSize / measuredSeconds / (1024.0 * 1024.0));
+    printf("  Connections lost:      %llu\n", static_cast<unsigned long long>(total.errors));
+    if (expectEcho) {
+        PrintLatency("Round trip:", total.roundTripsNs);
+    }
+    if (messages > 0) {
+        printf("  CPU per message:       %.2f us process, %.2f us client threads\n",
+               cpuSeconds * 1e6 / messages, total.cpuSeconds * 1e6 / messages);
+    }
+    printf("\n");
+
+    if (httpServer) {
+        httpServer->Stop();
+    }
+    if (liteServer) {
+        liteServer->Stop();
+        // Its detached client threads poll every millisecond before noticing the stop
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    return opened > 0 && messages > 0 ? 0 : 1;
+}
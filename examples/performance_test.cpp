@@ -6,6 +6,7 @@
  * using various data sizes and configurations.
  */
 
+#include "WebSocket/Benchmark.h"
 #include "WebSocket/Socket.h"
 #include "WebSocket/TestUtilities.h"
 #include <iostream>
@@ -22,6 +23,8 @@ using namespace WebSocket;
 
 class PerformanceTestSuite {
 private:
+    BenchmarkReport m_report;
+    
     struct TestResult {
         std::string testName;
         size_t dataSize;
@@ -568,7 +571,81 @@ private:
         return result;
     }
 
+    // One connected pair over TCP loopback or a Unix domain socket, no extra copies or
+    // sleeps, so the difference between the two is the kernel path alone
+    TestResult MeasureStreamTransfer(SOCKET_FAMILY family, size_t dataSize, size_t chunkSize = 65536) {
+        TestResult result{"", dataSize, 0.0, 0.0, 0.0, false};
+        bool unixDomain = family == SOCKET_FAMILY::UNIX;
+#ifdef __linux__
+        // Abstract names leave no file behind
+        std::string unixPath = "@aiws-perf-" + std::to_string(getpid());
+#elif !defined(_WIN32)
+        std::string unixPath = "/tmp/aiws-perf-" + std::to_string(getpid()) + ".sock";
+#else
+        std::string unixPath;
+#endif
+        
+        Socket listener;
+        if (!listener.Create(family, SOCKET_TYPE::TCP).IsSuccess() ||
+            !listener.Bind(unixDomain ? unixPath : "127.0.0.1", 0).IsSuccess() ||
+            !listener.Listen(1).IsSuccess()) {
+            return result;
+        }
+        
+        Socket client;
+        if (!client.Create(family, SOCKET_TYPE::TCP).IsSuccess() ||
+            !client.Connect(unixDomain ? unixPath : "127.0.0.1", listener.LocalPort()).IsSuccess()) {
+            return result;
+        }
+        auto [acceptResult, server] = listener.Accept();
+        if (!acceptResult.IsSuccess() || !server) {
+            return result;
+        }
+        if (!unixDomain) {
+            client.NoDelay(true);
+        }
+        
+        std::vector<uint8_t> testData = WebSocket::CreateTestData(chunkSize);
+        std::vector<uint8_t> receiveBuffer(chunkSize);
+        
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::thread sender([&]() {
+            size_t sent = 0;
+            while (sent < dataSize) {
+                size_t length = std::min(chunkSize, dataSize - sent);
+                auto [sendResult, bytes] = client.SendRaw(testData.data(), length);
+                if (!sendResult.IsSuccess() || bytes == 0) {
+                    break;
+                }
+                sent += bytes;
+            }
+            client.Shutdown();
+        });
+        
+        size_t received = 0;
+        while (received < dataSize) {
+            auto [receiveResult, bytes] = server->ReceiveInto(receiveBuffer.data(), receiveBuffer.size());
+            if (!receiveResult.IsSuccess() || bytes == 0) {
+                break;
+            }
+            received += bytes;
+        }
+        auto endTime = std::chrono::high_resolution_clock::now();
+        sender.join();
+        
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+        result.transferTimeMs = duration.count() / 1000.0;
+        if (duration.count() > 0) {
+            result.throughputMBps = (static_cast<double>(received) * 1000000.0 / duration.count()) / (1024.0 * 1024.0);
+            result.throughputGbps = result.throughputMBps / 1024.0;
+        }
+        result.success = received == dataSize;
+        return result;
+    }
+
 public:
+    const BenchmarkReport& Report() const { return m_report; }
+    
     void RunPerformanceTests() {
         std::cout << "WebSocket Socket Performance Test Suite" << std::endl;
         std::cout << "=======================================" << std::endl;
@@ -649,6 +726,52 @@ public:
         std::cout << "✅ Concurrent connection tests completed" << std::endl;
         std::cout << std::endl;
         
+        std::cout << "=== TCP Loopback vs Unix Domain Socket ===" << std::endl;
+        std::cout << std::endl;
+        
+        for (size_t size : {1 * 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024}) {
+            TestResult loopback = MeasureStreamTransfer(SOCKET_FAMILY::IPV4, size);
+            loopback.testName = "Loopback " + FormatBytes(size);
+            PrintResult(loopback.testName, loopback);
+            allResults.push_back(loopback);
+            
+            TestResult unixSocket = MeasureStreamTransfer(SOCKET_FAMILY::UNIX, size);
+            unixSocket.testName = "Unix sock " + FormatBytes(size);
+            if (!unixSocket.success) {
+                std::cout << "  Unix socket transfer failed (not supported on this platform?)" << std::endl << std::endl;
+                continue;
+            }
+            PrintResult(unixSocket.testName, unixSocket);
+            allResults.push_back(unixSocket);
+            
+            if (loopback.success && loopback.throughputMBps > 0) {
+                std::cout << "  Unix socket / loopback: " << std::fixed << std::setprecision(2)
+                          << unixSocket.throughputMBps / loopback.throughputMBps << "x" << std::endl << std::endl;
+            }
+            for (const TestResult* candidate : {&loopback, &unixSocket}) {
+                if (candidate->success && candidate->throughputMBps > bestResult.throughputMBps) {
+                    bestResult = *candidate;
+                }
+            }
+        }
+        
+        std::cout << "✅ Loopback vs Unix socket tests completed" << std::endl;
+        std::cout << std::endl;
+        
+        // Keep the results for --json
+        for (const auto& result : allResults) {
+            BenchmarkResult benchmark;
+            benchmark.Name = "Transfer/" + result.testName;
+            benchmark.Iterations = 1;
+            benchmark.Repetitions = 1;
+            benchmark.NsPerOp = benchmark.NsPerOpMin = result.transferTimeMs * 1e6;
+            benchmark.BytesPerSecond = result.throughputMBps * 1024.0 * 1024.0;
+            if (!result.success) {
+                benchmark.Error = "Transfer failed";
+            }
+            m_report.Add(benchmark);
+        }
+        
         // Summary
         std::cout << "=== Performance Summary ===" << std::endl;
         std::cout << std::endl;
@@ -703,8 +826,22 @@ public:
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
+    // --json PATH writes the results in the websocket_benchmarks format
+    std::string jsonPath;
+    if (argc == 3 && std::string(argv[1]) == "--json") {
+        jsonPath = argv[2];
+    }
+    
     PerformanceTestSuite testSuite;
     testSuite.RunPerformanceTests();
+    
+    if (!jsonPath.empty()) {
+        Result writeResult = testSuite.Report().WriteJson(jsonPath);
+        if (writeResult.IsError()) {
+            std::cout << "Failed to write results: " << writeResult.GetErrorMessage() << std::endl;
+            return 1;
+        }
+    }
     return 0;
 }
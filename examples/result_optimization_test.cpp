@@ -55,8 +55,8 @@ void TestResultOptimization() {
     // Time multiple accesses to cached message
     start = high_resolution_clock::now();
     for (int i = 0; i < 1000; ++i) {
-        volatile const std::string& msg = freshResult.GetErrorMessage();
-        (void)msg; // Prevent optimization
+        volatile size_t msgLength = freshResult.GetErrorMessage().size();
+        (void)msgLength; // Prevent optimization
     }
     end = high_resolution_clock::now();
     auto multipleAccessTime = duration_cast<microseconds>(end - start).count();
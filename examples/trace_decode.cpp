@@ -0,0 +1,61 @@
+/**
+ * @file trace_decode.cpp
+ * @brief Prints a binary trace file or converts it to Chrome trace JSON
+ *
+ * Trace files are written by Tracer::Start() with TraceOptions::Path set. The
+ * JSON output opens in chrome://tracing and in Perfetto (ui.perfetto.dev).
+ *
+ * Usage:
+ *   trace_decode TRACE_FILE [--chrome OUTPUT.json]
+ */
+
+#include "WebSocket/Trace.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace WebSocket;
+
+int main(int argc, char* argv[]) {
+    std::string input;
+    std::string chromePath;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--chrome") == 0 && i + 1 < argc) {
+            chromePath = argv[++i];
+        } else if (input.empty() && argv[i][0] != '-') {
+            input = argv[i];
+        } else {
+            input.clear();
+            break;
+        }
+    }
+    if (input.empty()) {
+        fprintf(stderr, "Usage: %s TRACE_FILE [--chrome OUTPUT.json]\n", argv[0]);
+        return 2;
+    }
+
+    TraceLog log;
+    Result result = TraceLog::ReadFile(input, log);
+    if (result.IsError()) {
+        fprintf(stderr, "%s\n", result.GetErrorMessage().c_str());
+        return 1;
+    }
+
+    if (chromePath.empty()) {
+        for (const TraceRecord& record : log.Records) {
+            printf("%s\n", log.Format(record).c_str());
+        }
+        return 0;
+    }
+
+    FILE* output = fopen(chromePath.c_str(), "wb");
+    if (!output) {
+        fprintf(stderr, "Cannot open %s\n", chromePath.c_str());
+        return 1;
+    }
+    std::string json = log.ToChromeTraceJson();
+    fwrite(json.data(), 1, json.size(), output);
+    fclose(output);
+    printf("Wrote %zu records to %s\n", log.Records.size(), chromePath.c_str());
+    return 0;
+}
@@ -0,0 +1,396 @@
+/**
+ * @file websocket_benchmarks.cpp
+ * @brief Frame, handshake, HTTP parsing, topic fan-out, metrics and loopback socket benchmarks
+ *
+ * Built on the Benchmark.h harness. Typical use:
+ *
+ *   websocket_benchmarks --json baseline.json                 # record
+ *   websocket_benchmarks --baseline baseline.json             # exit code 2 on a >10% regression
+ *   websocket_benchmarks --filter ParseFrame --min-time 0.5   # focus on one area
+ */
+
+#include "WebSocket/Benchmark.h"
+#include "WebSocket/HttpWsServer.h"
+#include "WebSocket/Metrics.h"
+#include "WebSocket/Socket.h"
+#include "WebSocket/TestUtilities.h"
+#include "WebSocket/TopicRouter.h"
+#include "WebSocket/Trace.h"
+#include "WebSocket/WebSocketProtocol.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace WebSocket;
+
+namespace {
+
+const size_t kFrameSizes[] = {125, 4096, 65536};
+
+std::vector<uint8_t> MaskedFrame(size_t payloadSize) {
+    WebSocketFrame frame = WebSocketProtocol::CreateBinaryFrame(CreateTestData(payloadSize));
+    frame.Masked = true;
+    frame.MaskingKey = {0x12, 0x34, 0x56, 0x78};
+    return WebSocketProtocol::GenerateFrame(frame);
+}
+
+void RegisterFrameBenchmarks(BenchmarkRunner& runner) {
+    for (size_t size : kFrameSizes) {
+        // Masked client frames, as a server receives them
+        runner.Add("ParseFrame/" + std::to_string(size), [size](BenchmarkState& state) {
+            std::vector<uint8_t> wire = MaskedFrame(size);
+            WebSocketFrame frame;
+            BufferHandle payload;
+            size_t consumed = 0;
+            for (uint64_t i = 0; i < state.Iterations(); i++) {
+                WebSocketProtocol::ParseFrame(wire.data(), wire.size(), frame, consumed, payload);
+                DoNotOptimize(payload.Data());
+            }
+            state.SetBytesProcessed(state.Iterations() * wire.size());
+        });
+
+        runner.Add("ParseFrameHeader/" + std::to_string(size), [size](BenchmarkState& state) {
+            std::vector<uint8_t> wire = MaskedFrame(size);
+            WebSocketFrame frame;
+            size_t headerSize = 0;
+            for (uint64_t i = 0; i < state.Iterations(); i++) {
+                WebSocketProtocol::ParseFrameHeader(wire.data(), wire.size(), frame, headerSize);
+                DoNotOptimize(headerSize);
+            }
+        });
+
+        // Unmasked server frames written into pooled buffers
+        runner.Add("GenerateFrame/" + std::to_string(size), [size](BenchmarkState& state) {
+            std::vector<uint8_t> payload = CreateTestData(size);
+            for (uint64_t i = 0; i < state.Iterations(); i++) {
+                BufferHandle frame = WebSocketProtocol::GenerateFrame(WEBSOCKET_OPCODE::BINARY, payload.data(), payload.size());
+                DoNotOptimize(frame.Data());
+            }
+            state.SetBytesProcessed(state.Iterations() * size);
+        });
+    }
+
+    for (size_t size : {size_t(64), size_t(4096), size_t(65536), size_t(1024 * 1024)}) {
+        runner.Add("ApplyMask/" + std::to_string(size), [size](BenchmarkState& state) {
+            std::vector<uint8_t> payload = CreateTestData(size);
+            const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+            for (uint64_t i = 0; i < state.Iterations(); i++) {
+                WebSocketProtocol::ApplyMask(payload.data(), payload.size(), mask);
+                DoNotOptimize(payload.data());
+            }
+            state.SetBytesProcessed(state.Iterations() * size);
+        });
+    }
+}
+
+void RegisterUtf8Benchmarks(BenchmarkRunner& runner) {
+    runner.Add("IsValidUTF8/Ascii/4096", [](BenchmarkState& state) {
+        std::vector<uint8_t> text(4096, 'a');
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            DoNotOptimize(WebSocketProtocol::IsValidUTF8(text));
+        }
+        state.SetBytesProcessed(state.Iterations() * text.size());
+    });
+
+    runner.Add("IsValidUTF8/Multibyte/4096", [](BenchmarkState& state) {
+        // Two-, three- and four-byte sequences mixed with ASCII
+        const std::string sample = "h\xC3\xA9llo w\xC3\xB6rld \xE2\x9C\x93 \xF0\x9F\x98\x80 ";
+        std::vector<uint8_t> text;
+        while (text.size() + sample.size() <= 4096) {
+            text.insert(text.end(), sample.begin(), sample.end());
+        }
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            DoNotOptimize(WebSocketProtocol::IsValidUTF8(text));
+        }
+        state.SetBytesProcessed(state.Iterations() * text.size());
+    });
+}
+
+const char kUpgradeRequest[] =
+    "GET /chat HTTP/1.1\r\n"
+    "Host: server.example.com:8080\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+    "Sec-WebSocket-Version: 13\r\n"
+    "Origin: http://example.com\r\n"
+    "\r\n";
+
+void RegisterHandshakeBenchmarks(BenchmarkRunner& runner) {
+    runner.Add("ParseHTTPRequest", [](BenchmarkState& state) {
+        std::string request = kUpgradeRequest;
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            HTTPRequest parsed = HttpWsServer::ParseHTTPRequest(request, "127.0.0.1");
+            DoNotOptimize(parsed.headers.size());
+        }
+        state.SetBytesProcessed(state.Iterations() * request.size());
+    });
+
+    runner.Add("ValidateHandshakeRequest", [](BenchmarkState& state) {
+        std::string request = kUpgradeRequest;
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            HandshakeInfo info;
+            DoNotOptimize(WebSocketProtocol::ValidateHandshakeRequest(request, info).IsSuccess());
+        }
+    });
+
+    runner.Add("GenerateHandshakeResponse", [](BenchmarkState& state) {
+        HandshakeInfo info;
+        WebSocketProtocol::ValidateHandshakeRequest(kUpgradeRequest, info);
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            std::string response = WebSocketProtocol::GenerateHandshakeResponse(info);
+            DoNotOptimize(response.data());
+        }
+    });
+
+    // The allocation-free path the servers use; items are handshakes
+    runner.Add("ParseHandshakeRequest", [](BenchmarkState& state) {
+        const std::string_view request = kUpgradeRequest;
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            HandshakeRequestView view;
+            DoNotOptimize(WebSocketProtocol::ParseHandshakeRequest(request, view).IsSuccess());
+        }
+        state.SetItemsProcessed(state.Iterations());
+    });
+
+    runner.Add("WriteHandshakeResponse", [](BenchmarkState& state) {
+        char response[WebSocketProtocol::kHandshakeResponseSize];
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            DoNotOptimize(WebSocketProtocol::WriteHandshakeResponse("dGhlIHNhbXBsZSBub25jZQ==", std::string_view(),
+                                                                    std::string_view(), response, sizeof(response)));
+        }
+        state.SetItemsProcessed(state.Iterations());
+    });
+
+    runner.Add("Handshake/Full", [](BenchmarkState& state) {
+        const std::string_view request = kUpgradeRequest;
+        char response[WebSocketProtocol::kHandshakeResponseSize];
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            HandshakeRequestView view;
+            WebSocketProtocol::ParseHandshakeRequest(request, view);
+            DoNotOptimize(WebSocketProtocol::WriteHandshakeResponse(view.Key, std::string_view(), std::string_view(),
+                                                                    response, sizeof(response)));
+        }
+        state.SetItemsProcessed(state.Iterations());
+    });
+
+    runner.Add("Handshake/Strings", [](BenchmarkState& state) {
+        const std::string request = kUpgradeRequest;
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            HandshakeInfo info;
+            WebSocketProtocol::ValidateHandshakeRequest(request, info);
+            std::string response = WebSocketProtocol::GenerateHandshakeResponse(info);
+            DoNotOptimize(response.data());
+        }
+        state.SetItemsProcessed(state.Iterations());
+    });
+
+    runner.Add("GenerateWebSocketKey", [](BenchmarkState& state) {
+        const std::string clientKey = "dGhlIHNhbXBsZSBub25jZQ==";
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            std::string accept = WebSocketProtocol::GenerateWebSocketKey(clientKey);
+            DoNotOptimize(accept.data());
+        }
+    });
+
+    runner.Add("GenerateClientKey", [](BenchmarkState& state) {
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            std::string key = WebSocketProtocol::GenerateClientKey();
+            DoNotOptimize(key.data());
+        }
+    });
+}
+
+// One iteration publishes one message that every subscriber matches; items are deliveries
+void TopicFanout(BenchmarkState& state, size_t subscribers) {
+    state.PauseTiming();
+    TopicRouterOptions options;
+    options.Shards = 4;
+    TopicRouter router(options);
+    std::vector<std::shared_ptr<DispatchChannel>> channels;
+    channels.reserve(subscribers);
+    for (size_t i = 0; i < subscribers; i++) {
+        channels.push_back(std::make_shared<DispatchChannel>(2, 256));
+        router.Register(i, channels.back());
+        router.Subscribe(i, i % 2 ? "prices/+/usd" : "prices/#");
+    }
+    if (router.Start().IsError()) {
+        state.SkipWithError("Failed to start topic router");
+        return;
+    }
+
+    // Stands in for the connection threads that would write the frames out
+    std::atomic<bool> draining{true};
+    std::thread drainer([&channels, &draining]() {
+        BufferHandle frame;
+        while (draining.load(std::memory_order_relaxed)) {
+            for (auto& channel : channels) {
+                while (channel->PopFrame(frame)) {
+                    frame.Reset();
+                }
+            }
+        }
+    });
+
+    const std::string payload(64, 'x');
+    const uint64_t expected = state.Iterations() * subscribers;
+    state.ResumeTiming();
+
+    for (uint64_t i = 0; i < state.Iterations(); i++) {
+        router.Publish("prices/btc/usd", payload);
+    }
+    for (;;) {
+        TopicRouterStats stats = router.Stats();
+        if (stats.Deliveries + stats.Dropped >= expected) {
+            break;
+        }
+        std::this_thread::yield();
+    }
+
+    state.PauseTiming();
+    draining = false;
+    drainer.join();
+    router.Stop();
+    state.SetItemsProcessed(expected);
+}
+
+void RegisterTopicBenchmarks(BenchmarkRunner& runner) {
+    for (size_t subscribers : {size_t(1024), size_t(8192)}) {
+        runner.Add("TopicFanout/" + std::to_string(subscribers), [subscribers](BenchmarkState& state) {
+            TopicFanout(state, subscribers);
+        });
+    }
+}
+
+// Cost of one update on the hot path
+void RegisterMetricsBenchmarks(BenchmarkRunner& runner) {
+    runner.Add("CounterIncrement", [](BenchmarkState& state) {
+        Counter counter;
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            counter.Increment();
+        }
+        DoNotOptimize(counter.Value());
+    });
+
+    runner.Add("HistogramRecord", [](BenchmarkState& state) {
+        Histogram histogram;
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            histogram.Record(i & 0xFFFFF);
+        }
+        DoNotOptimize(histogram.Snapshot().Count);
+    });
+
+    runner.Add("PrometheusText", [](BenchmarkState& state) {
+        HttpWsServer server(0, "127.0.0.1");
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            std::string text = server.GetMetrics().PrometheusText();
+            DoNotOptimize(text.data());
+        }
+    });
+}
+
+void RegisterTraceBenchmarks(BenchmarkRunner& runner) {
+    // A trace point while the tracer is stopped: one relaxed load
+    runner.Add("TraceDisabled", [](BenchmarkState& state) {
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            WS_TRACE_ERROR("bench", "disabled", "iteration {}", i);
+        }
+    });
+
+    // Recording into the thread's ring buffer; records beyond its capacity are dropped
+    runner.Add("TraceEmit", [](BenchmarkState& state) {
+        TraceOptions options;
+        options.ThreadBufferRecords = 65536;
+        options.MaxMemoryRecords = 1024;
+        options.DrainInterval = std::chrono::milliseconds(1);
+        if (Tracer::Instance().Start(options).IsError()) {
+            state.SkipWithError("Tracer already running");
+            return;
+        }
+        static TraceSite site{TRACE_LEVEL::ERR, "bench", "emit"};
+        for (uint64_t i = 0; i < state.Iterations(); i++) {
+            Tracer::Emit(site, TRACE_PHASE::INSTANT, "iteration {} of {s}", i, "bench");
+        }
+        state.PauseTiming();
+        Tracer::Instance().Stop();
+    });
+}
+
+// One iteration moves one chunk from a client socket to a server socket over loopback
+void LoopbackThroughput(BenchmarkState& state, size_t chunkSize) {
+    state.PauseTiming();
+    Socket listener;
+    if (listener.Create(SOCKET_FAMILY::IPV4, SOCKET_TYPE::TCP).IsError() ||
+        listener.Bind("127.0.0.1", 0).IsError() || listener.Listen(1).IsError()) {
+        state.SkipWithError("Failed to create loopback listener");
+        return;
+    }
+
+    Socket client;
+    if (client.Create(SOCKET_FAMILY::IPV4, SOCKET_TYPE::TCP).IsError() ||
+        client.Connect("127.0.0.1", listener.LocalPort()).IsError()) {
+        state.SkipWithError("Failed to connect over loopback");
+        return;
+    }
+    auto [acceptResult, server] = listener.Accept();
+    if (acceptResult.IsError() || !server) {
+        state.SkipWithError("Failed to accept loopback connection");
+        return;
+    }
+    server->Blocking(true);
+
+    const uint64_t totalBytes = state.Iterations() * chunkSize;
+    std::vector<uint8_t> chunk = CreateTestData(chunkSize);
+    state.ResumeTiming();
+
+    std::thread receiver([&server, totalBytes]() {
+        std::vector<uint8_t> buffer(256 * 1024);
+        uint64_t received = 0;
+        while (received < totalBytes) {
+            auto [result, count] = server->ReceiveInto(buffer.data(), buffer.size());
+            if (result.IsError() || count == 0) {
+                break;
+            }
+            received += count;
+        }
+    });
+
+    for (uint64_t i = 0; i < state.Iterations(); i++) {
+        if (client.SendRaw(chunk.data(), chunk.size()).first.IsError()) {
+            state.SkipWithError("Loopback send failed");
+            client.Close();
+            break;
+        }
+    }
+    receiver.join();
+
+    state.PauseTiming();
+    state.SetBytesProcessed(totalBytes);
+}
+
+void RegisterSocketBenchmarks(BenchmarkRunner& runner) {
+    for (size_t size : {size_t(4096), size_t(65536)}) {
+        runner.Add("LoopbackThroughput/" + std::to_string(size), [size](BenchmarkState& state) {
+            LoopbackThroughput(state, size);
+        });
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchmarkRunner runner;
+    RegisterFrameBenchmarks(runner);
+    RegisterUtf8Benchmarks(runner);
+    RegisterHandshakeBenchmarks(runner);
+    RegisterTopicBenchmarks(runner);
+    RegisterMetricsBenchmarks(runner);
+    RegisterTraceBenchmarks(runner);
+    RegisterSocketBenchmarks(runner);
+    return BenchmarkMain(argc, argv, runner);
+}
@@ -0,0 +1,154 @@
+/**
+ * @file Benchmark.h
+ * @brief Minimal benchmark harness with JSON results and baseline comparison
+ *
+ * Benchmarks are registered with a BenchmarkRunner as functions that run a
+ * requested number of iterations. The runner calibrates the iteration count to
+ * a minimum run time, repeats the measurement, and reports the median. Results
+ * are written as JSON so runs can be compared across releases; BenchmarkMain
+ * can fail a run whose results regressed against a saved baseline.
+ */
+
+#pragma once
+
+#include "ErrorCodes.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace WebSocket {
+
+/**
+ * @brief Keeps the compiler from discarding a computed value
+ */
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    const volatile char* sink = reinterpret_cast<const volatile char*>(&value);
+    (void)*sink;
+#endif
+}
+
+struct BenchmarkResult {
+    std::string Name;
+    uint64_t Iterations = 0;        // Per repetition
+    size_t Repetitions = 0;
+    double NsPerOp = 0.0;           // Median across repetitions
+    double NsPerOpMin = 0.0;
+    double NsPerOpStdDev = 0.0;
+    double BytesPerSecond = 0.0;    // 0 when the benchmark does not count bytes
+    double ItemsPerSecond = 0.0;    // 0 when the benchmark does not count items
+    std::string Error;              // Set when the benchmark skipped itself
+};
+
+/**
+ * @brief Passed to each benchmark run; the function performs Iterations() operations
+ */
+class BenchmarkState {
+public:
+    explicit BenchmarkState(uint64_t iterations) : m_iterations(iterations) {}
+
+    uint64_t Iterations() const { return m_iterations; }
+
+    // Totals for the whole run, not per iteration
+    void SetBytesProcessed(uint64_t bytes) { m_bytes = bytes; }
+    void SetItemsProcessed(uint64_t items) { m_items = items; }
+
+    // Exclude setup or teardown inside the benchmark function from the timing
+    void PauseTiming();
+    void ResumeTiming();
+
+    void SkipWithError(const std::string& message) { m_error = message; }
+
+private:
+    friend class BenchmarkRunner;
+
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t m_iterations;
+    uint64_t m_bytes = 0;
+    uint64_t m_items = 0;
+    std::string m_error;
+    Clock::time_point m_start;
+    Clock::duration m_elapsed{0};
+    bool m_timing = false;
+};
+
+using BenchmarkFn = std::function<void(BenchmarkState&)>;
+
+struct BenchmarkOptions {
+    double MinTimeSeconds = 0.1;    // Per repetition
+    size_t Repetitions = 5;
+    std::string Filter;             // Substring of the benchmark name; empty runs all
+    bool Quiet = false;             // Suppress the console table
+};
+
+class BenchmarkRunner {
+public:
+    BenchmarkRunner& Add(const std::string& name, BenchmarkFn function);
+    std::vector<std::string> Names() const;
+    std::vector<BenchmarkResult> Run(const BenchmarkOptions& options) const;
+
+private:
+    struct Case {
+        std::string Name;
+        BenchmarkFn Function;
+    };
+
+    static double RunOnce(const Case& benchmark, BenchmarkState& state);
+
+    std::vector<Case> m_cases;
+};
+
+/**
+ * @brief A set of results with JSON serialization
+ *
+ * Programs that measure in their own way (transfer tests, load generators) can
+ * add results directly and share the same file format.
+ */
+class BenchmarkReport {
+public:
+    BenchmarkReport() = default;
+    explicit BenchmarkReport(std::vector<BenchmarkResult> results) : m_results(std::move(results)) {}
+
+    void Add(const BenchmarkResult& result) { m_results.push_back(result); }
+    const std::vector<BenchmarkResult>& Results() const { return m_results; }
+    const BenchmarkResult* Find(const std::string& name) const;
+
+    std::string ToJson() const;
+    Result WriteJson(const std::string& path) const;    // "-" writes to stdout
+    static std::pair<Result, BenchmarkReport> FromJson(const std::string& json);
+    static std::pair<Result, BenchmarkReport> ReadJson(const std::string& path);
+
+private:
+    std::vector<BenchmarkResult> m_results;
+};
+
+struct BenchmarkComparison {
+    std::string Name;
+    double BaselineNsPerOp = 0.0;
+    double CurrentNsPerOp = 0.0;
+    double ChangePercent = 0.0;     // Positive is slower
+    bool Regressed = false;
+};
+
+// Compares every current result that also exists in the baseline
+std::vector<BenchmarkComparison> CompareBenchmarks(const BenchmarkReport& baseline, const BenchmarkReport& current,
+                                                   double maxRegressionPercent);
+
+/**
+ * @brief Command line driver for benchmark executables
+ *
+ * Options: --filter TEXT, --min-time SECONDS, --repetitions N, --json PATH,
+ * --baseline PATH, --max-regression PERCENT (default 10), --list.
+ * Returns 0 on success, 1 on bad arguments or I/O errors, 2 when a result
+ * regressed against the baseline.
+ */
+int BenchmarkMain(int argc, char* argv[], const BenchmarkRunner& runner);
+
+} // namespace WebSocket
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace WebSocket {
+
+// Pool block header (internal to BufferPool.cpp)
+struct BufferBlock;
+
+/**
+ * @brief Counters reported by BufferPool
+ *
+ * Hits are served from the calling thread's cache or the global free lists;
+ * heap allocations cover pool misses and requests larger than the biggest class.
+ */
+struct BufferPoolStats {
+    uint64_t Allocations = 0;           // Buffers handed out
+    uint64_t ThreadCacheHits = 0;       // Served from the calling thread's free list
+    uint64_t GlobalHits = 0;            // Served from the shared overflow list
+    uint64_t HeapAllocations = 0;       // Pool misses and oversize requests
+    uint64_t BuffersOutstanding = 0;    // Buffers currently referenced by handles
+    uint64_t BytesOutstanding = 0;      // Capacity of those buffers
+    uint64_t RemoteReleases = 0;        // Released on a thread of another NUMA node
+
+    double HitRate() const {
+        return Allocations ? static_cast<double>(ThreadCacheHits + GlobalHits) / Allocations : 0.0;
+    }
+};
+
+/**
+ * @brief Reference-counted handle to a pooled byte buffer
+ *
+ * Copies share the same storage; the buffer returns to the pool when the last
+ * handle goes away, on whichever thread that happens. The reference count is
+ * atomic, the bytes themselves are not synchronized.
+ */
+class BufferHandle {
+public:
+    BufferHandle() = default;
+    ~BufferHandle() { Reset(); }
+
+    BufferHandle(const BufferHandle& other);
+    BufferHandle& operator=(const BufferHandle& other);
+    BufferHandle(BufferHandle&& other) noexcept;
+    BufferHandle& operator=(BufferHandle&& other) noexcept;
+
+    bool Valid() const { return m_block != nullptr; }
+    uint8_t* Data() { return m_data; }
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    size_t Capacity() const { return m_capacity; }
+    bool Empty() const { return m_size == 0; }
+
+    // Sets the number of valid bytes; fails if size exceeds the capacity
+    bool Resize(size_t size);
+    void Reset();
+    uint32_t UseCount() const;
+
+    std::vector<uint8_t> ToVector() const { return std::vector<uint8_t>(m_data, m_data + m_size); }
+
+private:
+    friend class BufferPool;
+
+    explicit BufferHandle(BufferBlock* block);
+
+    BufferBlock* m_block{nullptr};
+    uint8_t* m_data{nullptr};
+    size_t m_size{0};
+    size_t m_capacity{0};
+};
+
+/**
+ * @brief Process-wide byte buffer pool with size classes and thread caches
+ *
+ * Requests are rounded up to 4 KiB, 16 KiB, 64 KiB or 1 MiB. Each thread keeps a
+ * small free list per class and exchanges buffers with a shared overflow list in
+ * batches, so the common acquire/release path takes no lock. Larger requests are
+ * served straight from the heap.
+ *
+ * Shared lists are kept per NUMA node. A thread uses node 0's until it is
+ * pinned (PinCurrentThread) or calls SetThreadNode. Buffers are first written
+ * by the thread that allocates them, so their pages land on its node, and a
+ * buffer released on another node's thread goes back to its own node's list.
+ */
+class BufferPool {
+public:
+    static constexpr size_t kSizeClassCount = 4;
+    static constexpr size_t kSizeClasses[kSizeClassCount] = {4 * 1024, 16 * 1024, 64 * 1024, 1024 * 1024};
+
+    // Returns an invalid handle if memory is exhausted; Size() starts at 0
+    static BufferHandle Acquire(size_t capacity);
+
+    // Aggregate counters, or counters for one size class (kSizeClassCount = oversize)
+    static BufferPoolStats Stats();
+    static BufferPoolStats ClassStats(size_t sizeClass);
+
+    // Return the calling thread's cached buffers to the shared lists
+    static void FlushThreadCache();
+
+    // Serve the calling thread from this NUMA node's shared lists from now on
+    static void SetThreadNode(int node);
+
+    // Free every buffer parked in the shared lists
+    static void Trim();
+
+private:
+    friend class BufferHandle;
+    static void Release(BufferBlock* block);
+};
+
+} // namespace WebSocket
@@ -0,0 +1,128 @@
+/**
+ * @file ConnectionStats.h
+ * @brief Per-connection counters and top-N selection of slow connections
+ *
+ * Each connection owns a ConnectionCounters block that its own threads update
+ * with relaxed atomics: bytes and frames in each direction, bytes stuck in a
+ * send call, last receive time and the ping round trip. Readers copy the
+ * counters into a ConnectionStats without taking any lock the I/O path
+ * holds, so finding slow consumers never pauses sending or receiving.
+ *
+ * GetSlowestConnections() on both servers walks the connections once and
+ * keeps the worst N in a SlowConnectionHeap, keyed by a CONNECTION_ORDER.
+ * Only the N winners get their client IP copied and, where the order does
+ * not already need it, their kernel TCP_INFO read.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace WebSocket {
+
+// Steady-clock nanoseconds; the time base of every timestamp below
+inline int64_t SteadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct ConnectionCounters {
+    std::atomic<uint64_t> BytesIn{0};
+    std::atomic<uint64_t> BytesOut{0};
+    std::atomic<uint64_t> FramesIn{0};
+    std::atomic<uint64_t> FramesOut{0};
+    std::atomic<uint64_t> SendingBytes{0};      // Handed to a send call that has not returned yet
+    std::atomic<int64_t> OpenedNs{SteadyNowNs()};
+    std::atomic<int64_t> LastActivityNs{SteadyNowNs()};    // Last data received
+    std::atomic<int64_t> PingSentNs{0};         // Payload of the outstanding ping; 0 when none
+    std::atomic<int64_t> RttNs{0};              // Last ping/pong round trip; 0 until measured
+    std::atomic<bool> WebSocket{false};         // Handshake completed
+    std::atomic<bool> ReadPaused{false};        // PauseRead(); set by any thread
+    std::atomic<bool> ReadThrottled{false};     // Over a flow-control limit; set by the connection thread
+    std::atomic<int> Cpu{-1};                   // The connection thread is pinned here; -1 when unpinned
+
+    void Received(size_t bytes) {
+        BytesIn.fetch_add(bytes, std::memory_order_relaxed);
+        LastActivityNs.store(SteadyNowNs(), std::memory_order_relaxed);
+    }
+    void Sent(size_t bytes, uint64_t frames = 0) {
+        BytesOut.fetch_add(bytes, std::memory_order_relaxed);
+        if (frames) {
+            FramesOut.fetch_add(frames, std::memory_order_relaxed);
+        }
+    }
+
+    // PING payload carrying the send time; replaces any ping still outstanding
+    int64_t BeginPing();
+    // Completes the round trip when the PONG echoes the outstanding payload
+    bool CompletePing(const uint8_t* payload, size_t length);
+};
+
+struct ConnectionStats {
+    ConnectionHandle Handle;
+    std::string ClientIP;
+    bool IsWebSocket = false;
+    uint64_t BytesIn = 0;
+    uint64_t BytesOut = 0;
+    uint64_t FramesIn = 0;
+    uint64_t FramesOut = 0;
+    uint64_t SendingBytes = 0;
+    size_t QueuedMessages = 0;      // Replies and published frames waiting for the connection's thread
+    size_t QueuedInboundBytes = 0;  // Received messages waiting for a handler worker
+    bool ReadPaused = false;        // By PauseRead()
+    bool ReadThrottled = false;     // By flow control (see FlowControlOptions)
+    int Cpu = -1;                   // Connection thread's CPU under HttpWsServer::SetCpuAffinity
+    int64_t ConnectedNs = 0;        // Age of the connection
+    int64_t IdleNs = 0;             // Since data was last received
+    int64_t RttNs = 0;              // From the last Ping(); 0 until one is answered
+    bool HasTcpInfo = false;        // False for HTTP connections and where TCP_INFO is unsupported
+    TcpInfo Tcp;
+
+    // Bytes accepted for sending that the peer has not acknowledged yet
+    uint64_t OutboundBytes() const { return SendingBytes + Tcp.SendQueueBytes; }
+};
+
+// What GetSlowestConnections ranks by, largest first
+enum class CONNECTION_ORDER {
+    OUTBOUND_BYTES,         // OutboundBytes(): blocked sends plus the kernel send queue
+    QUEUED_MESSAGES,        // Replies and frames waiting in user space
+    RTT,                    // Ping round trip, else the kernel's smoothed RTT
+    IDLE,
+    UNACKED,                // Kernel segments in flight
+    RETRANSMITS
+};
+
+// True when ranking needs TCP_INFO for every connection, one getsockopt each
+bool ConnectionOrderNeedsTcpInfo(CONNECTION_ORDER order);
+uint64_t ConnectionOrderKey(const ConnectionStats& stats, CONNECTION_ORDER order);
+
+// Copies the counters; handle, IP, queue sizes and TCP_INFO are the caller's
+void ReadConnectionCounters(const ConnectionCounters& counters, int64_t now, ConnectionStats& stats);
+
+/**
+ * @brief Keeps the count handles with the largest keys offered
+ *
+ * A min-heap of at most count entries, so a walk over n connections costs
+ * O(n log count) and no allocation beyond count entries.
+ */
+class SlowConnectionHeap {
+public:
+    SlowConnectionHeap(size_t count, CONNECTION_ORDER order) : m_count(count), m_order(order) {}
+
+    void Offer(const ConnectionStats& stats);
+    std::vector<ConnectionHandle> Take();       // Slowest first
+
+private:
+    size_t m_count;
+    CONNECTION_ORDER m_order;
+    std::vector<std::pair<uint64_t, ConnectionHandle>> m_heap;
+};
+
+} // namespace WebSocket
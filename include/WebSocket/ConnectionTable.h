@@ -0,0 +1,161 @@
+/**
+ * @file ConnectionTable.h
+ * @brief Generation-checked slot table that hands out ConnectionHandles
+ *
+ * Each entry lives in a slot addressed by ConnectionHandle::Index. Removing an
+ * entry bumps the slot's generation, so handles held after a connection
+ * closed simply stop resolving, even once the slot is reused. Slots are
+ * allocated in fixed chunks that never move, which lets lookups run without
+ * the table lock: Find() costs one per-slot mutex, and connections only ever
+ * contend with operations on the same slot.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace WebSocket {
+
+template <typename T>
+class ConnectionTable {
+public:
+    static const size_t kChunkSize = 1024;
+    static const size_t kMaxChunks = 4096;      // Up to 4M simultaneous connections
+
+    ConnectionTable() : m_chunks(new std::atomic<Slot*>[kMaxChunks]) {
+        for (size_t i = 0; i < kMaxChunks; i++) {
+            m_chunks[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~ConnectionTable() {
+        for (size_t i = 0; i < kMaxChunks; i++) {
+            delete[] m_chunks[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    ConnectionTable(const ConnectionTable&) = delete;
+    ConnectionTable& operator=(const ConnectionTable&) = delete;
+
+    // Takes ownership and returns the entry's handle; an invalid handle (and
+    // value left untouched) when the table is full
+    ConnectionHandle Insert(std::unique_ptr<T>&& value) {
+        uint32_t index = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_free.empty()) {
+                index = m_free.back();
+                m_free.pop_back();
+            } else {
+                if (m_used == kChunkSize * kMaxChunks) {
+                    return ConnectionHandle();
+                }
+                index = m_used;
+                if (index % kChunkSize == 0) {
+                    m_chunks[index / kChunkSize].store(new Slot[kChunkSize], std::memory_order_release);
+                    m_free.reserve(index + kChunkSize);     // Remove() then never allocates
+                }
+                m_used++;
+            }
+        }
+
+        Slot& slot = SlotAt(index);
+        std::lock_guard<std::mutex> lock(slot.Mutex);
+        slot.Value = std::move(value);
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        return ConnectionHandle{index, slot.Generation};
+    }
+
+    // Returns the entry so it is destroyed outside the slot lock; null for a
+    // stale handle
+    std::unique_ptr<T> Remove(ConnectionHandle handle) {
+        Slot* slot = Lookup(handle);
+        if (!slot) {
+            return nullptr;
+        }
+        std::unique_ptr<T> removed;
+        {
+            std::lock_guard<std::mutex> lock(slot->Mutex);
+            if (slot->Generation != handle.Generation || !slot->Value) {
+                return nullptr;
+            }
+            removed = std::move(slot->Value);
+            if (++slot->Generation == 0) {
+                slot->Generation = 1;       // 0 marks the invalid handle
+            }
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(handle.Index);
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        return removed;
+    }
+
+    // Calls fn(T&) with the slot locked, so the entry cannot be removed while
+    // fn runs; keep fn short. False for a stale handle.
+    template <typename Fn>
+    bool Find(ConnectionHandle handle, Fn&& fn) const {
+        Slot* slot = Lookup(handle);
+        if (!slot) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(slot->Mutex);
+        if (slot->Generation != handle.Generation || !slot->Value) {
+            return false;
+        }
+        fn(*slot->Value);
+        return true;
+    }
+
+    // Calls fn(ConnectionHandle, T&) for every entry, one slot lock at a time
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        uint32_t used = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            used = m_used;
+        }
+        for (uint32_t index = 0; index < used; index++) {
+            Slot& slot = SlotAt(index);
+            std::lock_guard<std::mutex> lock(slot.Mutex);
+            if (slot.Value) {
+                fn(ConnectionHandle{index, slot.Generation}, *slot.Value);
+            }
+        }
+    }
+
+    size_t Size() const { return m_size.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::mutex Mutex;
+        uint32_t Generation = 1;
+        std::unique_ptr<T> Value;
+    };
+
+    Slot& SlotAt(uint32_t index) const {
+        return m_chunks[index / kChunkSize].load(std::memory_order_acquire)[index % kChunkSize];
+    }
+
+    Slot* Lookup(ConnectionHandle handle) const {
+        if (!handle.Valid() || handle.Index / kChunkSize >= kMaxChunks) {
+            return nullptr;
+        }
+        Slot* chunk = m_chunks[handle.Index / kChunkSize].load(std::memory_order_acquire);
+        return chunk ? &chunk[handle.Index % kChunkSize] : nullptr;
+    }
+
+    std::unique_ptr<std::atomic<Slot*>[]> m_chunks;
+    mutable std::mutex m_mutex;                 // Guards m_free and m_used
+    std::vector<uint32_t> m_free;
+    uint32_t m_used = 0;
+    std::atomic<size_t> m_size{0};
+};
+
+} // namespace WebSocket
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "Socket.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace WebSocket {
+
+/**
+ * @brief One resolved socket address (IPv4 or IPv6, port filled in)
+ */
+struct ResolvedAddress {
+    struct sockaddr_storage Address{};
+    size_t Length = 0;
+    SOCKET_FAMILY Family = SOCKET_FAMILY::IPV4;
+
+    std::string ToString() const;
+};
+
+using ResolveResult = std::pair<Result, std::vector<ResolvedAddress>>;
+using ResolveCallbackFn = std::function<void(const Result&, const std::vector<ResolvedAddress>&)>;
+
+struct DnsResolverStats {
+    uint64_t Lookups = 0;       // Resolve requests received
+    uint64_t CacheHits = 0;     // Answered from the cache (including literals)
+    uint64_t Queries = 0;       // getaddrinfo() calls made
+    uint64_t Coalesced = 0;     // Requests that joined a query already in flight
+    uint64_t Failures = 0;      // Queries that returned no address
+    uint64_t Evictions = 0;     // Live entries dropped to stay within the host limit
+    size_t CachedHosts = 0;
+};
+
+/**
+ * @brief Host name resolver with a thread pool and a TTL cache
+ *
+ * getaddrinfo() blocks, so lookups run on a small pool of resolver threads.
+ * Results are cached per host for a fixed TTL (getaddrinfo does not expose the
+ * record TTL); failures are cached for a shorter negative TTL. At most
+ * maxCachedHosts hosts are kept: a full cache first drops expired entries, then
+ * the one closest to expiry. Concurrent lookups of the same host share one
+ * query. IP literals never leave the caller.
+ */
+class DnsResolver {
+public:
+    explicit DnsResolver(size_t threadCount = 2,
+                         std::chrono::milliseconds ttl = std::chrono::seconds(60),
+                         std::chrono::milliseconds negativeTtl = std::chrono::seconds(5),
+                         size_t maxCachedHosts = 1024);
+    ~DnsResolver();
+
+    DnsResolver(const DnsResolver&) = delete;
+    DnsResolver& operator=(const DnsResolver&) = delete;
+
+    // Callback runs on a resolver thread, or inline for literals and cache hits
+    void ResolveAsync(const std::string& host, uint16_t port, ResolveCallbackFn callback);
+    ResolveResult Resolve(const std::string& host, uint16_t port);
+
+    void ClearCache();
+    DnsResolverStats Stats() const;
+
+private:
+    struct CacheEntry {
+        Result Status;
+        std::vector<ResolvedAddress> Addresses;    // Port 0; callers patch in their own
+        std::chrono::steady_clock::time_point Expires;
+    };
+
+    struct Waiter {
+        uint16_t Port;
+        ResolveCallbackFn Callback;
+    };
+
+    void ResolverThread();
+    CacheEntry Query(const std::string& host);
+    static bool ParseLiteral(const std::string& host, uint16_t port, ResolvedAddress& address);
+    static std::vector<ResolvedAddress> WithPort(const std::vector<ResolvedAddress>& addresses, uint16_t port);
+    void MakeRoomInCache();     // Caller holds m_mutex
+
+
+    const std::chrono::milliseconds m_ttl;
+    const std::chrono::milliseconds m_negativeTtl;
+    const size_t m_maxCachedHosts;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::string> m_queue;
+    std::unordered_map<std::string, CacheEntry> m_cache;
+    std::unordered_map<std::string, std::vector<Waiter>> m_inFlight;
+    std::vector<std::thread> m_threads;
+    bool m_stopping{false};
+    DnsResolverStats m_stats;
+};
+
+/**
+ * @brief Options for Connector::ConnectAsync
+ */
+struct ConnectOptions {
+    int TimeoutMs = 10000;          // Deadline for resolution plus all attempts
+    int AttemptDelayMs = 250;       // RFC 8305 Connection Attempt Delay between staggered attempts
+    bool PreferIPv6 = true;         // Address family tried first
+    bool NonBlocking = false;       // Leave the connected socket in non-blocking mode
+    SocketProfile Profile;          // Applied to every attempt before connect()
+};
+
+using ConnectCallbackFn = std::function<void(const Result&, std::unique_ptr<Socket>)>;
+
+/**
+ * @brief Asynchronous outbound connections with Happy Eyeballs
+ *
+ * Resolves host names through a DnsResolver, orders the addresses by
+ * alternating families (RFC 8305), and starts a new non-blocking attempt every
+ * AttemptDelayMs - or at once when the previous attempt fails - until one
+ * succeeds or the deadline passes. All attempts for all requests are driven by
+ * a single event loop thread (epoll on Linux, WSAPoll on Windows); callbacks
+ * run on that thread and should hand off any heavy work.
+ */
+class Connector {
+public:
+    explicit Connector(size_t resolverThreads = 2);
+    ~Connector();
+
+    Connector(const Connector&) = delete;
+    Connector& operator=(const Connector&) = delete;
+
+    // Starts the event loop on first use
+    Result ConnectAsync(const std::string& host, uint16_t port, ConnectCallbackFn callback,
+                        const ConnectOptions& options = ConnectOptions());
+
+    // Blocking convenience wrapper around ConnectAsync
+    std::pair<Result, std::unique_ptr<Socket>> Connect(const std::string& host, uint16_t port,
+                                                       const ConnectOptions& options = ConnectOptions());
+
+    void Stop();
+    size_t PendingConnections() const;
+    DnsResolver& Resolver() { return m_resolver; }
+
+    // Process-wide instance for callers that do not manage their own
+    static Connector& Shared();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Attempt {
+        std::unique_ptr<Socket> Connection;
+        ResolvedAddress Address;
+    };
+
+    struct Request {
+        uint64_t Id = 0;
+        std::string Host;
+        uint16_t Port = 0;
+        ConnectOptions Options;
+        ConnectCallbackFn Callback;
+        bool Resolved = false;
+        std::vector<ResolvedAddress> Addresses;
+        size_t NextAddress = 0;
+        std::vector<Attempt> Attempts;
+        Result LastError;
+        Clock::time_point Deadline;
+        Clock::time_point NextAttempt;
+    };
+
+    struct Resolution {
+        uint64_t Id;
+        Result Status;
+        std::vector<ResolvedAddress> Addresses;
+    };
+
+    Result StartLoop();
+    void EventLoop();
+    void Wake();
+    void DrainSubmissions();
+    void HandleWritable(intptr_t handle);
+    void StartNextAttempt(Request& request);
+    void ServiceTimers(Clock::time_point now, int& waitMs);
+    void Finish(uint64_t id, const Result& result, std::unique_ptr<Socket> connection);
+    static std::vector<ResolvedAddress> InterleaveFamilies(const std::vector<ResolvedAddress>& addresses, bool preferIPv6);
+
+    bool Watch(intptr_t handle, uint64_t id);
+    void Unwatch(intptr_t handle);
+    size_t WaitForEvents(int timeoutMs);
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Request>> m_submitted;
+    std::vector<Resolution> m_resolutions;
+    std::atomic<size_t> m_pending{0};
+    std::atomic<uint64_t> m_nextId{1};
+
+    // Owned by the loop thread
+    std::unordered_map<uint64_t, std::unique_ptr<Request>> m_requests;
+    std::unordered_map<intptr_t, uint64_t> m_watched;
+    std::vector<intptr_t> m_ready;
+
+    std::thread m_loopThread;
+    std::atomic<bool> m_running{false};
+#ifdef _WIN32
+    std::vector<WSAPOLLFD> m_pollFds;
+#else
+    int m_epollFd{-1};
+    int m_wakeFd{-1};
+#endif
+
+    // Declared last so it is destroyed first: its threads call back into this object
+    DnsResolver m_resolver;
+};
+
+} // namespace WebSocket
@@ -0,0 +1,378 @@
+/**
+ * @file Coroutine.h
+ * @brief C++20 coroutine API: awaitable sockets and WebSocket connections
+ *
+ * An IoContext is a single-threaded event loop (epoll on Linux, WSAPoll on
+ * Windows). Coroutines spawned on it suspend while a socket would block and
+ * resume when it becomes ready, so handler code reads sequentially while many
+ * connections share one thread:
+ *
+ *   Task<void> Echo(std::unique_ptr<AsyncSocket> socket) {
+ *       auto [result, ws] = co_await AsyncWebSocket::Accept(std::move(socket));
+ *       while (result.IsSuccess()) {
+ *           auto [readResult, message] = co_await ws->ReadMessage();
+ *           if (readResult.IsError()) break;
+ *           co_await ws->Send(message);
+ *       }
+ *   }
+ *
+ * Run one IoContext per thread to use several cores; a coroutine can move to
+ * another context with co_await context.Schedule().
+ *
+ * Everything here requires C++20 (-DAIWEBSOCKETS_CXX20=ON). In a C++17 build
+ * the header only defines WEBSOCKET_HAS_COROUTINES as 0.
+ */
+
+#pragma once
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define WEBSOCKET_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifndef WEBSOCKET_HAS_COROUTINES
+#define WEBSOCKET_HAS_COROUTINES 0
+#endif
+
+#if WEBSOCKET_HAS_COROUTINES
+
+#include "Socket.h"
+#include "Types.h"
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace WebSocket {
+
+template <typename T = void>
+class Task;
+
+namespace Detail {
+
+struct TaskPromiseBase {
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept {
+            // Symmetric transfer back to whoever awaited the task
+            std::coroutine_handle<> continuation = finished.promise().Continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { Exception = std::current_exception(); }
+
+    std::coroutine_handle<> Continuation;
+    std::exception_ptr Exception;
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    Task<T> get_return_object() noexcept;
+    void return_value(T value) { Value.emplace(std::move(value)); }
+    T TakeValue() {
+        if (Exception) std::rethrow_exception(Exception);
+        return std::move(*Value);
+    }
+
+    std::optional<T> Value;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void TakeValue() {
+        if (Exception) std::rethrow_exception(Exception);
+    }
+};
+
+} // namespace Detail
+
+/**
+ * @brief Lazily started coroutine producing a T
+ *
+ * The body runs when the task is awaited and resumes the awaiting coroutine
+ * when it finishes. Pass tasks that nobody awaits to IoContext::Spawn().
+ */
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = Detail::TaskPromise<T>;
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (m_handle) m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        m_handle.promise().Continuation = awaiting;
+        return m_handle;
+    }
+    T await_resume() { return m_handle.promise().TakeValue(); }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+namespace Detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace Detail
+
+/**
+ * @brief Single-threaded event loop that resumes coroutines
+ *
+ * Spawn(), Schedule() and Stop() may be called from any thread; the
+ * readiness and timer awaitables must be used on the thread running Run().
+ */
+class IoContext {
+public:
+    IoContext();
+    ~IoContext();
+
+    IoContext(const IoContext&) = delete;
+    IoContext& operator=(const IoContext&) = delete;
+
+    bool Valid() const;
+
+    // Starts the task on this context's thread; it is destroyed when it finishes
+    void Spawn(Task<void> task);
+
+    // Runs until Stop() or until every spawned task has finished
+    void Run();
+    void Stop();
+
+    // co_await context.Schedule(): continue on this context's thread
+    auto Schedule() {
+        struct Awaiter {
+            IoContext& Context;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { Context.Post(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    // co_await context.Yield(): let the other ready coroutines and pending I/O go first
+    auto Yield() {
+        struct Awaiter {
+            IoContext& Context;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { Context.m_ready.push_back(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    // co_await context.SleepFor(ms)
+    auto SleepFor(std::chrono::milliseconds duration) {
+        struct Awaiter {
+            IoContext& Context;
+            std::chrono::milliseconds Duration;
+            bool await_ready() const noexcept { return Duration.count() <= 0; }
+            void await_suspend(std::coroutine_handle<> handle) { Context.AddTimer(Duration, handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this, duration};
+    }
+
+    // Suspend until the descriptor is readable / writable (or has an error)
+    auto WaitReadable(intptr_t handle) { return ReadinessAwaiter{*this, handle, false}; }
+    auto WaitWritable(intptr_t handle) { return ReadinessAwaiter{*this, handle, true}; }
+
+    // Drop the registration for a descriptor that is about to be closed
+    void Forget(intptr_t handle);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct ReadinessAwaiter {
+        IoContext& Context;
+        intptr_t Handle;
+        bool Write;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> coroutine) { Context.AddWaiter(Handle, Write, coroutine); }
+        void await_resume() const noexcept {}
+    };
+
+    struct Registration {
+        std::coroutine_handle<> Reader;
+        std::coroutine_handle<> Writer;
+        bool Added = false;
+    };
+
+    struct Timer {
+        Clock::time_point Deadline;
+        uint64_t Sequence;
+        std::coroutine_handle<> Coroutine;
+        bool operator>(const Timer& other) const {
+            return Deadline != other.Deadline ? Deadline > other.Deadline : Sequence > other.Sequence;
+        }
+    };
+
+    struct DetachedTask;
+    static DetachedTask RunDetached(IoContext& context, Task<void> task);
+
+    void Post(std::coroutine_handle<> handle);
+    void Wake();
+    void AddWaiter(intptr_t handle, bool write, std::coroutine_handle<> coroutine);
+    void AddTimer(std::chrono::milliseconds duration, std::coroutine_handle<> coroutine);
+    void WaitForEvents(int timeoutMs);
+    int NextTimeoutMs() const;
+    void FireTimers();
+
+    std::vector<std::coroutine_handle<>> m_ready;
+    std::unordered_map<intptr_t, Registration> m_registrations;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_timers;
+    uint64_t m_timerSequence = 0;
+
+    std::mutex m_postMutex;
+    std::vector<std::coroutine_handle<>> m_posted;
+
+    // Frames of spawned tasks that have not finished; destroyed with the context
+    std::unordered_set<void*> m_detached;
+
+    std::atomic<size_t> m_liveTasks{0};
+    std::atomic<bool> m_stopped{false};
+
+#ifndef _WIN32
+    int m_epollFd = -1;
+    int m_wakeFd = -1;
+#endif
+};
+
+/**
+ * @brief Non-blocking socket whose operations suspend instead of blocking
+ */
+class AsyncSocket {
+public:
+    AsyncSocket(IoContext& context, std::unique_ptr<Socket> socket);
+    ~AsyncSocket();
+
+    AsyncSocket(const AsyncSocket&) = delete;
+    AsyncSocket& operator=(const AsyncSocket&) = delete;
+
+    // Bound, listening socket ready for Accept()
+    static std::pair<Result, std::unique_ptr<AsyncSocket>> Listen(IoContext& context, const std::string& address,
+                                                                  uint16_t port, int backlog = 128);
+    static Task<std::pair<Result, std::unique_ptr<AsyncSocket>>> Connect(IoContext& context, std::string address,
+                                                                         uint16_t port);
+
+    Task<std::pair<Result, std::unique_ptr<AsyncSocket>>> Accept();
+
+    // Up to size bytes; 0 bytes means the peer closed the connection
+    Task<ReceiveIntoResult> Recv(void* buffer, size_t size);
+
+    // The whole buffer, suspending whenever the send buffer is full
+    Task<Result> Send(const void* data, size_t length);
+
+    void Close();
+
+    Socket& Native() { return *m_socket; }
+    IoContext& Context() { return m_context; }
+
+private:
+    IoContext& m_context;
+    std::unique_ptr<Socket> m_socket;
+    unsigned m_inlineCompletions = 0;   // Operations finished in a row without suspending
+};
+
+/**
+ * @brief WebSocket connection over an AsyncSocket
+ *
+ * Server connections come from Accept() (which performs the opening
+ * handshake), client connections from Connect(). ReadMessage() reassembles
+ * fragments and answers pings; a close frame is echoed and reported as
+ * WEBSOCKET_CONNECTION_CLOSED.
+ */
+class AsyncWebSocket {
+public:
+    static Task<std::pair<Result, std::unique_ptr<AsyncWebSocket>>> Accept(std::unique_ptr<AsyncSocket> socket);
+    static Task<std::pair<Result, std::unique_ptr<AsyncWebSocket>>> Connect(IoContext& context, std::string address,
+                                                                            uint16_t port, std::string path = "/");
+
+    Task<std::pair<Result, WebSocketMessage>> ReadMessage();
+
+    Task<Result> SendText(const std::string& text);
+    Task<Result> SendBinary(const std::vector<uint8_t>& data);
+    Task<Result> Send(const WebSocketMessage& message);
+    Task<Result> Close(uint16_t code = 1000);
+
+    // Close frame sent (by Close() or in reply to the peer's)
+    bool IsClosing() const { return m_closeSent; }
+
+    void SetMaxMessageSize(size_t maxMessageSize) { m_maxMessageSize = maxMessageSize; }
+    AsyncSocket& Transport() { return *m_socket; }
+
+private:
+    AsyncWebSocket(std::unique_ptr<AsyncSocket> socket, bool client);
+
+    // Frames go out whole and in order: a sender that finds another frame in
+    // flight (say, a pong from ReadMessage) waits its turn here
+    struct SendTurn {
+        AsyncWebSocket& Connection;
+        bool await_ready() const noexcept { return !Connection.m_sending; }
+        void await_suspend(std::coroutine_handle<> handle) { Connection.m_sendWaiters.push_back(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    Task<Result> SendFrame(WEBSOCKET_OPCODE opcode, const uint8_t* data, size_t length);
+    Task<Result> Fill();
+    Task<std::pair<Result, size_t>> ReadHttpHeaders();
+    uint32_t NextMask();
+
+    std::unique_ptr<AsyncSocket> m_socket;
+    bool m_client;
+    bool m_closeSent = false;
+    size_t m_maxMessageSize = 16 * 1024 * 1024;
+    uint64_t m_maskState;
+
+    std::vector<uint8_t> m_receiveBuffer;
+    size_t m_receiveStart = 0;
+    size_t m_receiveEnd = 0;
+    std::vector<uint8_t> m_sendBuffer;
+    bool m_sending = false;
+    std::deque<std::coroutine_handle<>> m_sendWaiters;
+    std::vector<uint8_t> m_fragments;
+    WEBSOCKET_OPCODE m_fragmentOpcode = WEBSOCKET_OPCODE::CONTINUATION;
+};
+
+} // namespace WebSocket
+
+#endif // WEBSOCKET_HAS_COROUTINES
@@ -0,0 +1,58 @@
+/**
+ * @file CpuTopology.h
+ * @brief CPUs, cores and NUMA nodes the process may run on, and thread pinning
+ *
+ * Read once from the process's affinity mask and, on Linux, from
+ * /sys/devices/system. Other platforms report every CPU as its own core on
+ * node 0. CPU lists built from it (AllCpus, PhysicalCores, NodeCpus) can be
+ * passed to HttpWsServer::SetCpuAffinity, ExecutorOptions::CpuAffinity and
+ * the other worker pools.
+ */
+
+#pragma once
+
+#include <thread>
+#include <vector>
+
+namespace WebSocket {
+
+struct CpuInfo {
+    int Cpu = 0;
+    int Core = 0;           // Unique across packages
+    int Package = 0;
+    int Node = 0;           // NUMA node
+};
+
+class CpuTopology {
+public:
+    // The CPUs the process was allowed to run on when first called
+    static const CpuTopology& System();
+    static CpuTopology Detect();
+
+    const std::vector<CpuInfo>& Cpus() const { return m_cpus; }
+    std::vector<int> AllCpus() const;
+    // One logical CPU per physical core, ordered by node, so hyperthread
+    // siblings do not share a core's caches and execution units
+    std::vector<int> PhysicalCores() const;
+    std::vector<int> NodeCpus(int node) const;
+    int NodeOf(int cpu) const;                  // 0 for a CPU it does not know
+    size_t NodeCount() const;
+
+private:
+    std::vector<CpuInfo> m_cpus;                // Ordered by CPU number
+};
+
+// CPU the calling thread is running on, or -1 where that is not available
+int CurrentCpu();
+
+/**
+ * @brief Restrict a thread to one CPU
+ *
+ * PinCurrentThread also moves the thread's BufferPool cache to the CPU's
+ * NUMA node, so buffers it allocates from then on come from, and go back
+ * to, memory on that node. Both return false when the CPU cannot be used.
+ */
+bool PinCurrentThread(int cpu);
+bool PinThread(std::thread& thread, int cpu);
+
+} // namespace WebSocket
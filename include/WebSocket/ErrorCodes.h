@@ -16,6 +16,7 @@ enum class ERROR_CODE {
     SOCKET_SET_OPTION_FAILED,
     SOCKET_GETSOCKNAME_FAILED,
     SOCKET_ADDRESS_PARSE_FAILED,
+    SOCKET_OPTION_NOT_SUPPORTED,
     INVALID_PARAMETER,
     MEMORY_ALLOCATION_FAILED,
     WEBSOCKET_HANDSHAKE_FAILED,
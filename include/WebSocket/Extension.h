@@ -0,0 +1,124 @@
+/**
+ * @file Extension.h
+ * @brief Pluggable WebSocket extensions (RFC 6455 section 9)
+ *
+ * A server holds a list of WebSocketExtension objects. During the handshake
+ * each one may accept an offer from the client's Sec-WebSocket-Extensions
+ * header and return an ExtensionSession: per-connection state built from the
+ * offer's parameters. The accepted sessions form the connection's
+ * ExtensionChain, and the server echoes the accepted names and parameters in
+ * its response.
+ *
+ * Sessions transform whole data messages. Outgoing messages pass through
+ * every session in negotiation order, and each session may set the RSV bits it
+ * claimed on the message's first frame. Incoming messages whose first frame
+ * carries negotiated RSV bits are reassembled, then passed in reverse order to
+ * the sessions owning those bits. Messages without those bits are never
+ * decoded. A frame with an RSV bit no extension claimed is a protocol error,
+ * and so is an RSV bit on a continuation frame unless its extension lists it
+ * in ContinuationRsvBits (permessage-deflate does not, RFC 7692 section 6.1).
+ * Control frames are never transformed.
+ *
+ * Some outgoing messages skip the sessions and go out with RSV clear:
+ * published topic frames, which are encoded once for all subscribers, and
+ * SendStream messages, which never exist whole. An extension must therefore
+ * accept plain messages, as permessage-deflate does.
+ */
+
+#pragma once
+
+#include "ErrorCodes.h"
+#include "Types.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace WebSocket {
+
+// RSV bits of a frame's first byte
+const uint8_t kRsv1 = 0x40;
+const uint8_t kRsv2 = 0x20;
+const uint8_t kRsv3 = 0x10;
+
+// One entry of a Sec-WebSocket-Extensions header: "name; flag; param=value"
+struct ExtensionOffer {
+    std::string Name;
+    std::vector<std::pair<std::string, std::string>> Params;   // Value empty for flags; quotes removed
+
+    const std::string* Find(const std::string& name) const;
+};
+
+// Splits a Sec-WebSocket-Extensions value into offers, in the client's order of preference
+std::vector<ExtensionOffer> ParseExtensionOffers(std::string_view header);
+
+/**
+ * @brief One connection's state for an accepted extension
+ *
+ * EncodeMessage runs under the connection's message lock, so only one
+ * message is encoded at a time. DecodeMessage runs on the connection's
+ * thread. A decode error closes the connection with 1002.
+ */
+class ExtensionSession {
+public:
+    virtual ~ExtensionSession() = default;
+
+    // Transforms an outgoing payload and ORs this extension's bits into rsv
+    virtual Result EncodeMessage(WEBSOCKET_OPCODE opcode, std::vector<uint8_t>& payload, uint8_t& rsv) = 0;
+    // Undoes EncodeMessage; rsv holds only this extension's bits and is never 0
+    virtual Result DecodeMessage(WEBSOCKET_OPCODE opcode, uint8_t rsv, std::vector<uint8_t>& payload) = 0;
+};
+
+/**
+ * @brief An extension a server offers, shared by all of its connections
+ */
+class WebSocketExtension {
+public:
+    virtual ~WebSocketExtension() = default;
+
+    virtual std::string Name() const = 0;
+    // RSV bits the extension's sessions may set; accepted extensions never share a bit
+    virtual uint8_t RsvBits() const = 0;
+    // Those of RsvBits that may also appear on continuation frames
+    virtual uint8_t ContinuationRsvBits() const { return 0; }
+    // Returns a session for an acceptable offer and its response parameters
+    // ("a=1; b" or empty), or nullptr to decline this offer
+    virtual std::unique_ptr<ExtensionSession> Accept(const ExtensionOffer& offer, std::string& responseParams) = 0;
+};
+
+/**
+ * @brief The sessions one connection negotiated, applied in order
+ */
+class ExtensionChain {
+public:
+    /**
+     * @brief Accepts offers from a Sec-WebSocket-Extensions value
+     *
+     * Offers are tried in the client's order. An extension is accepted at
+     * most once and only if its RSV bits are still free. Returns the value
+     * for the response header, or an empty string when nothing was accepted.
+     */
+    std::string Negotiate(std::string_view offered, const std::vector<std::shared_ptr<WebSocketExtension>>& available);
+
+    bool Empty() const { return m_sessions.empty(); }
+    uint8_t RsvBits() const { return m_rsvBits; }
+    uint8_t ContinuationRsvBits() const { return m_continuationRsvBits; }
+    const std::vector<std::string>& Names() const { return m_names; }
+
+    Result Encode(WEBSOCKET_OPCODE opcode, std::vector<uint8_t>& payload, uint8_t& rsv);
+    Result Decode(WEBSOCKET_OPCODE opcode, uint8_t rsv, std::vector<uint8_t>& payload);
+
+private:
+    struct Entry {
+        std::unique_ptr<ExtensionSession> Session;
+        uint8_t RsvBits;
+    };
+    std::vector<Entry> m_sessions;
+    std::vector<std::string> m_names;
+    uint8_t m_rsvBits = 0;
+    uint8_t m_continuationRsvBits = 0;
+};
+
+} // namespace WebSocket
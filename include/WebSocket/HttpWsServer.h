@@ -3,13 +3,27 @@
 #include "Socket.h"
 #include "Types.h"
 #include "WebSocketProtocol.h"
+#include "ObjectPool.h"
+#include "MessageDispatcher.h"
+#include "WorkStealingExecutor.h"
+#include "TopicRouter.h"
+#include "ConnectionTable.h"
+#include "Metrics.h"
+#include "ConnectionStats.h"
+#include "Extension.h"
+#include "MemoryBudget.h"
+#include "ListenerHandoff.h"
+#include "CpuTopology.h"
 #include <string>
+#include <string_view>
 #include <functional>
 #include <memory>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
+#include <chrono>
 #include <map>
 
 namespace WebSocket {
@@ -35,15 +49,59 @@ struct SecurityConfig {
     size_t maxRequestSize = 1024 * 1024;     // 1MB max request size
     size_t maxMessageSize = 1024 * 1024;     // 1MB max message size
     
+    // Memory held for all clients together: connections, requests, messages
+    // being reassembled or queued and queued replies (0 = count only)
+    size_t maxMemoryBytes = 0;
+    
     // Security features
     bool enableRequestSizeLimit = true;      // Enable request size validation
     bool enableMessageSizeLimit = true;      // Enable message size validation
     bool enableConnectionTimeout = true;     // Enable connection timeout
     bool enableRateLimiting = true;          // Enable rate limiting
     bool enableIPBlocking = true;            // Enable IP blocking
+    bool trustUnixPeers = false;             // Exempt Unix socket clients from limits like loopback ones
     
     // Blocked IPs (can be managed dynamically)
     std::vector<std::string> blockedIPs;
+    
+    // TCP tuning applied to the listener and every accepted connection
+    SocketProfile socketProfile;
+};
+
+/**
+ * @brief Limits on received messages waiting for a handler worker
+ *
+ * Applies in MESSAGE_DISPATCH::WORKER_POOL mode, where a connection thread
+ * can read and queue messages faster than the workers handle them. A
+ * connection over either per-connection limit, or any connection while the
+ * whole server is over MaxServerQueuedBytes, stops reading until its queue is
+ * back under half the limit. Unread data stays in the kernel, where TCP flow
+ * control slows the client down. Limits are checked between receives, so the
+ * messages in one receive buffer can overshoot them. 0 turns a limit off.
+ */
+struct FlowControlOptions {
+    size_t MaxQueuedMessages = 256;                     // Per connection
+    size_t MaxQueuedBytes = 8 * 1024 * 1024;            // Per connection
+    size_t MaxServerQueuedBytes = 256 * 1024 * 1024;    // All connections together
+};
+
+/**
+ * @brief Why a connection, request or message was turned away
+ *
+ * Counted in the aiws_rejections_total metric, labelled by reason.
+ */
+enum class REJECT_REASON {
+    IP_BLOCKED,
+    CONNECTION_LIMIT,           // maxConnectionsTotal or maxConnectionsPerIP
+    RATE_LIMIT,                 // maxRequestsPerIP within the reset period
+    SERVER_BUSY,                // Request executor queue full (503)
+    CONNECTION_TABLE_FULL,
+    REQUEST_TOO_LARGE,
+    INVALID_HANDSHAKE,
+    MESSAGE_TOO_LARGE,          // Closed with 1009
+    PROTOCOL_ERROR,             // Closed with 1002
+    MEMORY_BUDGET,              // SecurityConfig::maxMemoryBytes; messages are closed with 1013
+    COUNT
 };
 
 /**
@@ -60,6 +118,13 @@ struct HTTPRequest {
 
 /**
  * @brief Client connection information
+ *
+ * Connections and their receive buffers are recycled through slab pools,
+ * so connect/disconnect churn does not touch the heap once warmed up.
+ * Frames may be written by the connection's own thread or by SendTo/Close
+ * from any thread, so every WebSocket write holds sendMutex. A data message
+ * also holds messageMutex across all of its fragments, which keeps other
+ * messages out while control frames can still go out in between.
  */
 struct ClientConnection {
     std::unique_ptr<Socket> socket;
@@ -67,6 +132,26 @@ struct ClientConnection {
     std::chrono::steady_clock::time_point connectTime;
     int requestCount = 0;
     bool isWebSocket = false;
+    PooledBuffer receiveBuffer;
+    ConnectionHandle handle;                            // Also routes dispatched messages to a fixed worker
+    std::mutex sendMutex;
+    std::mutex messageMutex;                            // Taken before sendMutex
+    std::atomic<int> senders{0};                        // SendTo/Close calls still using the socket
+    std::mutex sendersMutex;                            // Released senders notify sendersDone under it
+    std::condition_variable sendersDone;
+    std::atomic<bool> closeSent{false};                 // Set under sendMutex; no data frame may follow
+    std::shared_ptr<DispatchChannel> dispatchChannel;   // Set in MESSAGE_DISPATCH::WORKER_POOL mode; changed under the slot lock
+    std::string_view pendingRequest;                    // Request already read by the request executor
+    std::string requestOverflow;                        // Holds only requests larger than receiveBuffer
+    ConnectionCounters counters;
+    std::string subProtocol;                            // Both set in the handshake, before SendTo can
+    ExtensionChain extensions;                          // reach the connection; encoded under messageMutex
+    MemoryReservation memory;                           // The connection, its buffer and its request
+    MemoryReservation messageMemory;                    // Message being reassembled; connection thread only
+
+    static void* operator new(size_t size);
+    static void operator delete(void* block, size_t size);
+    static SlabPoolStats PoolStats();
 };
 
 /**
@@ -83,15 +168,6 @@ struct ConnectionInfo {
     bool isWebSocket = false;
 };
 
-/**
- * @brief WebSocket message with client IP information
- */
-struct WebSocketMessageWithIP {
-    WebSocketMessage message;
-    std::string clientIP;
-    WEBSOCKET_OPCODE opcode;
-};
-
 /**
  * @brief HTTP + WebSocket Server with advanced security features
  * 
@@ -106,27 +182,91 @@ private:
     uint16_t m_port;
     bool m_running;
     SecurityConfig m_securityConfig;
+    MemoryBudget m_memoryBudget;                        // Outlives every connection and channel
     
     // Connection tracking
     std::map<std::string, ConnectionInfo> m_connectionMap;
     std::atomic<int> m_currentConnections{0};
     mutable std::mutex m_connectionMutex;
     
-    // Client connections
-    std::vector<std::unique_ptr<ClientConnection>> m_clients;
-    mutable std::mutex m_clientsMutex;
+    // Client connections, addressed by ConnectionHandle
+    ConnectionTable<ClientConnection> m_connections;
     
     // Callbacks
     std::function<std::string(const HTTPRequest&)> m_onHttpRequest;
     std::function<std::string(const WebSocketMessageWithIP&)> m_onWebSocketMessage;
+    std::function<std::string(const WebSocketMessageView&)> m_onWebSocketMessageView;
     std::function<void(const std::string&)> m_onConnect;
     std::function<void(const std::string&)> m_onDisconnect;
+    std::function<void(ConnectionHandle, const std::string&)> m_onConnectHandle;
+    std::function<void(ConnectionHandle, const std::string&)> m_onDisconnectHandle;
+    std::function<void(ConnectionHandle, WEBSOCKET_OPCODE)> m_onMessageBegin;
+    std::function<void(ConnectionHandle, const uint8_t*, size_t)> m_onMessageChunk;
+    std::function<void(ConnectionHandle)> m_onMessageEnd;
     std::function<void(const std::string&, const std::string&)> m_onSecurityViolation;
     std::function<void(const std::string&)> m_onError;
     
     // Server thread
     std::unique_ptr<std::thread> m_serverThread;
     std::atomic<bool> m_shouldStop{false};
+    std::atomic<bool> m_stopAccepting{false};           // Draining or handed off; connections carry on
+    std::vector<std::unique_ptr<Socket>> m_acceptedSockets;   // Reused by every accept batch
+    
+    // Hot restart: listener taken over from a predecessor, and the path a successor takes it from
+    std::unique_ptr<Socket> m_adoptedListener;
+    std::string m_handoffPath;
+    ListenerHandoff m_handoff;                          // Server thread only while running
+    std::function<void()> m_onListenerHandoff;
+    
+    // Client worker threads park here between connections instead of exiting
+    std::vector<ClientConnection*> m_pendingClients;
+    int m_idleWorkers = 0;
+    int m_workerCount = 0;
+    std::mutex m_workerMutex;
+    std::condition_variable m_workerCondition;
+    
+    // Optional handler worker pool (MESSAGE_DISPATCH::WORKER_POOL)
+    MESSAGE_DISPATCH m_dispatchMode = MESSAGE_DISPATCH::INLINE;
+    size_t m_dispatchWorkers = 4;
+    size_t m_dispatchQueueCapacity = 1024;
+    std::unique_ptr<MessageDispatcher> m_dispatcher;
+    
+    // Optional work-stealing executor that serves HTTP requests
+    bool m_useRequestExecutor = false;
+    ExecutorOptions m_requestExecutorOptions;
+    std::unique_ptr<WorkStealingExecutor> m_requestExecutor;
+    
+    // Outgoing data messages larger than this are split into fragments (0 = never)
+    size_t m_fragmentSize = 0;
+    
+    FlowControlOptions m_flowControl;
+    
+    // Thread placement (SetCpuAffinity); empty leaves threads to the scheduler
+    std::vector<int> m_cpuAffinity;
+    std::atomic<uint64_t> m_nextCpu{0};
+    
+    // Handshake negotiation
+    std::vector<std::string> m_subProtocols;
+    std::vector<std::shared_ptr<WebSocketExtension>> m_extensions;
+    
+    // Optional publish/subscribe router
+    bool m_useTopics = false;
+    TopicRouterOptions m_topicOptions;
+    std::unique_ptr<TopicRouter> m_topicRouter;
+    
+    // Instruments are registered in the constructor and never null
+    MetricsRegistry m_metrics;
+    std::string m_metricsPath;                          // Empty: no metrics endpoint
+    Counter* m_acceptedConnections = nullptr;
+    Counter* m_bytesReceived = nullptr;
+    Counter* m_bytesSent = nullptr;
+    Counter* m_framesReceived[16] = {};                 // By opcode; null for reserved opcodes
+    Counter* m_framesSent[16] = {};
+    Counter* m_rejections[static_cast<size_t>(REJECT_REASON::COUNT)] = {};
+    Counter* m_readThrottles = nullptr;                 // Connections that hit a flow-control limit
+    Histogram* m_handshakeLatency = nullptr;            // Accept to handshake response sent
+    Histogram* m_messageHandlerLatency = nullptr;
+    Histogram* m_httpHandlerLatency = nullptr;
 
 public:
     // Constructor
@@ -139,14 +279,134 @@ public:
     
     // Configuration methods
     HttpWsServer& SetPort(uint16_t port);
+    // An IPv4 address, or a Unix socket ("unix:<path>", "/path" or "@name";
+    // the port is then ignored). Unix socket clients are reported as "unix", or
+    // "unix:<path>" when bound, and are only exempt from limits with trustUnixPeers.
     HttpWsServer& SetBindAddress(const std::string& address);
     HttpWsServer& SetSecurityConfig(const SecurityConfig& config);
     
+    /**
+     * @brief Choose where WebSocket message handlers run (takes effect on Start)
+     *
+     * WORKER_POOL hands decoded messages to workerThreads handler threads
+     * through lock-free queues of queueCapacity entries. Each connection is
+     * served by one worker, so its messages are handled and answered in order;
+     * replies travel back to the connection thread, which alone writes to the
+     * socket. A connection whose worker inbox is full, or that is over its
+     * FlowControlOptions limits, stops reading until the worker catches up.
+     */
+    HttpWsServer& SetMessageDispatch(MESSAGE_DISPATCH mode, size_t workerThreads = 4, size_t queueCapacity = 1024);
+    
+    /**
+     * @brief Serve connections from a work-stealing executor (takes effect on Start)
+     *
+     * New connections are queued on the executor instead of being given a
+     * thread. HTTP requests are read, handled and answered on an executor
+     * worker; WebSocket upgrades move to a connection thread once the request
+     * has been read. Connections beyond options.MaxPendingTasks are answered
+     * with 503. Handlers with CPU-heavy work can submit it to
+     * GetRequestExecutor() as well.
+     */
+    HttpWsServer& SetRequestExecutor(const ExecutorOptions& options = ExecutorOptions());
+    
+    /**
+     * @brief Enable topic publish/subscribe (takes effect on Start)
+     *
+     * WebSocket connections can then be subscribed to topic patterns by their
+     * WebSocketMessageWithIP::connection handle, and Publish() fans a message
+     * out to every matching connection. See TopicRouter for pattern syntax.
+     * A connection whose queue of undelivered frames (SubscriberQueueCapacity)
+     * is full misses messages instead of slowing publishers down.
+     */
+    HttpWsServer& EnableTopics(const TopicRouterOptions& options = TopicRouterOptions());
+    
+    /**
+     * @brief Split outgoing data messages into fragments of at most this many bytes
+     *
+     * Applies to replies, SendTo and SendStream. Only whole messages wait for
+     * each other; control frames such as pongs and Close() can go out between
+     * two fragments of a large message. 0 (the default) sends every message as
+     * a single frame.
+     */
+    HttpWsServer& SetFragmentSize(size_t bytes);
+    
+    // Limits on messages queued for the worker pool (see FlowControlOptions)
+    HttpWsServer& SetFlowControl(const FlowControlOptions& options);
+    
+    /**
+     * @brief Run server threads only on these CPUs (takes effect on Start)
+     *
+     * Pass an explicit list or one built from CpuTopology, such as
+     * CpuTopology::System().PhysicalCores(). Each connection thread is pinned
+     * to the CPU its connection's packets arrive on (SO_INCOMING_CPU) when
+     * that CPU is in the list, and otherwise to the next CPU in turn, so the
+     * kernel's receive work, the thread and the buffers it allocates stay on
+     * one core and NUMA node. Handler workers, request executor workers and
+     * topic shards are spread over the list too, unless their own options
+     * name CPUs. An empty list (the default) leaves placement to the scheduler.
+     */
+    HttpWsServer& SetCpuAffinity(const std::vector<int>& cpus);
+    
+    /**
+     * @brief Serve GetMetrics() in Prometheus text format at path
+     *
+     * GET requests for the path are answered by the server itself and never
+     * reach OnHttpRequest. An empty path turns the endpoint off.
+     */
+    HttpWsServer& EnableMetricsEndpoint(const std::string& path = "/metrics");
+    
+    /**
+     * @brief Subprotocols the server speaks (ServerConfig::SubProtocol names one)
+     *
+     * The handshake selects the first protocol in the client's
+     * Sec-WebSocket-Protocol list that appears here and echoes it back. A
+     * client offering none of them still connects, without a subprotocol.
+     */
+    HttpWsServer& SetSubProtocols(const std::vector<std::string>& protocols);
+    
+    /**
+     * @brief Offer an extension to clients (see Extension.h)
+     *
+     * Offers are accepted in the client's order. Every connection gets its
+     * own ExtensionSession, so negotiated parameters and transform state are
+     * per connection. A decoded message is held to the message size limit.
+     */
+    HttpWsServer& AddExtension(std::shared_ptr<WebSocketExtension> extension);
+    
     // Callback registration
     HttpWsServer& OnHttpRequest(const std::function<std::string(const HTTPRequest&)>& callback);
+    // Replies to a message go out with its opcode (TEXT or BINARY)
     HttpWsServer& OnWebSocketMessage(const std::function<std::string(const WebSocketMessageWithIP&)>& callback);
+    
+    /**
+     * @brief Handle TEXT and BINARY messages without copying their payload
+     *
+     * Takes precedence over OnWebSocketMessage. The view borrows the
+     * connection's receive buffer, or a pooled buffer that the message moves
+     * into when handlers run on the worker pool. A non-empty return value is
+     * sent back with the message's opcode.
+     */
+    HttpWsServer& OnWebSocketMessageView(const std::function<std::string(const WebSocketMessageView&)>& callback);
     HttpWsServer& OnConnect(const std::function<void(const std::string&)>& callback);
     HttpWsServer& OnDisconnect(const std::function<void(const std::string&)>& callback);
+    // Handle-aware variants; the handle stops resolving once the disconnect callback runs
+    HttpWsServer& OnConnect(const std::function<void(ConnectionHandle, const std::string&)>& callback);
+    HttpWsServer& OnDisconnect(const std::function<void(ConnectionHandle, const std::string&)>& callback);
+    
+    /**
+     * @brief Receive data messages as a stream instead of whole
+     *
+     * Once any of these is set, TEXT and BINARY messages are no longer
+     * buffered or passed to OnWebSocketMessage. Begin, Chunk and End run on
+     * the connection thread as bytes arrive, with fragments joined into one
+     * message. Chunk data is only valid during the call. With the message size
+     * limit on, a message announced to be too large closes the connection
+     * (1009) before its payload is read. Call Close() from a callback to
+     * reject a message early.
+     */
+    HttpWsServer& OnMessageBegin(const std::function<void(ConnectionHandle, WEBSOCKET_OPCODE)>& callback);
+    HttpWsServer& OnMessageChunk(const std::function<void(ConnectionHandle, const uint8_t*, size_t)>& callback);
+    HttpWsServer& OnMessageEnd(const std::function<void(ConnectionHandle)>& callback);
     HttpWsServer& OnSecurityViolation(const std::function<void(const std::string&, const std::string&)>& callback);
     HttpWsServer& OnError(const std::function<void(const std::string&)>& callback);
     
@@ -154,43 +414,181 @@ public:
     Result Start();
     Result Stop();
     bool IsRunning() const { return m_running; }
+    bool IsAccepting() const { return m_running && !m_stopAccepting; }
+    
+    /**
+     * @brief Stop gracefully: stop accepting, close WebSocket clients with 1001, then Stop()
+     *
+     * The listener is closed first, so new connections are refused (after a
+     * listener handoff the successor accepts them instead). HTTP requests in
+     * progress are answered. Every WebSocket connection, including one whose
+     * handshake completes during the drain, is sent CLOSE 1001 (Going Away)
+     * and has until the deadline to answer it; no data frame is sent after
+     * that close frame. Connections still open at the deadline are closed
+     * abruptly by Stop(). Blocks the caller, which must not be a server
+     * callback.
+     */
+    Result Drain(std::chrono::milliseconds deadline = std::chrono::seconds(10));
+    
+    /**
+     * @brief Hot restart without refusing connections (see ListenerHandoff.h)
+     *
+     * EnableListenerHandoff makes the running server hand its listener to a
+     * successor process that calls ListenerHandoff::Receive(path). From then
+     * on the server no longer accepts, and OnListenerHandoff runs on the
+     * server thread; it should signal another thread to call Drain(). The
+     * successor passes the received socket to AdoptListener, and Start()
+     * serves it instead of binding, so it can EnableListenerHandoff at the
+     * same path for the next upgrade. Both take effect on Start.
+     */
+    HttpWsServer& EnableListenerHandoff(const std::string& path);
+    HttpWsServer& AdoptListener(std::unique_ptr<Socket> listener);
+    HttpWsServer& OnListenerHandoff(const std::function<void()>& callback);
     
     // Server info
     uint16_t GetPort() const { return m_port; }
     std::string GetBindAddress() const { return m_bindAddress; }
     int GetCurrentConnectionCount() const;
     std::vector<std::string> GetConnectedIPs() const;
+    std::vector<ConnectionHandle> GetConnections() const;
+    bool IsConnected(ConnectionHandle connection) const;
+    
+    /**
+     * @brief Send a WebSocket message to one connection from any thread
+     *
+     * The handle is resolved in O(1) through the connection table. Writes are
+     * serialized with the connection's own replies, and the call blocks while
+     * that connection's send buffer is full. Fails with
+     * WEBSOCKET_CONNECTION_CLOSED once the connection is gone or before its
+     * handshake has completed.
+     */
+    Result SendTo(ConnectionHandle connection, const std::string& text);
+    Result SendTo(ConnectionHandle connection, const uint8_t* data, size_t length,
+                  WEBSOCKET_OPCODE opcode = WEBSOCKET_OPCODE::BINARY);
+    
+    // Sends one message whose payload comes from read(buffer, capacity) until
+    // it returns 0. Each read becomes a fragment, so the message never has
+    // to fit in memory.
+    Result SendStream(ConnectionHandle connection, WEBSOCKET_OPCODE opcode,
+                      const std::function<size_t(uint8_t*, size_t)>& read);
+    
+    // Sends a close frame with the given status code (WebSocket connections
+    // only, and only the first close frame) and shuts the socket down; the
+    // connection thread then cleans up
+    Result Close(ConnectionHandle connection, uint16_t code = 1000);
+    MESSAGE_DISPATCH GetMessageDispatch() const { return m_dispatchMode; }
+    MessageDispatcherStats GetDispatchStats() const;
+    WorkStealingExecutor* GetRequestExecutor() const { return m_requestExecutor.get(); }
+    ExecutorStats GetRequestExecutorStats() const;
+    
+    // Publish/subscribe (EnableTopics); false when topics are disabled
+    bool Subscribe(ConnectionHandle connection, const std::string& pattern);
+    bool Unsubscribe(ConnectionHandle connection, const std::string& pattern);
+    bool Publish(const std::string& topic, const std::string& payload);
+    TopicRouter* GetTopicRouter() const { return m_topicRouter.get(); }
+    TopicRouterStats GetTopicStats() const;
+    
+    /**
+     * @brief Per-connection statistics, read without pausing I/O
+     *
+     * Counters come from relaxed atomics and TCP_INFO from one getsockopt per
+     * WebSocket connection, so a connection stuck in a blocking send is
+     * reported, not waited for. GetSlowestConnections walks the table once and
+     * fills in IP and TCP_INFO only for the count it returns.
+     */
+    bool GetConnectionStats(ConnectionHandle connection, ConnectionStats& stats) const;
+    std::vector<ConnectionStats> GetAllConnectionStats(bool includeTcpInfo = false) const;
+    std::vector<ConnectionStats> GetSlowestConnections(size_t count, CONNECTION_ORDER order) const;
+    
+    // Sends a PING carrying its send time; the PONG sets ConnectionStats::RttNs
+    Result Ping(ConnectionHandle connection);
+    
+    /**
+     * @brief Stop and restart reading from a WebSocket connection, from any thread
+     *
+     * A paused connection finishes the data it has already received, then
+     * leaves new data unread so TCP holds the client back. Called from a
+     * message handler this takes effect before the next receive; from another
+     * thread, a receive already waiting for data may complete first. Replies, SendTo and
+     * published frames still go out, and a close by either side is still
+     * noticed. Independent of flow-control throttling: a connection reads
+     * again only once it is resumed and under its limits.
+     */
+    Result PauseRead(ConnectionHandle connection);
+    Result ResumeRead(ConnectionHandle connection);
+    
+    // What the connection's handshake settled on; false once it is gone
+    bool GetNegotiatedProtocol(ConnectionHandle connection, std::string& subProtocol,
+                               std::vector<std::string>& extensions) const;
+    
+    // Memory held for clients against SecurityConfig::maxMemoryBytes
+    MemoryBudgetStats GetMemoryStats() const { return m_memoryBudget.Stats(); }
+    
+    // Server metrics (aiws_*); applications may register their own alongside
+    MetricsRegistry& GetMetrics() { return m_metrics; }
+    MetricsSnapshot GetMetricsSnapshot() const { return m_metrics.Snapshot(); }
     
     // Security management
     void BlockIP(const std::string& ip);
     void UnblockIP(const std::string& ip);
     std::vector<std::string> GetBlockedIPs() const;
     SecurityConfig GetSecurityConfig() const { return m_securityConfig; }
+    
+    // Request parsing (stateless)
+    static HTTPRequest ParseHTTPRequest(std::string_view request, const std::string& clientIP);
 
 private:
     // Internal methods
     void ServerLoop();
+    void DispatchClient(std::unique_ptr<ClientConnection> client);
+    void SubmitClient(std::unique_ptr<ClientConnection> client);
+    void ServeClient(std::unique_ptr<ClientConnection> client);
+    bool ReceiveRequest(ClientConnection* client, std::string_view& request);
+    void ClientWorker(ClientConnection* client);
+    void PlaceConnectionThread(ClientConnection* client);
     void HandleClient(std::unique_ptr<ClientConnection> client);
-    void HandleHTTPRequest(ClientConnection* client, const std::string& request);
-    void HandleWebSocketConnection(ClientConnection* client, const std::string& request);
+    void HandleHTTPRequest(ClientConnection* client, std::string_view request);
+    void HandleWebSocketConnection(ClientConnection* client, std::string_view request);
+    bool HandleMessageData(ClientConnection* client, const FrameStreamDecoder::Event& event, std::vector<uint8_t>& message);
+    bool HandleExtensionData(ClientConnection* client, const FrameStreamDecoder::Event& event, std::vector<uint8_t>& message);
+    bool HandleControlFrame(ClientConnection* client, const FrameStreamDecoder::Event& event);
+    bool ReserveMessageMemory(ClientConnection* client, size_t bytes);
+    void ReleaseMessage(ClientConnection* client, std::vector<uint8_t>& message);
+    bool DeliverMessage(ClientConnection* client, WEBSOCKET_OPCODE opcode, const uint8_t* data, size_t length,
+                        std::vector<uint8_t>* reassembled);
+    bool DispatchWebSocketMessage(ClientConnection* client, WebSocketMessageWithIP&& message, BufferHandle&& payload);
+    bool WaitForDispatchedInput(ClientConnection* client);
+    bool WaitUntilReadAllowed(ClientConnection* client);
+    bool UpdateReadThrottle(ClientConnection* client);
+    void SendDispatchedReplies(ClientConnection* client);
+    void RemoveClient(ClientConnection* client);
+    ClientConnection* PinClient(ConnectionHandle connection) const;
+    static void UnpinClient(ClientConnection* client);
+    static bool IsHandshakeComplete(ClientConnection* client);
+    Result SendFrame(ClientConnection* client, const BufferHandle& frame);
+    Result SendClose(ConnectionHandle connection, uint16_t code, bool shutdown);
+    Result SendDataMessage(ClientConnection* client, WEBSOCKET_OPCODE opcode, const uint8_t* data, size_t length);
     void SendHTTPResponse(ClientConnection* client, const std::string& status, 
                          const std::string& contentType, const std::string& body);
-    void SendHTTPResponseSync(ClientConnection* client, const std::string& status, 
-                             const std::string& contentType, const std::string& body);
+    void CloseHTTPConnection(ClientConnection* client);
     
     // Security methods
     bool IsIPBlocked(const std::string& ip) const;
+    bool IsTrustedClient(const std::string& ip) const;
     bool IsConnectionAllowed(const std::string& ip);
-    bool IsRequestSizeValid(const std::string& request, const std::string& clientIP) const;
-    bool IsMessageSizeValid(const std::string& message, const std::string& clientIP) const;
+    bool IsRequestSizeValid(std::string_view request, const std::string& clientIP) const;
+    bool IsMessageSizeValid(size_t messageSize, const std::string& clientIP) const;
     void UpdateConnectionInfo(const std::string& ip, bool isWebSocket = false);
     void RemoveConnection(const std::string& ip);
     void CleanupStaleConnections();
     
     // Utility methods
     std::string GetClientIP(const Socket& socket);
-    HTTPRequest ParseHTTPRequest(const std::string& request, const std::string& clientIP);
-    bool IsWebSocketUpgrade(const std::string& request) const;
+    bool IsWebSocketUpgrade(std::string_view request) const;
+    void RegisterMetrics();
+    void Reject(REJECT_REASON reason) { m_rejections[static_cast<size_t>(reason)]->Increment(); }
+    void ReadStats(const ClientConnection& client, ConnectionHandle handle, bool tcpInfo, int64_t now,
+                   ConnectionStats& stats) const;
     std::string GenerateHTTPResponse(const std::string& status, const std::string& contentType, const std::string& body);
 };
 
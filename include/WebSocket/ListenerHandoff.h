@@ -0,0 +1,54 @@
+/**
+ * @file ListenerHandoff.h
+ * @brief Passing a listening socket to a new process for hot restarts
+ *
+ * The running server listens on a Unix domain socket at a filesystem path.
+ * Its successor connects to that path and is sent the listening socket with
+ * SCM_RIGHTS, so both processes share one accept queue: connections that
+ * arrive during the upgrade wait in the kernel for whichever process accepts
+ * next and none are refused. The old process then stops accepting and drains
+ * its own connections (HttpWsServer::Drain).
+ *
+ * Only a peer running as the same user is served. Not supported on Windows,
+ * where every call fails with SOCKET_OPTION_NOT_SUPPORTED.
+ */
+
+#pragma once
+
+#include "Socket.h"
+#include <memory>
+#include <string>
+
+namespace WebSocket {
+
+class ListenerHandoff {
+public:
+    ListenerHandoff() = default;
+    ~ListenerHandoff();
+
+    ListenerHandoff(const ListenerHandoff&) = delete;
+    ListenerHandoff& operator=(const ListenerHandoff&) = delete;
+
+    // Serve successors at path; a file left there by an earlier process is replaced
+    Result Listen(const std::string& path);
+
+    // Sends listener to a successor that is already waiting, without blocking.
+    // True once the listener has been handed over; the handoff socket is then
+    // closed so the successor can listen at the same path, and closing the
+    // listener here no longer shuts it down.
+    std::pair<Result, bool> Offer(Socket& listener);
+
+    // Closes the handoff socket and removes its path
+    void Close();
+    bool Valid() const;
+    const std::string& Path() const { return m_path; }
+
+    // Successor side: connect to path and wait up to timeoutMs for the listener
+    static std::pair<Result, std::unique_ptr<Socket>> Receive(const std::string& path, int timeoutMs = 5000);
+
+private:
+    intptr_t m_handle = -1;
+    std::string m_path;
+};
+
+} // namespace WebSocket
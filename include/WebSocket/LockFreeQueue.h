@@ -0,0 +1,359 @@
+/**
+ * @file LockFreeQueue.h
+ * @brief Bounded lock-free ring queues for handing messages between threads
+ *
+ * SpscQueue has one producer and one consumer; MpscQueue accepts any number of
+ * producers and a single consumer, MpmcQueue any number of both. All have a
+ * fixed power-of-two capacity and never allocate after construction. A full queue rejects the push instead of
+ * blocking, so callers decide how to apply backpressure.
+ *
+ * Element types must be default constructible and move assignable; popped
+ * slots are left in their moved-from state until reused.
+ *
+ * WorkStealingDeque is the per-worker deque of a work-stealing scheduler: its
+ * owner pushes and pops at one end while other threads steal from the other.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace WebSocket {
+
+// Keeps producer and consumer indices on separate cache lines
+static const size_t kQueueCacheLineSize = 64;
+
+inline size_t QueueCapacityFor(size_t requested) {
+    size_t capacity = 2;
+    while (capacity < requested) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+/**
+ * @brief Single-producer single-consumer ring queue
+ */
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : m_capacity(QueueCapacityFor(capacity)), m_mask(m_capacity - 1),
+          m_slots(new T[m_capacity]) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer thread only
+    bool TryPush(T&& value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == m_capacity) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == m_capacity) {
+                return false;
+            }
+        }
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool TryPop(T& value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) {
+                return false;
+            }
+        }
+        value = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called while the other side is active
+    size_t SizeApprox() const {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    bool EmptyApprox() const { return SizeApprox() == 0; }
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+
+    alignas(kQueueCacheLineSize) std::atomic<size_t> m_head{0};
+    size_t m_cachedTail = 0;                // Consumer's last view of m_tail
+
+    alignas(kQueueCacheLineSize) std::atomic<size_t> m_tail{0};
+    size_t m_cachedHead = 0;                // Producer's last view of m_head
+};
+
+/**
+ * @brief Multi-producer single-consumer ring queue
+ *
+ * Each slot carries a sequence number (Vyukov's bounded queue): producers claim
+ * a position with a compare-and-swap on the tail and publish the slot by
+ * advancing its sequence, so a slow producer never exposes a half-written
+ * element to the consumer.
+ */
+template <typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity)
+        : m_capacity(QueueCapacityFor(capacity)), m_mask(m_capacity - 1),
+          m_slots(new Slot[m_capacity]) {
+        for (size_t i = 0; i < m_capacity; i++) {
+            m_slots[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread
+    bool TryPush(T&& value) {
+        size_t position = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_slots[position & m_mask];
+            const size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.Value = std::move(value);
+                    slot.Sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;   // Consumer has not freed this slot yet: full
+            } else {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only
+    bool TryPop(T& value) {
+        const size_t position = m_head.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[position & m_mask];
+        if (slot.Sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+        value = std::move(slot.Value);
+        slot.Sequence.store(position + m_capacity, std::memory_order_release);
+        m_head.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer thread only: true when the next slot has not been published
+    bool Empty() const {
+        const size_t position = m_head.load(std::memory_order_relaxed);
+        return m_slots[position & m_mask].Sequence.load(std::memory_order_acquire) != position + 1;
+    }
+
+    size_t SizeApprox() const {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> Sequence{0};
+        T Value{};
+    };
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+
+    alignas(kQueueCacheLineSize) std::atomic<size_t> m_head{0};
+    alignas(kQueueCacheLineSize) std::atomic<size_t> m_tail{0};
+};
+
+/**
+ * @brief Multi-producer multi-consumer ring queue
+ *
+ * The same sequenced slots as MpscQueue, with consumers also claiming
+ * positions by compare-and-swap.
+ */
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(size_t capacity)
+        : m_capacity(QueueCapacityFor(capacity)), m_mask(m_capacity - 1),
+          m_slots(new Slot[m_capacity]) {
+        for (size_t i = 0; i < m_capacity; i++) {
+            m_slots[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    bool TryPush(T&& value) {
+        size_t position = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_slots[position & m_mask];
+            const size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.Value = std::move(value);
+                    slot.Sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPop(T& value) {
+        size_t position = m_head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_slots[position & m_mask];
+            const size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0) {
+                if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(slot.Value);
+                    slot.Sequence.store(position + m_capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;   // Empty
+            } else {
+                position = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t SizeApprox() const {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> Sequence{0};
+        T Value{};
+    };
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+
+    alignas(kQueueCacheLineSize) std::atomic<size_t> m_head{0};
+    alignas(kQueueCacheLineSize) std::atomic<size_t> m_tail{0};
+};
+
+/**
+ * @brief Bounded Chase-Lev work-stealing deque of pointers
+ *
+ * The owning thread pushes and pops at the bottom (LIFO, cache-warm work
+ * first); any thread may steal from the top (FIFO, oldest work first). Only
+ * pointers are stored so a losing thief never observes a torn element.
+ */
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_pointer<T>::value, "WorkStealingDeque stores pointers");
+
+public:
+    explicit WorkStealingDeque(size_t capacity)
+        : m_capacity(static_cast<int64_t>(QueueCapacityFor(capacity))), m_mask(m_capacity - 1),
+          m_slots(new std::atomic<T>[static_cast<size_t>(m_capacity)]) {
+        for (int64_t i = 0; i < m_capacity; i++) {
+            m_slots[static_cast<size_t>(i)].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner thread only
+    bool Push(T value) {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const int64_t top = m_top.load(std::memory_order_acquire);
+        if (bottom - top >= m_capacity) {
+            return false;
+        }
+        Slot(bottom).store(value, std::memory_order_relaxed);
+        m_bottom.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Owner thread only; nullptr when empty or the last element was stolen
+    T Pop() {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T value = Slot(bottom).load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // Last element: race the thieves for it
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                value = nullptr;
+            }
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    // Any thread; nullptr when empty or another thread won the race
+    T Steal() {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+        T value = Slot(top).load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return value;
+    }
+
+    size_t SizeApprox() const {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const int64_t top = m_top.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    size_t Capacity() const { return static_cast<size_t>(m_capacity); }
+
+private:
+    std::atomic<T>& Slot(int64_t index) { return m_slots[static_cast<size_t>(index & m_mask)]; }
+
+    const int64_t m_capacity;
+    const int64_t m_mask;
+    std::unique_ptr<std::atomic<T>[]> m_slots;
+
+    alignas(kQueueCacheLineSize) std::atomic<int64_t> m_top{0};
+    alignas(kQueueCacheLineSize) std::atomic<int64_t> m_bottom{0};
+};
+
+} // namespace WebSocket
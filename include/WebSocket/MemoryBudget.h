@@ -0,0 +1,92 @@
+/**
+ * @file MemoryBudget.h
+ * @brief Server-wide accounting of connection and message memory
+ *
+ * A MemoryBudget counts the bytes a server holds on behalf of its clients:
+ * connection state and receive buffers, messages being reassembled, messages
+ * queued for handler workers and replies queued for sending. Admission points
+ * call TryReserve and turn the connection or message away when the budget is
+ * spent; memory the server already holds is added with Reserve so the usage
+ * stays accurate. A limit of 0 only counts.
+ *
+ * Usage is one atomic shared by every connection, so reservations are made
+ * per connection and per queued or reassembled message, never per frame of a
+ * message that fits in a receive buffer.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace WebSocket {
+
+struct MemoryBudgetStats {
+    size_t Limit = 0;           // 0 = unlimited
+    size_t Used = 0;
+    size_t Peak = 0;            // Highest Used since the budget was created
+    uint64_t Rejected = 0;      // TryReserve calls that would have exceeded the limit
+};
+
+class MemoryBudget {
+public:
+    explicit MemoryBudget(size_t limit = 0) : m_limit(limit) {}
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    // Applies to later reservations; memory already reserved is kept
+    void SetLimit(size_t limit) { m_limit.store(limit, std::memory_order_relaxed); }
+    size_t Limit() const { return m_limit.load(std::memory_order_relaxed); }
+    size_t Used() const { return m_used.load(std::memory_order_relaxed); }
+
+    // Fails, reserving nothing, when the bytes would take usage over the limit
+    bool TryReserve(size_t bytes);
+    // Counts memory that is already allocated, even over the limit
+    void Reserve(size_t bytes);
+    void Release(size_t bytes) { m_used.fetch_sub(bytes, std::memory_order_relaxed); }
+
+    MemoryBudgetStats Stats() const;
+
+private:
+    void UpdatePeak(size_t used);
+
+    std::atomic<size_t> m_limit;
+    std::atomic<size_t> m_used{0};
+    std::atomic<size_t> m_peak{0};
+    std::atomic<uint64_t> m_rejected{0};
+};
+
+/**
+ * @brief Bytes held against a MemoryBudget, released on destruction
+ *
+ * Owned by one thread at a time. The budget must outlive the reservation.
+ */
+class MemoryReservation {
+public:
+    MemoryReservation() = default;
+    explicit MemoryReservation(MemoryBudget* budget) : m_budget(budget) {}
+    ~MemoryReservation() { Reset(); }
+
+    MemoryReservation(MemoryReservation&& other) noexcept : m_budget(other.m_budget), m_bytes(other.m_bytes) {
+        other.m_bytes = 0;
+    }
+    MemoryReservation& operator=(MemoryReservation&& other) noexcept;
+    MemoryReservation(const MemoryReservation&) = delete;
+    MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+    // Without a budget every call succeeds and nothing is counted
+    bool TryGrow(size_t bytes);
+    void Grow(size_t bytes);
+    void Shrink(size_t bytes);
+    void Reset() { Shrink(m_bytes); }
+
+    size_t Bytes() const { return m_bytes; }
+
+private:
+    MemoryBudget* m_budget = nullptr;
+    size_t m_bytes = 0;
+};
+
+} // namespace WebSocket
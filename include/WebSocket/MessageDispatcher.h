@@ -0,0 +1,209 @@
+/**
+ * @file MessageDispatcher.h
+ * @brief Worker pool that runs message handlers off the connection threads
+ *
+ * Connection threads submit decoded messages; each connection is pinned to one
+ * worker so its messages are handled in arrival order. Workers push replies
+ * into the connection's DispatchChannel, whose single consumer is the thread
+ * that owns the socket. All queues are bounded and lock-free; workers only
+ * take a lock to park when their inbox runs dry or a reply queue is full.
+ */
+
+#pragma once
+
+#include "BufferPool.h"
+#include "LockFreeQueue.h"
+#include "MemoryBudget.h"
+#include "Socket.h"
+#include "Types.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace WebSocket {
+
+enum class MESSAGE_DISPATCH {
+    INLINE,         // Handlers run on the connection thread (default)
+    WORKER_POOL     // Handlers run on a MessageDispatcher worker
+};
+
+/**
+ * @brief A handler's reply on its way back to the connection thread
+ */
+struct DispatchedReply {
+    WEBSOCKET_OPCODE Opcode = WEBSOCKET_OPCODE::TEXT;   // Matches the message being answered
+    std::string Data;
+};
+
+/**
+ * @brief Outbound path from other threads back to one connection
+ *
+ * Carries handler replies from the dispatcher worker that owns the connection
+ * (the only producer of replies) and pre-encoded frames from the TopicRouter.
+ * The connection thread is the only consumer. Notify() wakes the connection
+ * thread out of Wait() through an eventfd on Linux; elsewhere Wait() polls the
+ * socket with a short timeout while replies or subscriptions are outstanding.
+ * A worker whose reply does not fit parks in WaitForReplyRoom() until
+ * PopReply() frees a slot.
+ */
+class DispatchChannel {
+public:
+    explicit DispatchChannel(size_t capacity, size_t frameCapacity = 1024, MemoryBudget* budget = nullptr);
+    ~DispatchChannel();
+
+    DispatchChannel(const DispatchChannel&) = delete;
+    DispatchChannel& operator=(const DispatchChannel&) = delete;
+
+    bool Valid() const;
+
+    // Worker side
+    bool PushReply(DispatchedReply&& reply);            // On a full queue the reply is left intact
+    void Notify();
+    // Parks until the connection thread pops a reply, the channel is closed or timeoutMs passes
+    void WaitForReplyRoom(int timeoutMs);
+
+    // Router side (any thread): a complete frame shared with other subscribers
+    bool PushFrame(const BufferHandle& frame);
+
+    // Connection side
+    bool PopReply(DispatchedReply& reply);
+    bool PopFrame(BufferHandle& frame) { return m_frames.TryPop(frame); }
+    std::pair<Result, bool> Wait(const Socket& socket, int timeoutMs);    // true when the socket is readable
+    // As Wait, but data arriving on the socket is left alone; true once it closes
+    std::pair<Result, bool> WaitWithoutReading(const Socket& socket, int timeoutMs);
+    // Waits for Notify() or queued output only; the socket is not watched
+    Result WaitForNotify(int timeoutMs);
+
+    // Replies and frames not yet popped; any thread
+    size_t QueuedApprox() const { return m_replies.SizeApprox() + m_frames.SizeApprox(); }
+
+    // Messages submitted but not yet answered (answered includes empty replies)
+    std::atomic<size_t> Pending{0};
+    std::atomic<size_t> PendingBytes{0};
+
+    // Set while the connection thread has stopped reading for flow control;
+    // workers then Notify() as each message completes, reply or not
+    std::atomic<bool> Throttled{false};
+
+    // Counts queued replies, and PendingBytes, which the connection thread
+    // reserves and the worker releases; may be null
+    MemoryBudget* const Budget;
+
+    // Set by the connection thread once it stops reading replies
+    std::atomic<bool> Closed{false};
+
+    // Topic subscriptions held for this connection
+    std::atomic<size_t> Subscriptions{0};
+
+private:
+    std::pair<Result, bool> WaitFor(const Socket& socket, int timeoutMs, bool readable);
+
+    SpscQueue<DispatchedReply> m_replies;
+    MpscQueue<BufferHandle> m_frames;
+
+    // The worker waiting for a free reply slot, if any
+    std::atomic<bool> m_replyWaiting{false};
+    std::mutex m_roomMutex;
+    std::condition_variable m_roomCondition;
+#ifndef _WIN32
+    int m_wakeFd = -1;
+#endif
+};
+
+/**
+ * @brief A decoded message waiting for a worker
+ */
+struct DispatchedMessage {
+    std::shared_ptr<DispatchChannel> Channel;
+    WebSocketMessageWithIP Message;
+    BufferHandle Payload;           // For view handlers; Message.message.Data stays empty
+    size_t Bytes = 0;               // Payload size, counted in QueuedBytes() until handled
+};
+
+struct MessageDispatcherStats {
+    uint64_t Dispatched = 0;        // Accepted by TrySubmit
+    uint64_t Completed = 0;         // Handler returned (or threw)
+    uint64_t RepliesDropped = 0;    // Connection closed before the reply was delivered
+    uint64_t SubmitRejected = 0;    // Messages that found the worker's inbox full, once each
+    uint64_t AffinityFailures = 0;  // Workers that could not be pinned
+    size_t QueuedBytes = 0;         // Payload bytes submitted and not yet handled
+};
+
+class MessageDispatcher {
+public:
+    using HandlerFn = std::function<std::string(const WebSocketMessageWithIP&)>;
+    using ViewHandlerFn = std::function<std::string(const WebSocketMessageView&)>;
+    using ErrorFn = std::function<void(const std::string&)>;
+
+    // With a view handler, messages carry their data in DispatchedMessage::Payload
+    // and handler is not called
+    MessageDispatcher(size_t workerCount, size_t queueCapacity, HandlerFn handler, ErrorFn onError = ErrorFn(),
+                      ViewHandlerFn viewHandler = ViewHandlerFn());
+    ~MessageDispatcher();
+
+    MessageDispatcher(const MessageDispatcher&) = delete;
+    MessageDispatcher& operator=(const MessageDispatcher&) = delete;
+
+    // Worker i runs on cpus[i % size] (see CpuTopology.h); call before Start
+    void SetCpuAffinity(const std::vector<int>& cpus) { m_cpuAffinity = cpus; }
+
+    Result Start();
+    void Stop();    // Joins the workers; queued messages are discarded
+
+    // Routes by connection id so one connection always lands on the same
+    // worker. On success the message is moved from; on a full inbox it is
+    // left intact for the caller to retry, with retry set so the message is
+    // counted in SubmitRejected once.
+    bool TrySubmit(uint64_t connectionId, DispatchedMessage& message, bool retry = false);
+    // Notifies channel once the connection's worker takes a message from its
+    // inbox. Register before retrying TrySubmit so no freed slot is missed.
+    void NotifyWhenRoom(uint64_t connectionId, const std::shared_ptr<DispatchChannel>& channel);
+
+    size_t WorkerCount() const { return m_workers.size(); }
+    size_t QueueCapacity() const { return m_queueCapacity; }
+    size_t QueuedBytes() const { return m_queuedBytes.load(std::memory_order_relaxed); }
+    MessageDispatcherStats Stats() const;
+
+private:
+    struct Worker {
+        explicit Worker(size_t capacity) : Inbox(capacity) {}
+
+        MpscQueue<DispatchedMessage> Inbox;
+        std::atomic<bool> Sleeping{false};
+        std::mutex ParkMutex;
+        std::condition_variable ParkCondition;
+        std::thread Thread;
+
+        // Connections waiting for a free inbox slot
+        std::atomic<bool> HasRoomWaiters{false};
+        std::mutex RoomMutex;
+        std::vector<std::shared_ptr<DispatchChannel>> RoomWaiters;
+    };
+
+    void WorkerLoop(Worker& worker, int cpu);
+    void WakeRoomWaiters(Worker& worker);
+    void Process(DispatchedMessage& message);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    size_t m_queueCapacity;
+    HandlerFn m_handler;
+    ViewHandlerFn m_viewHandler;
+    ErrorFn m_onError;
+    std::vector<int> m_cpuAffinity;
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_affinityFailures{0};
+
+    std::atomic<uint64_t> m_dispatched{0};
+    std::atomic<uint64_t> m_completed{0};
+    std::atomic<uint64_t> m_repliesDropped{0};
+    std::atomic<uint64_t> m_submitRejected{0};
+    std::atomic<size_t> m_queuedBytes{0};
+};
+
+} // namespace WebSocket
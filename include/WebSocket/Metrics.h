@@ -0,0 +1,223 @@
+/**
+ * @file Metrics.h
+ * @brief Sharded counters and gauges, log-linear latency histograms and a registry
+ *
+ * Every metric keeps kMetricShards cache-line-aligned cells, and each thread
+ * always updates the same cell, so threads recording the same metric never
+ * contend for one cache line. An update is a thread-local lookup plus a
+ * relaxed atomic add, a few nanoseconds. Reading sums the cells, which is
+ * slower but still lock-free.
+ *
+ * Histograms use HDR-style log-linear buckets: values below 16 get a bucket
+ * each, and every power of two above that is split into 16 buckets, so a
+ * reported percentile is within 1/16 (6.25%) of the true value.
+ *
+ * Metrics are created by a MetricsRegistry, which owns them, takes snapshots
+ * and renders the Prometheus text exposition format.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace WebSocket {
+
+static const size_t kMetricShards = 16;
+static const size_t kMetricCacheLineSize = 64;
+
+// Threads are given cells round-robin on their first update
+inline size_t MetricShard() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+    return shard;
+}
+
+enum class METRIC_TYPE {
+    COUNTER,
+    GAUGE,
+    HISTOGRAM
+};
+
+// Monotonic count, exported with a _total suffix by convention
+class Counter {
+public:
+    void Increment(uint64_t amount = 1) {
+        m_cells[MetricShard()].Value.fetch_add(amount, std::memory_order_relaxed);
+    }
+    uint64_t Value() const;
+
+private:
+    struct alignas(kMetricCacheLineSize) Cell {
+        std::atomic<uint64_t> Value{0};
+    };
+    Cell m_cells[kMetricShards];
+};
+
+// Level that moves both ways, such as open connections. Levels owned by
+// another component are better read on demand with AddGaugeCallback.
+class Gauge {
+public:
+    void Add(int64_t amount) {
+        m_cells[MetricShard()].Value.fetch_add(amount, std::memory_order_relaxed);
+    }
+    void Increment() { Add(1); }
+    void Decrement() { Add(-1); }
+    int64_t Value() const;
+
+private:
+    struct alignas(kMetricCacheLineSize) Cell {
+        std::atomic<int64_t> Value{0};
+    };
+    Cell m_cells[kMetricShards];
+};
+
+struct HistogramSnapshot {
+    uint64_t Count = 0;
+    uint64_t Sum = 0;
+    uint64_t Max = 0;
+    std::vector<uint64_t> Buckets;      // Count per Histogram bucket
+
+    double Mean() const { return Count ? static_cast<double>(Sum) / Count : 0.0; }
+    // Upper bound of the bucket holding the given fraction of values, capped at Max
+    uint64_t Percentile(double fraction) const;
+};
+
+// Records unsigned values; latency histograms record nanoseconds
+class Histogram {
+public:
+    static const size_t kSubBucketBits = 4;
+    static const size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static const size_t kMaxExponent = 40;     // Values from 2^41 (about 37 minutes in ns) share the last bucket
+    static const size_t kBuckets = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+    void Record(uint64_t value) {
+        Shard& shard = m_shards[MetricShard() % kHistogramShards];
+        shard.Buckets[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.Sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = shard.Max.load(std::memory_order_relaxed);
+        while (value > max && !shard.Max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    HistogramSnapshot Snapshot() const;
+
+    static size_t BucketFor(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        size_t exponent = HighestBit(value);
+        if (exponent > kMaxExponent) {
+            return kBuckets - 1;
+        }
+        size_t sub = static_cast<size_t>(value >> (exponent - kSubBucketBits)) - kSubBuckets;
+        return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+    }
+    static uint64_t BucketUpperBound(size_t bucket);    // Largest value the bucket holds
+
+private:
+    static size_t HighestBit(uint64_t value) {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanReverse64(&index, value);
+        return index;
+#else
+        return 63 - static_cast<size_t>(__builtin_clzll(value));
+#endif
+    }
+
+    // Fewer cells than counters: each one holds a full set of buckets
+    static const size_t kHistogramShards = 8;
+
+    struct alignas(kMetricCacheLineSize) Shard {
+        std::atomic<uint64_t> Buckets[kBuckets] = {};
+        std::atomic<uint64_t> Sum{0};
+        std::atomic<uint64_t> Max{0};
+    };
+    std::unique_ptr<Shard[]> m_shards{new Shard[kHistogramShards]};
+};
+
+struct MetricSample {
+    std::string Name;
+    std::string Labels;                 // Prometheus label pairs without braces, e.g. opcode="text"
+    std::string Help;
+    METRIC_TYPE Type = METRIC_TYPE::COUNTER;
+    int64_t Value = 0;                  // Counters and gauges
+    HistogramSnapshot Histogram;
+};
+
+struct MetricsSnapshot {
+    std::vector<MetricSample> Samples;
+
+    const MetricSample* Find(const std::string& name, const std::string& labels = "") const;
+    // Counter or gauge value; 0 when there is no such metric
+    int64_t Value(const std::string& name, const std::string& labels = "") const;
+};
+
+/**
+ * @brief Owns named metrics and exports them
+ *
+ * Registration takes a lock; keep the returned pointer and update through it.
+ * Asking again for the same name and labels returns the same metric. The
+ * result is null when the name is not a valid Prometheus name or is already
+ * registered as another type. Metrics live as long as the registry.
+ *
+ * Histograms are exported as Prometheus summaries (quantiles, _sum, _count)
+ * with nanoseconds converted to seconds, so their names should end in
+ * _seconds.
+ */
+class MetricsRegistry {
+public:
+    using GaugeFn = std::function<int64_t()>;
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    Counter* GetCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Gauge* GetGauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    Histogram* GetHistogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    // Gauge whose value comes from read() whenever a snapshot is taken;
+    // registering the same name and labels again replaces the callback
+    bool AddGaugeCallback(const std::string& name, const std::string& help, GaugeFn read,
+                          const std::string& labels = "");
+
+    MetricsSnapshot Snapshot() const;
+    std::string PrometheusText() const;
+
+    static bool IsValidName(const std::string& name);
+
+private:
+    struct Entry {
+        std::string Labels;
+        std::unique_ptr<Counter> CounterMetric;
+        std::unique_ptr<Gauge> GaugeMetric;
+        std::unique_ptr<Histogram> HistogramMetric;
+        GaugeFn Read;
+    };
+
+    struct Family {
+        std::string Help;
+        METRIC_TYPE Type = METRIC_TYPE::COUNTER;
+        std::vector<std::unique_ptr<Entry>> Entries;
+    };
+
+    Entry* FindOrAdd(const std::string& name, const std::string& help, const std::string& labels, METRIC_TYPE type,
+                     bool& added);
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, Family> m_families;   // Sorted by name, so output is stable
+};
+
+} // namespace WebSocket
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "ErrorCodes.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace WebSocket {
+
+/**
+ * @brief Snapshot of a SlabPool's usage
+ */
+struct SlabPoolStats {
+    size_t BlockSize = 0;       // Bytes per block (after alignment)
+    size_t SlabCount = 0;       // Slabs obtained from the heap
+    size_t BlocksInUse = 0;     // Blocks currently handed out
+    size_t BlocksFree = 0;      // Blocks waiting on the free list
+    size_t Allocations = 0;     // Total blocks handed out since construction
+};
+
+/**
+ * @brief Fixed-size block allocator backed by slabs
+ *
+ * Blocks are carved out of slabs of blocksPerSlab blocks and recycled through
+ * an intrusive free list, so steady-state allocate/free cycles never reach the
+ * heap. Slabs are only returned to the system when the pool is destroyed.
+ * All operations are thread-safe.
+ */
+class SlabPool {
+public:
+    explicit SlabPool(size_t blockSize, size_t blocksPerSlab = 64);
+    ~SlabPool() = default;
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    // Returns nullptr if a new slab could not be allocated
+    void* Allocate();
+    void Deallocate(void* block);
+
+    // Pre-allocate slabs so the first `blocks` allocations avoid the heap too
+    Result Reserve(size_t blocks);
+
+    size_t BlockSize() const { return m_blockSize; }
+    SlabPoolStats Stats() const;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    // Caller must hold m_mutex
+    bool AddSlab();
+
+    size_t m_blockSize;
+    size_t m_blocksPerSlab;
+    std::vector<std::unique_ptr<uint8_t[]>> m_slabs;
+    FreeBlock* m_freeList{nullptr};
+    size_t m_freeCount{0};
+    size_t m_inUse{0};
+    size_t m_allocations{0};
+    mutable std::mutex m_mutex;
+};
+
+/**
+ * @brief Typed wrapper around SlabPool
+ *
+ * Acquire() constructs a T in a recycled block, Release() destroys it and hands
+ * the block back to the free list.
+ */
+template <typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(size_t objectsPerSlab = 64)
+        : m_slabs(sizeof(T), objectsPerSlab) {}
+
+    template <typename... Args>
+    T* Acquire(Args&&... args) {
+        void* block = m_slabs.Allocate();
+        if (!block) {
+            return nullptr;
+        }
+        return new (block) T(std::forward<Args>(args)...);
+    }
+
+    void Release(T* object) {
+        if (!object) {
+            return;
+        }
+        object->~T();
+        m_slabs.Deallocate(object);
+    }
+
+    Result Reserve(size_t objects) { return m_slabs.Reserve(objects); }
+    SlabPoolStats Stats() const { return m_slabs.Stats(); }
+
+private:
+    SlabPool m_slabs;
+};
+
+/**
+ * @brief Move-only fixed-size buffer borrowed from a SlabPool
+ *
+ * The block goes back to its pool when the buffer is reset or destroyed.
+ */
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+    explicit PooledBuffer(SlabPool& pool)
+        : m_data(static_cast<uint8_t*>(pool.Allocate())), m_pool(m_data ? &pool : nullptr) {}
+    ~PooledBuffer() { Reset(); }
+
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    PooledBuffer(PooledBuffer&& other) noexcept
+        : m_data(other.m_data), m_pool(other.m_pool) {
+        other.m_data = nullptr;
+        other.m_pool = nullptr;
+    }
+
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            m_data = other.m_data;
+            m_pool = other.m_pool;
+            other.m_data = nullptr;
+            other.m_pool = nullptr;
+        }
+        return *this;
+    }
+
+    void Reset() {
+        if (m_pool) {
+            m_pool->Deallocate(m_data);
+        }
+        m_data = nullptr;
+        m_pool = nullptr;
+    }
+
+    bool Valid() const { return m_data != nullptr; }
+    uint8_t* Data() { return m_data; }
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_pool ? m_pool->BlockSize() : 0; }
+
+private:
+    uint8_t* m_data{nullptr};
+    SlabPool* m_pool{nullptr};
+};
+
+} // namespace WebSocket
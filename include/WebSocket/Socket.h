@@ -2,6 +2,8 @@
 
 #include "ErrorCodes.h"
 #include "Types.h"
+#include "ObjectPool.h"
+#include "BufferPool.h"
 #include <memory>
 #include <string>
 #include <thread>
@@ -27,14 +29,18 @@ namespace WebSocket {
 
 // Type aliases for cleaner code
 using AcceptResult = std::pair<Result, std::unique_ptr<Socket>>;
+using AcceptBatchResult = std::pair<Result, std::vector<std::unique_ptr<Socket>>>;
 using SendResult = std::pair<Result, size_t>;
 using ReceiveResult = std::pair<Result, std::vector<uint8_t>>;
+using ReceiveIntoResult = std::pair<Result, size_t>;
+using BufferReceiveResult = std::pair<Result, BufferHandle>;
 
 /**
  * @brief Cross-platform socket wrapper class
  * 
  * This class provides a platform-independent interface for socket operations.
- * It handles both IPv4 and IPv6, TCP and UDP sockets.
+ * It handles IPv4 and IPv6, TCP and UDP sockets, and Unix domain sockets
+ * for clients on the same host (see IsUnixAddress).
  * Uses C-style I/O and proper error handling without exceptions.
  */
 class Socket {
@@ -50,10 +56,24 @@ public:
 
     // Socket creation and configuration
     Result Create(SOCKET_FAMILY family, SOCKET_TYPE type);
+    // Unix sockets take a path and ignore the port. A socket file left by a
+    // process that died is replaced; to tell, Bind connects to it once, so a
+    // live listener at that path sees a connection that closes at once.
     Result Bind(const std::string& address, uint16_t port);
     Result Listen(int backlog = 128);
     std::pair<Result, std::unique_ptr<Socket>> Accept();
-    Result Connect(const std::string& address, uint16_t port);
+    AcceptBatchResult AcceptBatch(size_t maxConnections = 64, bool nonBlocking = true);
+    Result AcceptBatch(std::vector<std::unique_ptr<Socket>>& accepted, size_t maxConnections = 64, bool nonBlocking = true);
+    Result Connect(const std::string& address, uint16_t port);         // IPv4 or IPv6 literal, or a Unix path
+    Result Connect(const struct sockaddr* address, size_t length);
+
+    // Non-blocking connect: ConnectPending() recognises the "in progress" result, and once
+    // the socket is writable ConnectComplete() reports the outcome (SO_ERROR)
+    static bool ConnectPending(const Result& connectResult);
+    Result ConnectComplete() const;
+
+    // True for a send/receive/accept failure that only means "try again when ready"
+    static bool WouldBlock(const Result& result);
     Result Shutdown();
     Result Close();
 
@@ -66,6 +86,21 @@ public:
     std::pair<Result, std::vector<uint8_t>> Receive(size_t maxLength);
     std::pair<Result, std::vector<uint8_t>> Receive(size_t maxLength, int timeoutMs);
 
+    // Data transmission - caller-owned buffers (no allocation; 0 bytes = peer closed or timed out)
+    ReceiveIntoResult ReceiveInto(void* buffer, size_t bufferSize);
+    ReceiveIntoResult ReceiveInto(void* buffer, size_t bufferSize, int timeoutMs);
+
+    // Data transmission - pooled buffers (see BufferPool; empty handle = peer closed or timed out)
+    Result Send(const BufferHandle& data);
+    BufferReceiveResult ReceivePooled(size_t maxLength);
+    BufferReceiveResult ReceivePooled(size_t maxLength, int timeoutMs);
+
+    // Readiness check without consuming data (timeoutMs = 0 polls)
+    std::pair<Result, bool> WaitReadable(int timeoutMs) const;
+    std::pair<Result, bool> WaitWritable(int timeoutMs) const;
+    // True once the connection failed, was shut down or the peer hung up; reads nothing
+    std::pair<Result, bool> WaitClosed(int timeoutMs) const;
+
     // Socket options
     Result Blocking(bool blocking);
     Result ReuseAddress(bool reuse);
@@ -73,21 +108,76 @@ public:
     Result SendBufferSize(size_t size);
     Result ReceiveBufferSize(size_t size);
 
+    // TCP tuning options - Linux-only options return SOCKET_OPTION_NOT_SUPPORTED elsewhere
+    Result NoDelay(bool noDelay);
+    Result QuickAck(bool quickAck);
+    Result KeepAliveIdle(int seconds);
+    Result KeepAliveInterval(int seconds);
+    Result KeepAliveCount(int count);
+    Result UserTimeout(int milliseconds);
+    Result NotSentLowat(int bytes);
+    Result BusyPoll(int microseconds);
+    Result FastOpen(int queueLength);        // Listening sockets - call before Listen()
+    Result FastOpenConnect(bool enable);     // Client sockets - call before Connect()
+    Result DeferAccept(int seconds);         // Listening sockets
+    Result IncomingCpu(int cpu);
+    Result ReusePort(bool reuse);            // Call before Bind()
+    // SO_REUSEPORT group of groupSize listeners, bound in order: a new
+    // connection goes to listener (receiving CPU % groupSize) (Linux)
+    Result ReusePortCpuGroup(int groupSize);
+
+    // Apply a tuning profile (connection options / listener options); Unix
+    // domain sockets only take the buffer sizes
+    Result ApplyProfile(const SocketProfile& profile);
+    Result ApplyListenerProfile(const SocketProfile& profile);
+
+    // Typed option getters
+    std::pair<Result, bool> KeepAlive() const;
+    std::pair<Result, bool> NoDelay() const;
+    std::pair<Result, bool> QuickAck() const;
+    std::pair<Result, int> KeepAliveIdle() const;
+    std::pair<Result, int> KeepAliveInterval() const;
+    std::pair<Result, int> KeepAliveCount() const;
+    std::pair<Result, int> UserTimeout() const;
+    std::pair<Result, int> NotSentLowat() const;
+    std::pair<Result, int> BusyPoll() const;
+    std::pair<Result, int> FastOpen() const;
+    std::pair<Result, bool> FastOpenConnect() const;
+    std::pair<Result, int> DeferAccept() const;
+    std::pair<Result, int> IncomingCpu() const;
+    std::pair<Result, bool> ReusePort() const;
+    std::pair<Result, int> SendBufferSize() const;
+    std::pair<Result, int> ReceiveBufferSize() const;
+
+    // Kernel RTT, congestion window, retransmits and send queue; safe to call
+    // while another thread is sending or receiving
+    std::pair<Result, TcpInfo> GetTcpInfo() const;
+
     // Getters
     bool Valid() const;
     bool Blocking() const;
-    std::string LocalAddress() const;
-    uint16_t LocalPort() const;
+    intptr_t NativeHandle() const;          // For registering with an external poller
+    std::string LocalAddress() const;       // Unix sockets: the path, "@name" or "" if unnamed
+    uint16_t LocalPort() const;             // 0 for Unix sockets
     std::string RemoteAddress() const;
     uint16_t RemotePort() const;
+    bool IsUnixDomain() const;
 
     // Utility methods
     static bool IsIPAddress(const std::string& address);
     static bool IsIPv4Address(const std::string& address);
     static bool IsIPv6Address(const std::string& address);
+    // "unix:<path>", an absolute path, or "@name" for the Linux abstract
+    // namespace (no file; the name disappears with the last socket)
+    static bool IsUnixAddress(const std::string& address);
     static bool IsPortAvailable(uint16_t port, const std::string& address = "127.0.0.1");
     static std::vector<std::string> GetLocalIPAddresses();
 
+    // Socket objects are carved from a shared slab pool
+    static void* operator new(size_t size);
+    static void operator delete(void* block, size_t size);
+    static SlabPoolStats PoolStats();
+
     // Async I/O methods (high performance)
     Result EnableAsyncIO();
     Result SendAsync(const std::vector<uint8_t>& data);
@@ -110,6 +200,9 @@ public:
     void ErrorCallback(ErrorCallbackFn callback);
 
 private:
+    friend class Connector;
+    friend class ListenerHandoff;
+
     // Platform-specific types (internal only)
     #ifdef _WIN32
     using SOCKET_TYPE_NATIVE = SOCKET;
@@ -125,9 +218,18 @@ private:
     // Factory method for creating sockets from native handles
     static std::unique_ptr<Socket> CreateFromNative(SOCKET_TYPE_NATIVE nativeSocket);
 
+    // Accept one pending connection as a close-on-exec (and optionally non-blocking) handle
+    SOCKET_TYPE_NATIVE AcceptNative(bool nonBlocking);
+
+    Result BindUnix(const std::string& address);
+    Result ConnectUnix(const std::string& address);
+
     SOCKET_TYPE_NATIVE m_socket;
     bool m_isBlocking;
     bool m_isListening{false};
+    bool m_isShared{false};             // Listener handed to another process; Close() must not shut it down
+    bool m_isUnix{false};               // AF_UNIX; accepted sockets inherit it from the listener
+    std::string m_unixPath;             // File created by Bind(), removed again by Close()
     mutable std::mutex m_mutex;
 
     // Static members for automatic socket system management
@@ -143,6 +245,9 @@ private:
     ReceiveCallbackFn m_receiveCallback;
     ErrorCallbackFn m_errorCallback;
     
+    // Reused by HandleReceiveEvent so each event does not allocate
+    std::vector<uint8_t> m_eventReceiveBuffer;
+    
     // Async I/O members
     std::atomic<bool> m_asyncEnabled{false};
 #ifdef _WIN32
@@ -168,10 +273,14 @@ private:
     // Platform-specific helper methods (private)
     Result SetSocketOption(int level, int option, const void* value, size_t length);
     Result GetSocketOption(int level, int option, void* value, size_t* length) const;
+    Result SetIntOption(int level, int option, int value);
+    std::pair<Result, int> GetIntOption(int level, int option) const;
+    std::pair<Result, bool> WaitForEvents(short events, int timeoutMs) const;
     void UpdateLastError();
     std::pair<std::string, uint16_t> GetSocketAddress(const struct sockaddr* addr) const;
     std::pair<Result, std::pair<std::string, uint16_t>> GetSocketAddress() const;
-    static std::string GetAddressString(const struct sockaddr* addr);
+    static std::string GetAddressString(const struct sockaddr* addr, size_t length);
+    static uint16_t GetAddressPort(const struct sockaddr* addr);
 };
 
 } // namespace WebSocket
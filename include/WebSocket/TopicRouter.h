@@ -0,0 +1,183 @@
+/**
+ * @file TopicRouter.h
+ * @brief Publish/subscribe fan-out with a sharded subscription trie
+ *
+ * Topics are '/'-separated paths such as "prices/btc/usd". Subscription
+ * patterns follow MQTT: '+' matches exactly one level and a final '#' matches
+ * any number of levels, including none ("prices/#" matches "prices" and
+ * "prices/btc/usd"; "prices/+/usd" matches "prices/btc/usd").
+ *
+ * Connections are spread over shards by id. Each shard owns the subscription
+ * trie for its connections and a worker thread that matches published topics
+ * against it, so subscribing only ever contends with one shard. Publish()
+ * encodes the WebSocket frame once; every shard receives the same
+ * reference-counted buffer and queues it on each matching connection's
+ * DispatchChannel, waking each connection thread once per batch. The
+ * connection threads remain the only writers to their sockets.
+ */
+
+#pragma once
+
+#include "BufferPool.h"
+#include "ErrorCodes.h"
+#include "LockFreeQueue.h"
+#include "MessageDispatcher.h"
+#include "Types.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace WebSocket {
+
+struct TopicRouterOptions {
+    size_t Shards = 0;                      // 0 uses std::thread::hardware_concurrency()
+    size_t QueueCapacity = 4096;            // Publishes waiting per shard
+    size_t SubscriberQueueCapacity = 1024;  // Frames waiting per connection (HttpWsServer channels)
+    int PublishWaitMs = 50;                 // How long Publish waits on a full shard queue before dropping
+    std::vector<int> CpuAffinity;           // Shard i runs on CpuAffinity[i % size]; empty leaves threads unpinned
+};
+
+struct TopicRouterStats {
+    uint64_t Published = 0;
+    uint64_t Deliveries = 0;        // Frames queued on subscriber channels
+    uint64_t Dropped = 0;           // Subscriber's frame queue was full (slow consumer)
+    uint64_t PublishDropped = 0;    // Shard queue stayed full for PublishWaitMs, once per shard
+    uint64_t Subscribers = 0;       // Registered connections
+    uint64_t Subscriptions = 0;     // Patterns across all connections
+    uint64_t AffinityFailures = 0;  // Shards that could not be pinned
+};
+
+class TopicRouter {
+public:
+    explicit TopicRouter(const TopicRouterOptions& options = TopicRouterOptions());
+    ~TopicRouter();
+
+    TopicRouter(const TopicRouter&) = delete;
+    TopicRouter& operator=(const TopicRouter&) = delete;
+
+    Result Start();
+    void Stop();    // Joins the shard workers; publications still queued are discarded
+
+    // A connection is registered once, before it subscribes; Unregister drops
+    // all of its subscriptions
+    bool Register(uint64_t connectionId, std::shared_ptr<DispatchChannel> channel);
+    void Unregister(uint64_t connectionId);
+
+    // False for an unknown connection or an invalid pattern; subscribing twice
+    // to the same pattern is a no-op that returns true
+    bool Subscribe(uint64_t connectionId, const std::string& pattern);
+    bool Unsubscribe(uint64_t connectionId, const std::string& pattern);
+
+    // Encodes one frame and queues it for every shard with subscribers. A full
+    // shard queue is waited on for up to PublishWaitMs; if its worker has not
+    // freed a slot by then that shard's subscribers miss the message, it is
+    // counted in PublishDropped and Publish returns false after trying the
+    // other shards. A connection whose patterns overlap still gets the message
+    // once. Also false when the router is stopped or the topic contains
+    // wildcards.
+    bool Publish(const std::string& topic, const uint8_t* payload, size_t length,
+                 WEBSOCKET_OPCODE opcode = WEBSOCKET_OPCODE::TEXT);
+    bool Publish(const std::string& topic, const std::string& payload);
+
+    static bool IsValidPattern(const std::string& pattern);
+    static bool IsValidTopic(const std::string& topic);
+    static bool Matches(const std::string& pattern, const std::string& topic);
+
+    bool IsRunning() const { return m_running.load(std::memory_order_acquire); }
+    size_t ShardCount() const { return m_shards.size(); }
+    TopicRouterStats Stats() const;
+
+private:
+    struct Subscriber;
+
+    // Flat array for fast fan-out, with an index for O(1) removal
+    struct SubscriberSet {
+        std::vector<Subscriber*> Members;
+        std::unordered_map<Subscriber*, size_t> Positions;
+
+        bool Add(Subscriber* subscriber);
+        bool Remove(Subscriber* subscriber);
+        bool Empty() const { return Members.empty(); }
+    };
+
+    struct Node {
+        std::map<std::string, std::unique_ptr<Node>, std::less<>> Children;
+        std::unique_ptr<Node> AnyLevel;     // '+'
+        SubscriberSet Exact;                // Patterns ending at this level
+        SubscriberSet Remainder;            // Patterns ending here with '#'
+
+        bool Empty() const;
+    };
+
+    struct Subscriber {
+        std::shared_ptr<DispatchChannel> Channel;
+        std::vector<std::string> Patterns;
+        uint64_t LastPublication = 0;       // Skips a second match of the same publication
+        uint64_t LastBatch = 0;             // Notified once per batch
+    };
+
+    struct Publication {
+        std::string Topic;
+        BufferHandle Frame;
+    };
+    using PublicationPtr = std::shared_ptr<const Publication>;
+
+    struct Shard {
+        explicit Shard(size_t capacity) : Inbox(capacity) {}
+
+        std::mutex Mutex;                   // Guards Root and Subscribers
+        Node Root;
+        std::unordered_map<uint64_t, Subscriber> Subscribers;
+        std::atomic<size_t> Subscriptions{0};
+
+        MpscQueue<PublicationPtr> Inbox;
+        std::atomic<bool> Sleeping{false};
+        std::mutex ParkMutex;
+        std::condition_variable ParkCondition;
+        std::thread Thread;
+
+        // Publishers waiting for the worker to free an inbox slot
+        std::atomic<int> RoomWaiters{0};
+        std::mutex RoomMutex;
+        std::condition_variable RoomCondition;
+
+        // Worker scratch, reused across publications
+        std::vector<std::string_view> Segments;
+        std::vector<Subscriber*> Matched;
+        std::vector<std::shared_ptr<DispatchChannel>> Woken;   // Outlive an Unregister during the wake-up
+        uint64_t PublicationSequence = 0;
+        uint64_t BatchSequence = 0;
+    };
+
+    Shard& ShardFor(uint64_t connectionId) { return *m_shards[connectionId % m_shards.size()]; }
+    void WorkerLoop(Shard& shard, int cpu);
+    bool WaitToPush(Shard& shard, PublicationPtr& item);
+    void Deliver(Shard& shard, const Publication& publication);
+    void Match(Shard& shard, const Node& node, size_t level);
+    static void Collect(Shard& shard, const SubscriberSet& set);
+    static bool RemovePattern(Node& node, const std::vector<std::string_view>& segments, size_t level,
+                              Subscriber* subscriber);
+    static void SplitTopic(std::string_view topic, std::vector<std::string_view>& segments);
+
+    TopicRouterOptions m_options;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<bool> m_running{false};
+
+    std::atomic<uint64_t> m_published{0};
+    std::atomic<uint64_t> m_deliveries{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_publishDropped{0};
+    std::atomic<uint64_t> m_subscribers{0};
+    std::atomic<uint64_t> m_subscriptions{0};
+    std::atomic<uint64_t> m_affinityFailures{0};
+};
+
+} // namespace WebSocket
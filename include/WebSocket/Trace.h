@@ -0,0 +1,282 @@
+/**
+ * @file Trace.h
+ * @brief Binary hot-path tracing into per-thread ring buffers
+ *
+ * Trace points write fixed-size 64-byte TraceRecords (timestamp, event id,
+ * up to three integers and a short text) into a lock-free ring buffer owned by
+ * the calling thread. Nothing is formatted or printed on that thread: a
+ * background drain thread empties the buffers into a binary trace file, an
+ * in-memory log, or stderr. A full buffer drops the record and counts it, so
+ * tracing never blocks I/O.
+ *
+ * Levels are filtered twice. Trace points above AIWEBSOCKETS_TRACE_LEVEL
+ * (CMake cache variable, default 3 = INFO) are compiled out entirely. The
+ * rest cost one relaxed load while the tracer is stopped, and are recorded
+ * once Tracer::Start() runs with a level that admits them.
+ *
+ *   WS_TRACE_INFO("server", "client_connected", "{s} connected, {} open", ip, count);
+ *   WS_TRACE_SCOPE("server", "handle_message");    // BEGIN/END span for Chrome traces
+ *
+ * Formats are rendered when the trace is decoded: "{}" prints the next
+ * integer argument, "{d}" prints it as signed, and "{s}" prints the text,
+ * truncated to TraceRecord::kTextSize - 1 bytes. TraceLog reads trace files
+ * back and exports Chrome trace JSON, which Perfetto also opens
+ * (examples/trace_decode.cpp wraps both).
+ */
+
+#pragma once
+
+#include "ErrorCodes.h"
+#include "LockFreeQueue.h"
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifndef AIWEBSOCKETS_TRACE_LEVEL
+#define AIWEBSOCKETS_TRACE_LEVEL 3
+#endif
+
+namespace WebSocket {
+
+enum class TRACE_LEVEL : uint8_t {
+    OFF = 0,
+    ERR = 1,        // Not ERROR, which <windows.h> defines as a macro
+    WARN = 2,
+    INFO = 3,
+    VERBOSE = 4     // Per-operation detail; compiled out by default
+};
+
+enum class TRACE_PHASE : uint8_t {
+    INSTANT,
+    BEGIN,
+    END
+};
+
+struct TraceRecord {
+    static const size_t kArgs = 3;
+    static const size_t kTextSize = 24;
+
+    uint64_t Timestamp = 0;         // Nanoseconds since the tracer's epoch
+    uint16_t Event = 0;             // Index into the event table; 0 is unused
+    TRACE_PHASE Phase = TRACE_PHASE::INSTANT;
+    uint8_t ArgCount = 0;
+    uint32_t Thread = 0;            // Assigned per thread by the tracer, from 1
+    uint64_t Args[kArgs] = {};
+    char Text[kTextSize] = {};      // NUL-terminated
+};
+static_assert(sizeof(TraceRecord) == 64, "TraceRecord must stay one cache line");
+
+struct TraceEventInfo {
+    TRACE_LEVEL Level = TRACE_LEVEL::INFO;
+    std::string Category;
+    std::string Name;
+    std::string Format;
+};
+
+/**
+ * @brief Event table and records, from a trace file or Tracer::Snapshot()
+ */
+struct TraceLog {
+    int64_t WallClockEpochNs = 0;           // System time at timestamp 0
+    std::vector<TraceEventInfo> Events;     // Indexed by TraceRecord::Event
+    std::vector<TraceRecord> Records;       // In the order they were drained
+
+    const TraceEventInfo* Event(uint16_t id) const;
+    std::string Message(const TraceRecord& record) const;      // Format with the arguments filled in
+    std::string Format(const TraceRecord& record) const;       // "+12.345678ms T3 INFO server/name: message"
+    std::string ToChromeTraceJson() const;
+
+    static Result ReadFile(const std::string& path, TraceLog& log);
+};
+
+struct TraceOptions {
+    TRACE_LEVEL Level = TRACE_LEVEL::INFO;  // Capped at AIWEBSOCKETS_TRACE_LEVEL
+    std::string Path;                       // Binary trace file; empty keeps records in memory
+    size_t ThreadBufferRecords = 1024;      // Per thread; a full buffer drops records
+    size_t MaxMemoryRecords = 65536;        // In-memory log keeps the newest this many
+    bool Echo = false;                      // Drain thread also prints records to stderr
+    std::chrono::milliseconds DrainInterval{10};
+};
+
+struct TraceStats {
+    uint64_t Drained = 0;
+    uint64_t Dropped = 0;           // Thread buffer was full
+    uint64_t Threads = 0;           // Buffers handed out
+};
+
+// One per trace point; registered in the event table on its first use
+struct TraceSite {
+    TRACE_LEVEL Level;
+    const char* Category;
+    const char* Name;
+    std::atomic<uint16_t> Id{0};
+};
+
+class Tracer {
+public:
+    static Tracer& Instance();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    Result Start(const TraceOptions& options = TraceOptions());
+    void Stop();        // Drains what has been recorded so far and closes the file
+    void Flush();       // Drains now instead of waiting for the next interval
+
+    // Records drained to memory so far; empty when tracing to a file
+    TraceLog Snapshot() const;
+    TraceStats Stats() const;
+
+    static bool IsEnabled(TRACE_LEVEL level) {
+        return s_level.load(std::memory_order_relaxed) >= static_cast<int>(level);
+    }
+
+    template <typename... Args>
+    static void Emit(TraceSite& site, TRACE_PHASE phase, const char* format, const Args&... args) {
+        TraceRecord record;
+        record.Event = site.Id.load(std::memory_order_acquire);
+        if (record.Event == 0) {
+            record.Event = Instance().RegisterSite(site, format);
+        }
+        record.Phase = phase;
+        Pack(record, args...);
+        Instance().Write(record);
+    }
+
+private:
+    struct ThreadBuffer;
+    struct BufferLease;
+
+    Tracer();
+
+    uint16_t RegisterSite(TraceSite& site, const char* format);
+    void Write(TraceRecord& record);
+    ThreadBuffer* AcquireBuffer();
+    void DrainLoop();
+    void Drain();
+    void WriteFileChunks(const std::vector<TraceRecord>& records);
+
+    static void Pack(TraceRecord&) {}
+
+    template <typename T, typename... Rest>
+    static void Pack(TraceRecord& record, const T& value, const Rest&... rest) {
+        PackOne(record, value);
+        Pack(record, rest...);
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+    PackOne(TraceRecord& record, const T& value) {
+        if (record.ArgCount < TraceRecord::kArgs) {
+            record.Args[record.ArgCount++] = static_cast<uint64_t>(value);
+        }
+    }
+
+    static void PackOne(TraceRecord& record, std::string_view text) {
+        size_t length = std::min(text.size(), TraceRecord::kTextSize - 1);
+        memcpy(record.Text, text.data(), length);
+        record.Text[length] = '\0';
+    }
+    static void PackOne(TraceRecord& record, const std::string& text) { PackOne(record, std::string_view(text)); }
+    static void PackOne(TraceRecord& record, const char* text) { PackOne(record, std::string_view(text ? text : "")); }
+
+    static std::atomic<int> s_level;
+
+    mutable std::mutex m_mutex;                         // Guards everything below but the counters
+    TraceOptions m_options;
+    std::chrono::steady_clock::time_point m_epoch;
+    int64_t m_wallClockEpochNs = 0;
+    std::vector<TraceEventInfo> m_events;
+    size_t m_eventsWritten = 1;                         // Event definitions already in the file
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::vector<ThreadBuffer*> m_freeBuffers;           // Drained buffers of exited threads
+    std::vector<TraceRecord> m_memory;                  // Ring of the newest MaxMemoryRecords
+    size_t m_memoryNext = 0;
+    FILE* m_file = nullptr;
+
+    std::mutex m_drainMutex;                            // One drain at a time
+    std::vector<TraceRecord> m_batch;
+    std::thread m_drainThread;
+    bool m_running = false;
+    std::condition_variable m_wake;
+
+    std::atomic<uint32_t> m_nextThread{1};
+    std::atomic<uint64_t> m_drained{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+// BEGIN on construction, END on destruction
+class TraceScope {
+public:
+    explicit TraceScope(TraceSite& site) : m_site(Tracer::IsEnabled(site.Level) ? &site : nullptr) {
+        if (m_site) {
+            Tracer::Emit(*m_site, TRACE_PHASE::BEGIN, "");
+        }
+    }
+    ~TraceScope() {
+        if (m_site) {
+            Tracer::Emit(*m_site, TRACE_PHASE::END, "");
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceSite* m_site;
+};
+
+} // namespace WebSocket
+
+#define WS_TRACE_CONCAT_INNER(a, b) a##b
+#define WS_TRACE_CONCAT(a, b) WS_TRACE_CONCAT_INNER(a, b)
+
+// The format is the first variadic argument, so trace points without
+// arguments stay valid ISO C++
+#define WS_TRACE_EVENT(level, category, name, ...)                                              \
+    do {                                                                                        \
+        if (::WebSocket::Tracer::IsEnabled(level)) {                                            \
+            static ::WebSocket::TraceSite wsTraceSite{level, category, name};                   \
+            ::WebSocket::Tracer::Emit(wsTraceSite, ::WebSocket::TRACE_PHASE::INSTANT, __VA_ARGS__); \
+        }                                                                                       \
+    } while (0)
+
+#if AIWEBSOCKETS_TRACE_LEVEL >= 1
+#define WS_TRACE_ERROR(category, name, ...) WS_TRACE_EVENT(::WebSocket::TRACE_LEVEL::ERR, category, name, __VA_ARGS__)
+#else
+#define WS_TRACE_ERROR(category, name, ...) do {} while (0)
+#endif
+
+#if AIWEBSOCKETS_TRACE_LEVEL >= 2
+#define WS_TRACE_WARN(category, name, ...) WS_TRACE_EVENT(::WebSocket::TRACE_LEVEL::WARN, category, name, __VA_ARGS__)
+#else
+#define WS_TRACE_WARN(category, name, ...) do {} while (0)
+#endif
+
+#if AIWEBSOCKETS_TRACE_LEVEL >= 3
+#define WS_TRACE_INFO(category, name, ...) WS_TRACE_EVENT(::WebSocket::TRACE_LEVEL::INFO, category, name, __VA_ARGS__)
+#else
+#define WS_TRACE_INFO(category, name, ...) do {} while (0)
+#endif
+
+#if AIWEBSOCKETS_TRACE_LEVEL >= 4
+#define WS_TRACE_VERBOSE(category, name, ...) WS_TRACE_EVENT(::WebSocket::TRACE_LEVEL::VERBOSE, category, name, __VA_ARGS__)
+#define WS_TRACE_SCOPE(category, name)                                                          \
+    static ::WebSocket::TraceSite WS_TRACE_CONCAT(wsTraceScopeSite, __LINE__){                  \
+        ::WebSocket::TRACE_LEVEL::VERBOSE, category, name};                                       \
+    ::WebSocket::TraceScope WS_TRACE_CONCAT(wsTraceScope, __LINE__)(WS_TRACE_CONCAT(wsTraceScopeSite, __LINE__))
+#else
+#define WS_TRACE_VERBOSE(category, name, ...) do {} while (0)
+#define WS_TRACE_SCOPE(category, name) do {} while (0)
+#endif
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>
 #include <functional>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <memory>
 #include "ErrorCodes.h"
@@ -21,7 +23,8 @@ enum class SOCKET_TYPE {
 
 enum class SOCKET_FAMILY {
     IPV4,
-    IPV6
+    IPV6,
+    UNIX        // Unix domain stream/datagram socket (not supported on Windows)
 };
 
 enum class WEBSOCKET_OPCODE {
@@ -49,7 +52,7 @@ struct WebSocketFrame {
     WEBSOCKET_OPCODE Opcode;
     bool Masked;
     uint64_t PayloadLength;
-    std::vector<uint8_t> MaskingKey;
+    std::array<uint8_t, 4> MaskingKey{};   // All zero: GenerateFrame picks a random key
     std::vector<uint8_t> PayloadData;
 };
 
@@ -68,12 +71,110 @@ struct WebSocketMessage {
     }
 };
 
+/**
+ * @brief Identifies one server connection for as long as it stays open
+ *
+ * Index addresses a slot in the server's connection table and Generation
+ * changes whenever that slot is reused, so a handle kept after its connection
+ * closed never reaches a newer one. Default-constructed handles are invalid.
+ */
+struct ConnectionHandle {
+    uint32_t Index = 0;
+    uint32_t Generation = 0;
+    
+    bool Valid() const { return Generation != 0; }
+    uint64_t Value() const { return (static_cast<uint64_t>(Generation) << 32) | Index; }
+    static ConnectionHandle FromValue(uint64_t value) {
+        return ConnectionHandle{static_cast<uint32_t>(value), static_cast<uint32_t>(value >> 32)};
+    }
+    
+    bool operator==(const ConnectionHandle& other) const { return Value() == other.Value(); }
+    bool operator!=(const ConnectionHandle& other) const { return Value() != other.Value(); }
+    bool operator<(const ConnectionHandle& other) const { return Value() < other.Value(); }
+};
+
+/**
+ * @brief WebSocket message with client IP information
+ */
+struct WebSocketMessageWithIP {
+    WebSocketMessage message;
+    std::string clientIP;
+    WEBSOCKET_OPCODE opcode;
+    ConnectionHandle connection;    // For HttpWsServer::SendTo/Close/Subscribe
+};
+
+/**
+ * @brief A received message whose payload is borrowed, not copied
+ *
+ * Data points into the connection's receive buffer, or into a pooled buffer
+ * when handlers run on the worker pool. It is only valid while the handler
+ * runs; call ToMessage() to keep a copy.
+ */
+struct WebSocketMessageView {
+    WEBSOCKET_OPCODE Opcode = WEBSOCKET_OPCODE::TEXT;
+    const uint8_t* Data = nullptr;
+    size_t Size = 0;
+    ConnectionHandle Connection;
+    std::string_view ClientIP;
+    
+    bool IsText() const { return Opcode == WEBSOCKET_OPCODE::TEXT; }
+    bool IsBinary() const { return Opcode == WEBSOCKET_OPCODE::BINARY; }
+    std::string_view Text() const { return std::string_view(reinterpret_cast<const char*>(Data), Size); }
+    WebSocketMessage ToMessage() const { return WebSocketMessage{Opcode, std::vector<uint8_t>(Data, Data + Size)}; }
+};
+
 // Callback types
 using ConnectionCallback = std::function<void(std::shared_ptr<WebSocketConnection>)>;
 using MessageCallback = std::function<void(std::shared_ptr<WebSocketConnection>, const WebSocketMessage&)>;
 using CloseCallback = std::function<void(std::shared_ptr<WebSocketConnection>, uint16_t code, const std::string& reason)>;
 using ErrorCallback = std::function<void(std::shared_ptr<WebSocketConnection>, const Result& result)>;
 
+/**
+ * @brief Socket tuning profile applied by the servers
+ *
+ * Connection options are applied to every accepted socket, listener options
+ * to the listening socket before Listen(). Integer fields left at -1 and
+ * boolean fields left at false keep the operating system default.
+ */
+struct SocketProfile {
+    // Connection options
+    bool NoDelay = false;                   // TCP_NODELAY - disable Nagle
+    bool QuickAck = false;                  // TCP_QUICKACK - disable delayed ACKs (Linux)
+    bool KeepAlive = false;                 // SO_KEEPALIVE
+    int KeepAliveIdleSeconds = -1;          // TCP_KEEPIDLE
+    int KeepAliveIntervalSeconds = -1;      // TCP_KEEPINTVL
+    int KeepAliveCount = -1;                // TCP_KEEPCNT
+    int UserTimeoutMs = -1;                 // TCP_USER_TIMEOUT (Linux)
+    int NotSentLowatBytes = -1;             // TCP_NOTSENT_LOWAT
+    int BusyPollMicroseconds = -1;          // SO_BUSY_POLL (Linux)
+    int SendBufferSize = -1;                // SO_SNDBUF
+    int ReceiveBufferSize = -1;             // SO_RCVBUF
+    bool FastOpenConnect = false;           // TCP_FASTOPEN_CONNECT - client sockets (Linux)
+
+    // Listener options
+    bool ReusePort = false;                 // SO_REUSEPORT
+    int FastOpenQueueLength = -1;           // TCP_FASTOPEN - pending TFO requests
+    int DeferAcceptSeconds = -1;            // TCP_DEFER_ACCEPT (Linux)
+    int IncomingCpu = -1;                   // SO_INCOMING_CPU (Linux)
+    int ReusePortCpuGroup = -1;             // SO_ATTACH_REUSEPORT_CBPF: steer by CPU across this many listeners (Linux)
+};
+
+/**
+ * @brief Kernel view of a TCP connection (Socket::GetTcpInfo)
+ *
+ * Filled from TCP_INFO on Linux and TCP_CONNECTION_INFO on macOS. Fields
+ * the platform does not report stay 0.
+ */
+struct TcpInfo {
+    uint32_t RttUs = 0;                     // Smoothed round-trip time
+    uint32_t RttVarUs = 0;
+    uint32_t CongestionWindow = 0;          // In segments
+    uint32_t Unacked = 0;                   // Segments sent but not yet acknowledged
+    uint32_t Lost = 0;                      // Segments currently presumed lost
+    uint32_t TotalRetransmits = 0;          // Segments retransmitted over the connection's life
+    uint32_t SendQueueBytes = 0;            // Written by the application, not yet acknowledged
+};
+
 // Configuration structs
 struct ServerConfig {
     uint16_t Port = 8080;
@@ -96,4 +197,25 @@ struct HandshakeInfo {
     std::vector<std::pair<std::string, std::string>> Headers;
 };
 
+// Allocation-free counterpart of HandshakeInfo; every field points into the request text.
+// A repeated header keeps its last value.
+struct HandshakeRequestView {
+    std::string_view Path;
+    std::string_view Host;
+    std::string_view Origin;
+    std::string_view Key;
+    std::string_view Version;
+    std::string_view Protocols;     // Raw comma-separated list
+    std::string_view Extensions;    // Raw comma-separated list
+};
+
 } // namespace WebSocket
+
+namespace std {
+template <>
+struct hash<WebSocket::ConnectionHandle> {
+    size_t operator()(const WebSocket::ConnectionHandle& handle) const {
+        return hash<uint64_t>()(handle.Value());
+    }
+};
+} // namespace std
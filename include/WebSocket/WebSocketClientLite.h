@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Socket.h"
+#include <deque>
 #include <memory>
 #include <functional>
 #include <string>
@@ -12,10 +13,25 @@ private:
     std::unique_ptr<Socket> m_socket;
     std::string m_serverHost;
     uint16_t m_serverPort;
+    std::string m_path{"/"};
     bool m_connected;
-    
+    size_t m_maxMessageSize{16 * 1024 * 1024};
+
+    // Incremental receive state: unparsed bytes live in m_receiveBuffer[m_receiveStart, m_receiveEnd)
+    std::vector<uint8_t> m_receiveBuffer;
+    size_t m_receiveStart{0};
+    size_t m_receiveEnd{0};
+    std::vector<uint8_t> m_fragments;              // Reassembled payload of a fragmented message
+    WEBSOCKET_OPCODE m_fragmentOpcode{WEBSOCKET_OPCODE::CONTINUATION};
+    std::deque<WebSocketMessage> m_inbox;          // Complete messages not yet delivered
+
+    // Send state: frames are built (and masked) here, capacity is reused
+    std::vector<uint8_t> m_sendBuffer;
+    uint64_t m_maskState;                          // xorshift64* PRNG for masking keys
+
     // Callbacks
     std::function<void(const std::string&)> m_onMessage;
+    std::function<void(const std::vector<uint8_t>&)> m_onBinary;
     std::function<void()> m_onConnect;
     std::function<void()> m_onDisconnect;
     std::function<void(const Result&)> m_onError;
@@ -23,41 +39,55 @@ private:
 public:
     // Constructor
     WebSocketClientLite(const std::string& host = "127.0.0.1", uint16_t port = 8080);
-    
+
     // Destructor
     ~WebSocketClientLite();
-    
-    // Configuration
+
+    // Configuration; host may be a Unix socket path ("unix:<path>", "/path" or "@name")
     WebSocketClientLite& SetServer(const std::string& host, uint16_t port);
-    
-    // Callback registration
+    WebSocketClientLite& SetPath(const std::string& path);
+    WebSocketClientLite& SetMaxMessageSize(size_t maxMessageSize);
+
+    // Callback registration (binary messages go to OnMessage when no OnBinary handler is set)
     WebSocketClientLite& OnMessage(const std::function<void(const std::string&)>& callback);
+    WebSocketClientLite& OnBinary(const std::function<void(const std::vector<uint8_t>&)>& callback);
     WebSocketClientLite& OnConnect(const std::function<void()>& callback);
     WebSocketClientLite& OnDisconnect(const std::function<void()>& callback);
     WebSocketClientLite& OnError(const std::function<void(const Result&)>& callback);
-    
+
     // Connection control
     Result Connect();
     Result Disconnect();
     bool IsConnected() const { return m_connected; }
-    
-    // Message sending
+
+    // Message sending (frames are masked as RFC 6455 requires of clients)
     Result SendMessage(const std::string& message);
     Result SendBinary(const std::vector<uint8_t>& data);
-    
-    // Message receiving (blocking)
-    std::pair<Result, std::string> ReceiveMessage();
-    
+    Result SendPing(const std::vector<uint8_t>& data = {});
+    Result SendFrame(WEBSOCKET_OPCODE opcode, const uint8_t* data, size_t length, bool fin = true);
+
+    // Message receiving (blocking; timeoutMs < 0 waits indefinitely). Returns the next
+    // complete text or binary message; an empty message with success means timeout.
+    std::pair<Result, std::string> ReceiveMessage(int timeoutMs = -1);
+    std::pair<Result, WebSocketMessage> ReceiveFrame(int timeoutMs = -1);
+
     // Message receiving (non-blocking)
     void ProcessMessages(); // Call this regularly to receive messages
-    
+
     // Get connection info
     std::string GetServerHost() const { return m_serverHost; }
     uint16_t GetServerPort() const { return m_serverPort; }
 
 private:
     Result PerformWebSocketHandshake();
-    Result SendWebSocketFrame(const std::vector<uint8_t>& data, int opcode);
+    Result SendAll(const uint8_t* data, size_t length);
+    Result ReadFrames(int timeoutMs, size_t& bytesRead);
+    void ReserveReceiveSpace(size_t space);
+    Result ParseFrames();
+    Result HandleControlFrame(const WebSocketFrame& frame, uint8_t* payload, size_t length);
+    void ResetReceiveState();
+    void HandleConnectionLost(const Result& error);
+    uint32_t NextMask();
 };
 
 } // namespace WebSocket
@@ -2,8 +2,10 @@
 
 #include "Types.h"
 #include "ErrorCodes.h"
+#include "BufferPool.h"
 #include <vector>
 #include <string>
+#include <string_view>
 
 namespace WebSocket {
 
@@ -20,15 +22,50 @@ public:
     static Result ValidateHandshakeRequest(const std::string& request, HandshakeInfo& info);
     static std::string GenerateHandshakeResponse(const HandshakeInfo& info);
     static std::string GenerateWebSocketKey(const std::string& clientKey);
+    static std::string GenerateClientKey();
+    static std::string GenerateHandshakeRequest(const std::string& host, uint16_t port, const std::string& path,
+                                                const std::string& clientKey);
+    static Result ValidateHandshakeResponse(const std::string& response, const std::string& clientKey);
+    
+    // Allocation-free server handshake: one pass over the request, the accept key hashed
+    // without building key + GUID, and the 101 response written into a caller buffer
+    static const size_t kAcceptKeySize = 28;
+    static const size_t kHandshakeResponseSize = 512;   // Room for a subprotocol and ~300 bytes of extensions
+    static Result ParseHandshakeRequest(std::string_view request, HandshakeRequestView& view);
+    // Upgrade detection only: Upgrade lists websocket, Connection lists upgrade and a key is
+    // present. ParseHandshakeRequest validates the rest, so a bad handshake still gets a 400
+    static bool IsUpgradeRequest(std::string_view request);
+    static void ComputeAcceptKey(std::string_view clientKey, char* out);   // Writes kAcceptKeySize chars
+    static size_t HandshakeResponseSize(size_t protocolLength, size_t extensionsLength = 0);
+    // Empty protocol/extensions omit their headers. Returns the response length, or 0 when capacity is too small
+    static size_t WriteHandshakeResponse(std::string_view clientKey, std::string_view protocol, std::string_view extensions,
+                                         char* out, size_t capacity);
     
     // Subprotocol negotiation
     static std::string NegotiateSubProtocol(const std::vector<std::string>& clientProtocols, 
                                           const std::vector<std::string>& serverProtocols);
+    // Same rule on a raw Sec-WebSocket-Protocol list; the result points into offered
+    static std::string_view SelectSubProtocol(std::string_view offered, const std::vector<std::string>& supported);
     
     // Frame parsing methods
     static Result ParseFrame(const std::vector<uint8_t>& data, WebSocketFrame& frame, size_t& bytesConsumed);
+    static Result ParseFrame(const uint8_t* data, size_t length, WebSocketFrame& frame, size_t& bytesConsumed);
     static std::vector<uint8_t> GenerateFrame(const WebSocketFrame& frame);
     
+    // Pooled variants: the payload is unmasked into / the frame is written into a BufferHandle
+    // (frame.PayloadData is left empty by the parser)
+    static Result ParseFrame(const uint8_t* data, size_t length, WebSocketFrame& frame, size_t& bytesConsumed, BufferHandle& payload);
+    static BufferHandle GenerateFrame(WEBSOCKET_OPCODE opcode, const uint8_t* payload, size_t length, bool fin = true,
+                                      uint8_t rsv = 0);
+    static size_t FrameHeaderSize(uint64_t payloadLength, bool masked);
+    
+    // Incremental parsing: decodes only the header; offset receives the header size.
+    // Fails with WEBSOCKET_FRAME_PARSE_FAILED while the header is still incomplete.
+    static Result ParseFrameHeader(const uint8_t* data, size_t length, WebSocketFrame& frame, size_t& offset);
+    
+    // XOR payload bytes with a masking key; maskOffset is the payload position of data[0]
+    static void ApplyMask(uint8_t* data, size_t length, const uint8_t* mask, size_t maskOffset = 0);
+    
     // Message utilities
     static WebSocketFrame CreateTextFrame(const std::string& text, bool fin = true);
     static WebSocketFrame CreateBinaryFrame(const std::vector<uint8_t>& data, bool fin = true);
@@ -40,10 +77,84 @@ public:
     static bool IsValidOpcode(WEBSOCKET_OPCODE opcode);
     static bool IsValidUTF8(const std::vector<uint8_t>& data);
     
+    // Raw 20-byte digest from the portable SHA-1; on Linux the accept key uses libcrypto instead
+    static std::string SHA1Hash(const std::string& input);
+    
 private:
     static std::string Base64Encode(const std::vector<uint8_t>& data);
+    static size_t Base64Encode(const uint8_t* data, size_t length, char* out);     // Writes 4 * ceil(length / 3) chars
     static std::vector<uint8_t> Base64Decode(const std::string& data);
-    static std::string SHA1Hash(const std::string& input);
+};
+
+enum class STREAM_EVENT {
+    NEED_MORE,      // The next header, payload bytes or control frame have not arrived yet
+    DATA,           // A piece of a TEXT/BINARY message
+    CONTROL         // A complete CLOSE/PING/PONG frame
+};
+
+/**
+ * @brief Incremental decoder for the frames a peer sends over one connection
+ *
+ * Next() works on whatever bytes the socket has returned so far and reports
+ * one event at a time. Data payloads are unmasked in place and handed out as
+ * they arrive, so a message of any size streams through a fixed receive
+ * buffer. Fragmented messages come out as one logical message, with control
+ * frames allowed between the fragments. Only an incomplete header or control
+ * frame (kMaxCarry bytes at most) is left unconsumed for the caller to keep
+ * in front of the next receive.
+ *
+ * A message that would exceed the size limit fails with
+ * WEBSOCKET_PAYLOAD_TOO_LARGE as soon as the frame header announcing it is
+ * decoded, before any of that frame's payload is delivered.
+ */
+class FrameStreamDecoder {
+public:
+    static const size_t kMaxCarry = 14 + 125;   // Largest header plus largest control payload
+
+    struct Event {
+        STREAM_EVENT Type = STREAM_EVENT::NEED_MORE;
+        WEBSOCKET_OPCODE Opcode = WEBSOCKET_OPCODE::TEXT;   // Message opcode for DATA, frame opcode for CONTROL
+        const uint8_t* Data = nullptr;                      // Points into the caller's buffer
+        size_t Length = 0;
+        bool First = false;                                 // DATA: the message starts here
+        bool Last = false;                                  // DATA: the message is complete after this piece
+        bool FrameEnd = false;                              // DATA: the current frame's payload is complete
+        uint8_t Rsv = 0;                                    // DATA: RSV bits of the message's first frame
+    };
+
+    explicit FrameStreamDecoder(uint64_t maxMessageSize = 0);   // 0 means no limit
+
+    // data is unmasked in place; consumed receives the number of bytes used up
+    Result Next(uint8_t* data, size_t length, size_t& consumed, Event& event);
+
+    void SetMaxMessageSize(uint64_t maxMessageSize) { m_maxMessageSize = maxMessageSize; }
+    // RSV bits negotiated extensions may set on a message's first frame and on
+    // its continuation frames; any other RSV bit is a protocol error
+    void SetAllowedRsv(uint8_t bits, uint8_t continuationBits = 0) {
+        m_allowedRsv = bits;
+        m_allowedContinuationRsv = continuationBits;
+    }
+    // Servers must reject unmasked client frames (RFC 6455 section 5.1)
+    void SetRequireMask(bool require) { m_requireMask = require; }
+    bool InMessage() const { return m_inMessage; }
+    uint64_t MessageSize() const { return m_messageSize; }
+    WEBSOCKET_OPCODE FrameOpcode() const { return m_frame.Opcode; }   // Of the last frame header decoded
+    void Reset();
+
+private:
+    uint64_t m_maxMessageSize;
+    WebSocketFrame m_frame{};               // Reused so the masking key keeps its storage
+    bool m_inFrame = false;
+    uint64_t m_frameRemaining = 0;
+    size_t m_maskOffset = 0;
+    bool m_inMessage = false;
+    bool m_messageStarted = false;          // First DATA event already reported
+    WEBSOCKET_OPCODE m_messageOpcode = WEBSOCKET_OPCODE::TEXT;
+    uint8_t m_messageRsv = 0;
+    uint8_t m_allowedRsv = 0;
+    uint8_t m_allowedContinuationRsv = 0;
+    bool m_requireMask = false;
+    uint64_t m_messageSize = 0;
 };
 
 } // namespace WebSocket
@@ -1,25 +1,30 @@
 #pragma once
 
 #include "Socket.h"
+#include "ConnectionTable.h"
+#include "ConnectionStats.h"
+#include "Extension.h"
+#include "MemoryBudget.h"
 #include <memory>
 #include <functional>
 #include <string>
+#include <vector>
 #include <map>
 #include <mutex>
 #include <atomic>
 
 namespace WebSocket {
 
-// Connection tracking for security
-struct ConnectionInfo {
-    std::chrono::steady_clock::time_point lastConnectionTime;
-    int currentConnections = 0;
-    int connectionsPerMinute = 0;
-    std::chrono::steady_clock::time_point minuteStart;
-};
-
 class WebSocketServerLite {
 private:
+    // Connection tracking for security (nested so it can coexist with HttpWsServer's ConnectionInfo)
+    struct ConnectionInfo {
+        std::chrono::steady_clock::time_point lastConnectionTime;
+        int currentConnections = 0;
+        int connectionsPerMinute = 0;
+        std::chrono::steady_clock::time_point minuteStart;
+    };
+    
     std::unique_ptr<Socket> m_serverSocket;
     std::string m_bindAddress;
     uint16_t m_port;
@@ -30,6 +35,25 @@ private:
     int m_maxConnections;
     int m_maxConnectionsPerIP;
     int m_maxConnectionsPerMinute;
+    SocketProfile m_socketProfile;
+    MemoryBudget m_memoryBudget;            // Connections, requests and messages being reassembled
+    
+    // Handshake negotiation
+    std::vector<std::string> m_subProtocols;
+    std::vector<std::shared_ptr<WebSocketExtension>> m_extensions;
+    
+    // One entry per client thread, for statistics and Ping(); the thread
+    // removes its entry before its socket closes
+    struct LiteConnection {
+        Socket* socket = nullptr;
+        std::string clientIP;                   // Changed under the slot lock
+        ConnectionCounters counters;
+        std::mutex sendMutex;                   // Pongs from the client thread, pings from Ping()
+    };
+    ConnectionTable<LiteConnection> m_connections;
+    
+    // Reused by every accept batch
+    std::vector<std::unique_ptr<Socket>> m_acceptedSockets;
     
     // Connection tracking
     std::map<std::string, ConnectionInfo> ipConnectionMap;
@@ -51,11 +75,23 @@ public:
     
     // Configuration methods
     WebSocketServerLite& SetPort(uint16_t port);
+    // IPv4 or IPv6 address, or a Unix socket path as for HttpWsServer
     WebSocketServerLite& SetBindAddress(const std::string& address);
     WebSocketServerLite& EnableSecurity(bool enabled = true);
     WebSocketServerLite& SetMaxConnections(int maxConnections);
     WebSocketServerLite& SetMaxConnectionsPerIP(int maxPerIP);
     WebSocketServerLite& SetMaxConnectionsPerMinute(int maxPerMinute);
+    WebSocketServerLite& SetSocketProfile(const SocketProfile& profile);
+    
+    // Caps the memory held for all clients together (0 = count only). New
+    // connections without room are closed at accept, and a message without
+    // room closes its connection.
+    WebSocketServerLite& SetMemoryBudget(size_t bytes);
+    
+    // Handshake negotiation, as in HttpWsServer. Lite connections only
+    // receive, so extensions here only ever decode.
+    WebSocketServerLite& SetSubProtocols(const std::vector<std::string>& protocols);
+    WebSocketServerLite& AddExtension(std::shared_ptr<WebSocketExtension> extension);
     
     // Callback registration
     WebSocketServerLite& OnMessage(const std::function<void(const std::string&)>& callback);
@@ -76,16 +112,36 @@ public:
     uint16_t GetPort() const { return m_port; }
     std::string GetBindAddress() const { return m_bindAddress; }
     int GetCurrentConnectionCount() const;
+    MemoryBudgetStats GetMemoryStats() const { return m_memoryBudget.Stats(); }
+    
+    // Per-connection statistics, read without pausing the client threads
+    // (see ConnectionStats.h). Lite connections queue nothing in user space,
+    // so QueuedMessages is always 0.
+    bool GetConnectionStats(ConnectionHandle connection, ConnectionStats& stats) const;
+    std::vector<ConnectionStats> GetAllConnectionStats(bool includeTcpInfo = false) const;
+    std::vector<ConnectionStats> GetSlowestConnections(size_t count, CONNECTION_ORDER order) const;
+    
+    // Sends a PING carrying its send time; the PONG sets ConnectionStats::RttNs
+    Result Ping(ConnectionHandle connection);
+    
+    // Stop and restart reading from a connection, as in HttpWsServer. A
+    // paused client thread checks for the resume and a close every millisecond.
+    Result PauseRead(ConnectionHandle connection);
+    Result ResumeRead(ConnectionHandle connection);
 
 private:
     // Internal methods
     Result InitializeServer();
-    void HandleClientConnection(std::unique_ptr<Socket> clientSocket);
+    void HandleClientConnection(std::unique_ptr<Socket> clientSocket, MemoryReservation memory);
     bool ValidateHTTPRequest(const std::string& request);
-    Result PerformWebSocketHandshake(Socket& clientSocket, const std::string& request);
+    Result PerformWebSocketHandshake(Socket& clientSocket, const std::string& request, ConnectionCounters& counters,
+                                     ExtensionChain& extensions);
     void SendHTTPResponse(Socket& clientSocket, const std::string& status, const std::string& contentType, const std::string& body);
     std::string GetClientIP(const Socket& socket, const std::string& httpRequest = "");
     
+    void ReadStats(const LiteConnection& connection, ConnectionHandle handle, bool tcpInfo, int64_t now,
+                   ConnectionStats& stats) const;
+    
     // Security methods
     bool IsConnectionAllowed(const std::string& clientIP);
     void RemoveConnection(const std::string& clientIP);
@@ -0,0 +1,128 @@
+/**
+ * @file WorkStealingExecutor.h
+ * @brief Fixed worker pool with per-worker deques and work stealing
+ *
+ * Tasks submitted from outside the pool enter a shared lock-free injection
+ * queue; tasks submitted by a running task go onto that worker's own deque.
+ * Idle workers take from their deque, then the injection queue, then steal
+ * from the deques of randomly chosen victims. The number of accepted but
+ * unfinished tasks is bounded: TrySubmit refuses work beyond MaxPendingTasks
+ * so callers can shed load instead of queueing without limit.
+ */
+
+#pragma once
+
+#include "ErrorCodes.h"
+#include "LockFreeQueue.h"
+#include "ObjectPool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace WebSocket {
+
+struct ExecutorOptions {
+    size_t Workers = 0;                 // 0 uses std::thread::hardware_concurrency()
+    size_t MaxPendingTasks = 4096;      // Submitted but not yet finished
+    size_t DequeCapacity = 256;         // Per worker; overflow goes to the injection queue
+    std::vector<int> CpuAffinity;       // Worker i runs on CpuAffinity[i % size]; empty leaves threads unpinned
+};
+
+/**
+ * @brief Counters and queue latency (submit to start of execution)
+ *
+ * Latency percentiles come from power-of-two buckets and report the bucket's
+ * upper bound, so they are accurate to within a factor of two.
+ */
+struct ExecutorStats {
+    uint64_t Submitted = 0;
+    uint64_t Completed = 0;
+    uint64_t Rejected = 0;              // TrySubmit refused: MaxPendingTasks reached
+    uint64_t Stolen = 0;                // Taken from another worker's deque
+    uint64_t Pending = 0;
+    uint64_t AffinityFailures = 0;      // Workers that could not be pinned
+    double QueueLatencyMeanUs = 0.0;
+    double QueueLatencyP50Us = 0.0;
+    double QueueLatencyP99Us = 0.0;
+    double QueueLatencyMaxUs = 0.0;
+};
+
+class WorkStealingExecutor {
+public:
+    using TaskFn = std::function<void()>;
+
+    explicit WorkStealingExecutor(const ExecutorOptions& options = ExecutorOptions());
+    ~WorkStealingExecutor();
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    Result Start();
+    void Stop();    // Refuses new work, runs every accepted task, then joins the workers
+
+    // False when stopped or MaxPendingTasks tasks are already outstanding.
+    // Exceptions escaping a task are caught and counted as completed.
+    bool TrySubmit(TaskFn task);
+
+    bool IsRunning() const { return m_accepting.load(std::memory_order_acquire); }
+    size_t WorkerCount() const { return m_workers.size(); }
+    ExecutorStats Stats() const;
+
+    // True on one of this executor's worker threads
+    bool IsWorkerThread() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Task {
+        TaskFn Function;
+        Clock::time_point Submitted;
+    };
+
+    struct Worker {
+        explicit Worker(size_t capacity) : Deque(capacity) {}
+
+        WorkStealingDeque<Task*> Deque;
+        std::thread Thread;
+        uint64_t RandomState = 0;
+    };
+
+    static const size_t kLatencyBuckets = 48;   // 2^47 ns is well over a day
+
+    void WorkerLoop(size_t index);
+    Task* FindTask(Worker& worker);
+    void Run(Task* task);
+    void RecordLatency(uint64_t nanoseconds);
+    bool HasVisibleWork() const;
+
+    ExecutorOptions m_options;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    MpmcQueue<Task*> m_injection;
+    ObjectPool<Task> m_taskPool;
+
+    std::atomic<bool> m_accepting{false};
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_pending{0};
+
+    // Idle workers park here; submitters only take the lock when someone sleeps
+    std::atomic<int> m_sleepers{0};
+    std::mutex m_parkMutex;
+    std::condition_variable m_parkCondition;
+
+    std::atomic<uint64_t> m_submitted{0};
+    std::atomic<uint64_t> m_completed{0};
+    std::atomic<uint64_t> m_rejected{0};
+    std::atomic<uint64_t> m_stolen{0};
+    std::atomic<uint64_t> m_affinityFailures{0};
+    std::atomic<uint64_t> m_latencyTotalNs{0};
+    std::atomic<uint64_t> m_latencyMaxNs{0};
+    std::atomic<uint64_t> m_latencyBuckets[kLatencyBuckets];
+};
+
+} // namespace WebSocket
@@ -0,0 +1,590 @@
+#include "WebSocket/Benchmark.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace WebSocket {
+
+namespace {
+
+constexpr uint64_t kMaxIterations = 1000000000ull;
+
+std::string EscapeJson(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                    escaped += buffer;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+std::string FormatNumber(double value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.3f", std::isfinite(value) ? value : 0.0);
+    return buffer;
+}
+
+std::string FormatRate(double bytesPerSecond) {
+    const char* units[] = {"B/s", "KiB/s", "MiB/s", "GiB/s"};
+    int unit = 0;
+    while (bytesPerSecond >= 1024.0 && unit < 3) {
+        bytesPerSecond /= 1024.0;
+        unit++;
+    }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.1f %s", bytesPerSecond, units[unit]);
+    return buffer;
+}
+
+std::string CompilerName() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "unknown";
+#endif
+}
+
+/**
+ * @brief Just enough JSON to read reports back: objects, arrays, strings, numbers, literals
+ */
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& text) : m_text(text) {}
+
+    // Collects each object in the top-level "benchmarks" array; other keys are skipped
+    bool ReadReport(std::vector<BenchmarkResult>& results) {
+        SkipWhitespace();
+        if (!Consume('{')) {
+            return false;
+        }
+        if (Consume('}')) {
+            return true;
+        }
+        do {
+            std::string key;
+            if (!ReadString(key) || !Consume(':')) {
+                return false;
+            }
+            if (key == "benchmarks") {
+                if (!ReadBenchmarks(results)) {
+                    return false;
+                }
+            } else if (!SkipValue()) {
+                return false;
+            }
+        } while (Consume(','));
+        return Consume('}');
+    }
+
+private:
+    bool ReadBenchmarks(std::vector<BenchmarkResult>& results) {
+        if (!Consume('[')) {
+            return false;
+        }
+        if (Consume(']')) {
+            return true;
+        }
+        do {
+            BenchmarkResult result;
+            if (!Consume('{')) {
+                return false;
+            }
+            if (!Consume('}')) {
+                do {
+                    std::string key;
+                    if (!ReadString(key) || !Consume(':')) {
+                        return false;
+                    }
+                    bool ok = true;
+                    if (key == "name") {
+                        ok = ReadString(result.Name);
+                    } else if (key == "error") {
+                        ok = ReadString(result.Error);
+                    } else if (key == "iterations") {
+                        double value = 0.0;
+                        ok = ReadNumber(value);
+                        result.Iterations = static_cast<uint64_t>(value);
+                    } else if (key == "repetitions") {
+                        double value = 0.0;
+                        ok = ReadNumber(value);
+                        result.Repetitions = static_cast<size_t>(value);
+                    } else if (key == "ns_per_op") {
+                        ok = ReadNumber(result.NsPerOp);
+                    } else if (key == "ns_per_op_min") {
+                        ok = ReadNumber(result.NsPerOpMin);
+                    } else if (key == "ns_per_op_stddev") {
+                        ok = ReadNumber(result.NsPerOpStdDev);
+                    } else if (key == "bytes_per_second") {
+                        ok = ReadNumber(result.BytesPerSecond);
+                    } else if (key == "items_per_second") {
+                        ok = ReadNumber(result.ItemsPerSecond);
+                    } else {
+                        ok = SkipValue();
+                    }
+                    if (!ok) {
+                        return false;
+                    }
+                } while (Consume(','));
+                if (!Consume('}')) {
+                    return false;
+                }
+            }
+            results.push_back(result);
+        } while (Consume(','));
+        return Consume(']');
+    }
+
+    void SkipWhitespace() {
+        while (m_position < m_text.size() && isspace(static_cast<unsigned char>(m_text[m_position]))) {
+            m_position++;
+        }
+    }
+
+    bool Consume(char expected) {
+        SkipWhitespace();
+        if (m_position < m_text.size() && m_text[m_position] == expected) {
+            m_position++;
+            return true;
+        }
+        return false;
+    }
+
+    bool ReadString(std::string& value) {
+        if (!Consume('"')) {
+            return false;
+        }
+        value.clear();
+        while (m_position < m_text.size()) {
+            char c = m_text[m_position++];
+            if (c == '"') {
+                return true;
+            }
+            if (c == '\\' && m_position < m_text.size()) {
+                char escaped = m_text[m_position++];
+                switch (escaped) {
+                    case 'n': value += '\n'; break;
+                    case 'r': value += '\r'; break;
+                    case 't': value += '\t'; break;
+                    case 'u':
+                        // Only control characters are written as \u escapes
+                        if (m_position + 4 > m_text.size()) {
+                            return false;
+                        }
+                        value += static_cast<char>(std::strtol(m_text.substr(m_position, 4).c_str(), nullptr, 16));
+                        m_position += 4;
+                        break;
+                    default: value += escaped; break;
+                }
+            } else {
+                value += c;
+            }
+        }
+        return false;
+    }
+
+    bool ReadNumber(double& value) {
+        SkipWhitespace();
+        const char* start = m_text.c_str() + m_position;
+        char* end = nullptr;
+        value = std::strtod(start, &end);
+        if (end == start) {
+            return false;
+        }
+        m_position += end - start;
+        return true;
+    }
+
+    bool SkipValue() {
+        SkipWhitespace();
+        if (m_position >= m_text.size()) {
+            return false;
+        }
+        char c = m_text[m_position];
+        if (c == '"') {
+            std::string ignored;
+            return ReadString(ignored);
+        }
+        if (c == '{' || c == '[') {
+            char close = c == '{' ? '}' : ']';
+            m_position++;
+            if (Consume(close)) {
+                return true;
+            }
+            do {
+                if (c == '{') {
+                    std::string key;
+                    if (!ReadString(key) || !Consume(':')) {
+                        return false;
+                    }
+                }
+                if (!SkipValue()) {
+                    return false;
+                }
+            } while (Consume(','));
+            return Consume(close);
+        }
+        for (const char* literal : {"true", "false", "null"}) {
+            size_t length = strlen(literal);
+            if (m_text.compare(m_position, length, literal) == 0) {
+                m_position += length;
+                return true;
+            }
+        }
+        double ignored = 0.0;
+        return ReadNumber(ignored);
+    }
+
+    const std::string& m_text;
+    size_t m_position = 0;
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// BenchmarkState
+// ---------------------------------------------------------------------------
+
+void BenchmarkState::PauseTiming() {
+    if (m_timing) {
+        m_elapsed += Clock::now() - m_start;
+        m_timing = false;
+    }
+}
+
+void BenchmarkState::ResumeTiming() {
+    if (!m_timing) {
+        m_start = Clock::now();
+        m_timing = true;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// BenchmarkRunner
+// ---------------------------------------------------------------------------
+
+BenchmarkRunner& BenchmarkRunner::Add(const std::string& name, BenchmarkFn function) {
+    m_cases.push_back({name, std::move(function)});
+    return *this;
+}
+
+std::vector<std::string> BenchmarkRunner::Names() const {
+    std::vector<std::string> names;
+    for (const Case& benchmark : m_cases) {
+        names.push_back(benchmark.Name);
+    }
+    return names;
+}
+
+double BenchmarkRunner::RunOnce(const Case& benchmark, BenchmarkState& state) {
+    state.ResumeTiming();
+    benchmark.Function(state);
+    state.PauseTiming();
+    return std::chrono::duration<double>(state.m_elapsed).count();
+}
+
+std::vector<BenchmarkResult> BenchmarkRunner::Run(const BenchmarkOptions& options) const {
+    std::vector<BenchmarkResult> results;
+    if (!options.Quiet) {
+        printf("%-36s %12s %12s %8s %14s %12s\n", "Benchmark", "ns/op", "min ns/op", "stddev", "throughput", "iterations");
+    }
+
+    for (const Case& benchmark : m_cases) {
+        if (!options.Filter.empty() && benchmark.Name.find(options.Filter) == std::string::npos) {
+            continue;
+        }
+
+        BenchmarkResult result;
+        result.Name = benchmark.Name;
+
+        // Grow the iteration count until one run lasts MinTimeSeconds; doubles as warm-up
+        uint64_t iterations = 1;
+        while (true) {
+            BenchmarkState state(iterations);
+            double seconds = RunOnce(benchmark, state);
+            if (!state.m_error.empty()) {
+                result.Error = state.m_error;
+                break;
+            }
+            if (seconds >= options.MinTimeSeconds || iterations >= kMaxIterations) {
+                break;
+            }
+            double scale = seconds > 0.0 ? options.MinTimeSeconds * 1.4 / seconds : 100.0;
+            scale = std::min(std::max(scale, 2.0), 100.0);
+            iterations = std::min(kMaxIterations, static_cast<uint64_t>(static_cast<double>(iterations) * scale));
+        }
+
+        if (result.Error.empty()) {
+            std::vector<double> nsPerOp;
+            double bytesPerSecond = 0.0;
+            double itemsPerSecond = 0.0;
+            size_t repetitions = std::max<size_t>(options.Repetitions, 1);
+            for (size_t repetition = 0; repetition < repetitions && result.Error.empty(); repetition++) {
+                BenchmarkState state(iterations);
+                double seconds = RunOnce(benchmark, state);
+                result.Error = state.m_error;
+                nsPerOp.push_back(seconds * 1e9 / static_cast<double>(iterations));
+                if (seconds > 0.0) {
+                    bytesPerSecond += static_cast<double>(state.m_bytes) / seconds;
+                    itemsPerSecond += static_cast<double>(state.m_items) / seconds;
+                }
+            }
+
+            std::vector<double> sorted = nsPerOp;
+            std::sort(sorted.begin(), sorted.end());
+            double mean = 0.0;
+            for (double value : nsPerOp) {
+                mean += value;
+            }
+            mean /= static_cast<double>(nsPerOp.size());
+            double variance = 0.0;
+            for (double value : nsPerOp) {
+                variance += (value - mean) * (value - mean);
+            }
+
+            result.Iterations = iterations;
+            result.Repetitions = nsPerOp.size();
+            result.NsPerOp = sorted[sorted.size() / 2];
+            result.NsPerOpMin = sorted.front();
+            result.NsPerOpStdDev = std::sqrt(variance / static_cast<double>(nsPerOp.size()));
+            result.BytesPerSecond = bytesPerSecond / static_cast<double>(nsPerOp.size());
+            result.ItemsPerSecond = itemsPerSecond / static_cast<double>(nsPerOp.size());
+        }
+
+        if (!options.Quiet) {
+            if (!result.Error.empty()) {
+                printf("%-36s skipped: %s\n", result.Name.c_str(), result.Error.c_str());
+            } else {
+                std::string throughput = result.BytesPerSecond > 0.0 ? FormatRate(result.BytesPerSecond)
+                                       : result.ItemsPerSecond > 0.0 ? FormatNumber(result.ItemsPerSecond) + "/s"
+                                       : std::string("-");
+                printf("%-36s %12.1f %12.1f %7.1f%% %14s %12llu\n", result.Name.c_str(), result.NsPerOp,
+                       result.NsPerOpMin, result.NsPerOp > 0.0 ? 100.0 * result.NsPerOpStdDev / result.NsPerOp : 0.0,
+                       throughput.c_str(), static_cast<unsigned long long>(result.Iterations));
+            }
+            fflush(stdout);
+        }
+        results.push_back(result);
+    }
+    return results;
+}
+
+// ---------------------------------------------------------------------------
+// BenchmarkReport
+// ---------------------------------------------------------------------------
+
+const BenchmarkResult* BenchmarkReport::Find(const std::string& name) const {
+    for (const BenchmarkResult& result : m_results) {
+        if (result.Name == name) {
+            return &result;
+        }
+    }
+    return nullptr;
+}
+
+std::string BenchmarkReport::ToJson() const {
+    char date[32] = "";
+    std::time_t now = std::time(nullptr);
+    std::tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"context\": {\n";
+    json << "    \"date\": \"" << date << "\",\n";
+    json << "    \"compiler\": \"" << EscapeJson(CompilerName()) << "\",\n";
+#ifdef NDEBUG
+    json << "    \"build_type\": \"release\",\n";
+#else
+    json << "    \"build_type\": \"debug\",\n";
+#endif
+    json << "    \"cpus\": " << std::thread::hardware_concurrency() << "\n";
+    json << "  },\n";
+    json << "  \"benchmarks\": [";
+    for (size_t i = 0; i < m_results.size(); i++) {
+        const BenchmarkResult& result = m_results[i];
+        json << (i == 0 ? "\n" : ",\n");
+        json << "    {\n";
+        json << "      \"name\": \"" << EscapeJson(result.Name) << "\",\n";
+        if (!result.Error.empty()) {
+            json << "      \"error\": \"" << EscapeJson(result.Error) << "\",\n";
+        }
+        json << "      \"iterations\": " << result.Iterations << ",\n";
+        json << "      \"repetitions\": " << result.Repetitions << ",\n";
+        json << "      \"ns_per_op\": " << FormatNumber(result.NsPerOp) << ",\n";
+        json << "      \"ns_per_op_min\": " << FormatNumber(result.NsPerOpMin) << ",\n";
+        json << "      \"ns_per_op_stddev\": " << FormatNumber(result.NsPerOpStdDev) << ",\n";
+        json << "      \"bytes_per_second\": " << FormatNumber(result.BytesPerSecond) << ",\n";
+        json << "      \"items_per_second\": " << FormatNumber(result.ItemsPerSecond) << "\n";
+        json << "    }";
+    }
+    json << (m_results.empty() ? "]\n" : "\n  ]\n");
+    json << "}\n";
+    return json.str();
+}
+
+Result BenchmarkReport::WriteJson(const std::string& path) const {
+    std::string json = ToJson();
+    if (path == "-") {
+        fwrite(json.data(), 1, json.size(), stdout);
+        return Result();
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return Result(ERROR_CODE::INVALID_PARAMETER, "Cannot open " + path + " for writing");
+    }
+    file << json;
+    if (!file) {
+        return Result(ERROR_CODE::INVALID_PARAMETER, "Failed to write " + path);
+    }
+    return Result();
+}
+
+std::pair<Result, BenchmarkReport> BenchmarkReport::FromJson(const std::string& json) {
+    std::vector<BenchmarkResult> results;
+    JsonReader reader(json);
+    if (!reader.ReadReport(results)) {
+        return { Result(ERROR_CODE::INVALID_PARAMETER, "Malformed benchmark JSON"), BenchmarkReport() };
+    }
+    return { Result(), BenchmarkReport(std::move(results)) };
+}
+
+std::pair<Result, BenchmarkReport> BenchmarkReport::ReadJson(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return { Result(ERROR_CODE::INVALID_PARAMETER, "Cannot open " + path), BenchmarkReport() };
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return FromJson(contents.str());
+}
+
+// ---------------------------------------------------------------------------
+// Comparison and command line
+// ---------------------------------------------------------------------------
+
+std::vector<BenchmarkComparison> CompareBenchmarks(const BenchmarkReport& baseline, const BenchmarkReport& current,
+                                                   double maxRegressionPercent) {
+    std::vector<BenchmarkComparison> comparisons;
+    for (const BenchmarkResult& result : current.Results()) {
+        const BenchmarkResult* previous = baseline.Find(result.Name);
+        if (!previous || previous->NsPerOp <= 0.0 || !result.Error.empty() || !previous->Error.empty()) {
+            continue;
+        }
+        BenchmarkComparison comparison;
+        comparison.Name = result.Name;
+        comparison.BaselineNsPerOp = previous->NsPerOp;
+        comparison.CurrentNsPerOp = result.NsPerOp;
+        comparison.ChangePercent = 100.0 * (result.NsPerOp - previous->NsPerOp) / previous->NsPerOp;
+        comparison.Regressed = comparison.ChangePercent > maxRegressionPercent;
+        comparisons.push_back(comparison);
+    }
+    return comparisons;
+}
+
+int BenchmarkMain(int argc, char* argv[], const BenchmarkRunner& runner) {
+    BenchmarkOptions options;
+    std::string jsonPath;
+    std::string baselinePath;
+    double maxRegressionPercent = 10.0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string name = argv[i];
+        if (name == "--list") {
+            for (const std::string& benchmark : runner.Names()) {
+                printf("%s\n", benchmark.c_str());
+            }
+            return 0;
+        }
+        if (i + 1 >= argc || name == "--help") {
+            printf("Usage: %s [--filter TEXT] [--min-time SECONDS] [--repetitions N] [--json PATH]\n"
+                   "       [--baseline PATH] [--max-regression PERCENT] [--list]\n", argv[0]);
+            return name == "--help" ? 0 : 1;
+        }
+        std::string value = argv[++i];
+        if (name == "--filter") {
+            options.Filter = value;
+        } else if (name == "--min-time") {
+            options.MinTimeSeconds = std::strtod(value.c_str(), nullptr);
+        } else if (name == "--repetitions") {
+            options.Repetitions = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (name == "--json") {
+            jsonPath = value;
+        } else if (name == "--baseline") {
+            baselinePath = value;
+        } else if (name == "--max-regression") {
+            maxRegressionPercent = std::strtod(value.c_str(), nullptr);
+        } else {
+            printf("Unknown option: %s\n", name.c_str());
+            return 1;
+        }
+    }
+
+    // JSON on stdout replaces the console table
+    options.Quiet = jsonPath == "-";
+    BenchmarkReport report(runner.Run(options));
+
+    if (!jsonPath.empty()) {
+        Result writeResult = report.WriteJson(jsonPath);
+        if (writeResult.IsError()) {
+            fprintf(stderr, "%s\n", writeResult.GetErrorMessage().c_str());
+            return 1;
+        }
+    }
+
+    if (baselinePath.empty()) {
+        return 0;
+    }
+
+    auto [readResult, baseline] = BenchmarkReport::ReadJson(baselinePath);
+    if (readResult.IsError()) {
+        fprintf(stderr, "%s\n", readResult.GetErrorMessage().c_str());
+        return 1;
+    }
+
+    // Diagnostics go to stderr so a JSON report on stdout stays parseable
+    size_t regressions = 0;
+    fprintf(stderr, "\n%-36s %12s %12s %9s\n", "Compared to baseline", "baseline", "current", "change");
+    for (const BenchmarkComparison& comparison : CompareBenchmarks(baseline, report, maxRegressionPercent)) {
+        fprintf(stderr, "%-36s %12.1f %12.1f %+8.1f%%%s\n", comparison.Name.c_str(), comparison.BaselineNsPerOp,
+                comparison.CurrentNsPerOp, comparison.ChangePercent, comparison.Regressed ? "  REGRESSED" : "");
+        regressions += comparison.Regressed ? 1 : 0;
+    }
+    if (regressions > 0) {
+        fprintf(stderr, "%zu benchmark(s) regressed by more than %.1f%%\n", regressions, maxRegressionPercent);
+        return 2;
+    }
+    return 0;
+}
+
+} // namespace WebSocket
@@ -0,0 +1,353 @@
+#include "WebSocket/BufferPool.h"
+#include <mutex>
+#include <new>
+
+namespace WebSocket {
+
+// Buffer header; blocks are allocated on a kHeaderSize boundary and the bytes
+// follow at kHeaderSize, so data starts on a cache line
+struct BufferBlock {
+    std::atomic<uint32_t> refCount;
+    uint32_t sizeClass;     // kSizeClassCount marks an oversize heap buffer
+    uint32_t node;          // Shared lists the block belongs to
+    size_t capacity;
+    BufferBlock* next;
+
+    uint8_t* Data() { return reinterpret_cast<uint8_t*>(this) + kHeaderSize; }
+
+    static constexpr size_t kHeaderSize = 64;
+};
+
+static_assert(sizeof(BufferBlock) <= BufferBlock::kHeaderSize, "Buffer header must fit its reserved space");
+
+namespace {
+
+using Block = BufferBlock;
+
+// Per-thread cache depth and shared list cap for each size class
+const size_t kThreadCacheLimit[BufferPool::kSizeClassCount] = {64, 32, 16, 4};
+const size_t kGlobalLimit[BufferPool::kSizeClassCount] = {4096, 1024, 256, 16};
+
+// Nodes beyond this share lists (node % kMaxNodes)
+const uint32_t kMaxNodes = 8;
+
+struct ClassCounters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> threadCacheHits{0};
+    std::atomic<uint64_t> globalHits{0};
+    std::atomic<uint64_t> heapAllocations{0};
+    std::atomic<uint64_t> buffersOutstanding{0};
+    std::atomic<uint64_t> bytesOutstanding{0};
+    std::atomic<uint64_t> remoteReleases{0};
+};
+
+struct GlobalList {
+    std::mutex mutex;
+    Block* head = nullptr;
+    size_t count = 0;
+};
+
+struct PoolState {
+    GlobalList lists[kMaxNodes][BufferPool::kSizeClassCount];
+    ClassCounters counters[BufferPool::kSizeClassCount + 1];
+};
+
+// Intentionally leaked: thread caches flush into it during thread and static teardown
+PoolState& State() {
+    static PoolState* state = new PoolState();
+    return *state;
+}
+
+Block* NewBlock(uint32_t sizeClass, uint32_t node, size_t capacity) {
+    void* memory = ::operator new(Block::kHeaderSize + capacity, std::align_val_t(Block::kHeaderSize), std::nothrow);
+    if (!memory) {
+        return nullptr;
+    }
+    Block* block = new (memory) Block();
+    block->sizeClass = sizeClass;
+    block->node = node;
+    block->capacity = capacity;
+    block->next = nullptr;
+    return block;
+}
+
+void DeleteBlock(Block* block) {
+    block->~Block();
+    ::operator delete(block, std::align_val_t(Block::kHeaderSize));
+}
+
+// Move up to count blocks from the front of list into a node's shared list, freeing any overflow
+void ReturnToGlobal(uint32_t node, size_t sizeClass, Block*& list, size_t& listCount, size_t count) {
+    Block* spill = nullptr;
+    {
+        GlobalList& global = State().lists[node][sizeClass];
+        std::lock_guard<std::mutex> lock(global.mutex);
+        while (count > 0 && list) {
+            Block* block = list;
+            list = block->next;
+            listCount--;
+            count--;
+            if (global.count < kGlobalLimit[sizeClass]) {
+                block->next = global.head;
+                global.head = block;
+                global.count++;
+            } else {
+                block->next = spill;
+                spill = block;
+            }
+        }
+    }
+    while (spill) {
+        Block* next = spill->next;
+        DeleteBlock(spill);
+        spill = next;
+    }
+}
+
+struct ThreadCache {
+    Block* lists[BufferPool::kSizeClassCount] = {};
+    size_t counts[BufferPool::kSizeClassCount] = {};
+    uint32_t node = 0;
+
+    void Flush() {
+        for (size_t i = 0; i < BufferPool::kSizeClassCount; i++) {
+            ReturnToGlobal(node, i, lists[i], counts[i], counts[i]);
+        }
+    }
+
+    ~ThreadCache() { Flush(); }
+};
+
+thread_local ThreadCache t_cache;
+
+size_t SizeClassFor(size_t capacity) {
+    for (size_t i = 0; i < BufferPool::kSizeClassCount; i++) {
+        if (capacity <= BufferPool::kSizeClasses[i]) {
+            return i;
+        }
+    }
+    return BufferPool::kSizeClassCount;
+}
+
+} // namespace
+
+BufferHandle::BufferHandle(BufferBlock* block)
+    : m_block(block), m_data(block->Data()), m_size(0), m_capacity(block->capacity) {
+}
+
+BufferHandle::BufferHandle(const BufferHandle& other)
+    : m_block(other.m_block), m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity) {
+    if (m_block) {
+        m_block->refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+BufferHandle& BufferHandle::operator=(const BufferHandle& other) {
+    if (this != &other) {
+        if (other.m_block) {
+            other.m_block->refCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        Reset();
+        m_block = other.m_block;
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+    }
+    return *this;
+}
+
+BufferHandle::BufferHandle(BufferHandle&& other) noexcept
+    : m_block(other.m_block), m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity) {
+    other.m_block = nullptr;
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_capacity = 0;
+}
+
+BufferHandle& BufferHandle::operator=(BufferHandle&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        m_block = other.m_block;
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        other.m_block = nullptr;
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_capacity = 0;
+    }
+    return *this;
+}
+
+bool BufferHandle::Resize(size_t size) {
+    if (size > m_capacity) {
+        return false;
+    }
+    m_size = size;
+    return true;
+}
+
+void BufferHandle::Reset() {
+    if (m_block && m_block->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        BufferPool::Release(m_block);
+    }
+    m_block = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_capacity = 0;
+}
+
+uint32_t BufferHandle::UseCount() const {
+    return m_block ? m_block->refCount.load(std::memory_order_relaxed) : 0;
+}
+
+BufferHandle BufferPool::Acquire(size_t capacity) {
+    size_t sizeClass = SizeClassFor(capacity);
+    ClassCounters& counters = State().counters[sizeClass];
+    Block* block = nullptr;
+
+    if (sizeClass < kSizeClassCount) {
+        ThreadCache& cache = t_cache;
+        if (cache.lists[sizeClass]) {
+            block = cache.lists[sizeClass];
+            cache.lists[sizeClass] = block->next;
+            cache.counts[sizeClass]--;
+            counters.threadCacheHits.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // Refill half the thread cache from the shared list in one lock
+            GlobalList& global = State().lists[cache.node][sizeClass];
+            std::lock_guard<std::mutex> lock(global.mutex);
+            size_t batch = kThreadCacheLimit[sizeClass] / 2;
+            while (global.head && batch > 0) {
+                Block* taken = global.head;
+                global.head = taken->next;
+                global.count--;
+                batch--;
+                if (!block) {
+                    block = taken;
+                } else {
+                    taken->next = cache.lists[sizeClass];
+                    cache.lists[sizeClass] = taken;
+                    cache.counts[sizeClass]++;
+                }
+            }
+            if (block) {
+                counters.globalHits.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        capacity = kSizeClasses[sizeClass];
+    }
+
+    if (!block) {
+        block = NewBlock(static_cast<uint32_t>(sizeClass), t_cache.node, capacity);
+        if (!block) {
+            return BufferHandle();
+        }
+        counters.heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    block->refCount.store(1, std::memory_order_relaxed);
+    block->next = nullptr;
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.buffersOutstanding.fetch_add(1, std::memory_order_relaxed);
+    counters.bytesOutstanding.fetch_add(block->capacity, std::memory_order_relaxed);
+    return BufferHandle(block);
+}
+
+void BufferPool::Release(BufferBlock* block) {
+    size_t sizeClass = block->sizeClass;
+    ClassCounters& counters = State().counters[sizeClass];
+    counters.buffersOutstanding.fetch_sub(1, std::memory_order_relaxed);
+    counters.bytesOutstanding.fetch_sub(block->capacity, std::memory_order_relaxed);
+
+    if (sizeClass >= kSizeClassCount) {
+        DeleteBlock(block);
+        return;
+    }
+
+    ThreadCache& cache = t_cache;
+    if (block->node != cache.node) {
+        // Keep each node's lists to memory on that node
+        counters.remoteReleases.fetch_add(1, std::memory_order_relaxed);
+        block->next = nullptr;
+        Block* list = block;
+        size_t count = 1;
+        ReturnToGlobal(block->node, sizeClass, list, count, 1);
+        return;
+    }
+    block->next = cache.lists[sizeClass];
+    cache.lists[sizeClass] = block;
+    cache.counts[sizeClass]++;
+
+    // Spill half the cache to the shared list once it is full
+    if (cache.counts[sizeClass] > kThreadCacheLimit[sizeClass]) {
+        ReturnToGlobal(cache.node, sizeClass, cache.lists[sizeClass], cache.counts[sizeClass], kThreadCacheLimit[sizeClass] / 2);
+    }
+}
+
+BufferPoolStats BufferPool::ClassStats(size_t sizeClass) {
+    BufferPoolStats stats;
+    if (sizeClass > kSizeClassCount) {
+        return stats;
+    }
+    const ClassCounters& counters = State().counters[sizeClass];
+    stats.Allocations = counters.allocations.load(std::memory_order_relaxed);
+    stats.ThreadCacheHits = counters.threadCacheHits.load(std::memory_order_relaxed);
+    stats.GlobalHits = counters.globalHits.load(std::memory_order_relaxed);
+    stats.HeapAllocations = counters.heapAllocations.load(std::memory_order_relaxed);
+    stats.BuffersOutstanding = counters.buffersOutstanding.load(std::memory_order_relaxed);
+    stats.BytesOutstanding = counters.bytesOutstanding.load(std::memory_order_relaxed);
+    stats.RemoteReleases = counters.remoteReleases.load(std::memory_order_relaxed);
+    return stats;
+}
+
+BufferPoolStats BufferPool::Stats() {
+    BufferPoolStats total;
+    for (size_t i = 0; i <= kSizeClassCount; i++) {
+        BufferPoolStats stats = ClassStats(i);
+        total.Allocations += stats.Allocations;
+        total.ThreadCacheHits += stats.ThreadCacheHits;
+        total.GlobalHits += stats.GlobalHits;
+        total.HeapAllocations += stats.HeapAllocations;
+        total.BuffersOutstanding += stats.BuffersOutstanding;
+        total.BytesOutstanding += stats.BytesOutstanding;
+        total.RemoteReleases += stats.RemoteReleases;
+    }
+    return total;
+}
+
+void BufferPool::FlushThreadCache() {
+    t_cache.Flush();
+}
+
+void BufferPool::SetThreadNode(int node) {
+    uint32_t index = node > 0 ? static_cast<uint32_t>(node) % kMaxNodes : 0;
+    ThreadCache& cache = t_cache;
+    if (cache.node != index) {
+        // Cached blocks belong to the old node
+        cache.Flush();
+        cache.node = index;
+    }
+}
+
+void BufferPool::Trim() {
+    for (uint32_t node = 0; node < kMaxNodes; node++) {
+        for (size_t i = 0; i < kSizeClassCount; i++) {
+            Block* list = nullptr;
+            {
+                GlobalList& global = State().lists[node][i];
+                std::lock_guard<std::mutex> lock(global.mutex);
+                list = global.head;
+                global.head = nullptr;
+                global.count = 0;
+            }
+            while (list) {
+                Block* next = list->next;
+                DeleteBlock(list);
+                list = next;
+            }
+        }
+    }
+}
+
+} // namespace WebSocket
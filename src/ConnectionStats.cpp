@@ -0,0 +1,96 @@
+#include "WebSocket/ConnectionStats.h"
+#include <algorithm>
+#include <cstring>
+
+namespace WebSocket {
+
+namespace {
+
+// Min-heap on the key: the root is the fastest of the slow connections kept
+bool KeyGreater(const std::pair<uint64_t, ConnectionHandle>& a, const std::pair<uint64_t, ConnectionHandle>& b) {
+    return a.first > b.first;
+}
+
+} // namespace
+
+int64_t ConnectionCounters::BeginPing() {
+    int64_t payload = SteadyNowNs();
+    PingSentNs.store(payload, std::memory_order_relaxed);
+    return payload;
+}
+
+bool ConnectionCounters::CompletePing(const uint8_t* payload, size_t length) {
+    int64_t sent = PingSentNs.load(std::memory_order_relaxed);
+    if (sent == 0 || length != sizeof(sent)) {
+        return false;
+    }
+    int64_t echoed = 0;
+    memcpy(&echoed, payload, sizeof(echoed));
+    if (echoed != sent || !PingSentNs.compare_exchange_strong(sent, 0, std::memory_order_relaxed)) {
+        return false;
+    }
+    RttNs.store(SteadyNowNs() - sent, std::memory_order_relaxed);
+    return true;
+}
+
+bool ConnectionOrderNeedsTcpInfo(CONNECTION_ORDER order) {
+    return order == CONNECTION_ORDER::OUTBOUND_BYTES || order == CONNECTION_ORDER::UNACKED ||
+           order == CONNECTION_ORDER::RETRANSMITS;
+}
+
+uint64_t ConnectionOrderKey(const ConnectionStats& stats, CONNECTION_ORDER order) {
+    switch (order) {
+        case CONNECTION_ORDER::OUTBOUND_BYTES: return stats.OutboundBytes();
+        case CONNECTION_ORDER::QUEUED_MESSAGES: return stats.QueuedMessages;
+        case CONNECTION_ORDER::RTT:
+            return stats.RttNs > 0 ? static_cast<uint64_t>(stats.RttNs) : uint64_t(stats.Tcp.RttUs) * 1000;
+        case CONNECTION_ORDER::IDLE: return stats.IdleNs > 0 ? static_cast<uint64_t>(stats.IdleNs) : 0;
+        case CONNECTION_ORDER::UNACKED: return stats.Tcp.Unacked;
+        case CONNECTION_ORDER::RETRANSMITS: return stats.Tcp.TotalRetransmits;
+    }
+    return 0;
+}
+
+void ReadConnectionCounters(const ConnectionCounters& counters, int64_t now, ConnectionStats& stats) {
+    stats.IsWebSocket = counters.WebSocket.load(std::memory_order_relaxed);
+    stats.BytesIn = counters.BytesIn.load(std::memory_order_relaxed);
+    stats.BytesOut = counters.BytesOut.load(std::memory_order_relaxed);
+    stats.FramesIn = counters.FramesIn.load(std::memory_order_relaxed);
+    stats.FramesOut = counters.FramesOut.load(std::memory_order_relaxed);
+    stats.SendingBytes = counters.SendingBytes.load(std::memory_order_relaxed);
+    stats.ConnectedNs = now - counters.OpenedNs.load(std::memory_order_relaxed);
+    stats.IdleNs = now - counters.LastActivityNs.load(std::memory_order_relaxed);
+    stats.RttNs = counters.RttNs.load(std::memory_order_relaxed);
+    stats.ReadPaused = counters.ReadPaused.load(std::memory_order_relaxed);
+    stats.ReadThrottled = counters.ReadThrottled.load(std::memory_order_relaxed);
+    stats.Cpu = counters.Cpu.load(std::memory_order_relaxed);
+}
+
+void SlowConnectionHeap::Offer(const ConnectionStats& stats) {
+    if (m_count == 0) {
+        return;
+    }
+    uint64_t key = ConnectionOrderKey(stats, m_order);
+    if (m_heap.size() < m_count) {
+        m_heap.emplace_back(key, stats.Handle);
+        std::push_heap(m_heap.begin(), m_heap.end(), KeyGreater);
+    } else if (key > m_heap.front().first) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), KeyGreater);
+        m_heap.back() = {key, stats.Handle};
+        std::push_heap(m_heap.begin(), m_heap.end(), KeyGreater);
+    }
+}
+
+std::vector<ConnectionHandle> SlowConnectionHeap::Take() {
+    // Sorting with the heap's comparator leaves the largest keys first
+    std::sort_heap(m_heap.begin(), m_heap.end(), KeyGreater);
+    std::vector<ConnectionHandle> handles;
+    handles.reserve(m_heap.size());
+    for (const auto& entry : m_heap) {
+        handles.push_back(entry.second);
+    }
+    m_heap.clear();
+    return handles;
+}
+
+} // namespace WebSocket
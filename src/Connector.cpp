@@ -0,0 +1,728 @@
+#include "WebSocket/Connector.h"
+#include "WebSocket/AddrInfoGuard.h"
+#include <algorithm>
+#include <cstring>
+#include <future>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace WebSocket {
+
+namespace {
+
+#ifdef _WIN32
+const int kTimedOutError = WSAETIMEDOUT;
+// WSAPoll cannot be woken from another thread, so the loop wakes up this often
+const int kMaxWaitMs = 10;
+#else
+const int kTimedOutError = ETIMEDOUT;
+const int kMaxWaitMs = 1000;
+#endif
+
+bool SameAddress(const ResolvedAddress& a, const ResolvedAddress& b) {
+    return a.Length == b.Length && memcmp(&a.Address, &b.Address, a.Length) == 0;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// ResolvedAddress
+// ---------------------------------------------------------------------------
+
+std::string ResolvedAddress::ToString() const {
+    char buffer[INET6_ADDRSTRLEN] = {0};
+    if (Family == SOCKET_FAMILY::IPV6) {
+        const auto* addr6 = reinterpret_cast<const struct sockaddr_in6*>(&Address);
+        inet_ntop(AF_INET6, &addr6->sin6_addr, buffer, sizeof(buffer));
+    } else {
+        const auto* addr4 = reinterpret_cast<const struct sockaddr_in*>(&Address);
+        inet_ntop(AF_INET, &addr4->sin_addr, buffer, sizeof(buffer));
+    }
+    return buffer;
+}
+
+// ---------------------------------------------------------------------------
+// DnsResolver
+// ---------------------------------------------------------------------------
+
+DnsResolver::DnsResolver(size_t threadCount, std::chrono::milliseconds ttl, std::chrono::milliseconds negativeTtl,
+                         size_t maxCachedHosts)
+    : m_ttl(ttl), m_negativeTtl(negativeTtl), m_maxCachedHosts(std::max<size_t>(maxCachedHosts, 1)) {
+#ifdef _WIN32
+    // getaddrinfo needs Winsock even before the first Socket exists
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+    threadCount = std::max<size_t>(threadCount, 1);
+    m_threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&DnsResolver::ResolverThread, this);
+    }
+}
+
+DnsResolver::~DnsResolver() {
+    std::unordered_map<std::string, std::vector<Waiter>> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+
+    // Queries that never ran still owe their callers an answer
+    abandoned.swap(m_inFlight);
+    Result stopped(ERROR_CODE::SOCKET_ADDRESS_PARSE_FAILED, "Resolver stopped");
+    for (auto& entry : abandoned) {
+        for (auto& waiter : entry.second) {
+            waiter.Callback(stopped, {});
+        }
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void DnsResolver::ResolveAsync(const std::string& host, uint16_t port, ResolveCallbackFn callback) {
+    ResolvedAddress literal;
+    if (ParseLiteral(host, port, literal)) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.Lookups++;
+            m_stats.CacheHits++;
+        }
+        callback(Result(), {literal});
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stats.Lookups++;
+
+    auto cached = m_cache.find(host);
+    if (cached != m_cache.end()) {
+        if (cached->second.Expires > std::chrono::steady_clock::now()) {
+            m_stats.CacheHits++;
+            Result status = cached->second.Status;
+            std::vector<ResolvedAddress> addresses = WithPort(cached->second.Addresses, port);
+            lock.unlock();
+            callback(status, addresses);
+            return;
+        }
+        m_cache.erase(cached);
+    }
+
+    if (m_stopping) {
+        lock.unlock();
+        callback(Result(ERROR_CODE::SOCKET_ADDRESS_PARSE_FAILED, "Resolver stopped"), {});
+        return;
+    }
+
+    auto& waiters = m_inFlight[host];
+    if (!waiters.empty()) {
+        m_stats.Coalesced++;
+    } else {
+        m_queue.push_back(host);
+        m_condition.notify_one();
+    }
+    waiters.push_back(Waiter{port, std::move(callback)});
+}
+
+ResolveResult DnsResolver::Resolve(const std::string& host, uint16_t port) {
+    auto promise = std::make_shared<std::promise<ResolveResult>>();
+    auto future = promise->get_future();
+    ResolveAsync(host, port, [promise](const Result& status, const std::vector<ResolvedAddress>& addresses) {
+        promise->set_value({status, addresses});
+    });
+    return future.get();
+}
+
+void DnsResolver::ClearCache() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cache.clear();
+}
+
+DnsResolverStats DnsResolver::Stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DnsResolverStats stats = m_stats;
+    stats.CachedHosts = m_cache.size();
+    return stats;
+}
+
+void DnsResolver::ResolverThread() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_condition.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+        if (m_stopping) {
+            return;
+        }
+
+        std::string host = std::move(m_queue.front());
+        m_queue.pop_front();
+
+        lock.unlock();
+        CacheEntry entry = Query(host);
+        lock.lock();
+
+        m_stats.Queries++;
+        if (entry.Status.IsError()) {
+            m_stats.Failures++;
+        }
+        if (m_cache.find(host) == m_cache.end()) {
+            MakeRoomInCache();
+        }
+        m_cache[host] = entry;
+
+        std::vector<Waiter> waiters;
+        auto inFlight = m_inFlight.find(host);
+        if (inFlight != m_inFlight.end()) {
+            waiters.swap(inFlight->second);
+            m_inFlight.erase(inFlight);
+        }
+
+        lock.unlock();
+        for (auto& waiter : waiters) {
+            waiter.Callback(entry.Status, WithPort(entry.Addresses, waiter.Port));
+        }
+        lock.lock();
+    }
+}
+
+void DnsResolver::MakeRoomInCache() {
+    if (m_cache.size() < m_maxCachedHosts) {
+        return;
+    }
+
+    // Hosts looked up once are never erased on lookup, so sweep them here
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        it = it->second.Expires <= now ? m_cache.erase(it) : std::next(it);
+    }
+    if (m_cache.size() < m_maxCachedHosts) {
+        return;
+    }
+
+    auto soonest = std::min_element(m_cache.begin(), m_cache.end(), [](const auto& a, const auto& b) {
+        return a.second.Expires < b.second.Expires;
+    });
+    m_cache.erase(soonest);
+    m_stats.Evictions++;
+}
+
+DnsResolver::CacheEntry DnsResolver::Query(const std::string& host) {
+    CacheEntry entry;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    struct addrinfo* raw = nullptr;
+    int status = getaddrinfo(host.c_str(), nullptr, &hints, &raw);
+    AddrInfoGuard addrInfo(raw);
+
+    if (status == 0 && addrInfo) {
+        for (const auto& info : addrInfo) {
+            if ((info.ai_family != AF_INET && info.ai_family != AF_INET6) ||
+                info.ai_addrlen > sizeof(sockaddr_storage)) {
+                continue;
+            }
+            ResolvedAddress address;
+            memcpy(&address.Address, info.ai_addr, info.ai_addrlen);
+            address.Length = info.ai_addrlen;
+            address.Family = info.ai_family == AF_INET6 ? SOCKET_FAMILY::IPV6 : SOCKET_FAMILY::IPV4;
+
+            bool duplicate = std::any_of(entry.Addresses.begin(), entry.Addresses.end(),
+                                         [&address](const ResolvedAddress& other) { return SameAddress(address, other); });
+            if (!duplicate) {
+                entry.Addresses.push_back(address);
+            }
+        }
+    }
+
+    if (entry.Addresses.empty()) {
+        std::string reason = status != 0 ? gai_strerror(status) : "no usable addresses";
+        entry.Status = Result(ERROR_CODE::SOCKET_ADDRESS_PARSE_FAILED, "Could not resolve " + host + ": " + reason);
+    }
+
+    entry.Expires = std::chrono::steady_clock::now() + (entry.Status.IsSuccess() ? m_ttl : m_negativeTtl);
+    return entry;
+}
+
+bool DnsResolver::ParseLiteral(const std::string& host, uint16_t port, ResolvedAddress& address) {
+    // Accept bracketed IPv6 literals as they appear in URLs
+    std::string literal = host;
+    if (literal.size() > 2 && literal.front() == '[' && literal.back() == ']') {
+        literal = literal.substr(1, literal.size() - 2);
+    }
+
+    auto* addr4 = reinterpret_cast<struct sockaddr_in*>(&address.Address);
+    if (inet_pton(AF_INET, literal.c_str(), &addr4->sin_addr) == 1) {
+        addr4->sin_family = AF_INET;
+        addr4->sin_port = htons(port);
+        address.Length = sizeof(struct sockaddr_in);
+        address.Family = SOCKET_FAMILY::IPV4;
+        return true;
+    }
+
+    auto* addr6 = reinterpret_cast<struct sockaddr_in6*>(&address.Address);
+    if (inet_pton(AF_INET6, literal.c_str(), &addr6->sin6_addr) == 1) {
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(port);
+        address.Length = sizeof(struct sockaddr_in6);
+        address.Family = SOCKET_FAMILY::IPV6;
+        return true;
+    }
+
+    return false;
+}
+
+std::vector<ResolvedAddress> DnsResolver::WithPort(const std::vector<ResolvedAddress>& addresses, uint16_t port) {
+    std::vector<ResolvedAddress> result = addresses;
+    for (auto& address : result) {
+        if (address.Family == SOCKET_FAMILY::IPV6) {
+            reinterpret_cast<struct sockaddr_in6*>(&address.Address)->sin6_port = htons(port);
+        } else {
+            reinterpret_cast<struct sockaddr_in*>(&address.Address)->sin_port = htons(port);
+        }
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Connector
+// ---------------------------------------------------------------------------
+
+Connector::Connector(size_t resolverThreads)
+    : m_resolver(resolverThreads) {
+}
+
+Connector::~Connector() {
+    Stop();
+}
+
+Connector& Connector::Shared() {
+    // Intentionally leaked: callers may still be connecting during static teardown
+    static Connector* connector = new Connector();
+    return *connector;
+}
+
+Result Connector::ConnectAsync(const std::string& host, uint16_t port, ConnectCallbackFn callback,
+                               const ConnectOptions& options) {
+    if (!callback) {
+        return Result(ERROR_CODE::INVALID_PARAMETER, "Connect callback is required");
+    }
+    if (host.empty() || port == 0) {
+        return Result(ERROR_CODE::INVALID_PARAMETER, "Host and port are required");
+    }
+
+    auto request = std::make_unique<Request>();
+    request->Id = m_nextId.fetch_add(1);
+    request->Host = host;
+    request->Port = port;
+    request->Options = options;
+    request->Callback = std::move(callback);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running) {
+        Result startResult = StartLoop();
+        if (startResult.IsError()) {
+            return startResult;
+        }
+    }
+    m_submitted.push_back(std::move(request));
+    m_pending++;
+    Wake();
+    return Result();
+}
+
+std::pair<Result, std::unique_ptr<Socket>> Connector::Connect(const std::string& host, uint16_t port,
+                                                               const ConnectOptions& options) {
+    using Outcome = std::pair<Result, std::unique_ptr<Socket>>;
+    auto promise = std::make_shared<std::promise<Outcome>>();
+    auto future = promise->get_future();
+
+    Result submitResult = ConnectAsync(host, port, [promise](const Result& result, std::unique_ptr<Socket> connection) {
+        promise->set_value(Outcome(result, std::move(connection)));
+    }, options);
+    if (submitResult.IsError()) {
+        return {submitResult, nullptr};
+    }
+    return future.get();
+}
+
+size_t Connector::PendingConnections() const {
+    return m_pending.load();
+}
+
+void Connector::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+        Wake();
+    }
+    if (m_loopThread.joinable()) {
+        m_loopThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+#ifndef _WIN32
+    close(m_epollFd);
+    close(m_wakeFd);
+    m_epollFd = -1;
+    m_wakeFd = -1;
+#endif
+}
+
+// Called with m_mutex held
+Result Connector::StartLoop() {
+    if (m_loopThread.joinable()) {
+        m_loopThread.join();
+    }
+#ifndef _WIN32
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd == -1) {
+        return Result(ERROR_CODE::UNKNOWN_ERROR, GetLastSystemErrorCode());
+    }
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeFd == -1) {
+        Result result(ERROR_CODE::UNKNOWN_ERROR, GetLastSystemErrorCode());
+        close(m_epollFd);
+        m_epollFd = -1;
+        return result;
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = m_wakeFd;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+#endif
+
+    m_running = true;
+    try {
+        m_loopThread = std::thread(&Connector::EventLoop, this);
+    } catch (const std::exception&) {
+        m_running = false;
+        return Result(ERROR_CODE::THREAD_CREATION_FAILED, "Failed to start connector thread");
+    }
+    return Result();
+}
+
+// Called with m_mutex held
+void Connector::Wake() {
+#ifndef _WIN32
+    if (m_wakeFd != -1) {
+        uint64_t one = 1;
+        ssize_t written = write(m_wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+#endif
+}
+
+void Connector::EventLoop() {
+    while (m_running) {
+        DrainSubmissions();
+
+        int waitMs = kMaxWaitMs;
+        ServiceTimers(Clock::now(), waitMs);
+
+        WaitForEvents(waitMs);
+        for (intptr_t handle : m_ready) {
+            HandleWritable(handle);
+        }
+    }
+
+    // Fail everything still outstanding
+    DrainSubmissions();
+    Result stopped(ERROR_CODE::SOCKET_CONNECT_FAILED, "Connector stopped");
+    while (!m_requests.empty()) {
+        Finish(m_requests.begin()->first, stopped, nullptr);
+    }
+}
+
+void Connector::DrainSubmissions() {
+    std::vector<std::unique_ptr<Request>> submitted;
+    std::vector<Resolution> resolutions;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        submitted.swap(m_submitted);
+        resolutions.swap(m_resolutions);
+    }
+
+    Clock::time_point now = Clock::now();
+    for (auto& request : submitted) {
+        uint64_t id = request->Id;
+        request->Deadline = now + std::chrono::milliseconds(request->Options.TimeoutMs);
+        std::string host = request->Host;
+        uint16_t port = request->Port;
+        m_requests.emplace(id, std::move(request));
+
+        m_resolver.ResolveAsync(host, port, [this, id](const Result& status, const std::vector<ResolvedAddress>& addresses) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running) {
+                return;
+            }
+            m_resolutions.push_back(Resolution{id, status, addresses});
+            Wake();
+        });
+    }
+
+    for (auto& resolution : resolutions) {
+        auto found = m_requests.find(resolution.Id);
+        if (found == m_requests.end()) {
+            continue; // Timed out while resolving
+        }
+        if (resolution.Status.IsError()) {
+            Finish(resolution.Id, resolution.Status, nullptr);
+            continue;
+        }
+        Request& request = *found->second;
+        request.Resolved = true;
+        request.Addresses = InterleaveFamilies(resolution.Addresses, request.Options.PreferIPv6);
+        StartNextAttempt(request);
+    }
+}
+
+void Connector::StartNextAttempt(Request& request) {
+    while (request.NextAddress < request.Addresses.size()) {
+        const ResolvedAddress& address = request.Addresses[request.NextAddress++];
+
+        auto connection = std::make_unique<Socket>();
+        Result result = connection->Create(address.Family, SOCKET_TYPE::TCP);
+        if (result.IsSuccess()) {
+            result = connection->Blocking(false);
+        }
+        if (result.IsSuccess()) {
+            connection->ApplyProfile(request.Options.Profile);
+            result = connection->Connect(reinterpret_cast<const struct sockaddr*>(&address.Address), address.Length);
+        }
+
+        if (result.IsSuccess()) {
+            Finish(request.Id, result, std::move(connection)); // Connected immediately
+            return;
+        }
+        if (Socket::ConnectPending(result)) {
+            intptr_t handle = static_cast<intptr_t>(connection->m_socket);
+            if (Watch(handle, request.Id)) {
+                request.Attempts.push_back(Attempt{std::move(connection), address});
+                request.NextAttempt = Clock::now() + std::chrono::milliseconds(request.Options.AttemptDelayMs);
+                return;
+            }
+            result = Result(ERROR_CODE::SOCKET_CONNECT_FAILED, GetLastSystemErrorCode());
+        }
+        request.LastError = result;
+    }
+
+    if (request.Attempts.empty()) {
+        Finish(request.Id, request.LastError, nullptr);
+    }
+}
+
+void Connector::HandleWritable(intptr_t handle) {
+    auto watched = m_watched.find(handle);
+    if (watched == m_watched.end()) {
+        return;
+    }
+    uint64_t id = watched->second;
+
+    auto found = m_requests.find(id);
+    if (found == m_requests.end()) {
+        Unwatch(handle);
+        return;
+    }
+    Request& request = *found->second;
+    auto attempt = std::find_if(request.Attempts.begin(), request.Attempts.end(), [handle](const Attempt& candidate) {
+        return static_cast<intptr_t>(candidate.Connection->m_socket) == handle;
+    });
+    if (attempt == request.Attempts.end()) {
+        Unwatch(handle);
+        return;
+    }
+
+    // The descriptor may have been reused by a newer attempt since this batch of events was
+    // collected; only a socket that is writable right now has finished connecting
+    auto [waitResult, writable] = attempt->Connection->WaitWritable(0);
+    if (waitResult.IsSuccess() && !writable) {
+        return;
+    }
+    Unwatch(handle);
+
+    Result result = attempt->Connection->ConnectComplete();
+    if (result.IsSuccess()) {
+        std::unique_ptr<Socket> connection = std::move(attempt->Connection);
+        request.Attempts.erase(attempt);
+        Finish(id, result, std::move(connection));
+        return;
+    }
+
+    // RFC 8305: a failed attempt starts the next one without waiting for the delay
+    request.LastError = result;
+    request.Attempts.erase(attempt);
+    StartNextAttempt(request);
+}
+
+void Connector::ServiceTimers(Clock::time_point now, int& waitMs) {
+    std::vector<uint64_t> expired;
+    std::vector<uint64_t> due;
+
+    for (auto& entry : m_requests) {
+        Request& request = *entry.second;
+        if (now >= request.Deadline) {
+            expired.push_back(entry.first);
+            continue;
+        }
+
+        Clock::time_point next = request.Deadline;
+        if (request.Resolved && request.NextAddress < request.Addresses.size()) {
+            if (now >= request.NextAttempt) {
+                due.push_back(entry.first);
+                continue;
+            }
+            next = std::min(next, request.NextAttempt);
+        }
+        auto untilNext = std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count() + 1;
+        waitMs = std::min<int>(waitMs, static_cast<int>(untilNext));
+    }
+
+    for (uint64_t id : expired) {
+        Finish(id, Result(ERROR_CODE::SOCKET_CONNECT_FAILED, kTimedOutError), nullptr);
+    }
+    for (uint64_t id : due) {
+        auto found = m_requests.find(id);
+        if (found != m_requests.end()) {
+            StartNextAttempt(*found->second);
+        }
+    }
+    if (!due.empty()) {
+        waitMs = 0; // Recompute timers for the attempts just started
+    }
+}
+
+void Connector::Finish(uint64_t id, const Result& result, std::unique_ptr<Socket> connection) {
+    auto found = m_requests.find(id);
+    if (found == m_requests.end()) {
+        return;
+    }
+    std::unique_ptr<Request> request = std::move(found->second);
+    m_requests.erase(found);
+
+    // Losing attempts are abandoned; closing them cancels the handshakes
+    for (auto& attempt : request->Attempts) {
+        Unwatch(static_cast<intptr_t>(attempt.Connection->m_socket));
+    }
+    request->Attempts.clear();
+
+    Result outcome = result;
+    if (connection && !request->Options.NonBlocking) {
+        outcome = connection->Blocking(true);
+        if (outcome.IsError()) {
+            connection.reset();
+        }
+    }
+
+    m_pending--;
+    request->Callback(outcome, std::move(connection));
+}
+
+std::vector<ResolvedAddress> Connector::InterleaveFamilies(const std::vector<ResolvedAddress>& addresses, bool preferIPv6) {
+    SOCKET_FAMILY first = preferIPv6 ? SOCKET_FAMILY::IPV6 : SOCKET_FAMILY::IPV4;
+    std::vector<ResolvedAddress> preferred;
+    std::vector<ResolvedAddress> other;
+    for (const auto& address : addresses) {
+        (address.Family == first ? preferred : other).push_back(address);
+    }
+
+    // RFC 8305 section 4: alternate families, starting with the preferred one
+    std::vector<ResolvedAddress> ordered;
+    ordered.reserve(addresses.size());
+    for (size_t i = 0; i < std::max(preferred.size(), other.size()); i++) {
+        if (i < preferred.size()) ordered.push_back(preferred[i]);
+        if (i < other.size()) ordered.push_back(other[i]);
+    }
+    return ordered;
+}
+
+#ifdef _WIN32
+
+bool Connector::Watch(intptr_t handle, uint64_t id) {
+    m_watched[handle] = id;
+    return true;
+}
+
+void Connector::Unwatch(intptr_t handle) {
+    m_watched.erase(handle);
+}
+
+size_t Connector::WaitForEvents(int timeoutMs) {
+    m_ready.clear();
+    timeoutMs = std::min(timeoutMs, kMaxWaitMs);
+    if (m_watched.empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+        return 0;
+    }
+
+    m_pollFds.clear();
+    for (const auto& entry : m_watched) {
+        WSAPOLLFD pfd;
+        pfd.fd = static_cast<SOCKET>(entry.first);
+        pfd.events = POLLWRNORM;
+        pfd.revents = 0;
+        m_pollFds.push_back(pfd);
+    }
+
+    int count = WSAPoll(m_pollFds.data(), static_cast<ULONG>(m_pollFds.size()), timeoutMs);
+    for (int i = 0; count > 0 && i < static_cast<int>(m_pollFds.size()); i++) {
+        if (m_pollFds[i].revents != 0) {
+            m_ready.push_back(static_cast<intptr_t>(m_pollFds[i].fd));
+        }
+    }
+    return m_ready.size();
+}
+
+#else
+
+bool Connector::Watch(intptr_t handle, uint64_t id) {
+    struct epoll_event event;
+    event.events = EPOLLOUT;
+    event.data.fd = static_cast<int>(handle);
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, static_cast<int>(handle), &event) != 0) {
+        return false;
+    }
+    m_watched[handle] = id;
+    return true;
+}
+
+void Connector::Unwatch(intptr_t handle) {
+    if (m_watched.erase(handle) > 0) {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, static_cast<int>(handle), nullptr);
+    }
+}
+
+size_t Connector::WaitForEvents(int timeoutMs) {
+    m_ready.clear();
+
+    struct epoll_event events[64];
+    int count = epoll_wait(m_epollFd, events, 64, timeoutMs);
+    for (int i = 0; i < count; i++) {
+        if (events[i].data.fd == m_wakeFd) {
+            uint64_t value = 0;
+            ssize_t drained = read(m_wakeFd, &value, sizeof(value));
+            (void)drained;
+            continue;
+        }
+        m_ready.push_back(events[i].data.fd);
+    }
+    return m_ready.size();
+}
+
+#endif
+
+} // namespace WebSocket
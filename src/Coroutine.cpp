@@ -0,0 +1,750 @@
+#include "WebSocket/Coroutine.h"
+
+#if WEBSOCKET_HAS_COROUTINES
+
+#include "WebSocket/WebSocketProtocol.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace WebSocket {
+
+namespace {
+
+const size_t kReadChunk = 16 * 1024;
+const size_t kMaxHandshakeSize = 16 * 1024;
+
+// A socket whose data is always ready never suspends; after this many
+// operations in a row it yields so the other connections get a turn
+const unsigned kMaxInlineCompletions = 1;
+
+#ifdef _WIN32
+// WSAPoll cannot be woken by Spawn()/Stop() from another thread, so never sleep long
+const int kMaxWaitMs = 10;
+#else
+const int kMaxEvents = 128;
+const uint64_t kWakeMarker = ~uint64_t(0);
+#endif
+
+WebSocketMessage NoMessage() {
+    return WebSocketMessage{WEBSOCKET_OPCODE::TEXT, {}};
+}
+
+} // namespace
+
+/**
+ * Owns a spawned task. It starts when the context first resumes it and, on
+ * completion, unregisters and destroys its own frame.
+ */
+struct IoContext::DetachedTask {
+    struct promise_type {
+        promise_type(IoContext& context, Task<void>&) : Context(context) {}
+
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                IoContext& context = handle.promise().Context;
+                {
+                    std::lock_guard<std::mutex> lock(context.m_postMutex);
+                    context.m_detached.erase(handle.address());
+                }
+                handle.destroy();
+                context.m_liveTasks.fetch_sub(1, std::memory_order_acq_rel);
+            }
+            void await_resume() const noexcept {}
+        };
+
+        DetachedTask get_return_object() noexcept {
+            return DetachedTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+
+        IoContext& Context;
+    };
+
+    std::coroutine_handle<promise_type> Handle;
+};
+
+IoContext::DetachedTask IoContext::RunDetached(IoContext& context, Task<void> task) {
+    (void)context;
+    try {
+        co_await task;
+    } catch (const std::exception&) {
+        // The task owns its error reporting; the context keeps running
+    }
+}
+
+IoContext::IoContext() {
+#ifndef _WIN32
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epollFd != -1 && m_wakeFd != -1) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = kWakeMarker;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+    }
+#endif
+}
+
+IoContext::~IoContext() {
+    // Destroying a spawned frame destroys the tasks it is awaiting, innermost last
+    for (void* address : m_detached) {
+        std::coroutine_handle<>::from_address(address).destroy();
+    }
+#ifndef _WIN32
+    if (m_wakeFd != -1) {
+        close(m_wakeFd);
+    }
+    if (m_epollFd != -1) {
+        close(m_epollFd);
+    }
+#endif
+}
+
+bool IoContext::Valid() const {
+#ifndef _WIN32
+    return m_epollFd != -1 && m_wakeFd != -1;
+#else
+    return true;
+#endif
+}
+
+void IoContext::Spawn(Task<void> task) {
+    DetachedTask detached = RunDetached(*this, std::move(task));
+    m_liveTasks.fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::lock_guard<std::mutex> lock(m_postMutex);
+        m_detached.insert(detached.Handle.address());
+        m_posted.push_back(detached.Handle);
+    }
+    Wake();
+}
+
+void IoContext::Run() {
+    std::vector<std::coroutine_handle<>> batch;
+
+    while (!m_stopped.load(std::memory_order_acquire) && m_liveTasks.load(std::memory_order_acquire) > 0) {
+        {
+            std::lock_guard<std::mutex> lock(m_postMutex);
+            m_ready.insert(m_ready.end(), m_posted.begin(), m_posted.end());
+            m_posted.clear();
+        }
+
+        // Poll without blocking while coroutines are runnable so I/O is never starved
+        WaitForEvents(m_ready.empty() ? NextTimeoutMs() : 0);
+        FireTimers();
+
+        // Coroutines made ready while this batch runs wait for the next pass
+        batch.swap(m_ready);
+        for (std::coroutine_handle<> handle : batch) {
+            handle.resume();
+        }
+        batch.clear();
+    }
+
+    m_stopped.store(false, std::memory_order_release);
+}
+
+void IoContext::Stop() {
+    m_stopped.store(true, std::memory_order_release);
+    Wake();
+}
+
+void IoContext::Forget(intptr_t handle) {
+    auto it = m_registrations.find(handle);
+    if (it == m_registrations.end()) {
+        return;
+    }
+#ifndef _WIN32
+    if (it->second.Added) {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, static_cast<int>(handle), nullptr);
+    }
+#endif
+    // Anything still waiting retries, and fails, against the closed socket
+    if (it->second.Reader) {
+        m_ready.push_back(it->second.Reader);
+    }
+    if (it->second.Writer) {
+        m_ready.push_back(it->second.Writer);
+    }
+    m_registrations.erase(it);
+}
+
+void IoContext::Post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(m_postMutex);
+        m_posted.push_back(handle);
+    }
+    Wake();
+}
+
+void IoContext::Wake() {
+#ifndef _WIN32
+    uint64_t one = 1;
+    ssize_t written = write(m_wakeFd, &one, sizeof(one));
+    (void)written;
+#endif
+}
+
+void IoContext::AddWaiter(intptr_t handle, bool write, std::coroutine_handle<> coroutine) {
+    Registration& registration = m_registrations[handle];
+    (write ? registration.Writer : registration.Reader) = coroutine;
+
+#ifndef _WIN32
+    // Registered once, edge-triggered: callers always try the operation first
+    // and only wait after it would block, so no edge is missed
+    if (!registration.Added) {
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.u64 = static_cast<uint64_t>(handle);
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, static_cast<int>(handle), &event) == 0) {
+            registration.Added = true;
+        } else {
+            // Not pollable (or already closed): let the operation report the error
+            (write ? registration.Writer : registration.Reader) = nullptr;
+            m_ready.push_back(coroutine);
+        }
+    }
+#endif
+}
+
+void IoContext::AddTimer(std::chrono::milliseconds duration, std::coroutine_handle<> coroutine) {
+    m_timers.push(Timer{Clock::now() + duration, m_timerSequence++, coroutine});
+}
+
+int IoContext::NextTimeoutMs() const {
+    int timeoutMs = -1;
+    if (!m_timers.empty()) {
+        auto remaining = m_timers.top().Deadline - Clock::now();
+        if (remaining <= Clock::duration::zero()) {
+            timeoutMs = 0;
+        } else {
+            // Round up so the wait never ends just before the deadline and spins
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(remaining + std::chrono::milliseconds(1) -
+                                                                            Clock::duration(1));
+            timeoutMs = static_cast<int>(std::min<long long>(ms.count(), 60 * 1000));
+        }
+    }
+#ifdef _WIN32
+    if (timeoutMs < 0 || timeoutMs > kMaxWaitMs) {
+        timeoutMs = kMaxWaitMs;
+    }
+#endif
+    return timeoutMs;
+}
+
+void IoContext::FireTimers() {
+    const auto now = Clock::now();
+    while (!m_timers.empty() && m_timers.top().Deadline <= now) {
+        m_ready.push_back(m_timers.top().Coroutine);
+        m_timers.pop();
+    }
+}
+
+void IoContext::WaitForEvents(int timeoutMs) {
+#ifndef _WIN32
+    epoll_event events[kMaxEvents];
+    int count = epoll_wait(m_epollFd, events, kMaxEvents, timeoutMs);
+    for (int i = 0; i < count; i++) {
+        if (events[i].data.u64 == kWakeMarker) {
+            uint64_t value = 0;
+            ssize_t readBytes = read(m_wakeFd, &value, sizeof(value));
+            (void)readBytes;
+            continue;
+        }
+
+        auto it = m_registrations.find(static_cast<intptr_t>(events[i].data.u64));
+        if (it == m_registrations.end()) {
+            continue;
+        }
+        Registration& registration = it->second;
+        const uint32_t flags = events[i].events;
+
+        // Errors and hang-ups wake both sides; the next operation reports them
+        if ((flags & (EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLRDHUP)) && registration.Reader) {
+            m_ready.push_back(std::exchange(registration.Reader, nullptr));
+        }
+        if ((flags & (EPOLLOUT | EPOLLERR | EPOLLHUP)) && registration.Writer) {
+            m_ready.push_back(std::exchange(registration.Writer, nullptr));
+        }
+    }
+#else
+    std::vector<WSAPOLLFD> fds;
+    std::vector<intptr_t> handles;
+    for (const auto& entry : m_registrations) {
+        if (!entry.second.Reader && !entry.second.Writer) {
+            continue;
+        }
+        WSAPOLLFD fd{};
+        fd.fd = static_cast<SOCKET>(entry.first);
+        fd.events = static_cast<SHORT>((entry.second.Reader ? POLLRDNORM : 0) | (entry.second.Writer ? POLLWRNORM : 0));
+        fds.push_back(fd);
+        handles.push_back(entry.first);
+    }
+    if (fds.empty()) {
+        if (timeoutMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+        }
+        return;
+    }
+
+    int count = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeoutMs);
+    for (size_t i = 0; count > 0 && i < fds.size(); i++) {
+        const SHORT flags = fds[i].revents;
+        if (flags == 0) {
+            continue;
+        }
+        Registration& registration = m_registrations[handles[i]];
+        if ((flags & (POLLRDNORM | POLLERR | POLLHUP)) && registration.Reader) {
+            m_ready.push_back(std::exchange(registration.Reader, nullptr));
+        }
+        if ((flags & (POLLWRNORM | POLLERR | POLLHUP)) && registration.Writer) {
+            m_ready.push_back(std::exchange(registration.Writer, nullptr));
+        }
+    }
+#endif
+}
+
+AsyncSocket::AsyncSocket(IoContext& context, std::unique_ptr<Socket> socket)
+    : m_context(context), m_socket(std::move(socket)) {
+    if (m_socket && m_socket->Valid()) {
+        m_socket->Blocking(false);
+    }
+}
+
+AsyncSocket::~AsyncSocket() {
+    Close();
+}
+
+std::pair<Result, std::unique_ptr<AsyncSocket>> AsyncSocket::Listen(IoContext& context, const std::string& address,
+                                                                    uint16_t port, int backlog) {
+    auto socket = std::make_unique<Socket>();
+    SOCKET_FAMILY family = Socket::IsIPv6Address(address) ? SOCKET_FAMILY::IPV6 : SOCKET_FAMILY::IPV4;
+
+    Result result = socket->Create(family, SOCKET_TYPE::TCP);
+    if (result.IsError()) {
+        return {result, nullptr};
+    }
+    socket->ReuseAddress(true);
+    result = socket->Bind(address, port);
+    if (result.IsError()) {
+        return {result, nullptr};
+    }
+    result = socket->Listen(backlog);
+    if (result.IsError()) {
+        return {result, nullptr};
+    }
+    return {Result(), std::make_unique<AsyncSocket>(context, std::move(socket))};
+}
+
+Task<std::pair<Result, std::unique_ptr<AsyncSocket>>> AsyncSocket::Connect(IoContext& context, std::string address,
+                                                                           uint16_t port) {
+    auto socket = std::make_unique<Socket>();
+    SOCKET_FAMILY family = Socket::IsIPv6Address(address) ? SOCKET_FAMILY::IPV6 : SOCKET_FAMILY::IPV4;
+
+    Result result = socket->Create(family, SOCKET_TYPE::TCP);
+    if (result.IsError()) {
+        co_return {result, nullptr};
+    }
+    auto connection = std::make_unique<AsyncSocket>(context, std::move(socket));
+
+    result = connection->Native().Connect(address, port);
+    if (result.IsError()) {
+        if (!Socket::ConnectPending(result)) {
+            co_return {result, nullptr};
+        }
+        co_await context.WaitWritable(connection->Native().NativeHandle());
+        result = connection->Native().ConnectComplete();
+        if (result.IsError()) {
+            co_return {result, nullptr};
+        }
+    }
+    co_return {Result(), std::move(connection)};
+}
+
+Task<std::pair<Result, std::unique_ptr<AsyncSocket>>> AsyncSocket::Accept() {
+    std::vector<std::unique_ptr<Socket>> accepted;
+    if (++m_inlineCompletions > kMaxInlineCompletions) {
+        m_inlineCompletions = 0;
+        co_await m_context.Yield();
+    }
+    for (;;) {
+        Result result = m_socket->AcceptBatch(accepted, 1, true);
+        if (result.IsError()) {
+            co_return {result, nullptr};
+        }
+        if (!accepted.empty()) {
+            co_return {Result(), std::make_unique<AsyncSocket>(m_context, std::move(accepted.front()))};
+        }
+        m_inlineCompletions = 0;
+        co_await m_context.WaitReadable(m_socket->NativeHandle());
+    }
+}
+
+Task<ReceiveIntoResult> AsyncSocket::Recv(void* buffer, size_t size) {
+    if (++m_inlineCompletions > kMaxInlineCompletions) {
+        m_inlineCompletions = 0;
+        co_await m_context.Yield();
+    }
+    for (;;) {
+        ReceiveIntoResult received = m_socket->ReceiveInto(buffer, size);
+        if (!Socket::WouldBlock(received.first)) {
+            co_return received;
+        }
+        m_inlineCompletions = 0;
+        co_await m_context.WaitReadable(m_socket->NativeHandle());
+    }
+}
+
+Task<Result> AsyncSocket::Send(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    size_t sent = 0;
+    while (sent < length) {
+        SendResult result = m_socket->SendRaw(bytes + sent, length - sent);
+        sent += result.second;
+        if (result.first.IsError()) {
+            if (!Socket::WouldBlock(result.first)) {
+                co_return result.first;
+            }
+            co_await m_context.WaitWritable(m_socket->NativeHandle());
+        }
+    }
+    co_return Result();
+}
+
+void AsyncSocket::Close() {
+    if (m_socket && m_socket->Valid()) {
+        m_context.Forget(m_socket->NativeHandle());
+        m_socket->Close();
+    }
+}
+
+AsyncWebSocket::AsyncWebSocket(std::unique_ptr<AsyncSocket> socket, bool client)
+    : m_socket(std::move(socket)), m_client(client), m_receiveBuffer(kReadChunk) {
+    // Frames are written whole, so Nagle would only delay them
+    m_socket->Native().NoDelay(true);
+
+    // Masking keys only need to be unpredictable to intermediaries, not cryptographically strong
+    std::random_device rd;
+    m_maskState = (static_cast<uint64_t>(rd()) << 32) ^ rd() ^ reinterpret_cast<uintptr_t>(this);
+    if (m_maskState == 0) {
+        m_maskState = 0x9E3779B97F4A7C15ULL;
+    }
+}
+
+Task<std::pair<Result, std::unique_ptr<AsyncWebSocket>>> AsyncWebSocket::Accept(std::unique_ptr<AsyncSocket> socket) {
+    std::unique_ptr<AsyncWebSocket> connection(new AsyncWebSocket(std::move(socket), false));
+
+    auto [readResult, headerLength] = co_await connection->ReadHttpHeaders();
+    if (readResult.IsError()) {
+        co_return {readResult, nullptr};
+    }
+    // Parsed in place; nothing reads into the buffer again before the response is sent
+    std::string_view request(reinterpret_cast<const char*>(connection->m_receiveBuffer.data() + connection->m_receiveStart),
+                             headerLength);
+    connection->m_receiveStart += headerLength;
+
+    HandshakeRequestView view;
+    Result result = WebSocketProtocol::ParseHandshakeRequest(request, view);
+    if (result.IsError()) {
+        static const char kBadRequest[] =
+            "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        co_await connection->m_socket->Send(kBadRequest, sizeof(kBadRequest) - 1);
+        co_return {result, nullptr};
+    }
+
+    char response[WebSocketProtocol::kHandshakeResponseSize];
+    size_t responseSize = WebSocketProtocol::WriteHandshakeResponse(view.Key, std::string_view(), std::string_view(),
+                                                                    response, sizeof(response));
+    result = co_await connection->m_socket->Send(response, responseSize);
+    if (result.IsError()) {
+        co_return {result, nullptr};
+    }
+    co_return {Result(), std::move(connection)};
+}
+
+Task<std::pair<Result, std::unique_ptr<AsyncWebSocket>>> AsyncWebSocket::Connect(IoContext& context, std::string address,
+                                                                                 uint16_t port, std::string path) {
+    auto [connectResult, socket] = co_await AsyncSocket::Connect(context, address, port);
+    if (connectResult.IsError()) {
+        co_return {connectResult, nullptr};
+    }
+    std::unique_ptr<AsyncWebSocket> connection(new AsyncWebSocket(std::move(socket), true));
+
+    std::string key = WebSocketProtocol::GenerateClientKey();
+    std::string request = WebSocketProtocol::GenerateHandshakeRequest(address, port, path.empty() ? "/" : path, key);
+    Result result = co_await connection->m_socket->Send(request.data(), request.size());
+    if (result.IsError()) {
+        co_return {result, nullptr};
+    }
+
+    auto [readResult, headerLength] = co_await connection->ReadHttpHeaders();
+    if (readResult.IsError()) {
+        co_return {readResult, nullptr};
+    }
+    std::string response(reinterpret_cast<const char*>(connection->m_receiveBuffer.data() + connection->m_receiveStart),
+                         headerLength);
+    connection->m_receiveStart += headerLength;
+
+    result = WebSocketProtocol::ValidateHandshakeResponse(response, key);
+    if (result.IsError()) {
+        co_return {result, nullptr};
+    }
+    co_return {Result(), std::move(connection)};
+}
+
+Task<std::pair<Result, WebSocketMessage>> AsyncWebSocket::ReadMessage() {
+    WebSocketFrame frame;
+
+    for (;;) {
+        while (m_receiveStart < m_receiveEnd) {
+            uint8_t* data = m_receiveBuffer.data() + m_receiveStart;
+            size_t available = m_receiveEnd - m_receiveStart;
+            size_t headerSize = 0;
+
+            if (WebSocketProtocol::ParseFrameHeader(data, available, frame, headerSize).IsError()) {
+                break; // Header not complete yet
+            }
+
+            if (frame.PayloadLength > m_maxMessageSize) {
+                const uint8_t tooBig[2] = {0x03, 0xF1}; // 1009 Message Too Big
+                m_closeSent = true;
+                co_await SendFrame(WEBSOCKET_OPCODE::CLOSE, tooBig, sizeof(tooBig));
+                co_return {Result(ERROR_CODE::WEBSOCKET_PAYLOAD_TOO_LARGE, "Incoming frame exceeds the message size limit"),
+                           NoMessage()};
+            }
+            if (frame.PayloadLength > available - headerSize) {
+                break; // Payload not complete yet; Fill() grows the buffer as needed
+            }
+
+            uint8_t* payload = data + headerSize;
+            size_t length = static_cast<size_t>(frame.PayloadLength);
+            m_receiveStart += headerSize + length;
+
+            if (frame.Masked) {
+                WebSocketProtocol::ApplyMask(payload, length, frame.MaskingKey.data());
+            }
+
+            bool fragmented = m_fragmentOpcode != WEBSOCKET_OPCODE::CONTINUATION;
+            const char* protocolError = nullptr;
+
+            switch (frame.Opcode) {
+                case WEBSOCKET_OPCODE::TEXT:
+                case WEBSOCKET_OPCODE::BINARY:
+                    if (fragmented) {
+                        protocolError = "New message started inside a fragmented message";
+                    } else if (frame.Fin) {
+                        co_return {Result(), WebSocketMessage{frame.Opcode, std::vector<uint8_t>(payload, payload + length)}};
+                    } else {
+                        m_fragmentOpcode = frame.Opcode;
+                        m_fragments.assign(payload, payload + length);
+                    }
+                    break;
+
+                case WEBSOCKET_OPCODE::CONTINUATION:
+                    if (!fragmented) {
+                        protocolError = "Continuation frame without a message to continue";
+                    } else if (m_fragments.size() + length > m_maxMessageSize) {
+                        const uint8_t tooBig[2] = {0x03, 0xF1};
+                        m_closeSent = true;
+                        co_await SendFrame(WEBSOCKET_OPCODE::CLOSE, tooBig, sizeof(tooBig));
+                        co_return {Result(ERROR_CODE::WEBSOCKET_PAYLOAD_TOO_LARGE,
+                                          "Reassembled message exceeds the message size limit"),
+                                   NoMessage()};
+                    } else {
+                        m_fragments.insert(m_fragments.end(), payload, payload + length);
+                        if (frame.Fin) {
+                            WebSocketMessage message{m_fragmentOpcode, std::move(m_fragments)};
+                            m_fragments.clear();
+                            m_fragmentOpcode = WEBSOCKET_OPCODE::CONTINUATION;
+                            co_return {Result(), std::move(message)};
+                        }
+                    }
+                    break;
+
+                case WEBSOCKET_OPCODE::PING:
+                case WEBSOCKET_OPCODE::PONG:
+                case WEBSOCKET_OPCODE::CLOSE:
+                    if (!frame.Fin || length > 125) {
+                        protocolError = "Fragmented or oversized control frame";
+                    } else if (frame.Opcode == WEBSOCKET_OPCODE::PING) {
+                        Result pongResult = co_await SendFrame(WEBSOCKET_OPCODE::PONG, payload, length);
+                        if (pongResult.IsError()) {
+                            co_return {pongResult, NoMessage()};
+                        }
+                    } else if (frame.Opcode == WEBSOCKET_OPCODE::CLOSE) {
+                        // Echo the status code back unless we started the close
+                        if (!m_closeSent) {
+                            m_closeSent = true;
+                            co_await SendFrame(WEBSOCKET_OPCODE::CLOSE, payload, std::min<size_t>(length, 2));
+                        }
+                        co_return {Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED, "Peer closed the connection"),
+                                   NoMessage()};
+                    }
+                    break; // Unsolicited pongs are ignored
+
+                default:
+                    protocolError = "Reserved opcode";
+                    break;
+            }
+
+            if (protocolError) {
+                const uint8_t protocolErrorCode[2] = {0x03, 0xEA}; // 1002 Protocol Error
+                m_closeSent = true;
+                co_await SendFrame(WEBSOCKET_OPCODE::CLOSE, protocolErrorCode, sizeof(protocolErrorCode));
+                co_return {Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, protocolError), NoMessage()};
+            }
+        }
+
+        Result fillResult = co_await Fill();
+        if (fillResult.IsError()) {
+            co_return {fillResult, NoMessage()};
+        }
+    }
+}
+
+Task<Result> AsyncWebSocket::SendText(const std::string& text) {
+    co_return co_await SendFrame(WEBSOCKET_OPCODE::TEXT, reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+Task<Result> AsyncWebSocket::SendBinary(const std::vector<uint8_t>& data) {
+    co_return co_await SendFrame(WEBSOCKET_OPCODE::BINARY, data.data(), data.size());
+}
+
+Task<Result> AsyncWebSocket::Send(const WebSocketMessage& message) {
+    co_return co_await SendFrame(message.Opcode, message.Data.data(), message.Data.size());
+}
+
+Task<Result> AsyncWebSocket::Close(uint16_t code) {
+    if (m_closeSent) {
+        co_return Result();
+    }
+    m_closeSent = true;
+    const uint8_t payload[2] = {static_cast<uint8_t>(code >> 8), static_cast<uint8_t>(code & 0xFF)};
+    co_return co_await SendFrame(WEBSOCKET_OPCODE::CLOSE, payload, sizeof(payload));
+}
+
+Task<Result> AsyncWebSocket::SendFrame(WEBSOCKET_OPCODE opcode, const uint8_t* data, size_t length) {
+    // Nothing may follow our close frame (RFC 6455 section 5.5.1)
+    if (m_closeSent && opcode != WEBSOCKET_OPCODE::CLOSE) {
+        co_return Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED, "Close frame already sent");
+    }
+    while (m_sending) {
+        co_await SendTurn{*this};
+    }
+    m_sending = true;
+
+    // Clients mask (RFC 6455 section 5.3); servers send the payload as is
+    size_t headerSize = WebSocketProtocol::FrameHeaderSize(length, m_client);
+    m_sendBuffer.resize(headerSize + length);
+    uint8_t* frame = m_sendBuffer.data();
+    const uint8_t maskBit = m_client ? 0x80 : 0x00;
+
+    frame[0] = static_cast<uint8_t>(0x80 | (static_cast<uint8_t>(opcode) & 0x0F));
+    if (length < 126) {
+        frame[1] = static_cast<uint8_t>(maskBit | length);
+    } else if (length < 65536) {
+        frame[1] = maskBit | 126;
+        frame[2] = static_cast<uint8_t>((length >> 8) & 0xFF);
+        frame[3] = static_cast<uint8_t>(length & 0xFF);
+    } else {
+        frame[1] = maskBit | 127;
+        uint64_t extended = length;
+        for (int i = 0; i < 8; i++) {
+            frame[2 + i] = static_cast<uint8_t>((extended >> ((7 - i) * 8)) & 0xFF);
+        }
+    }
+    if (length > 0) {
+        memcpy(frame + headerSize, data, length);
+    }
+    if (m_client) {
+        uint8_t* mask = frame + headerSize - 4;
+        uint32_t maskValue = NextMask();
+        memcpy(mask, &maskValue, sizeof(maskValue));
+        WebSocketProtocol::ApplyMask(frame + headerSize, length, mask);
+    }
+
+    Result result = co_await m_socket->Send(frame, headerSize + length);
+
+    // Hand the connection straight to the next waiting sender
+    m_sending = false;
+    if (!m_sendWaiters.empty()) {
+        std::coroutine_handle<> next = m_sendWaiters.front();
+        m_sendWaiters.pop_front();
+        next.resume();
+    }
+    co_return result;
+}
+
+Task<Result> AsyncWebSocket::Fill() {
+    if (m_receiveStart == m_receiveEnd) {
+        m_receiveStart = 0;
+        m_receiveEnd = 0;
+    }
+    if (m_receiveEnd == m_receiveBuffer.size()) {
+        if (m_receiveStart > 0) {
+            memmove(m_receiveBuffer.data(), m_receiveBuffer.data() + m_receiveStart, m_receiveEnd - m_receiveStart);
+            m_receiveEnd -= m_receiveStart;
+            m_receiveStart = 0;
+        } else {
+            // One frame larger than the buffer; its size was checked against the limit
+            m_receiveBuffer.resize(m_receiveBuffer.size() * 2);
+        }
+    }
+
+    auto [result, received] = co_await m_socket->Recv(m_receiveBuffer.data() + m_receiveEnd,
+                                                      m_receiveBuffer.size() - m_receiveEnd);
+    if (result.IsError()) {
+        co_return result;
+    }
+    if (received == 0) {
+        co_return Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED, "Connection closed by peer");
+    }
+    m_receiveEnd += received;
+    co_return Result();
+}
+
+Task<std::pair<Result, size_t>> AsyncWebSocket::ReadHttpHeaders() {
+    static const char kTerminator[] = "\r\n\r\n";
+    for (;;) {
+        const char* begin = reinterpret_cast<const char*>(m_receiveBuffer.data() + m_receiveStart);
+        const char* end = reinterpret_cast<const char*>(m_receiveBuffer.data() + m_receiveEnd);
+        const char* found = std::search(begin, end, kTerminator, kTerminator + 4);
+        if (found != end) {
+            co_return {Result(), static_cast<size_t>(found - begin) + 4};
+        }
+        if (m_receiveEnd - m_receiveStart >= kMaxHandshakeSize) {
+            co_return {Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Handshake headers too large"), 0};
+        }
+
+        Result result = co_await Fill();
+        if (result.IsError()) {
+            co_return {result, 0};
+        }
+    }
+}
+
+uint32_t AsyncWebSocket::NextMask() {
+    // xorshift64*
+    m_maskState ^= m_maskState >> 12;
+    m_maskState ^= m_maskState << 25;
+    m_maskState ^= m_maskState >> 27;
+    return static_cast<uint32_t>((m_maskState * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+} // namespace WebSocket
+
+#endif // WEBSOCKET_HAS_COROUTINES
@@ -0,0 +1,215 @@
+#include "WebSocket/CpuTopology.h"
+#include "WebSocket/BufferPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#elif defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace WebSocket {
+
+namespace {
+
+#ifdef __linux__
+int ReadSysInt(const std::string& path, int fallback) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) {
+        return fallback;
+    }
+    int value = fallback;
+    if (fscanf(file, "%d", &value) != 1) {
+        value = fallback;
+    }
+    fclose(file);
+    return value;
+}
+
+// The cpuN directory links to its node as nodeM
+int ReadNode(const std::string& cpuPath) {
+    DIR* directory = opendir(cpuPath.c_str());
+    if (!directory) {
+        return 0;
+    }
+    int node = 0;
+    while (struct dirent* entry = readdir(directory)) {
+        int parsed = 0;
+        if (strncmp(entry->d_name, "node", 4) == 0 && sscanf(entry->d_name + 4, "%d", &parsed) == 1) {
+            node = parsed;
+            break;
+        }
+    }
+    closedir(directory);
+    return node;
+}
+#endif
+
+} // namespace
+
+const CpuTopology& CpuTopology::System() {
+    static const CpuTopology topology = Detect();
+    return topology;
+}
+
+CpuTopology CpuTopology::Detect() {
+    CpuTopology topology;
+#ifdef __linux__
+    // The main thread's mask stands for the process; worker threads may be pinned already
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(getpid(), sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        for (unsigned i = 0; i < std::max(1u, std::thread::hardware_concurrency()) && i < CPU_SETSIZE; i++) {
+            CPU_SET(i, &allowed);
+        }
+    }
+    std::map<std::pair<int, int>, int> cores;   // (package, core_id) -> Core
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        CpuInfo info;
+        info.Cpu = cpu;
+        info.Package = ReadSysInt(path + "/topology/physical_package_id", 0);
+        int coreId = ReadSysInt(path + "/topology/core_id", cpu);
+        auto core = cores.emplace(std::make_pair(info.Package, coreId), static_cast<int>(cores.size())).first;
+        info.Core = core->second;
+        info.Node = ReadNode(path);
+        topology.m_cpus.push_back(info);
+    }
+#else
+    unsigned count = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned cpu = 0; cpu < count; cpu++) {
+        CpuInfo info;
+        info.Cpu = static_cast<int>(cpu);
+        info.Core = static_cast<int>(cpu);
+        topology.m_cpus.push_back(info);
+    }
+#endif
+    return topology;
+}
+
+std::vector<int> CpuTopology::AllCpus() const {
+    std::vector<int> cpus;
+    cpus.reserve(m_cpus.size());
+    for (const CpuInfo& info : m_cpus) {
+        cpus.push_back(info.Cpu);
+    }
+    return cpus;
+}
+
+std::vector<int> CpuTopology::PhysicalCores() const {
+    std::vector<CpuInfo> ordered = m_cpus;
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const CpuInfo& a, const CpuInfo& b) { return a.Node < b.Node; });
+    std::vector<int> cpus;
+    std::vector<int> seenCores;
+    for (const CpuInfo& info : ordered) {
+        if (std::find(seenCores.begin(), seenCores.end(), info.Core) == seenCores.end()) {
+            seenCores.push_back(info.Core);
+            cpus.push_back(info.Cpu);
+        }
+    }
+    return cpus;
+}
+
+std::vector<int> CpuTopology::NodeCpus(int node) const {
+    std::vector<int> cpus;
+    for (const CpuInfo& info : m_cpus) {
+        if (info.Node == node) {
+            cpus.push_back(info.Cpu);
+        }
+    }
+    return cpus;
+}
+
+int CpuTopology::NodeOf(int cpu) const {
+    for (const CpuInfo& info : m_cpus) {
+        if (info.Cpu == cpu) {
+            return info.Node;
+        }
+    }
+    return 0;
+}
+
+size_t CpuTopology::NodeCount() const {
+    std::vector<int> nodes;
+    for (const CpuInfo& info : m_cpus) {
+        if (std::find(nodes.begin(), nodes.end(), info.Node) == nodes.end()) {
+            nodes.push_back(info.Node);
+        }
+    }
+    return std::max<size_t>(nodes.size(), 1);
+}
+
+int CurrentCpu() {
+#ifdef _WIN32
+    return static_cast<int>(GetCurrentProcessorNumber());
+#elif defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+bool PinCurrentThread(int cpu) {
+    if (cpu < 0) {
+        return false;
+    }
+#ifdef _WIN32
+    if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8) ||
+        SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) == 0) {
+        return false;
+    }
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        return false;
+    }
+#else
+    return false;
+#endif
+    BufferPool::SetThreadNode(CpuTopology::System().NodeOf(cpu));
+    return true;
+}
+
+bool PinThread(std::thread& thread, int cpu) {
+    if (cpu < 0) {
+        return false;
+    }
+#ifdef _WIN32
+    if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+        return false;
+    }
+    return SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    (void)thread;
+    return false;
+#endif
+}
+
+} // namespace WebSocket
@@ -34,6 +34,8 @@ const char* GetErrorCodeString(ERROR_CODE code) {
             return "Socket getsockname failed";
         case ERROR_CODE::SOCKET_ADDRESS_PARSE_FAILED:
             return "Socket address parse failed";
+        case ERROR_CODE::SOCKET_OPTION_NOT_SUPPORTED:
+            return "Socket option not supported on this platform";
         case ERROR_CODE::INVALID_PARAMETER:
             return "Invalid parameter";
         case ERROR_CODE::MEMORY_ALLOCATION_FAILED:
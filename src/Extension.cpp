@@ -0,0 +1,140 @@
+#include "WebSocket/Extension.h"
+
+namespace WebSocket {
+
+namespace {
+
+std::string_view Trim(std::string_view text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && (text[begin] == ' ' || text[begin] == '\t')) begin++;
+    while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\t')) end--;
+    return text.substr(begin, end - begin);
+}
+
+// Calls fn with each trimmed, non-empty part between delimiters outside double quotes
+template <typename Fn>
+void SplitOutsideQuotes(std::string_view text, char delimiter, Fn&& fn) {
+    bool quoted = false;
+    size_t start = 0;
+    for (size_t i = 0; i <= text.size(); i++) {
+        if (i < text.size() && text[i] == '"') {
+            quoted = !quoted;
+        }
+        if (i == text.size() || (text[i] == delimiter && !quoted)) {
+            std::string_view part = Trim(text.substr(start, i - start));
+            if (!part.empty()) {
+                fn(part);
+            }
+            start = i + 1;
+        }
+    }
+}
+
+} // namespace
+
+const std::string* ExtensionOffer::Find(const std::string& name) const {
+    for (const auto& param : Params) {
+        if (param.first == name) {
+            return &param.second;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<ExtensionOffer> ParseExtensionOffers(std::string_view header) {
+    std::vector<ExtensionOffer> offers;
+    SplitOutsideQuotes(header, ',', [&offers](std::string_view entry) {
+        ExtensionOffer offer;
+        SplitOutsideQuotes(entry, ';', [&offer](std::string_view part) {
+            if (offer.Name.empty()) {
+                offer.Name.assign(part);
+                return;
+            }
+            size_t equals = part.find('=');
+            std::string_view name = Trim(part.substr(0, equals));
+            std::string_view value = equals == std::string_view::npos ? std::string_view() : Trim(part.substr(equals + 1));
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                value = value.substr(1, value.size() - 2);
+            }
+            offer.Params.emplace_back(std::string(name), std::string(value));
+        });
+        if (!offer.Name.empty()) {
+            offers.push_back(std::move(offer));
+        }
+    });
+    return offers;
+}
+
+std::string ExtensionChain::Negotiate(std::string_view offered,
+                                      const std::vector<std::shared_ptr<WebSocketExtension>>& available) {
+    std::string response;
+    if (available.empty() || offered.empty()) {
+        return response;
+    }
+
+    for (const ExtensionOffer& offer : ParseExtensionOffers(offered)) {
+        bool accepted = false;
+        for (const std::string& name : m_names) {
+            accepted = accepted || name == offer.Name;
+        }
+        if (accepted) {
+            continue;   // Later offers of an accepted extension were alternatives
+        }
+
+        for (const auto& extension : available) {
+            if (extension->Name() != offer.Name || (extension->RsvBits() & m_rsvBits) != 0) {
+                continue;
+            }
+            std::string params;
+            std::unique_ptr<ExtensionSession> session = extension->Accept(offer, params);
+            if (!session) {
+                continue;
+            }
+            uint8_t bits = extension->RsvBits() & (kRsv1 | kRsv2 | kRsv3);
+            m_sessions.push_back(Entry{std::move(session), bits});
+            m_names.push_back(offer.Name);
+            m_rsvBits |= bits;
+            m_continuationRsvBits |= extension->ContinuationRsvBits() & bits;
+
+            if (!response.empty()) {
+                response += ", ";
+            }
+            response += offer.Name;
+            if (!params.empty()) {
+                response += "; " + params;
+            }
+            break;
+        }
+    }
+    return response;
+}
+
+Result ExtensionChain::Encode(WEBSOCKET_OPCODE opcode, std::vector<uint8_t>& payload, uint8_t& rsv) {
+    rsv = 0;
+    for (Entry& entry : m_sessions) {
+        uint8_t bits = 0;
+        Result result = entry.Session->EncodeMessage(opcode, payload, bits);
+        if (result.IsError()) {
+            return result;
+        }
+        rsv |= bits & entry.RsvBits;
+    }
+    return Result();
+}
+
+Result ExtensionChain::Decode(WEBSOCKET_OPCODE opcode, uint8_t rsv, std::vector<uint8_t>& payload) {
+    for (auto it = m_sessions.rbegin(); it != m_sessions.rend(); ++it) {
+        uint8_t bits = rsv & it->RsvBits;
+        if (bits == 0) {
+            continue;
+        }
+        Result result = it->Session->DecodeMessage(opcode, bits, payload);
+        if (result.IsError()) {
+            return result;
+        }
+    }
+    return Result();
+}
+
+} // namespace WebSocket
@@ -2,13 +2,81 @@
 #include <sstream>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <limits>
 
 namespace WebSocket {
 
+// Pooled per-connection receive buffer size; larger requests/frames spill to the heap
+static const size_t kClientBufferSize = 64 * 1024;
+
+// Reserved from the memory budget when a connection is accepted
+static const size_t kConnectionMemory = sizeof(ClientConnection) + kClientBufferSize;
+
+// How long a finished client worker waits for the next connection before exiting
+static const auto kIdleWorkerTimeout = std::chrono::seconds(30);
+
+// Read size for SendStream when no fragment size is configured
+static const size_t kDefaultStreamChunk = 64 * 1024;
+
+// How often a connection that is not reading re-checks the server-wide queue
+// and, without a dispatch channel to wake it, whether it has been resumed
+static const int kReadBlockedWaitMs = 10;
+
+// How often Drain() sends close frames to newly upgraded connections and
+// checks whether every connection is gone
+static const auto kDrainPollInterval = std::chrono::milliseconds(50);
+
+// CPU a connection thread is pinned to; threads are reused between connections
+static thread_local int t_connectionThreadCpu = -1;
+
+// Nanoseconds since start, as recorded by the latency histograms
+static uint64_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return elapsed > 0 ? static_cast<uint64_t>(elapsed) : 0;
+}
+
+// Pools are intentionally leaked so connections outliving static teardown still free safely
+static SlabPool& ClientConnectionPool() {
+    static SlabPool* pool = new SlabPool(sizeof(ClientConnection), 64);
+    return *pool;
+}
+
+static SlabPool& ClientBufferPool() {
+    static SlabPool* pool = new SlabPool(kClientBufferSize, 16);
+    return *pool;
+}
+
+void* ClientConnection::operator new(size_t size) {
+    if (size == sizeof(ClientConnection)) {
+        if (void* block = ClientConnectionPool().Allocate()) {
+            return block;
+        }
+    }
+    return ::operator new(size);
+}
+
+void ClientConnection::operator delete(void* block, size_t size) {
+    if (!block) {
+        return;
+    }
+    if (size == sizeof(ClientConnection)) {
+        ClientConnectionPool().Deallocate(block);
+        return;
+    }
+    ::operator delete(block);
+}
+
+SlabPoolStats ClientConnection::PoolStats() {
+    return ClientConnectionPool().Stats();
+}
+
 HttpWsServer::HttpWsServer(uint16_t port, 
                            const std::string& bindAddress,
                            const SecurityConfig& config)
-    : m_bindAddress(bindAddress), m_port(port), m_running(false), m_securityConfig(config) {
+    : m_bindAddress(bindAddress), m_port(port), m_running(false), m_securityConfig(config),
+      m_memoryBudget(config.maxMemoryBytes) {
+    RegisterMetrics();
 }
 
 HttpWsServer::~HttpWsServer() {
@@ -27,9 +95,130 @@ HttpWsServer& HttpWsServer::SetBindAddress(const std::string& address) {
 
 HttpWsServer& HttpWsServer::SetSecurityConfig(const SecurityConfig& config) {
     m_securityConfig = config;
+    m_memoryBudget.SetLimit(config.maxMemoryBytes);
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::SetMessageDispatch(MESSAGE_DISPATCH mode, size_t workerThreads, size_t queueCapacity) {
+    m_dispatchMode = mode;
+    m_dispatchWorkers = std::max<size_t>(workerThreads, 1);
+    m_dispatchQueueCapacity = std::max<size_t>(queueCapacity, 2);
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::SetRequestExecutor(const ExecutorOptions& options) {
+    m_useRequestExecutor = true;
+    m_requestExecutorOptions = options;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::EnableTopics(const TopicRouterOptions& options) {
+    m_useTopics = true;
+    m_topicOptions = options;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::SetFragmentSize(size_t bytes) {
+    m_fragmentSize = bytes;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::SetFlowControl(const FlowControlOptions& options) {
+    m_flowControl = options;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::EnableMetricsEndpoint(const std::string& path) {
+    m_metricsPath = path;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::SetSubProtocols(const std::vector<std::string>& protocols) {
+    m_subProtocols = protocols;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::AddExtension(std::shared_ptr<WebSocketExtension> extension) {
+    if (extension) {
+        m_extensions.push_back(std::move(extension));
+    }
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::SetCpuAffinity(const std::vector<int>& cpus) {
+    m_cpuAffinity = cpus;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::EnableListenerHandoff(const std::string& path) {
+    m_handoffPath = path;
     return *this;
 }
 
+HttpWsServer& HttpWsServer::AdoptListener(std::unique_ptr<Socket> listener) {
+    m_adoptedListener = std::move(listener);
+    return *this;
+}
+
+void HttpWsServer::RegisterMetrics() {
+    m_acceptedConnections = m_metrics.GetCounter("aiws_connections_accepted_total", "Connections accepted by the listener");
+    m_bytesReceived = m_metrics.GetCounter("aiws_received_bytes_total", "Bytes read from client sockets");
+    m_bytesSent = m_metrics.GetCounter("aiws_sent_bytes_total", "Bytes written to client sockets");
+    
+    const std::pair<WEBSOCKET_OPCODE, const char*> opcodes[] = {
+        {WEBSOCKET_OPCODE::CONTINUATION, "continuation"}, {WEBSOCKET_OPCODE::TEXT, "text"},
+        {WEBSOCKET_OPCODE::BINARY, "binary"}, {WEBSOCKET_OPCODE::CLOSE, "close"},
+        {WEBSOCKET_OPCODE::PING, "ping"}, {WEBSOCKET_OPCODE::PONG, "pong"}};
+    for (const auto& [opcode, name] : opcodes) {
+        std::string labels = std::string("opcode=\"") + name + "\"";
+        m_framesReceived[static_cast<uint8_t>(opcode)] =
+            m_metrics.GetCounter("aiws_frames_received_total", "WebSocket frames received, by opcode", labels);
+        m_framesSent[static_cast<uint8_t>(opcode)] =
+            m_metrics.GetCounter("aiws_frames_sent_total", "WebSocket frames sent, by opcode", labels);
+    }
+    
+    const char* reasons[] = {"ip_blocked", "connection_limit", "rate_limit", "server_busy", "connection_table_full",
+                             "request_too_large", "invalid_handshake", "message_too_large", "protocol_error",
+                             "memory_budget"};
+    static_assert(sizeof(reasons) / sizeof(reasons[0]) == static_cast<size_t>(REJECT_REASON::COUNT),
+                  "Every REJECT_REASON needs a label");
+    for (size_t i = 0; i < static_cast<size_t>(REJECT_REASON::COUNT); i++) {
+        m_rejections[i] = m_metrics.GetCounter("aiws_rejections_total", "Connections, requests and messages turned away, by reason",
+                                               std::string("reason=\"") + reasons[i] + "\"");
+    }
+    
+    m_readThrottles = m_metrics.GetCounter("aiws_read_throttled_total",
+                                           "Times a connection stopped reading because its queued messages were over a limit");
+    
+    m_handshakeLatency = m_metrics.GetHistogram("aiws_handshake_duration_seconds",
+                                                "Time from accept to the WebSocket handshake response");
+    m_messageHandlerLatency = m_metrics.GetHistogram("aiws_handler_duration_seconds", "Time spent in request and message handlers",
+                                                     "kind=\"websocket\"");
+    m_httpHandlerLatency = m_metrics.GetHistogram("aiws_handler_duration_seconds", "Time spent in request and message handlers",
+                                                  "kind=\"http\"");
+    
+    // Levels owned by other components are read when a snapshot is taken
+    m_metrics.AddGaugeCallback("aiws_connections", "Open client connections", [this]() {
+        return static_cast<int64_t>(m_currentConnections.load(std::memory_order_relaxed));
+    });
+    m_metrics.AddGaugeCallback("aiws_dispatch_queue_depth", "Messages waiting for or running in a handler worker", [this]() {
+        MessageDispatcherStats stats = GetDispatchStats();
+        return static_cast<int64_t>(stats.Dispatched - stats.Completed);
+    });
+    m_metrics.AddGaugeCallback("aiws_dispatch_queued_bytes", "Payload bytes waiting for or running in a handler worker", [this]() {
+        return static_cast<int64_t>(GetDispatchStats().QueuedBytes);
+    });
+    m_metrics.AddGaugeCallback("aiws_memory_used_bytes", "Memory held for clients against the memory budget", [this]() {
+        return static_cast<int64_t>(m_memoryBudget.Used());
+    });
+    m_metrics.AddGaugeCallback("aiws_memory_limit_bytes", "The memory budget; 0 when unlimited", [this]() {
+        return static_cast<int64_t>(m_memoryBudget.Limit());
+    });
+    m_metrics.AddGaugeCallback("aiws_executor_queue_depth", "Connections waiting for or running on the request executor", [this]() {
+        return static_cast<int64_t>(GetRequestExecutorStats().Pending);
+    });
+}
+
 HttpWsServer& HttpWsServer::OnHttpRequest(const std::function<std::string(const HTTPRequest&)>& callback) {
     m_onHttpRequest = callback;
     return *this;
@@ -40,6 +229,11 @@ HttpWsServer& HttpWsServer::OnWebSocketMessage(const std::function<std::string(c
     return *this;
 }
 
+HttpWsServer& HttpWsServer::OnWebSocketMessageView(const std::function<std::string(const WebSocketMessageView&)>& callback) {
+    m_onWebSocketMessageView = callback;
+    return *this;
+}
+
 HttpWsServer& HttpWsServer::OnConnect(const std::function<void(const std::string&)>& callback) {
     m_onConnect = callback;
     return *this;
@@ -50,6 +244,31 @@ HttpWsServer& HttpWsServer::OnDisconnect(const std::function<void(const std::str
     return *this;
 }
 
+HttpWsServer& HttpWsServer::OnMessageBegin(const std::function<void(ConnectionHandle, WEBSOCKET_OPCODE)>& callback) {
+    m_onMessageBegin = callback;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::OnMessageChunk(const std::function<void(ConnectionHandle, const uint8_t*, size_t)>& callback) {
+    m_onMessageChunk = callback;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::OnMessageEnd(const std::function<void(ConnectionHandle)>& callback) {
+    m_onMessageEnd = callback;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::OnConnect(const std::function<void(ConnectionHandle, const std::string&)>& callback) {
+    m_onConnectHandle = callback;
+    return *this;
+}
+
+HttpWsServer& HttpWsServer::OnDisconnect(const std::function<void(ConnectionHandle, const std::string&)>& callback) {
+    m_onDisconnectHandle = callback;
+    return *this;
+}
+
 HttpWsServer& HttpWsServer::OnSecurityViolation(const std::function<void(const std::string&, const std::string&)>& callback) {
     m_onSecurityViolation = callback;
     return *this;
@@ -60,38 +279,132 @@ HttpWsServer& HttpWsServer::OnError(const std::function<void(const std::string&)
     return *this;
 }
 
+HttpWsServer& HttpWsServer::OnListenerHandoff(const std::function<void()>& callback) {
+    m_onListenerHandoff = callback;
+    return *this;
+}
+
 Result HttpWsServer::Start() {
     if (m_running) {
         return Result(ERROR_CODE::UNKNOWN_ERROR, "Server is already running");
     }
     
-    // Create server socket
-    m_serverSocket = std::make_unique<Socket>();
-    auto createResult = m_serverSocket->Create(SOCKET_FAMILY::IPV4, SOCKET_TYPE::TCP);
-    if (!createResult.IsSuccess()) {
-        if (m_onError) m_onError("Failed to create server socket: " + createResult.GetErrorMessage());
-        return createResult;
+    if (m_adoptedListener) {
+        // Already bound, tuned and listening in the process that handed it over
+        m_serverSocket = std::move(m_adoptedListener);
+        m_bindAddress = m_serverSocket->LocalAddress();
+        m_port = m_serverSocket->LocalPort();
+    } else {
+        // Create server socket
+        m_serverSocket = std::make_unique<Socket>();
+        SOCKET_FAMILY family = Socket::IsUnixAddress(m_bindAddress) ? SOCKET_FAMILY::UNIX : SOCKET_FAMILY::IPV4;
+        auto createResult = m_serverSocket->Create(family, SOCKET_TYPE::TCP);
+        if (!createResult.IsSuccess()) {
+            if (m_onError) m_onError("Failed to create server socket: " + createResult.GetErrorMessage());
+            return createResult;
+        }
+        
+        // Set socket options
+        m_serverSocket->ReuseAddress(true);
+        auto profileResult = m_serverSocket->ApplyListenerProfile(m_securityConfig.socketProfile);
+        if (!profileResult.IsSuccess()) {
+            if (m_onError) m_onError("Failed to apply listener socket profile: " + profileResult.GetErrorMessage());
+        }
+        
+        // Bind to address
+        auto bindResult = m_serverSocket->Bind(m_bindAddress, m_port);
+        if (!bindResult.IsSuccess()) {
+            if (m_onError) m_onError("Failed to bind server socket: " + bindResult.GetErrorMessage());
+            return bindResult;
+        }
+        
+        // Start listening
+        auto listenResult = m_serverSocket->Listen(128);
+        if (!listenResult.IsSuccess()) {
+            if (m_onError) m_onError("Failed to listen on server socket: " + listenResult.GetErrorMessage());
+            return listenResult;
+        }
     }
     
-    // Set socket options
-    m_serverSocket->ReuseAddress(true);
+    // Non-blocking listener lets the accept loop drain the backlog until EAGAIN
+    m_serverSocket->Blocking(false);
     
-    // Bind to address
-    auto bindResult = m_serverSocket->Bind(m_bindAddress, m_port);
-    if (!bindResult.IsSuccess()) {
-        if (m_onError) m_onError("Failed to bind server socket: " + bindResult.GetErrorMessage());
-        return bindResult;
+    if (!m_handoffPath.empty()) {
+        auto handoffResult = m_handoff.Listen(m_handoffPath);
+        if (!handoffResult.IsSuccess()) {
+            if (m_onError) m_onError("Failed to listen for a listener handoff: " + handoffResult.GetErrorMessage());
+            m_serverSocket->Close();
+            return handoffResult;
+        }
     }
     
-    // Start listening
-    auto listenResult = m_serverSocket->Listen(128);
-    if (!listenResult.IsSuccess()) {
-        if (m_onError) m_onError("Failed to listen on server socket: " + listenResult.GetErrorMessage());
-        return listenResult;
+    // Handler workers must be up before the first connection is accepted
+    if (m_useRequestExecutor) {
+        ExecutorOptions executorOptions = m_requestExecutorOptions;
+        if (executorOptions.CpuAffinity.empty()) {
+            executorOptions.CpuAffinity = m_cpuAffinity;
+        }
+        m_requestExecutor = std::make_unique<WorkStealingExecutor>(executorOptions);
+        auto executorResult = m_requestExecutor->Start();
+        if (!executorResult.IsSuccess()) {
+            if (m_onError) m_onError("Failed to start request executor: " + executorResult.GetErrorMessage());
+            m_requestExecutor.reset();
+            m_serverSocket->Close();
+            return executorResult;
+        }
+    }
+
+    if (m_dispatchMode == MESSAGE_DISPATCH::WORKER_POOL) {
+        // Handlers are wrapped so time spent on the workers is measured too
+        Histogram* latency = m_messageHandlerLatency;
+        MessageDispatcher::HandlerFn handler;
+        MessageDispatcher::ViewHandlerFn viewHandler;
+        if (m_onWebSocketMessage) {
+            handler = [latency, callback = m_onWebSocketMessage](const WebSocketMessageWithIP& message) {
+                auto start = std::chrono::steady_clock::now();
+                std::string response = callback(message);
+                latency->Record(ElapsedNs(start));
+                return response;
+            };
+        }
+        if (m_onWebSocketMessageView) {
+            viewHandler = [latency, callback = m_onWebSocketMessageView](const WebSocketMessageView& message) {
+                auto start = std::chrono::steady_clock::now();
+                std::string response = callback(message);
+                latency->Record(ElapsedNs(start));
+                return response;
+            };
+        }
+        m_dispatcher = std::make_unique<MessageDispatcher>(m_dispatchWorkers, m_dispatchQueueCapacity,
+                                                           handler, m_onError, viewHandler);
+        m_dispatcher->SetCpuAffinity(m_cpuAffinity);
+        auto dispatchResult = m_dispatcher->Start();
+        if (!dispatchResult.IsSuccess()) {
+            if (m_onError) m_onError("Failed to start message dispatcher: " + dispatchResult.GetErrorMessage());
+            m_dispatcher.reset();
+            m_serverSocket->Close();
+            return dispatchResult;
+        }
+    }
+    
+    if (m_useTopics) {
+        TopicRouterOptions topicOptions = m_topicOptions;
+        if (topicOptions.CpuAffinity.empty()) {
+            topicOptions.CpuAffinity = m_cpuAffinity;
+        }
+        m_topicRouter = std::make_unique<TopicRouter>(topicOptions);
+        auto routerResult = m_topicRouter->Start();
+        if (!routerResult.IsSuccess()) {
+            if (m_onError) m_onError("Failed to start topic router: " + routerResult.GetErrorMessage());
+            m_topicRouter.reset();
+            m_serverSocket->Close();
+            return routerResult;
+        }
     }
     
     m_running = true;
     m_shouldStop = false;
+    m_stopAccepting = false;
     
     // Start server thread
     m_serverThread = std::make_unique<std::thread>(&HttpWsServer::ServerLoop, this);
@@ -107,43 +420,357 @@ Result HttpWsServer::Stop() {
     m_running = false;
     m_shouldStop = true;
     
-    // Close server socket to unblock accept
+    // Wait for server thread to finish (it polls m_shouldStop between waits)
+    if (m_serverThread && m_serverThread->joinable()) {
+        m_serverThread->join();
+    }
+    
+    // Close server socket once nothing is waiting on it
     if (m_serverSocket) {
         m_serverSocket->Close();
     }
+    m_handoff.Close();
     
-    // Wait for server thread to finish
-    if (m_serverThread && m_serverThread->joinable()) {
-        m_serverThread->join();
+    // Wake client workers blocked in receive; each worker closes its own socket
+    m_connections.ForEach([](ConnectionHandle, ClientConnection& client) {
+        if (client.socket) {
+            client.socket->Shutdown();
+        }
+    });
+    
+    // Queued connections are dropped unread; requests already running finish
+    if (m_requestExecutor) {
+        m_requestExecutor->Stop();
     }
     
-    // Close all client connections
+    // Wait for workers to finish their connections and leave the idle pool
+    std::vector<ClientConnection*> pendingClients;
+    bool workersFinished = false;
     {
-        std::lock_guard<std::mutex> lock(m_clientsMutex);
-        for (auto& client : m_clients) {
-            if (client && client->socket) {
-                client->socket->Close();
-            }
+        std::unique_lock<std::mutex> lock(m_workerMutex);
+        m_workerCondition.notify_all();
+        workersFinished = m_workerCondition.wait_for(lock, std::chrono::seconds(5),
+            [this] { return m_workerCount == 0; });
+        pendingClients.swap(m_pendingClients);
+    }
+    
+    // Connections that were handed off but never picked up
+    for (ClientConnection* client : pendingClients) {
+        RemoveConnection(client->clientIP);
+        delete client;
+    }
+    
+    if (workersFinished) {
+        m_requestExecutor.reset();
+    }
+    
+    // Connection threads are done submitting; stop the handler workers
+    if (m_dispatcher) {
+        m_dispatcher->Stop();
+        if (workersFinished) {
+            m_dispatcher.reset();
+        }
+    }
+    
+    if (m_topicRouter) {
+        m_topicRouter->Stop();
+        if (workersFinished) {
+            m_topicRouter.reset();
         }
-        m_clients.clear();
     }
     
     return Result();
 }
 
+Result HttpWsServer::Drain(std::chrono::milliseconds deadline) {
+    if (!m_running) {
+        return Result();
+    }
+    auto until = std::chrono::steady_clock::now() + deadline;
+    
+    // Stop accepting; closing the listener refuses new connections rather
+    // than leaving them in the backlog until Stop(). A handed-off listener is
+    // only closed here, not shut down, so the successor keeps accepting.
+    m_stopAccepting = true;
+    if (m_serverThread && m_serverThread->joinable()) {
+        m_serverThread->join();
+    }
+    if (m_serverSocket) {
+        m_serverSocket->Close();
+    }
+    m_handoff.Close();
+    
+    // Connections accepted before the listener closed may still be upgrading,
+    // so keep sweeping; only the first close frame goes out on each
+    std::vector<ConnectionHandle> connections;
+    while (m_currentConnections.load() > 0 && std::chrono::steady_clock::now() < until) {
+        connections.clear();
+        m_connections.ForEach([&connections](ConnectionHandle handle, const ClientConnection&) {
+            connections.push_back(handle);
+        });
+        for (ConnectionHandle connection : connections) {
+            SendClose(connection, 1001, false);
+        }
+        std::this_thread::sleep_for(kDrainPollInterval);
+    }
+    
+    // Whatever did not finish its closing handshake in time is cut off
+    return Stop();
+}
+
 int HttpWsServer::GetCurrentConnectionCount() const {
     return m_currentConnections.load();
 }
 
+ExecutorStats HttpWsServer::GetRequestExecutorStats() const {
+    return m_requestExecutor ? m_requestExecutor->Stats() : ExecutorStats();
+}
+
+void HttpWsServer::ReadStats(const ClientConnection& client, ConnectionHandle handle, bool tcpInfo, int64_t now,
+                             ConnectionStats& stats) const {
+    stats.Handle = handle;
+    ReadConnectionCounters(client.counters, now, stats);
+    stats.QueuedMessages = client.dispatchChannel ? client.dispatchChannel->QueuedApprox() : 0;
+    stats.QueuedInboundBytes = client.dispatchChannel ? client.dispatchChannel->PendingBytes.load(std::memory_order_relaxed) : 0;
+    stats.HasTcpInfo = false;
+    stats.Tcp = TcpInfo();
+    // HTTP connections close their socket while still in the table
+    if (tcpInfo && stats.IsWebSocket) {
+        auto [result, info] = client.socket->GetTcpInfo();
+        stats.HasTcpInfo = result.IsSuccess();
+        stats.Tcp = info;
+    }
+}
+
+bool HttpWsServer::GetConnectionStats(ConnectionHandle connection, ConnectionStats& stats) const {
+    int64_t now = SteadyNowNs();
+    return m_connections.Find(connection, [&](const ClientConnection& client) {
+        ReadStats(client, connection, true, now, stats);
+        stats.ClientIP = client.clientIP;
+    });
+}
+
+std::vector<ConnectionStats> HttpWsServer::GetAllConnectionStats(bool includeTcpInfo) const {
+    std::vector<ConnectionStats> all;
+    all.reserve(m_connections.Size());
+    int64_t now = SteadyNowNs();
+    m_connections.ForEach([&](ConnectionHandle handle, const ClientConnection& client) {
+        all.emplace_back();
+        ReadStats(client, handle, includeTcpInfo, now, all.back());
+        all.back().ClientIP = client.clientIP;
+    });
+    return all;
+}
+
+std::vector<ConnectionStats> HttpWsServer::GetSlowestConnections(size_t count, CONNECTION_ORDER order) const {
+    // Rank on counters alone where possible; the winners are read again in full
+    SlowConnectionHeap heap(count, order);
+    ConnectionStats scratch;
+    bool tcpInfo = ConnectionOrderNeedsTcpInfo(order);
+    int64_t now = SteadyNowNs();
+    m_connections.ForEach([&](ConnectionHandle handle, const ClientConnection& client) {
+        ReadStats(client, handle, tcpInfo, now, scratch);
+        heap.Offer(scratch);
+    });
+    
+    std::vector<ConnectionStats> slowest;
+    for (ConnectionHandle handle : heap.Take()) {
+        ConnectionStats stats;
+        if (GetConnectionStats(handle, stats)) {     // Skips connections closed in between
+            slowest.push_back(std::move(stats));
+        }
+    }
+    return slowest;
+}
+
+Result HttpWsServer::Ping(ConnectionHandle connection) {
+    ClientConnection* client = PinClient(connection);
+    if (!client) {
+        return Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+    }
+    Result result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+    if (IsHandshakeComplete(client)) {
+        int64_t payload = client->counters.BeginPing();
+        result = SendFrame(client, WebSocketProtocol::GenerateFrame(
+            WEBSOCKET_OPCODE::PING, reinterpret_cast<const uint8_t*>(&payload), sizeof(payload)));
+    }
+    UnpinClient(client);
+    return result;
+}
+
+bool HttpWsServer::GetNegotiatedProtocol(ConnectionHandle connection, std::string& subProtocol,
+                                         std::vector<std::string>& extensions) const {
+    return m_connections.Find(connection, [&subProtocol, &extensions](const ClientConnection& client) {
+        subProtocol = client.subProtocol;
+        extensions = client.extensions.Names();
+    });
+}
+
+MessageDispatcherStats HttpWsServer::GetDispatchStats() const {
+    return m_dispatcher ? m_dispatcher->Stats() : MessageDispatcherStats();
+}
+
+bool HttpWsServer::Subscribe(ConnectionHandle connection, const std::string& pattern) {
+    return m_topicRouter && m_topicRouter->Subscribe(connection.Value(), pattern);
+}
+
+bool HttpWsServer::Unsubscribe(ConnectionHandle connection, const std::string& pattern) {
+    return m_topicRouter && m_topicRouter->Unsubscribe(connection.Value(), pattern);
+}
+
+bool HttpWsServer::Publish(const std::string& topic, const std::string& payload) {
+    return m_topicRouter && m_topicRouter->Publish(topic, payload);
+}
+
+TopicRouterStats HttpWsServer::GetTopicStats() const {
+    return m_topicRouter ? m_topicRouter->Stats() : TopicRouterStats();
+}
+
 std::vector<std::string> HttpWsServer::GetConnectedIPs() const {
-    std::lock_guard<std::mutex> lock(m_clientsMutex);
     std::vector<std::string> ips;
-    for (const auto& client : m_clients) {
-        if (client) {
-            ips.push_back(client->clientIP);
+    m_connections.ForEach([&ips](ConnectionHandle, const ClientConnection& client) {
+        ips.push_back(client.clientIP);
+    });
+    return ips;
+}
+
+std::vector<ConnectionHandle> HttpWsServer::GetConnections() const {
+    std::vector<ConnectionHandle> connections;
+    connections.reserve(m_connections.Size());
+    m_connections.ForEach([&connections](ConnectionHandle handle, const ClientConnection&) {
+        connections.push_back(handle);
+    });
+    return connections;
+}
+
+Result HttpWsServer::PauseRead(ConnectionHandle connection) {
+    bool found = m_connections.Find(connection, [](ClientConnection& client) {
+        client.counters.ReadPaused.store(true, std::memory_order_release);
+    });
+    return found ? Result() : Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+}
+
+Result HttpWsServer::ResumeRead(ConnectionHandle connection) {
+    bool found = m_connections.Find(connection, [](ClientConnection& client) {
+        client.counters.ReadPaused.store(false, std::memory_order_release);
+        if (client.dispatchChannel) {
+            client.dispatchChannel->Notify();
         }
+    });
+    return found ? Result() : Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+}
+
+bool HttpWsServer::IsConnected(ConnectionHandle connection) const {
+    return m_connections.Find(connection, [](const ClientConnection&) {});
+}
+
+ClientConnection* HttpWsServer::PinClient(ConnectionHandle connection) const {
+    // The count keeps the connection alive after the slot lock is released,
+    // so a slow send never holds up Stop() or other lookups
+    ClientConnection* pinned = nullptr;
+    m_connections.Find(connection, [&pinned](ClientConnection& client) {
+        client.senders.fetch_add(1, std::memory_order_relaxed);
+        pinned = &client;
+    });
+    return pinned;
+}
+
+void HttpWsServer::UnpinClient(ClientConnection* client) {
+    // Under the mutex, so RemoveClient cannot free the connection between the
+    // decrement and the notify
+    std::lock_guard<std::mutex> lock(client->sendersMutex);
+    if (client->senders.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        client->sendersDone.notify_all();
     }
-    return ips;
+}
+
+Result HttpWsServer::SendTo(ConnectionHandle connection, const std::string& text) {
+    return SendTo(connection, reinterpret_cast<const uint8_t*>(text.data()), text.size(), WEBSOCKET_OPCODE::TEXT);
+}
+
+Result HttpWsServer::SendTo(ConnectionHandle connection, const uint8_t* data, size_t length, WEBSOCKET_OPCODE opcode) {
+    ClientConnection* client = PinClient(connection);
+    if (!client) {
+        return Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+    }
+    
+    Result result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+    if (IsHandshakeComplete(client)) {
+        result = SendDataMessage(client, opcode, data, length);
+    }
+    UnpinClient(client);
+    return result;
+}
+
+Result HttpWsServer::SendStream(ConnectionHandle connection, WEBSOCKET_OPCODE opcode,
+                                const std::function<size_t(uint8_t*, size_t)>& read) {
+    ClientConnection* client = PinClient(connection);
+    if (!client) {
+        return Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+    }
+    if (!IsHandshakeComplete(client)) {
+        UnpinClient(client);
+        return Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+    }
+    
+    // Read one chunk ahead so the last fragment can carry FIN
+    size_t chunkSize = m_fragmentSize > 0 ? m_fragmentSize : kDefaultStreamChunk;
+    std::vector<uint8_t> current(chunkSize);
+    std::vector<uint8_t> next(chunkSize);
+    Result result;
+    {
+        std::lock_guard<std::mutex> lock(client->messageMutex);
+        size_t currentLength = read(current.data(), chunkSize);
+        bool first = true;
+        for (;;) {
+            size_t nextLength = currentLength > 0 ? read(next.data(), chunkSize) : 0;
+            result = SendFrame(client, WebSocketProtocol::GenerateFrame(
+                first ? opcode : WEBSOCKET_OPCODE::CONTINUATION, current.data(), currentLength, nextLength == 0));
+            if (result.IsError() || nextLength == 0) {
+                break;
+            }
+            current.swap(next);
+            currentLength = nextLength;
+            first = false;
+        }
+    }
+    UnpinClient(client);
+    return result;
+}
+
+bool HttpWsServer::IsHandshakeComplete(ClientConnection* client) {
+    std::lock_guard<std::mutex> lock(client->sendMutex);
+    return client->isWebSocket;
+}
+
+Result HttpWsServer::Close(ConnectionHandle connection, uint16_t code) {
+    return SendClose(connection, code, true);
+}
+
+Result HttpWsServer::SendClose(ConnectionHandle connection, uint16_t code, bool shutdown) {
+    ClientConnection* client = PinClient(connection);
+    if (!client) {
+        return Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+    }
+    
+    const uint8_t payload[2] = {static_cast<uint8_t>(code >> 8), static_cast<uint8_t>(code & 0xFF)};
+    BufferHandle frame = WebSocketProtocol::GenerateFrame(WEBSOCKET_OPCODE::CLOSE, payload, sizeof(payload));
+    Result result(ERROR_CODE::INVALID_PARAMETER, "Not a WebSocket connection");
+    {
+        // HTTP connections close themselves once their response is out
+        std::lock_guard<std::mutex> lock(client->sendMutex);
+        if (client->isWebSocket) {
+            if (!client->closeSent.exchange(true) && client->socket->Send(frame).IsSuccess()) {
+                m_bytesSent->Increment(frame.Size());
+                m_framesSent[static_cast<uint8_t>(WEBSOCKET_OPCODE::CLOSE)]->Increment();
+                client->counters.Sent(frame.Size(), 1);
+            }
+            // Without a shutdown the client answers and the connection thread ends
+            result = shutdown ? client->socket->Shutdown() : Result();
+        }
+    }
+    UnpinClient(client);
+    return result;
 }
 
 void HttpWsServer::BlockIP(const std::string& ip) {
@@ -152,12 +779,11 @@ void HttpWsServer::BlockIP(const std::string& ip) {
         m_securityConfig.blockedIPs.push_back(ip);
         
         // Disconnect existing connections from this IP
-        std::lock_guard<std::mutex> clientsLock(m_clientsMutex);
-        for (auto& client : m_clients) {
-            if (client && client->clientIP == ip) {
-                client->socket->Close();
+        m_connections.ForEach([&ip](ConnectionHandle, ClientConnection& client) {
+            if (client.clientIP == ip) {
+                client.socket->Shutdown();
             }
-        }
+        });
     }
 }
 
@@ -173,101 +799,358 @@ std::vector<std::string> HttpWsServer::GetBlockedIPs() const {
 }
 
 void HttpWsServer::ServerLoop() {
-    while (!m_shouldStop) {
-        // Accept new connection
-        auto [acceptResult, clientSocket] = m_serverSocket->Accept();
-        if (!acceptResult.IsSuccess() || !clientSocket) {
-            if (m_shouldStop) break;
-            continue;
+    while (!m_shouldStop && !m_stopAccepting) {
+        // A successor waiting for the listener takes over accepting from here
+        if (m_handoff.Valid()) {
+            auto [handoffResult, handedOff] = m_handoff.Offer(*m_serverSocket);
+            if (!handoffResult.IsSuccess() && m_onError) {
+                m_onError("Listener handoff failed: " + handoffResult.GetErrorMessage());
+            }
+            if (handedOff) {
+                m_stopAccepting = true;
+                if (m_onListenerHandoff) m_onListenerHandoff();
+                break;
+            }
         }
         
-        // Enable async I/O for better performance
-        auto asyncResult = clientSocket->EnableAsyncIO();
-        if (!asyncResult.IsSuccess()) {
-            // Log warning but continue with sync mode
-            if (m_onError) m_onError("Failed to enable async I/O: " + asyncResult.GetErrorMessage());
+        // Wait for pending connections so Stop() is noticed promptly
+        auto [waitResult, readable] = m_serverSocket->WaitReadable(100);
+        if (!waitResult.IsSuccess() || !readable) {
+            continue;
         }
         
-        std::string clientIP = GetClientIP(*clientSocket);
-        
-        // Security checks
-        if (!IsConnectionAllowed(clientIP)) {
-            if (m_onSecurityViolation) {
-                m_onSecurityViolation(clientIP, "Connection rejected: Security limits exceeded");
-            }
-            clientSocket->Close();
+        // Drain the backlog in one go; client threads use blocking I/O
+        auto acceptResult = m_serverSocket->AcceptBatch(m_acceptedSockets, 64, false);
+        if (!acceptResult.IsSuccess()) {
+            if (m_shouldStop) break;
+            if (m_onError) m_onError("Failed to accept connection: " + acceptResult.GetErrorMessage());
             continue;
         }
         
-        // Create client connection
-        auto client = std::make_unique<ClientConnection>();
-        client->socket = std::move(clientSocket);
-        client->clientIP = clientIP;
-        client->connectTime = std::chrono::steady_clock::now();
-        
-        // Update connection tracking
-        UpdateConnectionInfo(clientIP);
-        
-        // Handle client in separate thread
-        std::thread clientThread(&HttpWsServer::HandleClient, this, std::move(client));
-        clientThread.detach();
+        m_acceptedConnections->Increment(m_acceptedSockets.size());
+        for (auto& clientSocket : m_acceptedSockets) {
+            // Per-connection TCP tuning
+            auto profileResult = clientSocket->ApplyProfile(m_securityConfig.socketProfile);
+            if (!profileResult.IsSuccess()) {
+                if (m_onError) m_onError("Failed to apply socket profile: " + profileResult.GetErrorMessage());
+            }
+            
+            std::string clientIP = GetClientIP(*clientSocket);
+            
+            // Security checks
+            if (!IsConnectionAllowed(clientIP)) {
+                if (m_onSecurityViolation) {
+                    m_onSecurityViolation(clientIP, "Connection rejected: Security limits exceeded");
+                }
+                clientSocket->Close();
+                continue;
+            }
+            
+            // Shed connections the memory budget has no room for; local ones too
+            MemoryReservation memory(&m_memoryBudget);
+            if (!memory.TryGrow(kConnectionMemory)) {
+                Reject(REJECT_REASON::MEMORY_BUDGET);
+                clientSocket->Close();
+                continue;
+            }
+            
+            // Create client connection
+            auto client = std::make_unique<ClientConnection>();
+            client->memory = std::move(memory);
+            client->messageMemory = MemoryReservation(&m_memoryBudget);
+            client->socket = std::move(clientSocket);
+            client->clientIP = clientIP;
+            client->connectTime = std::chrono::steady_clock::now();
+            
+            // Update connection tracking
+            UpdateConnectionInfo(clientIP);
+            
+            // Handle client on the request executor or a worker thread
+            if (m_requestExecutor) {
+                SubmitClient(std::move(client));
+            } else {
+                DispatchClient(std::move(client));
+            }
+        }
+        m_acceptedSockets.clear();
     }
 }
 
-void HttpWsServer::HandleClient(std::unique_ptr<ClientConnection> client) {
-    if (!client || !client->socket) return;
+void HttpWsServer::SubmitClient(std::unique_ptr<ClientConnection> client) {
+    ClientConnection* pending = client.release();
+    if (m_requestExecutor->TrySubmit([this, pending]() { ServeClient(std::unique_ptr<ClientConnection>(pending)); })) {
+        return;
+    }
     
-    std::string clientIP = client->clientIP;
+    // Executor saturated: shed the connection instead of queueing without bound
+    std::unique_ptr<ClientConnection> rejected(pending);
+    Reject(REJECT_REASON::SERVER_BUSY);
+    SendHTTPResponse(rejected.get(), "503 Service Unavailable", "text/plain", "Server busy");
+    RemoveConnection(rejected->clientIP);
+}
+
+void HttpWsServer::ServeClient(std::unique_ptr<ClientConnection> client) {
+    std::string_view request;
+    if (m_shouldStop || !ReceiveRequest(client.get(), request)) {
+        RemoveConnection(client->clientIP);
+        return;
+    }
     
-    // Add to clients list
+    // WebSocket connections live for a long time; give them their own thread
+    client->pendingRequest = request;
+    if (IsWebSocketUpgrade(request)) {
+        DispatchClient(std::move(client));
+    } else {
+        HandleClient(std::move(client));
+    }
+}
+
+void HttpWsServer::DispatchClient(std::unique_ptr<ClientConnection> client) {
     {
-        std::lock_guard<std::mutex> lock(m_clientsMutex);
-        m_clients.push_back(std::move(client));
+        std::lock_guard<std::mutex> lock(m_workerMutex);
+        // Hand the connection to a parked worker if one is free
+        if (m_idleWorkers > static_cast<int>(m_pendingClients.size())) {
+            m_pendingClients.push_back(client.release());
+            m_workerCondition.notify_one();
+            return;
+        }
+        m_workerCount++;
+        // Hand-offs never outnumber the workers, so the push above never allocates
+        m_pendingClients.reserve(static_cast<size_t>(m_workerCount));
     }
     
+    std::thread clientThread(&HttpWsServer::ClientWorker, this, client.release());
+    clientThread.detach();
+}
+
+void HttpWsServer::ClientWorker(ClientConnection* client) {
+    while (client) {
+        PlaceConnectionThread(client);
+        HandleClient(std::unique_ptr<ClientConnection>(client));
+        client = nullptr;
+        
+        // Park until the accept loop hands over another connection
+        std::unique_lock<std::mutex> lock(m_workerMutex);
+        m_idleWorkers++;
+        m_workerCondition.wait_for(lock, kIdleWorkerTimeout,
+            [this] { return m_shouldStop || !m_pendingClients.empty(); });
+        m_idleWorkers--;
+        if (!m_shouldStop && !m_pendingClients.empty()) {
+            client = m_pendingClients.back();
+            m_pendingClients.pop_back();
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(m_workerMutex);
+    m_workerCount--;
+    m_workerCondition.notify_all();
+}
+
+void HttpWsServer::PlaceConnectionThread(ClientConnection* client) {
+    if (m_cpuAffinity.empty()) {
+        return;
+    }
+    
+    // Prefer the CPU that already does the connection's receive processing
+    auto [result, incoming] = client->socket->IncomingCpu();
+    int cpu = incoming;
+    if (result.IsError() || std::find(m_cpuAffinity.begin(), m_cpuAffinity.end(), cpu) == m_cpuAffinity.end()) {
+        cpu = m_cpuAffinity[m_nextCpu.fetch_add(1, std::memory_order_relaxed) % m_cpuAffinity.size()];
+    }
+    
+    // Parked workers keep their placement, so only a move costs a system call
+    if (cpu != t_connectionThreadCpu && PinCurrentThread(cpu)) {
+        t_connectionThreadCpu = cpu;
+    }
+    client->counters.Cpu.store(t_connectionThreadCpu, std::memory_order_relaxed);
+}
+
+void HttpWsServer::HandleClient(std::unique_ptr<ClientConnection> ownedClient) {
+    if (!ownedClient || !ownedClient->socket) return;
+    
+    ClientConnection* client = ownedClient.get();
+    
+    // Add to the connection table; its handle identifies the connection from here on
+    ConnectionHandle handle = m_connections.Insert(std::move(ownedClient));
+    if (!handle.Valid()) {
+        if (m_onError) m_onError("Connection table is full");
+        Reject(REJECT_REASON::CONNECTION_TABLE_FULL);
+        RemoveConnection(client->clientIP);
+        return;
+    }
+    client->handle = handle;
+    
     // Notify connection
     if (m_onConnect) {
-        m_onConnect(clientIP);
+        m_onConnect(client->clientIP);
+    }
+    if (m_onConnectHandle) {
+        m_onConnectHandle(handle, client->clientIP);
     }
     
-    // Receive request with short timeout to prevent hanging
-    auto [receiveResult, requestData] = m_clients.back()->socket->Receive(m_securityConfig.maxRequestSize, 1000); // 1 second timeout
-    if (!receiveResult.IsSuccess() || requestData.empty()) {
-        RemoveConnection(clientIP);
-        return;
+    // The executor may already have read the request before handing over
+    std::string_view request = client->pendingRequest;
+    if (!request.empty() || ReceiveRequest(client, request)) {
+        // Validate request size
+        if (m_securityConfig.enableRequestSizeLimit && !IsRequestSizeValid(request, client->clientIP)) {
+            Reject(REJECT_REASON::REQUEST_TOO_LARGE);
+            if (m_onSecurityViolation) {
+                m_onSecurityViolation(client->clientIP, "Request too large");
+            }
+        } else if (IsWebSocketUpgrade(request)) {
+            // Handle based on request type
+            HandleWebSocketConnection(client, request);
+        } else {
+            HandleHTTPRequest(client, request);
+        }
     }
     
-    std::string request(requestData.begin(), requestData.end());
+    // Remove connection
+    RemoveConnection(client->clientIP);
+    RemoveClient(client);
+}
+
+bool HttpWsServer::ReceiveRequest(ClientConnection* client, std::string_view& request) {
+    if (!client->receiveBuffer.Valid()) {
+        client->receiveBuffer = PooledBuffer(ClientBufferPool());
+    }
+    if (!client->receiveBuffer.Valid()) {
+        return false;
+    }
     
-    // Validate request size
-    if (m_securityConfig.enableRequestSizeLimit && !IsRequestSizeValid(request, clientIP)) {
-        if (m_onSecurityViolation) {
-            m_onSecurityViolation(clientIP, "Request too large");
+    uint8_t* buffer = client->receiveBuffer.Data();
+    size_t chunkSize = std::min(client->receiveBuffer.Size(), m_securityConfig.maxRequestSize);
+    
+    // Receive request with short timeout to prevent hanging
+    auto [receiveResult, received] = client->socket->ReceiveInto(buffer, chunkSize, 1000); // 1 second timeout
+    if (!receiveResult.IsSuccess() || received == 0) {
+        return false;
+    }
+    m_bytesReceived->Increment(received);
+    client->counters.Received(received);
+    // The request is kept for as long as the connection lives
+    if (!client->memory.TryGrow(received)) {
+        Reject(REJECT_REASON::MEMORY_BUDGET);
+        return false;
+    }
+    // Parsed in place; the buffer is only reused for frames once the handshake is done
+    request = std::string_view(reinterpret_cast<const char*>(buffer), received);
+    if (received < chunkSize || received == m_securityConfig.maxRequestSize) {
+        return true;
+    }
+    
+    // Requests larger than one buffer: drain whatever else has already arrived
+    std::string& overflow = client->requestOverflow;
+    overflow.assign(request);
+    bool bufferFilled = true;
+    while (bufferFilled && overflow.size() < m_securityConfig.maxRequestSize) {
+        size_t wanted = std::min(chunkSize, m_securityConfig.maxRequestSize - overflow.size());
+        auto [moreResult, more] = client->socket->ReceiveInto(buffer, wanted, 0);
+        if (!moreResult.IsSuccess() || more == 0) break;
+        m_bytesReceived->Increment(more);
+        client->counters.Received(more);
+        if (!client->memory.TryGrow(more)) {
+            Reject(REJECT_REASON::MEMORY_BUDGET);
+            return false;
         }
-        RemoveConnection(clientIP);
+        overflow.append(reinterpret_cast<const char*>(buffer), more);
+        bufferFilled = more == wanted;
+    }
+    request = overflow;
+    return true;
+}
+
+void HttpWsServer::RemoveClient(ClientConnection* client) {
+    std::unique_ptr<ClientConnection> removed = m_connections.Remove(client->handle);
+    if (!removed) {
         return;
     }
     
-    // Handle based on request type
-    if (IsWebSocketUpgrade(request)) {
-        HandleWebSocketConnection(m_clients.back().get(), request);
-    } else {
-        HandleHTTPRequest(m_clients.back().get(), request);
+    // SendTo/Close calls that resolved the handle before removal may still be
+    // writing; unblock them and sleep until the last one is done with the socket
+    std::unique_lock<std::mutex> lock(removed->sendersMutex);
+    if (removed->senders.load(std::memory_order_acquire) > 0) {
+        removed->socket->Shutdown();
+        removed->sendersDone.wait(lock, [&removed] { return removed->senders.load(std::memory_order_acquire) == 0; });
     }
+    lock.unlock();
     
-    // Remove connection
-    RemoveConnection(clientIP);
+    if (m_onDisconnectHandle) {
+        m_onDisconnectHandle(removed->handle, removed->clientIP);
+    }
+    // The socket closes and pooled blocks are returned here, outside any lock
+}
+
+Result HttpWsServer::SendFrame(ClientConnection* client, const BufferHandle& frame) {
+    // Counted from before the lock, so a writer queued behind a blocked send shows up too
+    client->counters.SendingBytes.fetch_add(frame.Size(), std::memory_order_relaxed);
+    Result result;
+    {
+        std::lock_guard<std::mutex> lock(client->sendMutex);
+        // No data frame may follow a close frame (RFC 6455 section 5.5.1)
+        if (client->closeSent.load(std::memory_order_relaxed) && (frame.Data()[0] & 0x08) == 0) {
+            result = Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+        } else {
+            result = client->socket->Send(frame);
+        }
+    }
+    client->counters.SendingBytes.fetch_sub(frame.Size(), std::memory_order_relaxed);
+    if (result.IsSuccess()) {
+        m_bytesSent->Increment(frame.Size());
+        client->counters.Sent(frame.Size(), 1);
+        if (Counter* frames = m_framesSent[frame.Data()[0] & 0x0F]) {
+            frames->Increment();
+        }
+    }
+    return result;
+}
+
+Result HttpWsServer::SendDataMessage(ClientConnection* client, WEBSOCKET_OPCODE opcode, const uint8_t* data, size_t length) {
+    std::lock_guard<std::mutex> lock(client->messageMutex);
+    std::vector<uint8_t> encoded;
+    uint8_t rsv = 0;
+    if (!client->extensions.Empty()) {
+        encoded.assign(data, data + length);
+        Result encodeResult = client->extensions.Encode(opcode, encoded, rsv);
+        if (encodeResult.IsError()) {
+            return encodeResult;
+        }
+        data = encoded.data();
+        length = encoded.size();
+    }
+    
+    size_t fragmentSize = m_fragmentSize > 0 ? m_fragmentSize : length;
+    size_t offset = 0;
+    do {
+        size_t fragment = std::min(fragmentSize, length - offset);
+        bool fin = offset + fragment == length;
+        Result result = SendFrame(client, WebSocketProtocol::GenerateFrame(
+            offset == 0 ? opcode : WEBSOCKET_OPCODE::CONTINUATION, data + offset, fragment, fin, offset == 0 ? rsv : 0));
+        if (result.IsError()) {
+            return result;
+        }
+        offset += fragment;
+    } while (offset < length);
+    return Result();
 }
 
-void HttpWsServer::HandleHTTPRequest(ClientConnection* client, const std::string& request) {
+void HttpWsServer::HandleHTTPRequest(ClientConnection* client, std::string_view request) {
     if (!client || !client->socket) return;
     
     HTTPRequest httpRequest = ParseHTTPRequest(request, client->clientIP);
     
+    if (!m_metricsPath.empty() && httpRequest.method == "GET" &&
+        httpRequest.path.substr(0, httpRequest.path.find('?')) == m_metricsPath) {
+        SendHTTPResponse(client, "200 OK", "text/plain; version=0.0.4", m_metrics.PrometheusText());
+        return;
+    }
+    
     std::string response;
     if (m_onHttpRequest) {
         try {
+            auto start = std::chrono::steady_clock::now();
             response = m_onHttpRequest(httpRequest);
+            m_httpHandlerLatency->Record(ElapsedNs(start));
         } catch (const std::exception& e) {
             response = GenerateHTTPResponse("500 Internal Server Error", "text/plain", "Server Error");
             if (m_onError) m_onError("HTTP request handler error: " + std::string(e.what()));
@@ -289,16 +1172,15 @@ void HttpWsServer::HandleHTTPRequest(ClientConnection* client, const std::string
     SendHTTPResponse(client, "200 OK", "text/html", response);
 }
 
-void HttpWsServer::HandleWebSocketConnection(ClientConnection* client, const std::string& request) {
+void HttpWsServer::HandleWebSocketConnection(ClientConnection* client, std::string_view request) {
     if (!client || !client->socket) return;
     
-    client->isWebSocket = true;
-    
     // Perform WebSocket handshake
-    HandshakeInfo info;
-    auto handshakeResult = WebSocketProtocol::ValidateHandshakeRequest(request, info);
+    HandshakeRequestView view;
+    auto handshakeResult = WebSocketProtocol::ParseHandshakeRequest(request, view);
     
     if (!handshakeResult.IsSuccess()) {
+        Reject(REJECT_REASON::INVALID_HANDSHAKE);
         SendHTTPResponse(client, "400 Bad Request", "text/plain", "Invalid WebSocket handshake");
         if (m_onSecurityViolation) {
             m_onSecurityViolation(client->clientIP, "Invalid WebSocket handshake");
@@ -306,128 +1188,451 @@ void HttpWsServer::HandleWebSocketConnection(ClientConnection* client, const std
         return;
     }
     
-    // Send handshake response
-    std::string handshakeResponse = WebSocketProtocol::GenerateHandshakeResponse(info);
-    auto sendResult = client->socket->Send(std::vector<uint8_t>(handshakeResponse.begin(), handshakeResponse.end()));
+    // Settled before the response goes out; readers look under the slot lock
+    std::string_view protocol = WebSocketProtocol::SelectSubProtocol(view.Protocols, m_subProtocols);
+    std::string extensions;
+    m_connections.Find(client->handle, [this, protocol, &view, &extensions](ClientConnection& connection) {
+        connection.subProtocol.assign(protocol);
+        extensions = connection.extensions.Negotiate(view.Extensions, m_extensions);
+    });
+    
+    // Send handshake response, written on the stack
+    char handshakeResponse[WebSocketProtocol::kHandshakeResponseSize];
+    size_t responseSize = WebSocketProtocol::WriteHandshakeResponse(view.Key, protocol, extensions, handshakeResponse,
+                                                                    sizeof(handshakeResponse));
+    if (responseSize == 0) {
+        if (m_onError) m_onError("Negotiated subprotocol and extensions do not fit the handshake response");
+        SendHTTPResponse(client, "500 Internal Server Error", "text/plain", "Handshake response too large");
+        return;
+    }
+    auto [sendResult, sent] = client->socket->SendRaw(handshakeResponse, responseSize);
     if (!sendResult.IsSuccess()) {
         if (m_onError) m_onError("Failed to send WebSocket handshake: " + sendResult.GetErrorMessage());
         return;
     }
+    m_bytesSent->Increment(sent);
+    client->counters.Sent(sent);
+    m_handshakeLatency->Record(ElapsedNs(client->connectTime));
+    {
+        // SendTo may write frames from here on
+        std::lock_guard<std::mutex> lock(client->sendMutex);
+        client->isWebSocket = true;
+    }
+    client->counters.WebSocket.store(true, std::memory_order_relaxed);
+    
+    // Replies from the handler workers and published frames come back
+    // through a per-connection channel
+    if (m_dispatcher || m_topicRouter) {
+        size_t replyCapacity = m_dispatcher ? m_dispatcher->QueueCapacity() : 2;
+        size_t frameCapacity = m_topicRouter ? m_topicOptions.SubscriberQueueCapacity : 2;
+        auto channel = std::make_shared<DispatchChannel>(replyCapacity, frameCapacity, &m_memoryBudget);
+        if (channel->Valid()) {
+            // Statistics readers look at the channel under the slot lock
+            m_connections.Find(client->handle, [&channel](ClientConnection& connection) {
+                connection.dispatchChannel = std::move(channel);
+            });
+            if (m_topicRouter) {
+                m_topicRouter->Register(client->handle.Value(), client->dispatchChannel);
+            }
+        } else if (m_onError) {
+            m_onError("Failed to create dispatch channel; handling messages inline without topics");
+        }
+    }
+    
+    // Frames are decoded straight out of the pooled receive buffer. Message
+    // payloads stream through it, so only an incomplete header or control
+    // frame is carried over to the next receive.
+    uint8_t* buffer = client->receiveBuffer.Data();
+    const size_t bufferSize = client->receiveBuffer.Size();
+    size_t buffered = 0;
+    
+    // Clients exempt from the size limit (see IsMessageSizeValid) get no limit
+    bool limited = m_securityConfig.enableMessageSizeLimit &&
+                   !IsMessageSizeValid(std::numeric_limits<size_t>::max(), client->clientIP);
+    FrameStreamDecoder decoder(limited ? m_securityConfig.maxMessageSize : 0);
+    decoder.SetAllowedRsv(client->extensions.RsvBits(), client->extensions.ContinuationRsvBits());
+    decoder.SetRequireMask(true);
+    std::vector<uint8_t> message;   // Message being reassembled when not streaming
     
     // Handle WebSocket messages
     while (!m_shouldStop && client->socket && client->socket->Valid()) {
-        auto [msgResult, msgData] = client->socket->Receive(m_securityConfig.maxMessageSize);
-        if (!msgResult.IsSuccess() || msgData.empty()) {
+        // Paused and throttled connections leave new data in the kernel
+        if (!WaitUntilReadAllowed(client)) {
             break;
         }
         
-        // Update activity time
-        client->connectTime = std::chrono::steady_clock::now();
-        
-        // Parse WebSocket frame
-        WebSocketFrame frame;
-        size_t bytesConsumed = 0;
-        auto parseResult = WebSocketProtocol::ParseFrame(msgData, frame, bytesConsumed);
+        // Flush worker replies while waiting for the next request
+        if (client->dispatchChannel && !WaitForDispatchedInput(client)) {
+            break;
+        }
         
-        if (!parseResult.IsSuccess()) {
-            continue;
+        auto [msgResult, received] = client->socket->ReceiveInto(buffer + buffered, bufferSize - buffered);
+        if (!msgResult.IsSuccess() || received == 0) {
+            break;
         }
+        m_bytesReceived->Increment(received);
+        client->counters.Received(received);
         
-        // Handle text messages
-        if (frame.Opcode == WEBSOCKET_OPCODE::TEXT) {
-            std::string message(frame.PayloadData.begin(), frame.PayloadData.end());
-            
-            // Validate message size
-            if (m_securityConfig.enableMessageSizeLimit && !IsMessageSizeValid(message, client->clientIP)) {
-                if (m_onSecurityViolation) {
+        size_t length = buffered + received;
+        size_t offset = 0;
+        bool keepOpen = true;
+        while (keepOpen) {
+            FrameStreamDecoder::Event event;
+            size_t consumed = 0;
+            Result decodeResult = decoder.Next(buffer + offset, length - offset, consumed, event);
+            if (decodeResult.IsError()) {
+                // Too large is reported before any of the payload has been read
+                bool tooLarge = decodeResult.GetErrorCode() == ERROR_CODE::WEBSOCKET_PAYLOAD_TOO_LARGE;
+                Reject(tooLarge ? REJECT_REASON::MESSAGE_TOO_LARGE : REJECT_REASON::PROTOCOL_ERROR);
+                if (tooLarge && m_onSecurityViolation) {
                     m_onSecurityViolation(client->clientIP, "WebSocket message too large");
                 }
+                Close(client->handle, tooLarge ? 1009 : 1002);
+                keepOpen = false;
                 break;
             }
-            
-            // Call message handler
-            if (m_onWebSocketMessage) {
-                try {
-                    WebSocketMessage wsMessage{frame.Opcode, std::vector<uint8_t>(message.begin(), message.end())};
-                    WebSocketMessageWithIP wsMessageWithIP{wsMessage, client->clientIP, frame.Opcode};
-                    std::string response = m_onWebSocketMessage(wsMessageWithIP);
-                    
-                    if (!response.empty()) {
-                        // Send response
-                        WebSocketFrame responseFrame = WebSocketProtocol::CreateTextFrame(response);
-                        std::vector<uint8_t> responseData = WebSocketProtocol::GenerateFrame(responseFrame);
-                        client->socket->Send(responseData);
-                    }
-                } catch (const std::exception& e) {
-                    if (m_onError) m_onError("WebSocket message handler error: " + std::string(e.what()));
+            offset += consumed;
+            if (event.Type == STREAM_EVENT::NEED_MORE) {
+                break;
+            }
+            if (event.Type == STREAM_EVENT::CONTROL || event.FrameEnd) {
+                uint8_t opcode = static_cast<uint8_t>(event.Type == STREAM_EVENT::CONTROL ? event.Opcode : decoder.FrameOpcode());
+                if (Counter* frames = m_framesReceived[opcode & 0x0F]) {
+                    frames->Increment();
                 }
+                client->counters.FramesIn.fetch_add(1, std::memory_order_relaxed);
             }
-        } else if (frame.Opcode == WEBSOCKET_OPCODE::CLOSE) {
+            keepOpen = event.Type == STREAM_EVENT::CONTROL ? HandleControlFrame(client, event)
+                                                            : HandleMessageData(client, event, message);
+        }
+        
+        if (!keepOpen) {
             break;
         }
+        
+        // Keep the undecoded tail for the next receive
+        buffered = length - offset;
+        if (buffered > 0) {
+            memmove(buffer, buffer + offset, buffered);
+        }
+    }
+    
+    // Replies already queued still go out; later ones are dropped by the workers
+    if (client->dispatchChannel) {
+        if (m_topicRouter) {
+            m_topicRouter->Unregister(client->handle.Value());
+        }
+        SendDispatchedReplies(client);
+        client->dispatchChannel->Closed = true;
+        std::shared_ptr<DispatchChannel> channel;
+        m_connections.Find(client->handle, [&channel](ClientConnection& connection) {
+            channel = std::move(connection.dispatchChannel);
+        });
     }
 }
 
-void HttpWsServer::SendHTTPResponseSync(ClientConnection* client, const std::string& status, 
-                                                    const std::string& contentType, const std::string& body) {
-    if (!client || !client->socket) return;
+bool HttpWsServer::HandleMessageData(ClientConnection* client, const FrameStreamDecoder::Event& event,
+                                     std::vector<uint8_t>& message) {
+    if (event.Rsv != 0) {
+        return HandleExtensionData(client, event, message);
+    }
+    if (m_onMessageBegin || m_onMessageChunk || m_onMessageEnd) {
+        if (event.First && m_onMessageBegin) {
+            m_onMessageBegin(client->handle, event.Opcode);
+        }
+        if (event.Length > 0 && m_onMessageChunk) {
+            m_onMessageChunk(client->handle, event.Data, event.Length);
+        }
+        if (event.Last && m_onMessageEnd) {
+            m_onMessageEnd(client->handle);
+        }
+        return true;
+    }
     
-    // Generate optimized HTTP response directly as vector
-    std::vector<uint8_t> response;
-    response.reserve(256 + body.size()); // Pre-allocate
+    // An unfragmented message that arrived in one receive is used in place
+    if (event.First && event.Last) {
+        return DeliverMessage(client, event.Opcode, event.Data, event.Length, nullptr);
+    }
+    if (!ReserveMessageMemory(client, event.Length)) {
+        return false;
+    }
+    message.insert(message.end(), event.Data, event.Data + event.Length);
+    if (!event.Last) {
+        return true;
+    }
+    bool keepOpen = DeliverMessage(client, event.Opcode, message.data(), message.size(), &message);
+    ReleaseMessage(client, message);
+    return keepOpen;
+}
+
+bool HttpWsServer::ReserveMessageMemory(ClientConnection* client, size_t bytes) {
+    if (client->messageMemory.TryGrow(bytes)) {
+        return true;
+    }
+    // Shed the message rather than the server; 1013 asks the client to try again later
+    Reject(REJECT_REASON::MEMORY_BUDGET);
+    Close(client->handle, 1013);
+    return false;
+}
+
+void HttpWsServer::ReleaseMessage(ClientConnection* client, std::vector<uint8_t>& message) {
+    message.clear();
+    if (message.capacity() > client->receiveBuffer.Size()) {
+        message.shrink_to_fit();    // Don't hold on to one large message's worth of memory
+    }
+    client->messageMemory.Reset();
+}
+
+bool HttpWsServer::HandleExtensionData(ClientConnection* client, const FrameStreamDecoder::Event& event,
+                                       std::vector<uint8_t>& message) {
+    // Extensions transform whole messages, so even streamed ones are reassembled first
+    if (!ReserveMessageMemory(client, event.Length)) {
+        return false;
+    }
+    message.insert(message.end(), event.Data, event.Data + event.Length);
+    if (!event.Last) {
+        return true;
+    }
     
-    // Add status line
-    const char* statusLine = "HTTP/1.1 ";
-    response.insert(response.end(), statusLine, statusLine + 9);
-    response.insert(response.end(), status.begin(), status.end());
-    response.push_back('\r'); response.push_back('\n');
+    Result decodeResult = client->extensions.Decode(event.Opcode, event.Rsv, message);
+    bool tooLarge = decodeResult.IsSuccess() && m_securityConfig.enableMessageSizeLimit &&
+                    !IsMessageSizeValid(message.size(), client->clientIP);
+    if (decodeResult.IsError() || tooLarge) {
+        Reject(tooLarge ? REJECT_REASON::MESSAGE_TOO_LARGE : REJECT_REASON::PROTOCOL_ERROR);
+        Close(client->handle, tooLarge ? 1009 : 1002);
+        ReleaseMessage(client, message);
+        return false;
+    }
     
-    // Add content type
-    const char* contentTypeHeader = "Content-Type: ";
-    response.insert(response.end(), contentTypeHeader, contentTypeHeader + 14);
-    response.insert(response.end(), contentType.begin(), contentType.end());
-    const char* charset = "; charset=UTF-8\r\n";
-    response.insert(response.end(), charset, charset + 17);
+    // Decoding may have made the message larger than what arrived
+    size_t reserved = client->messageMemory.Bytes();
+    if (message.size() > reserved && !ReserveMessageMemory(client, message.size() - reserved)) {
+        ReleaseMessage(client, message);
+        return false;
+    }
     
-    // Add content length
-    const char* contentLengthHeader = "Content-Length: ";
-    response.insert(response.end(), contentLengthHeader, contentLengthHeader + 16);
-    std::string lengthStr = std::to_string(body.length());
-    response.insert(response.end(), lengthStr.begin(), lengthStr.end());
-    response.push_back('\r'); response.push_back('\n');
+    bool keepOpen = true;
+    if (m_onMessageBegin || m_onMessageChunk || m_onMessageEnd) {
+        if (m_onMessageBegin) {
+            m_onMessageBegin(client->handle, event.Opcode);
+        }
+        if (!message.empty() && m_onMessageChunk) {
+            m_onMessageChunk(client->handle, message.data(), message.size());
+        }
+        if (m_onMessageEnd) {
+            m_onMessageEnd(client->handle);
+        }
+    } else {
+        keepOpen = DeliverMessage(client, event.Opcode, message.data(), message.size(), &message);
+    }
+    ReleaseMessage(client, message);
+    return keepOpen;
+}
+
+bool HttpWsServer::HandleControlFrame(ClientConnection* client, const FrameStreamDecoder::Event& event) {
+    if (event.Opcode == WEBSOCKET_OPCODE::PING) {
+        // Control frames only wait for the frame being written, not a whole message
+        SendFrame(client, WebSocketProtocol::GenerateFrame(WEBSOCKET_OPCODE::PONG, event.Data, event.Length));
+        return true;
+    }
+    if (event.Opcode == WEBSOCKET_OPCODE::PONG) {
+        client->counters.CompletePing(event.Data, event.Length);
+        return true;
+    }
+    if (event.Opcode == WEBSOCKET_OPCODE::CLOSE) {
+        // Echo the status code to complete the closing handshake, unless
+        // this is the answer to a close frame sent by Close() or Drain().
+        // Marked and sent under sendMutex, so no SendTo can slip a data frame in after it
+        BufferHandle frame = WebSocketProtocol::GenerateFrame(WEBSOCKET_OPCODE::CLOSE, event.Data, std::min<size_t>(event.Length, 2));
+        std::lock_guard<std::mutex> lock(client->sendMutex);
+        if (!client->closeSent.exchange(true) && client->socket->Send(frame).IsSuccess()) {
+            m_bytesSent->Increment(frame.Size());
+            m_framesSent[static_cast<uint8_t>(WEBSOCKET_OPCODE::CLOSE)]->Increment();
+            client->counters.Sent(frame.Size(), 1);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool HttpWsServer::DeliverMessage(ClientConnection* client, WEBSOCKET_OPCODE opcode, const uint8_t* data, size_t length,
+                                  std::vector<uint8_t>* reassembled) {
+    if (m_onWebSocketMessageView) {
+        if (m_dispatcher && client->dispatchChannel) {
+            // The worker needs its own copy; a pooled buffer avoids the heap
+            BufferHandle payload = BufferPool::Acquire(length);
+            if (!payload.Valid() || !payload.Resize(length)) {
+                if (m_onError) m_onError("Failed to allocate a buffer for a dispatched message");
+                return false;
+            }
+            if (length > 0) {
+                memcpy(payload.Data(), data, length);
+            }
+            return DispatchWebSocketMessage(client,
+                WebSocketMessageWithIP{WebSocketMessage{opcode, {}}, client->clientIP, opcode, client->handle},
+                std::move(payload));
+        }
+        
+        try {
+            WebSocketMessageView view{opcode, data, length, client->handle, client->clientIP};
+            auto start = std::chrono::steady_clock::now();
+            std::string response = m_onWebSocketMessageView(view);
+            m_messageHandlerLatency->Record(ElapsedNs(start));
+            if (!response.empty()) {
+                SendDataMessage(client, opcode, reinterpret_cast<const uint8_t*>(response.data()), response.size());
+            }
+        } catch (const std::exception& e) {
+            if (m_onError) m_onError("WebSocket message handler error: " + std::string(e.what()));
+        }
+        return true;
+    }
     
-    // Add connection close
-    const char* connectionHeader = "Connection: close\r\n";
-    response.insert(response.end(), connectionHeader, connectionHeader + 19);
+    if (!m_onWebSocketMessage) {
+        return true;
+    }
     
-    // Add blank line
-    response.push_back('\r'); response.push_back('\n');
+    // The owning message takes the reassembly buffer instead of a copy
+    WebSocketMessage wsMessage{opcode, reassembled ? std::move(*reassembled) : std::vector<uint8_t>(data, data + length)};
+    WebSocketMessageWithIP wsMessageWithIP{std::move(wsMessage), client->clientIP, opcode, client->handle};
+    if (m_dispatcher && client->dispatchChannel) {
+        return DispatchWebSocketMessage(client, std::move(wsMessageWithIP), BufferHandle());
+    }
     
-    // Add body
-    response.insert(response.end(), body.begin(), body.end());
+    // Call message handler
+    try {
+        auto start = std::chrono::steady_clock::now();
+        std::string response = m_onWebSocketMessage(wsMessageWithIP);
+        m_messageHandlerLatency->Record(ElapsedNs(start));
+        if (!response.empty()) {
+            // Send response
+            SendDataMessage(client, opcode, reinterpret_cast<const uint8_t*>(response.data()), response.size());
+        }
+    } catch (const std::exception& e) {
+        if (m_onError) m_onError("WebSocket message handler error: " + std::string(e.what()));
+    }
+    return true;
+}
+
+bool HttpWsServer::DispatchWebSocketMessage(ClientConnection* client, WebSocketMessageWithIP&& message, BufferHandle&& payload) {
+    DispatchChannel& channel = *client->dispatchChannel;
+    size_t bytes = message.message.Data.size() + payload.Size();
+    DispatchedMessage dispatched{client->dispatchChannel, std::move(message), std::move(payload), bytes};
+    // Already in memory, so counted even over the budget; the worker releases it
+    if (channel.Budget) {
+        channel.Budget->Reserve(bytes);
+    }
+    channel.Pending.fetch_add(1, std::memory_order_acq_rel);
+    channel.PendingBytes.fetch_add(bytes, std::memory_order_relaxed);
+    
+    // A full worker inbox is backpressure: keep delivering replies (the worker
+    // may be waiting on our reply queue) and stop reading until the worker
+    // takes a message and wakes us
+    uint64_t id = client->handle.Value();
+    if (m_dispatcher->TrySubmit(id, dispatched)) {
+        return true;
+    }
+    while (!m_shouldStop) {
+        m_dispatcher->NotifyWhenRoom(id, client->dispatchChannel);
+        if (m_dispatcher->TrySubmit(id, dispatched, true)) {
+            return true;
+        }
+        SendDispatchedReplies(client);
+        if (channel.WaitForNotify(kReadBlockedWaitMs).IsError()) {
+            break;
+        }
+    }
+    channel.PendingBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    channel.Pending.fetch_sub(1, std::memory_order_acq_rel);
+    if (channel.Budget) {
+        channel.Budget->Release(bytes);
+    }
+    return false;
+}
+
+bool HttpWsServer::WaitForDispatchedInput(ClientConnection* client) {
+    while (!m_shouldStop) {
+        SendDispatchedReplies(client);
+        auto [waitResult, readable] = client->dispatchChannel->Wait(*client->socket, 1000);
+        if (!waitResult.IsSuccess()) {
+            return false;
+        }
+        if (readable) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HttpWsServer::WaitUntilReadAllowed(ClientConnection* client) {
+    while (!m_shouldStop) {
+        bool paused = client->counters.ReadPaused.load(std::memory_order_acquire);
+        if (!UpdateReadThrottle(client) && !paused) {
+            return true;
+        }
+        
+        // Replies keep flowing; a worker finishing a message, ResumeRead and
+        // the socket closing all end the wait early
+        std::pair<Result, bool> waited;
+        if (client->dispatchChannel) {
+            SendDispatchedReplies(client);
+            waited = client->dispatchChannel->WaitWithoutReading(*client->socket, kReadBlockedWaitMs);
+        } else {
+            waited = client->socket->WaitClosed(kReadBlockedWaitMs);
+        }
+        if (!waited.first.IsSuccess()) {
+            return false;
+        }
+        if (waited.second) {
+            return true;    // The receive reports the close once buffered data is read
+        }
+    }
+    return false;
+}
+
+bool HttpWsServer::UpdateReadThrottle(ClientConnection* client) {
+    DispatchChannel* channel = client->dispatchChannel.get();
+    if (!channel || !m_dispatcher) {
+        return false;
+    }
     
-    // Send synchronously - blocking fallback
-    client->socket->Send(response);
+    // Throttling starts at a limit and ends at half of it, so a connection
+    // hovering around its limit doesn't stop and start on every message
+    bool throttled = client->counters.ReadThrottled.load(std::memory_order_relaxed);
+    auto over = [throttled](size_t queued, size_t limit) {
+        return limit != 0 && (throttled ? queued > limit / 2 : queued >= limit);
+    };
+    bool throttle = over(channel->Pending.load(std::memory_order_acquire), m_flowControl.MaxQueuedMessages) ||
+                    over(channel->PendingBytes.load(std::memory_order_relaxed), m_flowControl.MaxQueuedBytes) ||
+                    over(m_dispatcher->QueuedBytes(), m_flowControl.MaxServerQueuedBytes);
+    if (throttle != throttled) {
+        channel->Throttled.store(throttle);
+        client->counters.ReadThrottled.store(throttle, std::memory_order_relaxed);
+        if (throttle) {
+            m_readThrottles->Increment();
+        }
+    }
+    return throttle;
+}
+
+void HttpWsServer::SendDispatchedReplies(ClientConnection* client) {
+    DispatchedReply reply;
+    while (client->dispatchChannel->PopReply(reply)) {
+        SendDataMessage(client, reply.Opcode, reinterpret_cast<const uint8_t*>(reply.Data.data()), reply.Data.size());
+    }
     
-    // For HTTP connections, close after sending response
-    // Socket::Close() handles proper shutdown internally
-    client->socket->Close();
+    // Published frames are already encoded and shared with the other subscribers
+    BufferHandle frame;
+    while (client->dispatchChannel->PopFrame(frame)) {
+        std::lock_guard<std::mutex> lock(client->messageMutex);
+        SendFrame(client, frame);
+        frame.Reset();
+    }
 }
 
 void HttpWsServer::SendHTTPResponse(ClientConnection* client, const std::string& status, 
                                                const std::string& contentType, const std::string& body) {
     if (!client || !client->socket) return;
     
-    // Enable async I/O for better performance
-    if (!client->socket->IsAsyncEnabled()) {
-        auto asyncResult = client->socket->EnableAsyncIO();
-        if (!asyncResult.IsSuccess()) {
-            // Fallback to sync if async fails
-            SendHTTPResponseSync(client, status, contentType, body);
-            return;
-        }
-    }
-    
     // Generate optimized HTTP response directly as vector
     std::vector<uint8_t> response;
     response.reserve(256 + body.size()); // Pre-allocate
@@ -452,7 +1657,7 @@ void HttpWsServer::SendHTTPResponse(ClientConnection* client, const std::string&
     response.insert(response.end(), lengthStr.begin(), lengthStr.end());
     response.push_back('\r'); response.push_back('\n');
     
-    // Add connection close for reliability
+    // Add connection close
     const char* connectionHeader = "Connection: close\r\n";
     response.insert(response.end(), connectionHeader, connectionHeader + 19);
     
@@ -462,38 +1667,58 @@ void HttpWsServer::SendHTTPResponse(ClientConnection* client, const std::string&
     // Add body
     response.insert(response.end(), body.begin(), body.end());
     
-    // Send asynchronously - non-blocking
-    auto sendResult = client->socket->SendAsync(response);
-    if (!sendResult.IsSuccess()) {
-        // Fallback to sync if async send fails
-        SendHTTPResponseSync(client, status, contentType, body);
-        return;
+    // Responses are small and the connection closes right after, so a
+    // blocking send is all they need
+    if (client->socket->Send(response).IsSuccess()) {
+        m_bytesSent->Increment(response.size());
+        client->counters.Sent(response.size());
     }
     
     // For HTTP connections, close after sending response
-    // Socket::Close() handles proper shutdown internally
-    client->socket->Close();
+    CloseHTTPConnection(client);
+}
+
+void HttpWsServer::CloseHTTPConnection(ClientConnection* client) {
+    // Stop() and BlockIP() shut sockets down through the table, so the close
+    // happens under the same slot lock; a client never inserted has no other users
+    bool found = m_connections.Find(client->handle, [](ClientConnection& connection) {
+        std::lock_guard<std::mutex> lock(connection.sendMutex);
+        connection.socket->Close();
+    });
+    if (!found) {
+        client->socket->Close();
+    }
 }
 
 bool HttpWsServer::IsIPBlocked(const std::string& ip) const {
     return std::find(m_securityConfig.blockedIPs.begin(), m_securityConfig.blockedIPs.end(), ip) != m_securityConfig.blockedIPs.end();
 }
 
+bool HttpWsServer::IsTrustedClient(const std::string& ip) const {
+    if (ip == "127.0.0.1" || ip == "::1" || ip == "localhost") {
+        return true;
+    }
+    // Unix socket peers are often a reverse proxy relaying remote clients
+    return m_securityConfig.trustUnixPeers && (ip == "unix" || ip.compare(0, 5, "unix:") == 0);
+}
+
 bool HttpWsServer::IsConnectionAllowed(const std::string& ip) {
     std::lock_guard<std::mutex> lock(m_connectionMutex);
     
     // Skip security limits for local addresses
-    if (ip == "127.0.0.1" || ip == "::1" || ip == "localhost") {
+    if (IsTrustedClient(ip)) {
         return true;
     }
     
     // Check if IP is blocked
     if (IsIPBlocked(ip)) {
+        Reject(REJECT_REASON::IP_BLOCKED);
         return false;
     }
     
     // Check total connection limit
     if (m_currentConnections.load() >= m_securityConfig.maxConnectionsTotal) {
+        Reject(REJECT_REASON::CONNECTION_LIMIT);
         return false;
     }
     
@@ -504,6 +1729,7 @@ bool HttpWsServer::IsConnectionAllowed(const std::string& ip) {
         
         // Check current connections from this IP
         if (info.currentConnections >= m_securityConfig.maxConnectionsPerIP) {
+            Reject(REJECT_REASON::CONNECTION_LIMIT);
             return false;
         }
         
@@ -519,6 +1745,7 @@ bool HttpWsServer::IsConnectionAllowed(const std::string& ip) {
         
         // Check if this IP has exceeded requests per period
         if (info.requestsThisPeriod >= m_securityConfig.maxRequestsPerIP) {
+            Reject(REJECT_REASON::RATE_LIMIT);
             return false;
         }
     }
@@ -526,25 +1753,25 @@ bool HttpWsServer::IsConnectionAllowed(const std::string& ip) {
     return true;
 }
 
-bool HttpWsServer::IsRequestSizeValid(const std::string& request, const std::string& clientIP) const {
+bool HttpWsServer::IsRequestSizeValid(std::string_view request, const std::string& clientIP) const {
     // Skip size validation for local addresses
-    if (clientIP == "127.0.0.1" || clientIP == "::1" || clientIP == "localhost") {
+    if (IsTrustedClient(clientIP)) {
         return true;
     }
     return request.size() <= static_cast<size_t>(m_securityConfig.maxRequestSize);
 }
 
-bool HttpWsServer::IsMessageSizeValid(const std::string& message, const std::string& clientIP) const {
+bool HttpWsServer::IsMessageSizeValid(size_t messageSize, const std::string& clientIP) const {
     // Skip size validation for local addresses
-    if (clientIP == "127.0.0.1" || clientIP == "::1" || clientIP == "localhost") {
+    if (IsTrustedClient(clientIP)) {
         return true;
     }
-    return message.size() <= static_cast<size_t>(m_securityConfig.maxMessageSize);
+    return messageSize <= static_cast<size_t>(m_securityConfig.maxMessageSize);
 }
 
 void HttpWsServer::UpdateConnectionInfo(const std::string& ip, bool isWebSocket) {
     // Skip tracking for local addresses (they're trusted)
-    if (ip == "127.0.0.1" || ip == "::1" || ip == "localhost") {
+    if (IsTrustedClient(ip)) {
         m_currentConnections++;
         return;
     }
@@ -571,13 +1798,8 @@ void HttpWsServer::UpdateConnectionInfo(const std::string& ip, bool isWebSocket)
 }
 
 void HttpWsServer::RemoveConnection(const std::string& ip) {
-    // Skip tracking cleanup for local addresses
-    if (ip == "127.0.0.1" || ip == "::1" || ip == "localhost") {
-        m_currentConnections--;
-        return;
-    }
-    
-    {
+    // Local addresses are not tracked per IP (they're trusted)
+    if (!IsTrustedClient(ip)) {
         std::lock_guard<std::mutex> lock(m_connectionMutex);
         auto it = m_connectionMap.find(ip);
         if (it != m_connectionMap.end()) {
@@ -586,20 +1808,8 @@ void HttpWsServer::RemoveConnection(const std::string& ip) {
                 m_connectionMap.erase(it);
             }
         }
-        m_currentConnections--;
-    }
-    
-    // Remove from clients list
-    {
-        std::lock_guard<std::mutex> lock(m_clientsMutex);
-        m_clients.erase(
-            std::remove_if(m_clients.begin(), m_clients.end(),
-                [&ip](const std::unique_ptr<ClientConnection>& client) {
-                    return client && client->clientIP == ip;
-                }),
-            m_clients.end()
-        );
     }
+    m_currentConnections--;
     
     // Notify disconnection
     if (m_onDisconnect) {
@@ -608,17 +1818,22 @@ void HttpWsServer::RemoveConnection(const std::string& ip) {
 }
 
 std::string HttpWsServer::GetClientIP(const Socket& socket) {
+    // Unix socket peers have no address; a bound peer is told apart by its path
+    if (socket.IsUnixDomain()) {
+        std::string path = socket.RemoteAddress();
+        return path.empty() ? "unix" : "unix:" + path;
+    }
     return socket.RemoteAddress();
 }
 
-HTTPRequest HttpWsServer::ParseHTTPRequest(const std::string& request, const std::string& clientIP) {
+HTTPRequest HttpWsServer::ParseHTTPRequest(std::string_view request, const std::string& clientIP) {
     HTTPRequest httpRequest;
     httpRequest.clientIP = clientIP;
     
     // Parse first line (method and path)
     size_t lineEnd = request.find("\r\n");
     if (lineEnd != std::string::npos) {
-        std::string firstLine = request.substr(0, lineEnd);
+        std::string firstLine(request.substr(0, lineEnd));
         std::stringstream ss(firstLine);
         ss >> httpRequest.method >> httpRequest.path;
     }
@@ -629,7 +1844,7 @@ HTTPRequest HttpWsServer::ParseHTTPRequest(const std::string& request, const std
         size_t nextLineEnd = request.find("\r\n", pos);
         if (nextLineEnd == std::string::npos) break;
         
-        std::string line = request.substr(pos, nextLineEnd - pos);
+        std::string line(request.substr(pos, nextLineEnd - pos));
         if (line.empty()) break;
         
         size_t colonPos = line.find(':');
@@ -652,13 +1867,9 @@ HTTPRequest HttpWsServer::ParseHTTPRequest(const std::string& request, const std
     return httpRequest;
 }
 
-bool HttpWsServer::IsWebSocketUpgrade(const std::string& request) const {
-    std::string lowerRequest = request;
-    std::transform(lowerRequest.begin(), lowerRequest.end(), lowerRequest.begin(), ::tolower);
-    
-    return lowerRequest.find("upgrade: websocket") != std::string::npos &&
-           lowerRequest.find("connection: upgrade") != std::string::npos &&
-           lowerRequest.find("sec-websocket-key:") != std::string::npos;
+bool HttpWsServer::IsWebSocketUpgrade(std::string_view request) const {
+    // Header scan over the request in place; the handshake itself is validated later
+    return WebSocketProtocol::IsUpgradeRequest(request);
 }
 
 std::string HttpWsServer::GenerateHTTPResponse(const std::string& status, const std::string& contentType, const std::string& body) {
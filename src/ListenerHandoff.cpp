@@ -0,0 +1,262 @@
+#include "WebSocket/ListenerHandoff.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+namespace WebSocket {
+
+#ifdef _WIN32
+
+ListenerHandoff::~ListenerHandoff() {
+}
+
+Result ListenerHandoff::Listen(const std::string&) {
+    return Result(ERROR_CODE::SOCKET_OPTION_NOT_SUPPORTED, "Listener handoff needs Unix domain sockets");
+}
+
+std::pair<Result, bool> ListenerHandoff::Offer(Socket&) {
+    return {Result(ERROR_CODE::SOCKET_OPTION_NOT_SUPPORTED, "Listener handoff needs Unix domain sockets"), false};
+}
+
+void ListenerHandoff::Close() {
+}
+
+bool ListenerHandoff::Valid() const {
+    return false;
+}
+
+std::pair<Result, std::unique_ptr<Socket>> ListenerHandoff::Receive(const std::string&, int) {
+    return {Result(ERROR_CODE::SOCKET_OPTION_NOT_SUPPORTED, "Listener handoff needs Unix domain sockets"), nullptr};
+}
+
+#else
+
+namespace {
+
+// The successor sends nothing; this byte carries the descriptor
+const char kHandoffByte = 'L';
+
+bool MakeAddress(const std::string& path, struct sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+int CreateUnixSocket() {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+}
+
+bool SameUser(int fd) {
+#if defined(SO_PEERCRED)
+    struct ucred credentials{};
+    socklen_t length = sizeof(credentials);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0 && credentials.uid == geteuid();
+#else
+    uid_t uid = 0;
+    gid_t gid = 0;
+    return getpeereid(fd, &uid, &gid) == 0 && uid == geteuid();
+#endif
+}
+
+} // namespace
+
+ListenerHandoff::~ListenerHandoff() {
+    Close();
+}
+
+Result ListenerHandoff::Listen(const std::string& path) {
+    Close();
+
+    struct sockaddr_un address;
+    if (!MakeAddress(path, address)) {
+        return Result(ERROR_CODE::INVALID_PARAMETER, "Handoff path is empty or too long");
+    }
+
+    int fd = CreateUnixSocket();
+    if (fd < 0) {
+        return Result(ERROR_CODE::SOCKET_CREATE_FAILED, errno);
+    }
+
+    // Offer polls between accept waits, so it must never block
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    // The previous process's handoff socket is left behind once it has handed over
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        int error = errno;
+        close(fd);
+        return Result(ERROR_CODE::SOCKET_BIND_FAILED, error);
+    }
+    chmod(path.c_str(), S_IRUSR | S_IWUSR);
+    if (listen(fd, 4) != 0) {
+        int error = errno;
+        close(fd);
+        unlink(path.c_str());
+        return Result(ERROR_CODE::SOCKET_LISTEN_FAILED, error);
+    }
+
+    m_handle = fd;
+    m_path = path;
+    return Result();
+}
+
+std::pair<Result, bool> ListenerHandoff::Offer(Socket& listener) {
+    if (!Valid()) {
+        return {Result(ERROR_CODE::INVALID_PARAMETER, "Handoff socket not listening"), false};
+    }
+
+    int peer = accept(static_cast<int>(m_handle), nullptr, nullptr);
+    if (peer < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return {Result(), false};
+        }
+        return {Result(ERROR_CODE::SOCKET_ACCEPT_FAILED, errno), false};
+    }
+    if (!SameUser(peer)) {
+        close(peer);
+        return {Result(ERROR_CODE::INVALID_PARAMETER, "Handoff peer runs as another user"), false};
+    }
+
+    int descriptor = static_cast<int>(listener.NativeHandle());
+    char byte = kHandoffByte;
+    struct iovec data = {&byte, 1};
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    struct msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(header), &descriptor, sizeof(int));
+
+    // The successor listens at the same path as soon as it has the listener,
+    // so the path must be gone before the descriptor goes out
+    std::string path = m_path;
+    Close();
+    ssize_t sent = sendmsg(peer, &message, MSG_NOSIGNAL);
+    int error = errno;
+    close(peer);
+    if (sent != 1) {
+        Listen(path);
+        return {Result(ERROR_CODE::SOCKET_SEND_FAILED, error), false};
+    }
+
+    // Shutting the listener down now would stop the successor accepting too
+    listener.m_isShared = true;
+    return {Result(), true};
+}
+
+void ListenerHandoff::Close() {
+    if (m_handle < 0) {
+        return;
+    }
+    close(static_cast<int>(m_handle));
+    unlink(m_path.c_str());
+    m_handle = -1;
+    m_path.clear();
+}
+
+bool ListenerHandoff::Valid() const {
+    return m_handle >= 0;
+}
+
+std::pair<Result, std::unique_ptr<Socket>> ListenerHandoff::Receive(const std::string& path, int timeoutMs) {
+    struct sockaddr_un address;
+    if (!MakeAddress(path, address)) {
+        return {Result(ERROR_CODE::INVALID_PARAMETER, "Handoff path is empty or too long"), nullptr};
+    }
+
+    int fd = CreateUnixSocket();
+    if (fd < 0) {
+        return {Result(ERROR_CODE::SOCKET_CREATE_FAILED, errno), nullptr};
+    }
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        int error = errno;
+        close(fd);
+        return {Result(ERROR_CODE::SOCKET_CONNECT_FAILED, error), nullptr};
+    }
+
+    // The running server checks for successors between accept waits
+    struct pollfd waiter = {fd, POLLIN, 0};
+    int ready = poll(&waiter, 1, timeoutMs);
+    if (ready <= 0) {
+        int error = ready < 0 ? errno : 0;
+        close(fd);
+        if (error != 0) {
+            return {Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, error), nullptr};
+        }
+        return {Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, "Timed out waiting for the listener"), nullptr};
+    }
+
+    char byte = 0;
+    struct iovec data = {&byte, 1};
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    struct msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+#ifdef MSG_CMSG_CLOEXEC
+    int flags = MSG_CMSG_CLOEXEC;
+#else
+    int flags = 0;
+#endif
+    ssize_t received = recvmsg(fd, &message, flags);
+    int error = errno;
+    close(fd);
+    if (received != 1) {
+        return {Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, received < 0 ? error : 0), nullptr};
+    }
+
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    if (byte != kHandoffByte || !header || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS ||
+        header->cmsg_len != CMSG_LEN(sizeof(int))) {
+        return {Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, "Handoff message carried no listener"), nullptr};
+    }
+    int descriptor = -1;
+    std::memcpy(&descriptor, CMSG_DATA(header), sizeof(int));
+#ifndef MSG_CMSG_CLOEXEC
+    fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+#endif
+
+    std::unique_ptr<Socket> listener = Socket::CreateFromNative(descriptor);
+    if (!listener) {
+        return {Result(ERROR_CODE::SOCKET_CREATE_FAILED, "Socket system initialization failed"), nullptr};
+    }
+    listener->m_isListening = true;
+    listener->m_isBlocking = (fcntl(descriptor, F_GETFL, 0) & O_NONBLOCK) == 0;
+
+    // A Unix listener's socket file now belongs to this process and goes when it closes
+    struct sockaddr_storage local;
+    socklen_t localLength = sizeof(local);
+    if (getsockname(descriptor, reinterpret_cast<struct sockaddr*>(&local), &localLength) == 0 &&
+        local.ss_family == AF_UNIX) {
+        listener->m_isUnix = true;
+        std::string localPath = listener->LocalAddress();
+        if (!localPath.empty() && localPath[0] != '@') {
+            listener->m_unixPath = localPath;
+        }
+    }
+    return {Result(), std::move(listener)};
+}
+
+#endif
+
+} // namespace WebSocket
@@ -0,0 +1,71 @@
+#include "WebSocket/MemoryBudget.h"
+#include <algorithm>
+
+namespace WebSocket {
+
+bool MemoryBudget::TryReserve(size_t bytes) {
+    // Add first and undo on failure: one atomic operation when there is room
+    size_t used = m_used.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t limit = m_limit.load(std::memory_order_relaxed);
+    if (limit != 0 && used > limit) {
+        m_used.fetch_sub(bytes, std::memory_order_relaxed);
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    UpdatePeak(used);
+    return true;
+}
+
+void MemoryBudget::Reserve(size_t bytes) {
+    UpdatePeak(m_used.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void MemoryBudget::UpdatePeak(size_t used) {
+    size_t peak = m_peak.load(std::memory_order_relaxed);
+    while (used > peak && !m_peak.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+}
+
+MemoryBudgetStats MemoryBudget::Stats() const {
+    MemoryBudgetStats stats;
+    stats.Limit = m_limit.load(std::memory_order_relaxed);
+    stats.Used = m_used.load(std::memory_order_relaxed);
+    stats.Peak = std::max(m_peak.load(std::memory_order_relaxed), stats.Used);
+    stats.Rejected = m_rejected.load(std::memory_order_relaxed);
+    return stats;
+}
+
+MemoryReservation& MemoryReservation::operator=(MemoryReservation&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        m_budget = other.m_budget;
+        m_bytes = other.m_bytes;
+        other.m_bytes = 0;
+    }
+    return *this;
+}
+
+bool MemoryReservation::TryGrow(size_t bytes) {
+    if (m_budget && !m_budget->TryReserve(bytes)) {
+        return false;
+    }
+    m_bytes += bytes;
+    return true;
+}
+
+void MemoryReservation::Grow(size_t bytes) {
+    if (m_budget) {
+        m_budget->Reserve(bytes);
+    }
+    m_bytes += bytes;
+}
+
+void MemoryReservation::Shrink(size_t bytes) {
+    bytes = std::min(bytes, m_bytes);
+    if (m_budget && bytes > 0) {
+        m_budget->Release(bytes);
+    }
+    m_bytes -= bytes;
+}
+
+} // namespace WebSocket
@@ -0,0 +1,395 @@
+#include "WebSocket/MessageDispatcher.h"
+#include "WebSocket/CpuTopology.h"
+#include <algorithm>
+#include <chrono>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace WebSocket {
+
+namespace {
+
+// Empty polls a worker spins through before parking
+const int kWorkerSpinCount = 64;
+
+// Parked workers re-check their inbox this often even without a wake-up
+const auto kWorkerParkTimeout = std::chrono::milliseconds(100);
+
+// A worker waiting for reply room re-checks Stop() and Closed this often
+const int kReplyRoomWaitMs = 100;
+
+#ifdef _WIN32
+// WSAPoll cannot be woken by the workers, so poll often while replies are due
+const int kPendingReplyWaitMs = 1;
+#elif defined(POLLRDHUP)
+// Socket events that end a wait without reading: the peer's FIN (errors and
+// hang-ups are always reported)
+const short kClosedEvents = POLLRDHUP;
+#else
+const short kClosedEvents = 0;
+#endif
+
+} // namespace
+
+DispatchChannel::DispatchChannel(size_t capacity, size_t frameCapacity, MemoryBudget* budget)
+    : Budget(budget), m_replies(capacity), m_frames(frameCapacity) {
+#ifndef _WIN32
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+DispatchChannel::~DispatchChannel() {
+    // Replies pushed after the connection's last drain
+    DispatchedReply reply;
+    while (PopReply(reply)) {
+    }
+#ifndef _WIN32
+    if (m_wakeFd != -1) {
+        close(m_wakeFd);
+    }
+#endif
+}
+
+bool DispatchChannel::Valid() const {
+#ifndef _WIN32
+    return m_wakeFd != -1;
+#else
+    return true;
+#endif
+}
+
+bool DispatchChannel::PushReply(DispatchedReply&& reply) {
+    size_t bytes = reply.Data.size();
+    if (Budget) {
+        Budget->Reserve(bytes);
+    }
+    if (!m_replies.TryPush(std::move(reply))) {
+        if (Budget) {
+            Budget->Release(bytes);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool DispatchChannel::PopReply(DispatchedReply& reply) {
+    if (!m_replies.TryPop(reply)) {
+        return false;
+    }
+    if (Budget) {
+        Budget->Release(reply.Data.size());
+    }
+
+    // Pairs with the fence in WaitForReplyRoom: either the worker sees the
+    // freed slot before parking or we see it waiting and wake it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_replyWaiting.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(m_roomMutex);
+        m_roomCondition.notify_one();
+    }
+    return true;
+}
+
+void DispatchChannel::WaitForReplyRoom(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(m_roomMutex);
+    m_replyWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    m_roomCondition.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] {
+        return m_replies.SizeApprox() < m_replies.Capacity() || Closed.load(std::memory_order_acquire);
+    });
+    m_replyWaiting.store(false, std::memory_order_relaxed);
+}
+
+bool DispatchChannel::PushFrame(const BufferHandle& frame) {
+    BufferHandle copy = frame;
+    return m_frames.TryPush(std::move(copy));
+}
+
+void DispatchChannel::Notify() {
+#ifndef _WIN32
+    uint64_t one = 1;
+    ssize_t written = write(m_wakeFd, &one, sizeof(one));
+    (void)written;
+#endif
+}
+
+std::pair<Result, bool> DispatchChannel::Wait(const Socket& socket, int timeoutMs) {
+    return WaitFor(socket, timeoutMs, true);
+}
+
+std::pair<Result, bool> DispatchChannel::WaitWithoutReading(const Socket& socket, int timeoutMs) {
+    return WaitFor(socket, timeoutMs, false);
+}
+
+Result DispatchChannel::WaitForNotify(int timeoutMs) {
+    if (!m_replies.EmptyApprox() || !m_frames.Empty()) {
+        return Result();
+    }
+#ifdef _WIN32
+    if (timeoutMs < 0 || timeoutMs > kPendingReplyWaitMs) {
+        timeoutMs = kPendingReplyWaitMs;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    return Result();
+#else
+    struct pollfd waker = {m_wakeFd, POLLIN, 0};
+    int pollResult = poll(&waker, 1, timeoutMs);
+    if (pollResult < 0) {
+        return Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, GetLastSystemErrorCode());
+    }
+    if (waker.revents != 0) {
+        uint64_t count = 0;
+        ssize_t readBytes = read(m_wakeFd, &count, sizeof(count));
+        (void)readBytes;
+    }
+    return Result();
+#endif
+}
+
+std::pair<Result, bool> DispatchChannel::WaitFor(const Socket& socket, int timeoutMs, bool readable) {
+    if (!m_replies.EmptyApprox() || !m_frames.Empty()) {
+        return { Result(), false };
+    }
+#ifdef _WIN32
+    bool expectingOutput = Pending.load(std::memory_order_acquire) > 0 ||
+                           Subscriptions.load(std::memory_order_acquire) > 0;
+    if (expectingOutput && (timeoutMs < 0 || timeoutMs > kPendingReplyWaitMs)) {
+        timeoutMs = kPendingReplyWaitMs;
+    }
+    return readable ? socket.WaitReadable(timeoutMs) : socket.WaitClosed(timeoutMs);
+#else
+    struct pollfd fds[2];
+    fds[0].fd = static_cast<int>(socket.NativeHandle());
+    fds[0].events = readable ? POLLIN : kClosedEvents;
+    fds[0].revents = 0;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    int pollResult = poll(fds, 2, timeoutMs);
+    if (pollResult < 0) {
+        return { Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, GetLastSystemErrorCode()), false };
+    }
+    if (fds[1].revents != 0) {
+        // Reset the counter; the replies themselves are read from the queue
+        uint64_t count = 0;
+        ssize_t readBytes = read(m_wakeFd, &count, sizeof(count));
+        (void)readBytes;
+    }
+
+    // Errors and hang-ups count as readable; the following receive reports them
+    return { Result(), fds[0].revents != 0 };
+#endif
+}
+
+MessageDispatcher::MessageDispatcher(size_t workerCount, size_t queueCapacity, HandlerFn handler, ErrorFn onError,
+                                     ViewHandlerFn viewHandler)
+    : m_queueCapacity(QueueCapacityFor(queueCapacity)), m_handler(std::move(handler)), m_viewHandler(std::move(viewHandler)),
+      m_onError(std::move(onError)) {
+    if (workerCount == 0) {
+        workerCount = 1;
+    }
+    m_workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        m_workers.push_back(std::make_unique<Worker>(m_queueCapacity));
+    }
+}
+
+MessageDispatcher::~MessageDispatcher() {
+    Stop();
+}
+
+Result MessageDispatcher::Start() {
+    if (m_running) {
+        return Result();
+    }
+    m_running = true;
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        Worker& worker = *m_workers[i];
+        int cpu = m_cpuAffinity.empty() ? -1 : m_cpuAffinity[i % m_cpuAffinity.size()];
+        try {
+            worker.Thread = std::thread(&MessageDispatcher::WorkerLoop, this, std::ref(worker), cpu);
+        } catch (const std::exception&) {
+            Stop();
+            return Result(ERROR_CODE::THREAD_CREATION_FAILED, "Failed to start dispatcher worker");
+        }
+    }
+    return Result();
+}
+
+void MessageDispatcher::Stop() {
+    m_running = false;
+    for (auto& worker : m_workers) {
+        {
+            std::lock_guard<std::mutex> lock(worker->ParkMutex);
+            worker->ParkCondition.notify_one();
+        }
+        if (worker->Thread.joinable()) {
+            worker->Thread.join();
+        }
+    }
+
+    // Discard whatever was still queued; the channels release with the messages
+    for (auto& worker : m_workers) {
+        DispatchedMessage message;
+        while (worker->Inbox.TryPop(message)) {
+            m_queuedBytes.fetch_sub(message.Bytes, std::memory_order_relaxed);
+            if (message.Channel && message.Channel->Budget) {
+                message.Channel->Budget->Release(message.Bytes);
+            }
+            message.Channel.reset();
+        }
+    }
+}
+
+bool MessageDispatcher::TrySubmit(uint64_t connectionId, DispatchedMessage& message, bool retry) {
+    Worker& worker = *m_workers[connectionId % m_workers.size()];
+    size_t bytes = message.Bytes;
+    m_queuedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (!worker.Inbox.TryPush(std::move(message))) {
+        m_queuedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        if (!retry) {
+            m_submitRejected.fetch_add(1, std::memory_order_relaxed);
+        }
+        return false;
+    }
+    m_dispatched.fetch_add(1, std::memory_order_relaxed);
+
+    // Pairs with the fence in WorkerLoop: either the worker sees the message
+    // before parking or we see it parked and wake it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker.Sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(worker.ParkMutex);
+        worker.ParkCondition.notify_one();
+    }
+    return true;
+}
+
+void MessageDispatcher::NotifyWhenRoom(uint64_t connectionId, const std::shared_ptr<DispatchChannel>& channel) {
+    Worker& worker = *m_workers[connectionId % m_workers.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.RoomMutex);
+        if (std::find(worker.RoomWaiters.begin(), worker.RoomWaiters.end(), channel) == worker.RoomWaiters.end()) {
+            worker.RoomWaiters.push_back(channel);
+        }
+        worker.HasRoomWaiters.store(true, std::memory_order_relaxed);
+    }
+
+    // Pairs with the fence in WorkerLoop: either the worker sees the waiter
+    // after its pop or the caller's retry sees the freed slot
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void MessageDispatcher::WakeRoomWaiters(Worker& worker) {
+    std::vector<std::shared_ptr<DispatchChannel>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(worker.RoomMutex);
+        waiters.swap(worker.RoomWaiters);
+        worker.HasRoomWaiters.store(false, std::memory_order_relaxed);
+    }
+    for (const auto& channel : waiters) {
+        channel->Notify();
+    }
+}
+
+MessageDispatcherStats MessageDispatcher::Stats() const {
+    MessageDispatcherStats stats;
+    stats.Dispatched = m_dispatched.load(std::memory_order_relaxed);
+    stats.Completed = m_completed.load(std::memory_order_relaxed);
+    stats.RepliesDropped = m_repliesDropped.load(std::memory_order_relaxed);
+    stats.SubmitRejected = m_submitRejected.load(std::memory_order_relaxed);
+    stats.QueuedBytes = m_queuedBytes.load(std::memory_order_relaxed);
+    stats.AffinityFailures = m_affinityFailures.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MessageDispatcher::WorkerLoop(Worker& worker, int cpu) {
+    DispatchedMessage message;
+    int idleSpins = 0;
+
+    if (cpu >= 0 && !PinCurrentThread(cpu)) {
+        m_affinityFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    while (m_running) {
+        if (worker.Inbox.TryPop(message)) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (worker.HasRoomWaiters.load(std::memory_order_relaxed)) {
+                WakeRoomWaiters(worker);
+            }
+            Process(message);
+            idleSpins = 0;
+            continue;
+        }
+        if (++idleSpins < kWorkerSpinCount) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(worker.ParkMutex);
+        worker.Sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        worker.ParkCondition.wait_for(lock, kWorkerParkTimeout,
+            [this, &worker] { return !m_running || !worker.Inbox.Empty(); });
+        worker.Sleeping.store(false, std::memory_order_relaxed);
+        idleSpins = 0;
+    }
+}
+
+void MessageDispatcher::Process(DispatchedMessage& message) {
+    std::shared_ptr<DispatchChannel> channel = std::move(message.Channel);
+
+    // Replies go out with the opcode of the message they answer
+    const WebSocketMessageWithIP& received = message.Message;
+    DispatchedReply reply;
+    reply.Opcode = received.opcode == WEBSOCKET_OPCODE::BINARY ? WEBSOCKET_OPCODE::BINARY : WEBSOCKET_OPCODE::TEXT;
+    if (m_viewHandler || m_handler) {
+        try {
+            if (m_viewHandler) {
+                WebSocketMessageView view{received.opcode, message.Payload.Data(), message.Payload.Size(),
+                                          received.connection, received.clientIP};
+                reply.Data = m_viewHandler(view);
+            } else {
+                reply.Data = m_handler(received);
+            }
+        } catch (const std::exception& e) {
+            if (m_onError) m_onError("WebSocket message handler error: " + std::string(e.what()));
+        }
+    }
+    m_completed.fetch_add(1, std::memory_order_relaxed);
+    m_queuedBytes.fetch_sub(message.Bytes, std::memory_order_relaxed);
+
+    if (channel) {
+        // A full reply queue parks the worker until the connection thread
+        // drains a reply; the wait is bounded so Stop() and Closed are seen
+        const bool hasReply = !reply.Data.empty();
+        bool delivered = !hasReply;
+        while (!delivered && m_running && !channel->Closed.load(std::memory_order_acquire)) {
+            delivered = channel->PushReply(std::move(reply));
+            if (!delivered) {
+                channel->Notify();
+                channel->WaitForReplyRoom(kReplyRoomWaitMs);
+            }
+        }
+        if (!delivered) {
+            m_repliesDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        channel->PendingBytes.fetch_sub(message.Bytes, std::memory_order_relaxed);
+        if (channel->Budget) {
+            channel->Budget->Release(message.Bytes);
+        }
+        channel->Pending.fetch_sub(1);
+        if ((hasReply && delivered) || channel->Throttled.load()) {
+            channel->Notify();
+        }
+    }
+
+    message.Message = WebSocketMessageWithIP();
+    message.Payload.Reset();
+}
+
+} // namespace WebSocket
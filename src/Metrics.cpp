@@ -0,0 +1,286 @@
+#include "WebSocket/Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+namespace WebSocket {
+
+namespace {
+
+// Quantiles reported for each histogram in the Prometheus output
+const double kExportedQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+const char* TypeName(METRIC_TYPE type) {
+    switch (type) {
+        case METRIC_TYPE::COUNTER: return "counter";
+        case METRIC_TYPE::GAUGE: return "gauge";
+        case METRIC_TYPE::HISTOGRAM: return "summary";
+    }
+    return "untyped";
+}
+
+std::string FormatSeconds(double nanoseconds) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.9g", nanoseconds / 1e9);
+    return buffer;
+}
+
+// HELP text escapes backslashes and line breaks
+std::string EscapeHelp(const std::string& help) {
+    std::string escaped;
+    escaped.reserve(help.size());
+    for (char c : help) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void AppendSeries(std::string& out, const std::string& name, const std::string& labels, const std::string& value) {
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+} // namespace
+
+uint64_t Counter::Value() const {
+    uint64_t total = 0;
+    for (const Cell& cell : m_cells) {
+        total += cell.Value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+int64_t Gauge::Value() const {
+    int64_t total = 0;
+    for (const Cell& cell : m_cells) {
+        total += cell.Value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Histogram::BucketUpperBound(size_t bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    if (bucket >= kBuckets - 1) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    size_t exponent = bucket / kSubBuckets + kSubBucketBits - 1;
+    uint64_t sub = bucket % kSubBuckets;
+    uint64_t width = uint64_t(1) << (exponent - kSubBucketBits);
+    return ((kSubBuckets + sub) << (exponent - kSubBucketBits)) + width - 1;
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+    HistogramSnapshot snapshot;
+    snapshot.Buckets.assign(kBuckets, 0);
+    for (size_t s = 0; s < kHistogramShards; s++) {
+        const Shard& shard = m_shards[s];
+        for (size_t i = 0; i < kBuckets; i++) {
+            snapshot.Buckets[i] += shard.Buckets[i].load(std::memory_order_relaxed);
+        }
+        snapshot.Sum += shard.Sum.load(std::memory_order_relaxed);
+        snapshot.Max = std::max(snapshot.Max, shard.Max.load(std::memory_order_relaxed));
+    }
+    for (uint64_t count : snapshot.Buckets) {
+        snapshot.Count += count;
+    }
+    return snapshot;
+}
+
+uint64_t HistogramSnapshot::Percentile(double fraction) const {
+    if (Count == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(fraction * Count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < Buckets.size(); i++) {
+        seen += Buckets[i];
+        if (seen > target) {
+            return std::min(Histogram::BucketUpperBound(i), Max);
+        }
+    }
+    return Max;
+}
+
+const MetricSample* MetricsSnapshot::Find(const std::string& name, const std::string& labels) const {
+    for (const MetricSample& sample : Samples) {
+        if (sample.Name == name && sample.Labels == labels) {
+            return &sample;
+        }
+    }
+    return nullptr;
+}
+
+int64_t MetricsSnapshot::Value(const std::string& name, const std::string& labels) const {
+    const MetricSample* sample = Find(name, labels);
+    return sample ? sample->Value : 0;
+}
+
+bool MetricsRegistry::IsValidName(const std::string& name) {
+    if (name.empty()) {
+        return false;
+    }
+    for (size_t i = 0; i < name.size(); i++) {
+        char c = name[i];
+        bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':';
+        bool digit = c >= '0' && c <= '9';
+        if (!letter && !(digit && i > 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+MetricsRegistry::Entry* MetricsRegistry::FindOrAdd(const std::string& name, const std::string& help,
+                                                   const std::string& labels, METRIC_TYPE type, bool& added) {
+    added = false;
+    if (!IsValidName(name)) {
+        return nullptr;
+    }
+    auto inserted = m_families.emplace(name, Family());
+    Family& family = inserted.first->second;
+    if (inserted.second) {
+        family.Help = help;
+        family.Type = type;
+    } else if (family.Type != type) {
+        return nullptr;
+    }
+    for (auto& entry : family.Entries) {
+        if (entry->Labels == labels) {
+            return entry.get();
+        }
+    }
+    family.Entries.push_back(std::make_unique<Entry>());
+    family.Entries.back()->Labels = labels;
+    added = true;
+    return family.Entries.back().get();
+}
+
+Counter* MetricsRegistry::GetCounter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool added = false;
+    Entry* entry = FindOrAdd(name, help, labels, METRIC_TYPE::COUNTER, added);
+    if (!entry) {
+        return nullptr;
+    }
+    if (added) {
+        entry->CounterMetric = std::make_unique<Counter>();
+    }
+    return entry->CounterMetric.get();
+}
+
+Gauge* MetricsRegistry::GetGauge(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool added = false;
+    Entry* entry = FindOrAdd(name, help, labels, METRIC_TYPE::GAUGE, added);
+    if (!entry) {
+        return nullptr;
+    }
+    if (added) {
+        entry->GaugeMetric = std::make_unique<Gauge>();
+    }
+    // Null when these labels already belong to a callback gauge
+    return entry->GaugeMetric.get();
+}
+
+Histogram* MetricsRegistry::GetHistogram(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool added = false;
+    Entry* entry = FindOrAdd(name, help, labels, METRIC_TYPE::HISTOGRAM, added);
+    if (!entry) {
+        return nullptr;
+    }
+    if (added) {
+        entry->HistogramMetric = std::make_unique<Histogram>();
+    }
+    return entry->HistogramMetric.get();
+}
+
+bool MetricsRegistry::AddGaugeCallback(const std::string& name, const std::string& help, GaugeFn read,
+                                       const std::string& labels) {
+    if (!read) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool added = false;
+    Entry* entry = FindOrAdd(name, help, labels, METRIC_TYPE::GAUGE, added);
+    if (!entry || entry->GaugeMetric) {
+        return false;
+    }
+    entry->Read = std::move(read);
+    return true;
+}
+
+MetricsSnapshot MetricsRegistry::Snapshot() const {
+    MetricsSnapshot snapshot;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [name, family] : m_families) {
+        for (const auto& entry : family.Entries) {
+            MetricSample sample;
+            sample.Name = name;
+            sample.Labels = entry->Labels;
+            sample.Help = family.Help;
+            sample.Type = family.Type;
+            if (entry->CounterMetric) {
+                sample.Value = static_cast<int64_t>(entry->CounterMetric->Value());
+            } else if (entry->GaugeMetric) {
+                sample.Value = entry->GaugeMetric->Value();
+            } else if (entry->HistogramMetric) {
+                sample.Histogram = entry->HistogramMetric->Snapshot();
+            } else if (entry->Read) {
+                sample.Value = entry->Read();
+            }
+            snapshot.Samples.push_back(std::move(sample));
+        }
+    }
+    return snapshot;
+}
+
+std::string MetricsRegistry::PrometheusText() const {
+    MetricsSnapshot snapshot = Snapshot();
+    std::string out;
+    out.reserve(snapshot.Samples.size() * 128);
+
+    const std::string* family = nullptr;
+    for (const MetricSample& sample : snapshot.Samples) {
+        // Samples of one family are adjacent; HELP and TYPE go out once
+        if (!family || *family != sample.Name) {
+            family = &sample.Name;
+            out += "# HELP " + sample.Name + " " + EscapeHelp(sample.Help) + "\n";
+            out += "# TYPE " + sample.Name + " " + TypeName(sample.Type) + "\n";
+        }
+
+        if (sample.Type != METRIC_TYPE::HISTOGRAM) {
+            AppendSeries(out, sample.Name, sample.Labels, std::to_string(sample.Value));
+            continue;
+        }
+
+        const HistogramSnapshot& histogram = sample.Histogram;
+        std::string prefix = sample.Labels.empty() ? "" : sample.Labels + ",";
+        for (double quantile : kExportedQuantiles) {
+            char label[32];
+            snprintf(label, sizeof(label), "quantile=\"%g\"", quantile);
+            AppendSeries(out, sample.Name, prefix + label,
+                         FormatSeconds(static_cast<double>(histogram.Percentile(quantile))));
+        }
+        AppendSeries(out, sample.Name + "_sum", sample.Labels, FormatSeconds(static_cast<double>(histogram.Sum)));
+        AppendSeries(out, sample.Name + "_count", sample.Labels, std::to_string(histogram.Count));
+    }
+    return out;
+}
+
+} // namespace WebSocket
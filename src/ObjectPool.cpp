@@ -0,0 +1,86 @@
+#include "WebSocket/ObjectPool.h"
+
+namespace WebSocket {
+
+static size_t AlignBlockSize(size_t size) {
+    const size_t alignment = alignof(std::max_align_t);
+    if (size < sizeof(void*)) {
+        size = sizeof(void*);
+    }
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+SlabPool::SlabPool(size_t blockSize, size_t blocksPerSlab)
+    : m_blockSize(AlignBlockSize(blockSize))
+    , m_blocksPerSlab(blocksPerSlab > 0 ? blocksPerSlab : 1) {
+}
+
+void* SlabPool::Allocate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_freeList && !AddSlab()) {
+        return nullptr;
+    }
+
+    FreeBlock* block = m_freeList;
+    m_freeList = block->next;
+    m_freeCount--;
+    m_inUse++;
+    m_allocations++;
+    return block;
+}
+
+void SlabPool::Deallocate(void* block) {
+    if (!block) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = m_freeList;
+    m_freeList = freeBlock;
+    m_freeCount++;
+    m_inUse--;
+}
+
+Result SlabPool::Reserve(size_t blocks) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (m_freeCount < blocks) {
+        if (!AddSlab()) {
+            return Result(ERROR_CODE::MEMORY_ALLOCATION_FAILED, "Failed to allocate slab");
+        }
+    }
+    return Result();
+}
+
+SlabPoolStats SlabPool::Stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SlabPoolStats stats;
+    stats.BlockSize = m_blockSize;
+    stats.SlabCount = m_slabs.size();
+    stats.BlocksInUse = m_inUse;
+    stats.BlocksFree = m_freeCount;
+    stats.Allocations = m_allocations;
+    return stats;
+}
+
+bool SlabPool::AddSlab() {
+    std::unique_ptr<uint8_t[]> slab(new (std::nothrow) uint8_t[m_blockSize * m_blocksPerSlab]);
+    if (!slab) {
+        return false;
+    }
+
+    // Thread the new blocks onto the free list in address order
+    uint8_t* base = slab.get();
+    for (size_t i = m_blocksPerSlab; i > 0; i--) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(base + (i - 1) * m_blockSize);
+        block->next = m_freeList;
+        m_freeList = block;
+    }
+    m_freeCount += m_blocksPerSlab;
+
+    m_slabs.push_back(std::move(slab));
+    return true;
+}
+
+} // namespace WebSocket
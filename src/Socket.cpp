@@ -1,7 +1,9 @@
 #include "WebSocket/Socket.h"
 #include "WebSocket/AddrInfoGuard.h"
 #include "WebSocket/ErrorCodes.h"
+#include "WebSocket/Trace.h"
 #include <string>
+#include <cstddef>
 #include <cstring>
 #include <thread>
 #include <chrono>
@@ -13,6 +15,8 @@
 #pragma comment(lib, "ws2_32.lib")
 #else
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
@@ -21,10 +25,70 @@
 #include <errno.h>
 #include <sys/select.h>
 #include <sys/time.h>
+#include <poll.h>
+#include <ifaddrs.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifdef __linux__
+#include <linux/filter.h>
 #endif
 
 namespace WebSocket {
 
+#ifndef _WIN32
+	namespace {
+
+		const char kUnixPrefix[] = "unix:";
+		const size_t kUnixPrefixLength = sizeof(kUnixPrefix) - 1;
+
+		// "unix:<path>", "/path" or "@name"; false when the path is empty or too long
+		bool MakeUnixAddress(const std::string& address, struct sockaddr_un& addr, socklen_t& length) {
+			std::string path = address.compare(0, kUnixPrefixLength, kUnixPrefix) == 0 ? address.substr(kUnixPrefixLength) : address;
+			std::memset(&addr, 0, sizeof(addr));
+			addr.sun_family = AF_UNIX;
+			if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+				return false;
+			}
+			if (path[0] == '@') {
+#ifdef __linux__
+				// Abstract names start with a NUL byte and their length is the address length;
+				// an empty name would ask the kernel to pick one
+				if (path.size() < 2) {
+					return false;
+				}
+				std::memcpy(addr.sun_path + 1, path.data() + 1, path.size() - 1);
+				length = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + path.size());
+				return true;
+#else
+				return false;
+#endif
+			}
+			std::memcpy(addr.sun_path, path.data(), path.size());
+			length = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + path.size() + 1);
+			return true;
+		}
+
+		// A socket file nobody listens on any more, left behind by a process that died
+		bool IsStaleUnixPath(const struct sockaddr_un& addr, socklen_t length) {
+			struct stat info;
+			if (lstat(addr.sun_path, &info) != 0 || !S_ISSOCK(info.st_mode)) {
+				return false;
+			}
+			// Non-blocking, so a live listener with a full backlog answers EAGAIN instead of stalling us
+			int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (probe < 0) {
+				return false;
+			}
+			fcntl(probe, F_SETFL, O_NONBLOCK);
+			bool stale = connect(probe, (const struct sockaddr*)&addr, length) != 0 && errno == ECONNREFUSED;
+			close(probe);
+			return stale;
+		}
+
+	} // namespace
+#endif
+
 	// Static member definitions
 	std::atomic<int> Socket::s_socketCount{ 0 };
 	std::mutex Socket::s_initMutex;
@@ -33,7 +97,6 @@ namespace WebSocket {
 		: m_socket(INVALID_SOCKET_NATIVE)
 		, m_isBlocking(true)
 		, m_isListening(false) {
-		puts("Socket created");
 	}
 
 	Socket::Socket(SOCKET_TYPE_NATIVE nativeSocket)
@@ -72,11 +135,17 @@ namespace WebSocket {
 	Socket::Socket(Socket&& other) noexcept
 		: m_socket(other.m_socket)
 		, m_isBlocking(other.m_isBlocking)
-		, m_isListening(other.m_isListening) {
+		, m_isListening(other.m_isListening)
+		, m_isShared(other.m_isShared)
+		, m_isUnix(other.m_isUnix)
+		, m_unixPath(std::move(other.m_unixPath)) {
 		// Move constructor - no change to socket count since we're just transferring ownership
 		other.m_socket = INVALID_SOCKET_NATIVE;
 		other.m_isBlocking = true;
 		other.m_isListening = false;
+		other.m_isShared = false;
+		other.m_isUnix = false;
+		other.m_unixPath.clear();
 	}
 
 	Socket& Socket::operator=(Socket&& other) noexcept {
@@ -85,9 +154,15 @@ namespace WebSocket {
 			m_socket = other.m_socket;
 			m_isBlocking = other.m_isBlocking;
 			m_isListening = other.m_isListening;
+			m_isShared = other.m_isShared;
+			m_isUnix = other.m_isUnix;
+			m_unixPath = std::move(other.m_unixPath);
 			other.m_socket = INVALID_SOCKET_NATIVE;
 			other.m_isBlocking = true;
 			other.m_isListening = false;
+			other.m_isShared = false;
+			other.m_isUnix = false;
+			other.m_unixPath.clear();
 		}
 		return *this;
 	}
@@ -115,6 +190,11 @@ namespace WebSocket {
 		if (Valid()) {
 			return Result(ERROR_CODE::INVALID_PARAMETER, "Socket already created");
 		}
+#ifdef _WIN32
+		if (family == SOCKET_FAMILY::UNIX) {
+			return Result(ERROR_CODE::SOCKET_OPTION_NOT_SUPPORTED, "Unix domain sockets are not supported on Windows");
+		}
+#endif
 
 		// Automatic socket system initialization - thread-safe with reference counting
 		{
@@ -130,15 +210,22 @@ namespace WebSocket {
 			}
 		}
 
-		int af = (family == SOCKET_FAMILY::IPV4) ? AF_INET : AF_INET6;
+		int af = AF_INET;
 		int sockType = (type == SOCKET_TYPE::TCP) ? SOCK_STREAM : SOCK_DGRAM;
 		int protocol = (type == SOCKET_TYPE::TCP) ? IPPROTO_TCP : IPPROTO_UDP;
+		if (family == SOCKET_FAMILY::IPV6) {
+			af = AF_INET6;
+		} else if (family == SOCKET_FAMILY::UNIX) {
+			af = AF_UNIX;
+			protocol = 0;
+		}
 
 		m_socket = socket(af, sockType, protocol);
 		if (m_socket == INVALID_SOCKET_NATIVE) {
 			return Result(ERROR_CODE::SOCKET_CREATE_FAILED, GetLastSystemErrorCode());
 		}
 
+		m_isUnix = family == SOCKET_FAMILY::UNIX;
 		return Result();
 	}
 
@@ -147,6 +234,10 @@ namespace WebSocket {
 			return Result(ERROR_CODE::INVALID_PARAMETER, "Socket not created");
 		}
 
+		if (m_isUnix) {
+			return BindUnix(address);
+		}
+
 		// Determine if this is IPv6 or IPv4
 		bool isIPv6 = IsIPv6Address(address);
 		
@@ -210,6 +301,40 @@ namespace WebSocket {
 		return Result();
 	}
 
+	Result Socket::BindUnix(const std::string& address) {
+#ifdef _WIN32
+		(void)address;
+		return Result(ERROR_CODE::SOCKET_OPTION_NOT_SUPPORTED, "Unix domain sockets are not supported on Windows");
+#else
+		struct sockaddr_un addr;
+		socklen_t length = 0;
+		if (!MakeUnixAddress(address, addr, length)) {
+			return Result(ERROR_CODE::INVALID_PARAMETER, "Invalid Unix socket path: " + address);
+		}
+
+		bool filesystem = addr.sun_path[0] != '\0';
+		int result = bind(m_socket, (struct sockaddr*)&addr, length);
+		if (result != 0 && errno == EADDRINUSE && filesystem && IsStaleUnixPath(addr, length)) {
+			unlink(addr.sun_path);
+			result = bind(m_socket, (struct sockaddr*)&addr, length);
+		}
+		if (result != 0) {
+			UpdateLastError();
+			int systemErrorCode = GetLastSystemErrorCode();
+			if (systemErrorCode == EADDRINUSE) {
+				return Result(ERROR_CODE::SOCKET_BIND_FAILED,
+					"Unix socket " + address + " is already in use. " + GetSystemErrorMessage(systemErrorCode));
+			}
+			return Result(ERROR_CODE::SOCKET_BIND_FAILED, systemErrorCode);
+		}
+
+		if (filesystem) {
+			m_unixPath = addr.sun_path;
+		}
+		return Result();
+#endif
+	}
+
 	Result Socket::Listen(int backlog) {
 		if (!Valid()) {
 			return Result(ERROR_CODE::INVALID_PARAMETER, "Socket not created");
@@ -229,12 +354,7 @@ namespace WebSocket {
 			return { Result(ERROR_CODE::INVALID_PARAMETER, "Socket not created"), nullptr };
 		}
 
-		// Use a large enough buffer for both IPv4 and IPv6 addresses
-		struct sockaddr_storage clientAddr;
-		socklen_t clientAddrLen = sizeof(clientAddr);
-		std::memset(&clientAddr, 0, sizeof(clientAddr));
-
-		SOCKET_TYPE_NATIVE clientSocket = accept(m_socket, (struct sockaddr*)&clientAddr, &clientAddrLen);
+		SOCKET_TYPE_NATIVE clientSocket = AcceptNative(false);
 		if (clientSocket == INVALID_SOCKET_NATIVE) {
 			UpdateLastError();
 			const auto ret = Result(ERROR_CODE::SOCKET_ACCEPT_FAILED, GetLastSystemErrorCode());
@@ -242,31 +362,200 @@ namespace WebSocket {
 		}
 
 		auto newSocket = CreateFromNative(clientSocket);
+		if (newSocket) {
+			newSocket->m_isUnix = m_isUnix;
+		}
 		return { Result(), std::move(newSocket) };
 	}
 
+	AcceptBatchResult Socket::AcceptBatch(size_t maxConnections, bool nonBlocking) {
+		std::vector<std::unique_ptr<Socket>> accepted;
+		Result result = AcceptBatch(accepted, maxConnections, nonBlocking);
+		return { result, std::move(accepted) };
+	}
+
+	Result Socket::AcceptBatch(std::vector<std::unique_ptr<Socket>>& accepted, size_t maxConnections, bool nonBlocking) {
+		accepted.clear();
+		if (!Valid()) {
+			return Result(ERROR_CODE::INVALID_PARAMETER, "Socket not created");
+		}
+
+		while (accepted.size() < maxConnections) {
+			// A blocking listener would park in accept() once the backlog is empty,
+			// so only keep draining while a connection is known to be pending
+			if (m_isBlocking && !accepted.empty()) {
+				auto [waitResult, readable] = WaitReadable(0);
+				if (waitResult.IsError() || !readable) {
+					break;
+				}
+			}
+
+			SOCKET_TYPE_NATIVE clientSocket = AcceptNative(nonBlocking);
+			if (clientSocket == INVALID_SOCKET_NATIVE) {
+				int errorCode = GetLastSystemErrorCode();
+#ifdef _WIN32
+				if (errorCode == WSAEWOULDBLOCK) {
+					break; // Backlog drained
+				}
+				if (errorCode == WSAECONNRESET) {
+					continue; // Peer gave up before we accepted
+				}
+#else
+				if (errorCode == EAGAIN || errorCode == EWOULDBLOCK) {
+					break; // Backlog drained
+				}
+				if (errorCode == ECONNABORTED || errorCode == EINTR) {
+					continue; // Peer gave up before we accepted / interrupted
+				}
+#endif
+				// Report hard errors (EMFILE, ENOBUFS...) only if nothing was accepted
+				if (accepted.empty()) {
+					UpdateLastError();
+					return Result(ERROR_CODE::SOCKET_ACCEPT_FAILED, errorCode);
+				}
+				break;
+			}
+
+			// The listener keeps the socket system initialized, so the reference
+			// count can be bumped without taking s_initMutex
+			s_socketCount.fetch_add(1);
+			auto newSocket = std::unique_ptr<Socket>(new Socket(clientSocket));
+			newSocket->m_isBlocking = !nonBlocking;
+			newSocket->m_isUnix = m_isUnix;
+			accepted.push_back(std::move(newSocket));
+		}
+
+		return Result();
+	}
+
+	Socket::SOCKET_TYPE_NATIVE Socket::AcceptNative(bool nonBlocking) {
+		// Use a large enough buffer for both IPv4 and IPv6 addresses
+		struct sockaddr_storage clientAddr;
+		socklen_t clientAddrLen = sizeof(clientAddr);
+
+#if defined(__linux__)
+		// accept4 sets the flags atomically, saving the fcntl round trips per connection
+		int flags = SOCK_CLOEXEC | (nonBlocking ? SOCK_NONBLOCK : 0);
+		return accept4(m_socket, (struct sockaddr*)&clientAddr, &clientAddrLen, flags);
+#else
+		SOCKET_TYPE_NATIVE clientSocket = accept(m_socket, (struct sockaddr*)&clientAddr, &clientAddrLen);
+		if (clientSocket == INVALID_SOCKET_NATIVE) {
+			return clientSocket;
+		}
+		// Plain accept() inherits a non-blocking listener's mode, so set it either way
+#ifdef _WIN32
+		u_long mode = nonBlocking ? 1 : 0;
+		ioctlsocket(clientSocket, FIONBIO, &mode);
+#else
+		fcntl(clientSocket, F_SETFD, FD_CLOEXEC);
+		int socketFlags = fcntl(clientSocket, F_GETFL, 0);
+		int wantedFlags = nonBlocking ? (socketFlags | O_NONBLOCK) : (socketFlags & ~O_NONBLOCK);
+		if (socketFlags != -1 && wantedFlags != socketFlags) {
+			fcntl(clientSocket, F_SETFL, wantedFlags);
+		}
+#endif
+		return clientSocket;
+#endif
+	}
+
 	Result Socket::Connect(const std::string& address, uint16_t port) {
 		if (!Valid()) {
 			return Result(ERROR_CODE::INVALID_PARAMETER, "Socket not created");
 		}
 
+		if (m_isUnix) {
+			return ConnectUnix(address);
+		}
+
+		if (IsIPv6Address(address)) {
+			struct sockaddr_in6 addr6;
+			std::memset(&addr6, 0, sizeof(addr6));
+			addr6.sin6_family = AF_INET6;
+			addr6.sin6_port = htons(port);
+
+			if (inet_pton(AF_INET6, address.c_str(), &addr6.sin6_addr) != 1) {
+				return Result(ERROR_CODE::INVALID_PARAMETER, "Invalid IPv6 address: " + address);
+			}
+
+			return Connect((const struct sockaddr*)&addr6, sizeof(addr6));
+		}
+
 		struct sockaddr_in addr;
 		std::memset(&addr, 0, sizeof(addr));
 		addr.sin_family = AF_INET;
 		addr.sin_port = htons(port);
 
 		if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
-			return Result(ERROR_CODE::INVALID_PARAMETER, "Invalid IPv4 address: " + address);
+			return Result(ERROR_CODE::INVALID_PARAMETER, "Invalid IP address (use Connector for host names): " + address);
 		}
 
-		if (connect(m_socket, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
-			UpdateLastError();
-			return Result(ERROR_CODE::SOCKET_CONNECT_FAILED, GetLastSystemErrorCode());
+		return Connect((const struct sockaddr*)&addr, sizeof(addr));
+	}
+
+	Result Socket::ConnectUnix(const std::string& address) {
+#ifdef _WIN32
+		(void)address;
+		return Result(ERROR_CODE::SOCKET_OPTION_NOT_SUPPORTED, "Unix domain sockets are not supported on Windows");
+#else
+		struct sockaddr_un addr;
+		socklen_t length = 0;
+		if (!MakeUnixAddress(address, addr, length)) {
+			return Result(ERROR_CODE::INVALID_PARAMETER, "Invalid Unix socket path: " + address);
+		}
+		return Connect((const struct sockaddr*)&addr, length);
+#endif
+	}
+
+	Result Socket::Connect(const struct sockaddr* address, size_t length) {
+		if (!Valid()) {
+			return Result(ERROR_CODE::INVALID_PARAMETER, "Socket not created");
+		}
+
+		if (connect(m_socket, address, (socklen_t)length) != 0) {
+			Result result(ERROR_CODE::SOCKET_CONNECT_FAILED, GetLastSystemErrorCode());
+			if (!ConnectPending(result)) {
+				UpdateLastError();
+			}
+			return result;
 		}
 
 		return Result();
 	}
 
+	bool Socket::ConnectPending(const Result& connectResult) {
+		if (connectResult.GetErrorCode() != ERROR_CODE::SOCKET_CONNECT_FAILED) {
+			return false;
+		}
+#ifdef _WIN32
+		return connectResult.GetSystemErrorCode() == WSAEWOULDBLOCK;
+#else
+		return connectResult.GetSystemErrorCode() == EINPROGRESS;
+#endif
+	}
+
+	bool Socket::WouldBlock(const Result& result) {
+		if (result.IsSuccess()) {
+			return false;
+		}
+		int systemError = result.GetSystemErrorCode();
+#ifdef _WIN32
+		return systemError == WSAEWOULDBLOCK;
+#else
+		return systemError == EAGAIN || systemError == EWOULDBLOCK;
+#endif
+	}
+
+	Result Socket::ConnectComplete() const {
+		auto [result, error] = GetIntOption(SOL_SOCKET, SO_ERROR);
+		if (result.IsError()) {
+			return Result(ERROR_CODE::SOCKET_CONNECT_FAILED, result.GetSystemErrorCode());
+		}
+		if (error != 0) {
+			return Result(ERROR_CODE::SOCKET_CONNECT_FAILED, error);
+		}
+		return Result();
+	}
+
 	Result Socket::Shutdown() {
 		if (!Valid()) {
 			return Result();
@@ -278,7 +567,7 @@ namespace WebSocket {
 		int result = ::shutdown(m_socket, SHUT_RDWR);
 #endif
 
-		if (result == SOCKET_ERROR) {
+		if (result != 0) {
 			UpdateLastError();
 			return Result(ERROR_CODE::UNKNOWN_ERROR, GetLastSystemErrorCode());
 		}
@@ -291,8 +580,10 @@ namespace WebSocket {
 			return Result();
 		}
 
-		// Graceful shutdown first
-		Shutdown();
+		// Graceful shutdown first, unless another process still accepts on this socket
+		if (!m_isShared) {
+			Shutdown();
+		}
 
 #ifdef _WIN32
 		int result = closesocket(m_socket);
@@ -300,13 +591,23 @@ namespace WebSocket {
 		int result = close(m_socket);
 #endif
 
+#ifndef _WIN32
+		// The socket file outlives the socket; a successor that was handed the listener still serves it
+		if (!m_unixPath.empty() && !m_isShared) {
+			unlink(m_unixPath.c_str());
+		}
+#endif
+
 		m_socket = INVALID_SOCKET_NATIVE;
+		m_isShared = false;
+		m_isUnix = false;
+		m_unixPath.clear();
 
-		// Automatic socket system cleanup - thread-safe with reference counting
-		{
+		// Automatic socket system cleanup - thread-safe with reference counting.
+		// Only the last socket needs s_initMutex, so connection churn stays lock-free
+		if (s_socketCount.fetch_sub(1) == 1) {
 			std::lock_guard<std::mutex> lock(s_initMutex);
-			int previousCount = s_socketCount.fetch_sub(1);
-			if (previousCount == 1) {
+			if (s_socketCount.load() == 0) {
 				// Last socket - cleanup the socket system
 				CleanupSocketSystem();
 			}
@@ -346,15 +647,13 @@ namespace WebSocket {
 
 			// Handle partial sends (result == 0 means connection closed)
 			if (result == 0) {
-				printf("DEBUG: Send returned 0 - connection closed\n");
+				WS_TRACE_VERBOSE("socket", "send_closed", "send returned 0 after {} bytes", totalSent);
 				break; // Connection closed
 			}
 
 			totalSent += result;
-			// printf("DEBUG: Send progress: %zu bytes this call, %zu total\n", (size_t)result, totalSent);
 		}
 
-		// printf("DEBUG: Send completed successfully - %zu bytes sent\n", totalSent);
 		return { Result(), totalSent };
 	}
 
@@ -394,16 +693,14 @@ namespace WebSocket {
 	}
 
 	ReceiveResult Socket::Receive(size_t maxLength) {
-		std::vector<uint8_t> buffer;
-		buffer.reserve(maxLength);
-		buffer.resize(maxLength);
-		auto [result, received] = ReceiveRaw(buffer.data(), maxLength);
+		// Receive into pooled scratch space, then copy out only the bytes that arrived
+		auto [result, buffer] = ReceivePooled(maxLength);
 
 		if (result.IsError()) {
 			return { result, {} };
 		}
 
-		return { result, received };
+		return { result, buffer.ToVector() };
 	}
 
 	ReceiveResult Socket::Receive(size_t maxLength, int timeoutMs) {
@@ -411,44 +708,126 @@ namespace WebSocket {
 			return {Result(ERROR_CODE::INVALID_PARAMETER, "Socket is not valid"), {}};
 		}
 
-		// Use select() to implement timeout
-		fd_set readfds;
-		FD_ZERO(&readfds);
-		FD_SET(m_socket, &readfds);
+		auto [result, buffer] = ReceivePooled(maxLength, timeoutMs);
 
-		struct timeval timeout;
-		timeout.tv_sec = timeoutMs / 1000;
-		timeout.tv_usec = (timeoutMs % 1000) * 1000;
+		if (result.IsError()) {
+			return { result, {} };
+		}
+
+		return { result, buffer.ToVector() };
+	}
+
+	Result Socket::Send(const BufferHandle& data) {
+		auto [result, bytesSent] = SendRaw(data.Data(), data.Size());
+		return result;
+	}
+
+	BufferReceiveResult Socket::ReceivePooled(size_t maxLength) {
+		BufferHandle buffer = BufferPool::Acquire(maxLength);
+		if (!buffer.Valid()) {
+			return { Result(ERROR_CODE::MEMORY_ALLOCATION_FAILED), BufferHandle() };
+		}
+
+		auto [result, received] = ReceiveInto(buffer.Data(), maxLength);
+		if (result.IsError() || received == 0) {
+			return { result, BufferHandle() };
+		}
+
+		buffer.Resize(received);
+		return { result, std::move(buffer) };
+	}
+
+	BufferReceiveResult Socket::ReceivePooled(size_t maxLength, int timeoutMs) {
+		auto [waitResult, readable] = WaitReadable(timeoutMs);
+		if (waitResult.IsError()) {
+			return { Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, waitResult.GetSystemErrorCode()), BufferHandle() };
+		}
+
+		if (!readable) {
+			// Timeout, no data available
+			return { Result(), BufferHandle() };
+		}
+
+		return ReceivePooled(maxLength);
+	}
+
+	ReceiveIntoResult Socket::ReceiveInto(void* buffer, size_t bufferSize) {
+		if (!Valid()) {
+			return { Result(ERROR_CODE::INVALID_PARAMETER, "Socket not created"), 0 };
+		}
+
+		if (!buffer || bufferSize == 0) {
+			return { Result(ERROR_CODE::INVALID_PARAMETER, "Invalid buffer parameters"), 0 };
+		}
 
-		int selectResult = select(
 #ifdef _WIN32
-			m_socket + 1,
+		int result = recv(m_socket, (char*)buffer, (int)bufferSize, 0);
 #else
-			m_socket + 1,
+		ssize_t result = recv(m_socket, buffer, bufferSize, 0);
 #endif
-			&readfds, nullptr, nullptr, &timeout);
 
-		if (selectResult < 0) {
+		if (result < 0) {
 			UpdateLastError();
-			return {Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, GetLastSystemErrorCode()), {}};
+			return { Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, GetLastSystemErrorCode()), 0 };
 		}
 
-		if (selectResult == 0) {
+		// 0 bytes means the peer closed the connection gracefully
+		return { Result(), static_cast<size_t>(result) };
+	}
+
+	ReceiveIntoResult Socket::ReceiveInto(void* buffer, size_t bufferSize, int timeoutMs) {
+		auto [waitResult, readable] = WaitReadable(timeoutMs);
+		if (waitResult.IsError()) {
+			return { waitResult, 0 };
+		}
+
+		if (!readable) {
 			// Timeout, no data available
-			return {Result(), {}};
+			return { Result(), 0 };
 		}
 
-		// Socket is ready for reading, proceed with normal receive
-		std::vector<uint8_t> buffer;
-		buffer.reserve(maxLength);
-		buffer.resize(maxLength);
-		auto [result, received] = ReceiveRaw(buffer.data(), maxLength);
+		return ReceiveInto(buffer, bufferSize);
+	}
 
-		if (result.IsError()) {
-			return { result, {} };
+	std::pair<Result, bool> Socket::WaitReadable(int timeoutMs) const {
+		return WaitForEvents(POLLIN, timeoutMs);
+	}
+
+	std::pair<Result, bool> Socket::WaitWritable(int timeoutMs) const {
+		return WaitForEvents(POLLOUT, timeoutMs);
+	}
+
+	std::pair<Result, bool> Socket::WaitClosed(int timeoutMs) const {
+		// Errors and hang-ups are reported whatever the requested events
+#ifdef POLLRDHUP
+		return WaitForEvents(POLLRDHUP, timeoutMs);
+#else
+		return WaitForEvents(0, timeoutMs);
+#endif
+	}
+
+	std::pair<Result, bool> Socket::WaitForEvents(short events, int timeoutMs) const {
+		if (!Valid()) {
+			return { Result(ERROR_CODE::INVALID_PARAMETER, "Socket not created"), false };
 		}
 
-		return { result, received };
+		// poll() rather than select(): no FD_SETSIZE ceiling on descriptor numbers
+		struct pollfd pfd;
+		pfd.fd = m_socket;
+		pfd.events = events;
+		pfd.revents = 0;
+
+#ifdef _WIN32
+		int pollResult = WSAPoll(&pfd, 1, timeoutMs);
+#else
+		int pollResult = poll(&pfd, 1, timeoutMs);
+#endif
+		if (pollResult < 0) {
+			return { Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, GetLastSystemErrorCode()), false };
+		}
+
+		// Errors and hang-ups count as ready; the following call reports them
+		return { Result(), pollResult > 0 };
 	}
 
 	Result Socket::Blocking(bool blocking) {
@@ -501,10 +880,359 @@ namespace WebSocket {
 		return SetSocketOption(SOL_SOCKET, SO_RCVBUF, &value, sizeof(value));
 	}
 
+	// Shared error for options the platform headers do not define
+	[[maybe_unused]] static Result OptionNotSupported(const char* optionName) {
+		return Result(ERROR_CODE::SOCKET_OPTION_NOT_SUPPORTED, std::string(optionName) + " is not supported on this platform");
+	}
+
+	Result Socket::NoDelay(bool noDelay) {
+		return SetIntOption(IPPROTO_TCP, TCP_NODELAY, noDelay ? 1 : 0);
+	}
+
+	Result Socket::QuickAck(bool quickAck) {
+#ifdef TCP_QUICKACK
+		return SetIntOption(IPPROTO_TCP, TCP_QUICKACK, quickAck ? 1 : 0);
+#else
+		(void)quickAck;
+		return OptionNotSupported("TCP_QUICKACK");
+#endif
+	}
+
+	Result Socket::KeepAliveIdle(int seconds) {
+#if defined(TCP_KEEPIDLE)
+		return SetIntOption(IPPROTO_TCP, TCP_KEEPIDLE, seconds);
+#elif defined(TCP_KEEPALIVE)
+		return SetIntOption(IPPROTO_TCP, TCP_KEEPALIVE, seconds); // macOS spelling
+#else
+		(void)seconds;
+		return OptionNotSupported("TCP_KEEPIDLE");
+#endif
+	}
+
+	Result Socket::KeepAliveInterval(int seconds) {
+#ifdef TCP_KEEPINTVL
+		return SetIntOption(IPPROTO_TCP, TCP_KEEPINTVL, seconds);
+#else
+		(void)seconds;
+		return OptionNotSupported("TCP_KEEPINTVL");
+#endif
+	}
+
+	Result Socket::KeepAliveCount(int count) {
+#ifdef TCP_KEEPCNT
+		return SetIntOption(IPPROTO_TCP, TCP_KEEPCNT, count);
+#else
+		(void)count;
+		return OptionNotSupported("TCP_KEEPCNT");
+#endif
+	}
+
+	Result Socket::UserTimeout(int milliseconds) {
+#ifdef TCP_USER_TIMEOUT
+		return SetIntOption(IPPROTO_TCP, TCP_USER_TIMEOUT, milliseconds);
+#else
+		(void)milliseconds;
+		return OptionNotSupported("TCP_USER_TIMEOUT");
+#endif
+	}
+
+	Result Socket::NotSentLowat(int bytes) {
+#ifdef TCP_NOTSENT_LOWAT
+		return SetIntOption(IPPROTO_TCP, TCP_NOTSENT_LOWAT, bytes);
+#else
+		(void)bytes;
+		return OptionNotSupported("TCP_NOTSENT_LOWAT");
+#endif
+	}
+
+	Result Socket::BusyPoll(int microseconds) {
+#ifdef SO_BUSY_POLL
+		return SetIntOption(SOL_SOCKET, SO_BUSY_POLL, microseconds);
+#else
+		(void)microseconds;
+		return OptionNotSupported("SO_BUSY_POLL");
+#endif
+	}
+
+	Result Socket::FastOpen(int queueLength) {
+#ifdef TCP_FASTOPEN
+		return SetIntOption(IPPROTO_TCP, TCP_FASTOPEN, queueLength);
+#else
+		(void)queueLength;
+		return OptionNotSupported("TCP_FASTOPEN");
+#endif
+	}
+
+	Result Socket::FastOpenConnect(bool enable) {
+#ifdef TCP_FASTOPEN_CONNECT
+		return SetIntOption(IPPROTO_TCP, TCP_FASTOPEN_CONNECT, enable ? 1 : 0);
+#else
+		(void)enable;
+		return OptionNotSupported("TCP_FASTOPEN_CONNECT");
+#endif
+	}
+
+	Result Socket::DeferAccept(int seconds) {
+#ifdef TCP_DEFER_ACCEPT
+		return SetIntOption(IPPROTO_TCP, TCP_DEFER_ACCEPT, seconds);
+#else
+		(void)seconds;
+		return OptionNotSupported("TCP_DEFER_ACCEPT");
+#endif
+	}
+
+	Result Socket::IncomingCpu(int cpu) {
+#ifdef SO_INCOMING_CPU
+		return SetIntOption(SOL_SOCKET, SO_INCOMING_CPU, cpu);
+#else
+		(void)cpu;
+		return OptionNotSupported("SO_INCOMING_CPU");
+#endif
+	}
+
+	Result Socket::ReusePort(bool reuse) {
+#ifdef SO_REUSEPORT
+		return SetIntOption(SOL_SOCKET, SO_REUSEPORT, reuse ? 1 : 0);
+#else
+		(void)reuse;
+		return OptionNotSupported("SO_REUSEPORT");
+#endif
+	}
+
+	Result Socket::ReusePortCpuGroup(int groupSize) {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+		if (groupSize <= 0) {
+			return Result(ERROR_CODE::INVALID_PARAMETER, "Group size must be positive");
+		}
+		// A = CPU that received the packet; return A % groupSize as the listener index
+		struct sock_filter code[] = {
+			{ BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+			{ BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(groupSize) },
+			{ BPF_RET | BPF_A, 0, 0, 0 },
+		};
+		struct sock_fprog program = { static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code };
+		return SetSocketOption(SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program));
+#else
+		(void)groupSize;
+		return OptionNotSupported("SO_ATTACH_REUSEPORT_CBPF");
+#endif
+	}
+
+	Result Socket::ApplyProfile(const SocketProfile& profile) {
+		// Apply every requested option and report the first failure
+		Result firstError;
+		auto apply = [&firstError](const Result& result) {
+			if (result.IsError() && firstError.IsSuccess()) {
+				firstError = result;
+			}
+		};
+
+		// A Unix domain socket has no TCP or NIC layer, so one profile serves both kinds of listener
+		if (!m_isUnix) {
+			if (profile.NoDelay) apply(NoDelay(true));
+			if (profile.QuickAck) apply(QuickAck(true));
+			if (profile.KeepAlive) apply(KeepAlive(true));
+			if (profile.KeepAliveIdleSeconds >= 0) apply(KeepAliveIdle(profile.KeepAliveIdleSeconds));
+			if (profile.KeepAliveIntervalSeconds >= 0) apply(KeepAliveInterval(profile.KeepAliveIntervalSeconds));
+			if (profile.KeepAliveCount >= 0) apply(KeepAliveCount(profile.KeepAliveCount));
+			if (profile.UserTimeoutMs >= 0) apply(UserTimeout(profile.UserTimeoutMs));
+			if (profile.NotSentLowatBytes >= 0) apply(NotSentLowat(profile.NotSentLowatBytes));
+			if (profile.BusyPollMicroseconds >= 0) apply(BusyPoll(profile.BusyPollMicroseconds));
+			if (profile.FastOpenConnect) apply(FastOpenConnect(true));
+		}
+		if (profile.SendBufferSize >= 0) apply(SendBufferSize((size_t)profile.SendBufferSize));
+		if (profile.ReceiveBufferSize >= 0) apply(ReceiveBufferSize((size_t)profile.ReceiveBufferSize));
+
+		return firstError;
+	}
+
+	Result Socket::ApplyListenerProfile(const SocketProfile& profile) {
+		Result firstError;
+		auto apply = [&firstError](const Result& result) {
+			if (result.IsError() && firstError.IsSuccess()) {
+				firstError = result;
+			}
+		};
+
+		if (!m_isUnix) {
+			if (profile.ReusePort) apply(ReusePort(true));
+			if (profile.FastOpenQueueLength >= 0) apply(FastOpen(profile.FastOpenQueueLength));
+			if (profile.DeferAcceptSeconds >= 0) apply(DeferAccept(profile.DeferAcceptSeconds));
+			if (profile.IncomingCpu >= 0) apply(IncomingCpu(profile.IncomingCpu));
+			if (profile.ReusePortCpuGroup > 0) apply(ReusePortCpuGroup(profile.ReusePortCpuGroup));
+		}
+		// Accepted sockets inherit buffer sizes and keep-alive from the listener on most stacks
+		if (profile.SendBufferSize >= 0) apply(SendBufferSize((size_t)profile.SendBufferSize));
+		if (profile.ReceiveBufferSize >= 0) apply(ReceiveBufferSize((size_t)profile.ReceiveBufferSize));
+
+		return firstError;
+	}
+
+	std::pair<Result, bool> Socket::KeepAlive() const {
+		auto [result, value] = GetIntOption(SOL_SOCKET, SO_KEEPALIVE);
+		return { result, value != 0 };
+	}
+
+	std::pair<Result, bool> Socket::NoDelay() const {
+		auto [result, value] = GetIntOption(IPPROTO_TCP, TCP_NODELAY);
+		return { result, value != 0 };
+	}
+
+	std::pair<Result, bool> Socket::QuickAck() const {
+#ifdef TCP_QUICKACK
+		auto [result, value] = GetIntOption(IPPROTO_TCP, TCP_QUICKACK);
+		return { result, value != 0 };
+#else
+		return { OptionNotSupported("TCP_QUICKACK"), false };
+#endif
+	}
+
+	std::pair<Result, int> Socket::KeepAliveIdle() const {
+#if defined(TCP_KEEPIDLE)
+		return GetIntOption(IPPROTO_TCP, TCP_KEEPIDLE);
+#elif defined(TCP_KEEPALIVE)
+		return GetIntOption(IPPROTO_TCP, TCP_KEEPALIVE);
+#else
+		return { OptionNotSupported("TCP_KEEPIDLE"), 0 };
+#endif
+	}
+
+	std::pair<Result, int> Socket::KeepAliveInterval() const {
+#ifdef TCP_KEEPINTVL
+		return GetIntOption(IPPROTO_TCP, TCP_KEEPINTVL);
+#else
+		return { OptionNotSupported("TCP_KEEPINTVL"), 0 };
+#endif
+	}
+
+	std::pair<Result, int> Socket::KeepAliveCount() const {
+#ifdef TCP_KEEPCNT
+		return GetIntOption(IPPROTO_TCP, TCP_KEEPCNT);
+#else
+		return { OptionNotSupported("TCP_KEEPCNT"), 0 };
+#endif
+	}
+
+	std::pair<Result, int> Socket::UserTimeout() const {
+#ifdef TCP_USER_TIMEOUT
+		return GetIntOption(IPPROTO_TCP, TCP_USER_TIMEOUT);
+#else
+		return { OptionNotSupported("TCP_USER_TIMEOUT"), 0 };
+#endif
+	}
+
+	std::pair<Result, int> Socket::NotSentLowat() const {
+#ifdef TCP_NOTSENT_LOWAT
+		return GetIntOption(IPPROTO_TCP, TCP_NOTSENT_LOWAT);
+#else
+		return { OptionNotSupported("TCP_NOTSENT_LOWAT"), 0 };
+#endif
+	}
+
+	std::pair<Result, int> Socket::BusyPoll() const {
+#ifdef SO_BUSY_POLL
+		return GetIntOption(SOL_SOCKET, SO_BUSY_POLL);
+#else
+		return { OptionNotSupported("SO_BUSY_POLL"), 0 };
+#endif
+	}
+
+	std::pair<Result, int> Socket::FastOpen() const {
+#ifdef TCP_FASTOPEN
+		return GetIntOption(IPPROTO_TCP, TCP_FASTOPEN);
+#else
+		return { OptionNotSupported("TCP_FASTOPEN"), 0 };
+#endif
+	}
+
+	std::pair<Result, bool> Socket::FastOpenConnect() const {
+#ifdef TCP_FASTOPEN_CONNECT
+		auto [result, value] = GetIntOption(IPPROTO_TCP, TCP_FASTOPEN_CONNECT);
+		return { result, value != 0 };
+#else
+		return { OptionNotSupported("TCP_FASTOPEN_CONNECT"), false };
+#endif
+	}
+
+	std::pair<Result, int> Socket::DeferAccept() const {
+#ifdef TCP_DEFER_ACCEPT
+		return GetIntOption(IPPROTO_TCP, TCP_DEFER_ACCEPT);
+#else
+		return { OptionNotSupported("TCP_DEFER_ACCEPT"), 0 };
+#endif
+	}
+
+	std::pair<Result, int> Socket::IncomingCpu() const {
+#ifdef SO_INCOMING_CPU
+		return GetIntOption(SOL_SOCKET, SO_INCOMING_CPU);
+#else
+		return { OptionNotSupported("SO_INCOMING_CPU"), 0 };
+#endif
+	}
+
+	std::pair<Result, bool> Socket::ReusePort() const {
+#ifdef SO_REUSEPORT
+		auto [result, value] = GetIntOption(SOL_SOCKET, SO_REUSEPORT);
+		return { result, value != 0 };
+#else
+		return { OptionNotSupported("SO_REUSEPORT"), false };
+#endif
+	}
+
+	std::pair<Result, int> Socket::SendBufferSize() const {
+		return GetIntOption(SOL_SOCKET, SO_SNDBUF);
+	}
+
+	std::pair<Result, int> Socket::ReceiveBufferSize() const {
+		return GetIntOption(SOL_SOCKET, SO_RCVBUF);
+	}
+
+	std::pair<Result, TcpInfo> Socket::GetTcpInfo() const {
+		TcpInfo info;
+#if defined(__linux__)
+		struct tcp_info kernel;
+		size_t length = sizeof(kernel);
+		Result result = GetSocketOption(IPPROTO_TCP, TCP_INFO, &kernel, &length);
+		if (result.IsError()) {
+			return { result, info };
+		}
+		info.RttUs = kernel.tcpi_rtt;
+		info.RttVarUs = kernel.tcpi_rttvar;
+		info.CongestionWindow = kernel.tcpi_snd_cwnd;
+		info.Unacked = kernel.tcpi_unacked;
+		info.Lost = kernel.tcpi_lost;
+		info.TotalRetransmits = kernel.tcpi_total_retrans;
+		int queued = 0;
+		if (ioctl(m_socket, TIOCOUTQ, &queued) == 0 && queued > 0) {
+			info.SendQueueBytes = static_cast<uint32_t>(queued);
+		}
+		return { Result(), info };
+#elif defined(__APPLE__) && defined(TCP_CONNECTION_INFO)
+		struct tcp_connection_info kernel;
+		size_t length = sizeof(kernel);
+		Result result = GetSocketOption(IPPROTO_TCP, TCP_CONNECTION_INFO, &kernel, &length);
+		if (result.IsError()) {
+			return { result, info };
+		}
+		info.RttUs = kernel.tcpi_srtt * 1000;
+		info.RttVarUs = kernel.tcpi_rttvar * 1000;
+		info.CongestionWindow = kernel.tcpi_maxseg > 0 ? kernel.tcpi_snd_cwnd / kernel.tcpi_maxseg : 0;
+		info.TotalRetransmits = static_cast<uint32_t>(kernel.tcpi_txretransmitpackets);
+		info.SendQueueBytes = kernel.tcpi_snd_sbbytes;
+		return { Result(), info };
+#else
+		return { OptionNotSupported("TCP_INFO"), info };
+#endif
+	}
+
 	bool Socket::Valid() const {
 		return m_socket != INVALID_SOCKET_NATIVE;
 	}
 
+	intptr_t Socket::NativeHandle() const {
+		return static_cast<intptr_t>(m_socket);
+	}
+
 	bool Socket::Blocking() const {
 		return m_isBlocking;
 	}
@@ -514,14 +1242,15 @@ namespace WebSocket {
 			return "";
 		}
 
-		struct sockaddr_in addr;
+		// Large enough for IPv4, IPv6 and Unix domain addresses
+		struct sockaddr_storage addr;
 		socklen_t addrLen = sizeof(addr);
 
 		if (getsockname(m_socket, (struct sockaddr*)&addr, &addrLen) != 0) {
 			return "";
 		}
 
-		return GetAddressString((struct sockaddr*)&addr);
+		return GetAddressString((struct sockaddr*)&addr, addrLen);
 	}
 
 	uint16_t Socket::LocalPort() const {
@@ -529,14 +1258,14 @@ namespace WebSocket {
 			return 0;
 		}
 
-		struct sockaddr_in addr;
+		struct sockaddr_storage addr;
 		socklen_t addrLen = sizeof(addr);
 
 		if (getsockname(m_socket, (struct sockaddr*)&addr, &addrLen) != 0) {
 			return 0;
 		}
 
-		return ntohs(addr.sin_port);
+		return GetAddressPort((struct sockaddr*)&addr);
 	}
 
 	std::string Socket::RemoteAddress() const {
@@ -544,14 +1273,14 @@ namespace WebSocket {
 			return "";
 		}
 
-		struct sockaddr_in addr;
+		struct sockaddr_storage addr;
 		socklen_t addrLen = sizeof(addr);
 
 		if (getpeername(m_socket, (struct sockaddr*)&addr, &addrLen) != 0) {
 			return "";
 		}
 
-		return GetAddressString((struct sockaddr*)&addr);
+		return GetAddressString((struct sockaddr*)&addr, addrLen);
 	}
 
 	uint16_t Socket::RemotePort() const {
@@ -559,31 +1288,68 @@ namespace WebSocket {
 			return 0;
 		}
 
-		struct sockaddr_in addr;
+		struct sockaddr_storage addr;
 		socklen_t addrLen = sizeof(addr);
 
 		if (getpeername(m_socket, (struct sockaddr*)&addr, &addrLen) != 0) {
 			return 0;
 		}
 
-		return ntohs(addr.sin_port);
+		return GetAddressPort((struct sockaddr*)&addr);
+	}
+
+	bool Socket::IsUnixDomain() const {
+		return m_isUnix;
 	}
 
-	std::string Socket::GetAddressString(const struct sockaddr* addr) {
+	std::string Socket::GetAddressString(const struct sockaddr* addr, size_t length) {
 		if (!addr) {
 			return "";
 		}
 
-		char buffer[INET_ADDRSTRLEN];
-		const struct sockaddr_in* addr4 = (const struct sockaddr_in*)addr;
-
-		if (inet_ntop(AF_INET, &addr4->sin_addr, buffer, sizeof(buffer)) != nullptr) {
-			return std::string(buffer);
+		char buffer[INET6_ADDRSTRLEN];
+		if (addr->sa_family == AF_INET) {
+			const struct sockaddr_in* addr4 = (const struct sockaddr_in*)addr;
+			if (inet_ntop(AF_INET, &addr4->sin_addr, buffer, sizeof(buffer)) != nullptr) {
+				return std::string(buffer);
+			}
+		} else if (addr->sa_family == AF_INET6) {
+			const struct sockaddr_in6* addr6 = (const struct sockaddr_in6*)addr;
+			if (inet_ntop(AF_INET6, &addr6->sin6_addr, buffer, sizeof(buffer)) != nullptr) {
+				return std::string(buffer);
+			}
+		}
+#ifndef _WIN32
+		else if (addr->sa_family == AF_UNIX) {
+			// An unbound client has no name; abstract names are reported as "@name"
+			const struct sockaddr_un* addrUnix = (const struct sockaddr_un*)addr;
+			size_t offset = offsetof(struct sockaddr_un, sun_path);
+			if (length <= offset) {
+				return "";
+			}
+			size_t pathLength = std::min(length - offset, sizeof(addrUnix->sun_path));
+			if (addrUnix->sun_path[0] == '\0') {
+				return "@" + std::string(addrUnix->sun_path + 1, pathLength - 1);
+			}
+			return std::string(addrUnix->sun_path, strnlen(addrUnix->sun_path, pathLength));
 		}
+#else
+		(void)length;
+#endif
 
 		return "";
 	}
 
+	uint16_t Socket::GetAddressPort(const struct sockaddr* addr) {
+		if (addr->sa_family == AF_INET) {
+			return ntohs(((const struct sockaddr_in*)addr)->sin_port);
+		}
+		if (addr->sa_family == AF_INET6) {
+			return ntohs(((const struct sockaddr_in6*)addr)->sin6_port);
+		}
+		return 0;
+	}
+
 	bool Socket::IsIPAddress(const std::string& address) {
 		return IsIPv4Address(address) || IsIPv6Address(address);
 	}
@@ -602,11 +1368,15 @@ namespace WebSocket {
 		return inet_pton(AF_INET6, address.c_str(), &addr.sin6_addr) == 1;
 	}
 
+	bool Socket::IsUnixAddress(const std::string& address) {
+		return address.compare(0, 5, "unix:") == 0 || (!address.empty() && (address[0] == '/' || address[0] == '@'));
+	}
+
 	bool Socket::IsPortAvailable(uint16_t port, const std::string& address) {
 		// Initialize socket system if needed (since this is a static method)
 		Result initResult = InitializeSocketSystem();
 		if (!initResult.IsSuccess()) {
-			printf("DEBUG: IsPortAvailable - Failed to initialize socket system: %s\n", initResult.GetErrorMessage().c_str());
+			WS_TRACE_WARN("socket", "port_probe_init_failed", "system error {}", initResult.GetSystemErrorCode());
 			return false;
 		}
 
@@ -621,7 +1391,7 @@ namespace WebSocket {
 			// IPv6 test
 			testSocket = socket(AF_INET6, SOCK_STREAM, 0);
 			if (testSocket == INVALID_SOCKET_NATIVE) {
-				printf("DEBUG: IsPortAvailable - Failed to create IPv6 test socket\n");
+				WS_TRACE_WARN("socket", "port_probe_socket_failed", "IPv6 test socket: system error {}", GetLastSystemErrorCode());
 				CleanupSocketSystem();
 				return false;
 			}
@@ -635,7 +1405,7 @@ namespace WebSocket {
 				addr6.sin6_addr = in6addr_any;
 			} else {
 				if (inet_pton(AF_INET6, address.c_str(), &addr6.sin6_addr) != 1) {
-					printf("DEBUG: IsPortAvailable - Invalid IPv6 address: %s\n", address.c_str());
+					WS_TRACE_VERBOSE("socket", "port_probe_bad_address", "invalid IPv6 address {s}", address);
 #ifdef _WIN32
 					closesocket(testSocket);
 #else
@@ -652,7 +1422,7 @@ namespace WebSocket {
 			// IPv4 test (default)
 			testSocket = socket(AF_INET, SOCK_STREAM, 0);
 			if (testSocket == INVALID_SOCKET_NATIVE) {
-				printf("DEBUG: IsPortAvailable - Failed to create IPv4 test socket\n");
+				WS_TRACE_WARN("socket", "port_probe_socket_failed", "IPv4 test socket: system error {}", GetLastSystemErrorCode());
 				CleanupSocketSystem();
 				return false;
 			}
@@ -667,7 +1437,7 @@ namespace WebSocket {
 			}
 			else {
 				if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
-					printf("DEBUG: IsPortAvailable - Invalid IPv4 address: %s\n", address.c_str());
+					WS_TRACE_VERBOSE("socket", "port_probe_bad_address", "invalid IPv4 address {s}", address);
 #ifdef _WIN32
 					closesocket(testSocket);
 #else
@@ -684,7 +1454,6 @@ namespace WebSocket {
 
 		// Try to bind to the port
 		int result = bind(testSocket, (struct sockaddr*)addrPtr, addrLen);
-		printf("DEBUG: IsPortAvailable - bind() result for port %d: %d\n", port, result);
 
 		// Close the test socket
 #ifdef _WIN32
@@ -698,7 +1467,7 @@ namespace WebSocket {
 
 		// If bind succeeded, port is available
 		bool available = (result == 0);
-		printf("DEBUG: IsPortAvailable - Port %d is %s\n", port, available ? "available" : "in use");
+		WS_TRACE_VERBOSE("socket", "port_probe", "port {} available {}", port, available);
 		return available;
 	}
 
@@ -831,7 +1600,7 @@ namespace WebSocket {
 		if (getsockopt(m_socket, level, option, (char*)value, &len) != 0) {
 			// Note: UpdateLastError is not const, so we handle error differently here
 			int systemErrorCode = GetLastSystemErrorCode();
-			printf("Socket getsockopt error: %s\n", GetSystemErrorMessage(systemErrorCode).c_str());
+			WS_TRACE_WARN("socket", "getsockopt_failed", "option {} system error {}", option, systemErrorCode);
 			return Result(ERROR_CODE::SOCKET_SET_OPTION_FAILED, systemErrorCode);
 		}
 
@@ -839,15 +1608,28 @@ namespace WebSocket {
 		return Result();
 	}
 
+	Result Socket::SetIntOption(int level, int option, int value) {
+		return SetSocketOption(level, option, &value, sizeof(value));
+	}
+
+	std::pair<Result, int> Socket::GetIntOption(int level, int option) const {
+		int value = 0;
+		size_t length = sizeof(value);
+		Result result = GetSocketOption(level, option, &value, &length);
+		return { result, value };
+	}
+
 	void Socket::UpdateLastError() {
 		int systemErrorCode = GetLastSystemErrorCode();
 		// Only log actual errors, not expected non-blocking behavior
-		if (systemErrorCode != 0) {
-			std::string systemError = GetSystemErrorMessage(systemErrorCode);
-			if (!systemError.empty() && systemError.find("would block") == std::string::npos
-				&& systemError.find("non-blocking") == std::string::npos) {
-				printf("Socket error: %s\n", systemError.c_str());
-			}
+#ifdef _WIN32
+		bool wouldBlock = systemErrorCode == WSAEWOULDBLOCK || systemErrorCode == WSAEINPROGRESS;
+#else
+		bool wouldBlock = systemErrorCode == EAGAIN || systemErrorCode == EWOULDBLOCK || systemErrorCode == EINPROGRESS;
+#endif
+		if (systemErrorCode != 0 && !wouldBlock) {
+			// Only the code is recorded; formatting strerror text here cost every failing call
+			WS_TRACE_WARN("socket", "error", "system error {}", systemErrorCode);
 		}
 	}
 
@@ -1163,29 +1945,18 @@ namespace WebSocket {
 	}
 
 	void Socket::HandleAcceptEvent() {
-		// Try to accept a connection
-		sockaddr_in clientAddr;
-#ifdef _WIN32
-		int clientAddrLen = sizeof(clientAddr);
-#else
-		socklen_t clientAddrLen = sizeof(clientAddr);
-#endif
-
-		SOCKET_TYPE_NATIVE clientSocket = accept(m_socket, (struct sockaddr*)&clientAddr, &clientAddrLen);
-
-		if (clientSocket != INVALID_SOCKET_NATIVE) {
-			// Successfully accepted a connection
-			auto newSocket = CreateFromNative(clientSocket);
-			if (newSocket) {
-				// Set the new socket to non-blocking for event loop
-				newSocket->Blocking(false);
+		// Drain the whole backlog per readiness event; accepted sockets are
+		// already non-blocking for the event loop
+		auto [acceptResult, sockets] = AcceptBatch();
+		if (acceptResult.IsError() && m_errorCallback) {
+			m_errorCallback(acceptResult);
+		}
 
-				if (m_acceptCallback) {
-					m_acceptCallback(std::move(newSocket));
-				}
+		if (m_acceptCallback) {
+			for (auto& newSocket : sockets) {
+				m_acceptCallback(std::move(newSocket));
 			}
 		}
-		// If accept fails, it's normal (no pending connections)
 	}
 
 	void Socket::HandleReceiveEvent() {
@@ -1194,10 +1965,10 @@ namespace WebSocket {
 		int result = recv(m_socket, buffer, sizeof(buffer), 0);
 
 		if (result > 0) {
-			// Data received
-			std::vector<uint8_t> data(buffer, buffer + result);
+			// Data received - assign() keeps the capacity from earlier events
+			m_eventReceiveBuffer.assign(buffer, buffer + result);
 			if (m_receiveCallback) {
-				m_receiveCallback(data);
+				m_receiveCallback(m_eventReceiveBuffer);
 			}
 		}
 		else if (result == 0) {
@@ -1207,12 +1978,12 @@ namespace WebSocket {
 			}
 		}
 		else {
-			// Error occurred
-			int errorCode = WSAGetLastError();
-			if (errorCode != WSAEWOULDBLOCK) {
+			// Error occurred; WSAEWOULDBLOCK on Windows is not errno's EWOULDBLOCK
+			Result error(ERROR_CODE::SOCKET_RECEIVE_FAILED, GetLastSystemErrorCode());
+			if (!WouldBlock(error)) {
 				UpdateLastError();
 				if (m_errorCallback) {
-					m_errorCallback(Result(ERROR_CODE::SOCKET_RECEIVE_FAILED, GetLastSystemErrorCode()));
+					m_errorCallback(error);
 				}
 			}
 		}
@@ -1221,15 +1992,23 @@ namespace WebSocket {
 	std::unique_ptr<Socket> Socket::CreateFromNative(SOCKET_TYPE_NATIVE nativeSocket) {
 		auto socket = std::unique_ptr<Socket>(new Socket(nativeSocket));
 
-		// This socket was created outside of Create(), so we need to increment the counter
-		std::lock_guard<std::mutex> lock(s_initMutex);
-		int previousCount = s_socketCount.fetch_add(1);
-		if (previousCount == 0) {
+		// This socket was created outside of Create(), so we need to increment the counter.
+		// Sockets accepted from a live listener find the system initialized already and
+		// never touch s_initMutex
+		if (s_socketCount.fetch_add(1) == 0) {
 			// This shouldn't happen if the system was properly initialized,
 			// but we handle it just in case
+			std::lock_guard<std::mutex> lock(s_initMutex);
 			Result initResult = InitializeSocketSystem();
 			if (initResult.IsError()) {
+				// Release the handle here so the destructor does not decrement the count again
 				s_socketCount.fetch_sub(1);
+#ifdef _WIN32
+				closesocket(nativeSocket);
+#else
+				close(nativeSocket);
+#endif
+				socket->m_socket = INVALID_SOCKET_NATIVE;
 				return nullptr;
 			}
 		}
@@ -1237,4 +2016,35 @@ namespace WebSocket {
 		return socket;
 	}
 
+	// Socket objects come from a slab pool so accept/close churn never reaches the heap.
+	// The pool is intentionally leaked: sockets may still be destroyed during static teardown
+	static SlabPool& SocketSlabPool() {
+		static SlabPool* pool = new SlabPool(sizeof(Socket), 64);
+		return *pool;
+	}
+
+	void* Socket::operator new(size_t size) {
+		if (size == sizeof(Socket)) {
+			if (void* block = SocketSlabPool().Allocate()) {
+				return block;
+			}
+		}
+		return ::operator new(size);
+	}
+
+	void Socket::operator delete(void* block, size_t size) {
+		if (!block) {
+			return;
+		}
+		if (size == sizeof(Socket)) {
+			SocketSlabPool().Deallocate(block);
+			return;
+		}
+		::operator delete(block);
+	}
+
+	SlabPoolStats Socket::PoolStats() {
+		return SocketSlabPool().Stats();
+	}
+
 } // namespace WebSocket
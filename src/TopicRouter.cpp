@@ -0,0 +1,482 @@
+#include "WebSocket/TopicRouter.h"
+#include "WebSocket/CpuTopology.h"
+#include "WebSocket/WebSocketProtocol.h"
+#include <algorithm>
+
+namespace WebSocket {
+
+namespace {
+
+// Empty polls a shard worker spins through before parking
+const int kWorkerSpinCount = 64;
+
+// Parked workers re-check their inbox this often even without a wake-up
+const auto kWorkerParkTimeout = std::chrono::milliseconds(100);
+
+// Publications matched per lock of the shard; subscribers are woken after each batch
+const size_t kMaxBatch = 64;
+
+} // namespace
+
+bool TopicRouter::SubscriberSet::Add(Subscriber* subscriber) {
+    if (!Positions.emplace(subscriber, Members.size()).second) {
+        return false;
+    }
+    Members.push_back(subscriber);
+    return true;
+}
+
+bool TopicRouter::SubscriberSet::Remove(Subscriber* subscriber) {
+    auto it = Positions.find(subscriber);
+    if (it == Positions.end()) {
+        return false;
+    }
+    // Swap with the last member to keep the array dense
+    size_t position = it->second;
+    Positions.erase(it);
+    if (position + 1 != Members.size()) {
+        Members[position] = Members.back();
+        Positions[Members[position]] = position;
+    }
+    Members.pop_back();
+    return true;
+}
+
+bool TopicRouter::Node::Empty() const {
+    return Children.empty() && !AnyLevel && Exact.Empty() && Remainder.Empty();
+}
+
+TopicRouter::TopicRouter(const TopicRouterOptions& options) : m_options(options) {
+    if (m_options.Shards == 0) {
+        m_options.Shards = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_shards.reserve(m_options.Shards);
+    for (size_t i = 0; i < m_options.Shards; i++) {
+        m_shards.push_back(std::make_unique<Shard>(m_options.QueueCapacity));
+    }
+}
+
+TopicRouter::~TopicRouter() {
+    Stop();
+}
+
+Result TopicRouter::Start() {
+    if (m_running) {
+        return Result();
+    }
+    m_running = true;
+    for (size_t i = 0; i < m_shards.size(); i++) {
+        Shard& shard = *m_shards[i];
+        int cpu = m_options.CpuAffinity.empty() ? -1 : m_options.CpuAffinity[i % m_options.CpuAffinity.size()];
+        try {
+            shard.Thread = std::thread(&TopicRouter::WorkerLoop, this, std::ref(shard), cpu);
+        } catch (const std::exception&) {
+            Stop();
+            return Result(ERROR_CODE::THREAD_CREATION_FAILED, "Failed to start topic router shard");
+        }
+    }
+    return Result();
+}
+
+void TopicRouter::Stop() {
+    m_running = false;
+    for (auto& shard : m_shards) {
+        {
+            std::lock_guard<std::mutex> lock(shard->ParkMutex);
+            shard->ParkCondition.notify_one();
+        }
+        {
+            std::lock_guard<std::mutex> lock(shard->RoomMutex);
+            shard->RoomCondition.notify_all();
+        }
+        if (shard->Thread.joinable()) {
+            shard->Thread.join();
+        }
+    }
+
+    for (auto& shard : m_shards) {
+        PublicationPtr publication;
+        while (shard->Inbox.TryPop(publication)) {
+            publication.reset();
+        }
+    }
+}
+
+bool TopicRouter::Register(uint64_t connectionId, std::shared_ptr<DispatchChannel> channel) {
+    if (!channel) {
+        return false;
+    }
+    Shard& shard = ShardFor(connectionId);
+    std::lock_guard<std::mutex> lock(shard.Mutex);
+    auto inserted = shard.Subscribers.emplace(connectionId, Subscriber());
+    if (!inserted.second) {
+        return false;
+    }
+    inserted.first->second.Channel = std::move(channel);
+    m_subscribers.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void TopicRouter::Unregister(uint64_t connectionId) {
+    Shard& shard = ShardFor(connectionId);
+    std::lock_guard<std::mutex> lock(shard.Mutex);
+    auto it = shard.Subscribers.find(connectionId);
+    if (it == shard.Subscribers.end()) {
+        return;
+    }
+
+    Subscriber& subscriber = it->second;
+    std::vector<std::string_view> segments;
+    for (const std::string& pattern : subscriber.Patterns) {
+        SplitTopic(pattern, segments);
+        RemovePattern(shard.Root, segments, 0, &subscriber);
+    }
+    const size_t patterns = subscriber.Patterns.size();
+    shard.Subscriptions.fetch_sub(patterns, std::memory_order_relaxed);
+    m_subscriptions.fetch_sub(patterns, std::memory_order_relaxed);
+    subscriber.Channel->Subscriptions.fetch_sub(patterns, std::memory_order_relaxed);
+
+    shard.Subscribers.erase(it);
+    m_subscribers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool TopicRouter::Subscribe(uint64_t connectionId, const std::string& pattern) {
+    if (!IsValidPattern(pattern)) {
+        return false;
+    }
+    Shard& shard = ShardFor(connectionId);
+    std::lock_guard<std::mutex> lock(shard.Mutex);
+    auto it = shard.Subscribers.find(connectionId);
+    if (it == shard.Subscribers.end()) {
+        return false;
+    }
+    Subscriber& subscriber = it->second;
+
+    std::vector<std::string_view> segments;
+    SplitTopic(pattern, segments);
+    Node* node = &shard.Root;
+    bool remainder = segments.back() == "#";
+    size_t levels = remainder ? segments.size() - 1 : segments.size();
+    for (size_t i = 0; i < levels; i++) {
+        std::unique_ptr<Node>* child = nullptr;
+        if (segments[i] == "+") {
+            child = &node->AnyLevel;
+        } else {
+            auto found = node->Children.find(segments[i]);
+            if (found == node->Children.end()) {
+                found = node->Children.emplace(std::string(segments[i]), nullptr).first;
+            }
+            child = &found->second;
+        }
+        if (!*child) {
+            *child = std::make_unique<Node>();
+        }
+        node = child->get();
+    }
+
+    if (!(remainder ? node->Remainder : node->Exact).Add(&subscriber)) {
+        return true;
+    }
+    subscriber.Patterns.push_back(pattern);
+    shard.Subscriptions.fetch_add(1, std::memory_order_relaxed);
+    m_subscriptions.fetch_add(1, std::memory_order_relaxed);
+    subscriber.Channel->Subscriptions.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool TopicRouter::Unsubscribe(uint64_t connectionId, const std::string& pattern) {
+    Shard& shard = ShardFor(connectionId);
+    std::lock_guard<std::mutex> lock(shard.Mutex);
+    auto it = shard.Subscribers.find(connectionId);
+    if (it == shard.Subscribers.end()) {
+        return false;
+    }
+    Subscriber& subscriber = it->second;
+    auto patternIt = std::find(subscriber.Patterns.begin(), subscriber.Patterns.end(), pattern);
+    if (patternIt == subscriber.Patterns.end()) {
+        return false;
+    }
+
+    std::vector<std::string_view> segments;
+    SplitTopic(pattern, segments);
+    RemovePattern(shard.Root, segments, 0, &subscriber);
+    subscriber.Patterns.erase(patternIt);
+    shard.Subscriptions.fetch_sub(1, std::memory_order_relaxed);
+    m_subscriptions.fetch_sub(1, std::memory_order_relaxed);
+    subscriber.Channel->Subscriptions.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool TopicRouter::Publish(const std::string& topic, const uint8_t* payload, size_t length, WEBSOCKET_OPCODE opcode) {
+    if (!m_running.load(std::memory_order_acquire) || !IsValidTopic(topic)) {
+        return false;
+    }
+
+    // One frame for every subscriber on every shard
+    auto publication = std::make_shared<Publication>();
+    publication->Topic = topic;
+    publication->Frame = WebSocketProtocol::GenerateFrame(opcode, payload, length);
+    m_published.fetch_add(1, std::memory_order_relaxed);
+
+    PublicationPtr shared = std::move(publication);
+    bool queuedEverywhere = true;
+    for (auto& shardPtr : m_shards) {
+        Shard& shard = *shardPtr;
+        if (shard.Subscriptions.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+
+        // A stalled shard costs each publisher at most PublishWaitMs, after
+        // which its subscribers miss this publication
+        PublicationPtr item = shared;
+        if (!shard.Inbox.TryPush(std::move(item)) && !WaitToPush(shard, item)) {
+            if (!m_running.load(std::memory_order_acquire)) {
+                return false;
+            }
+            m_publishDropped.fetch_add(1, std::memory_order_relaxed);
+            queuedEverywhere = false;
+            continue;
+        }
+
+        // Pairs with the fence in WorkerLoop: either the worker sees the
+        // publication before parking or we see it parked and wake it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (shard.Sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(shard.ParkMutex);
+            shard.ParkCondition.notify_one();
+        }
+    }
+    return queuedEverywhere;
+}
+
+bool TopicRouter::WaitToPush(Shard& shard, PublicationPtr& item) {
+    bool pushed = false;
+    std::unique_lock<std::mutex> lock(shard.RoomMutex);
+    shard.RoomWaiters.fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence in WorkerLoop: either the worker sees us waiting
+    // after its batch or our retry sees the slots it freed
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    shard.RoomCondition.wait_for(lock, std::chrono::milliseconds(std::max(m_options.PublishWaitMs, 0)),
+        [this, &shard, &item, &pushed] {
+            pushed = shard.Inbox.TryPush(std::move(item));
+            return pushed || !m_running.load(std::memory_order_acquire);
+        });
+    shard.RoomWaiters.fetch_sub(1, std::memory_order_relaxed);
+    return pushed;
+}
+
+bool TopicRouter::Publish(const std::string& topic, const std::string& payload) {
+    return Publish(topic, reinterpret_cast<const uint8_t*>(payload.data()), payload.size());
+}
+
+bool TopicRouter::IsValidPattern(const std::string& pattern) {
+    if (pattern.empty()) {
+        return false;
+    }
+    std::vector<std::string_view> segments;
+    SplitTopic(pattern, segments);
+    for (size_t i = 0; i < segments.size(); i++) {
+        std::string_view segment = segments[i];
+        if (segment == "#") {
+            if (i + 1 != segments.size()) {
+                return false;   // '#' only as the last level
+            }
+        } else if (segment != "+" && segment.find_first_of("+#") != std::string_view::npos) {
+            return false;       // Wildcards must fill a whole level
+        }
+    }
+    return true;
+}
+
+bool TopicRouter::IsValidTopic(const std::string& topic) {
+    return !topic.empty() && topic.find_first_of("+#") == std::string::npos;
+}
+
+bool TopicRouter::Matches(const std::string& pattern, const std::string& topic) {
+    if (!IsValidPattern(pattern) || !IsValidTopic(topic)) {
+        return false;
+    }
+    std::vector<std::string_view> patternLevels;
+    std::vector<std::string_view> topicLevels;
+    SplitTopic(pattern, patternLevels);
+    SplitTopic(topic, topicLevels);
+
+    for (size_t i = 0; i < patternLevels.size(); i++) {
+        if (patternLevels[i] == "#") {
+            return true;
+        }
+        if (i >= topicLevels.size()) {
+            return false;
+        }
+        if (patternLevels[i] != "+" && patternLevels[i] != topicLevels[i]) {
+            return false;
+        }
+    }
+    return patternLevels.size() == topicLevels.size();
+}
+
+TopicRouterStats TopicRouter::Stats() const {
+    TopicRouterStats stats;
+    stats.Published = m_published.load(std::memory_order_relaxed);
+    stats.Deliveries = m_deliveries.load(std::memory_order_relaxed);
+    stats.Dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.PublishDropped = m_publishDropped.load(std::memory_order_relaxed);
+    stats.Subscribers = m_subscribers.load(std::memory_order_relaxed);
+    stats.Subscriptions = m_subscriptions.load(std::memory_order_relaxed);
+    stats.AffinityFailures = m_affinityFailures.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void TopicRouter::WorkerLoop(Shard& shard, int cpu) {
+    PublicationPtr publication;
+    int idleSpins = 0;
+
+    if (cpu >= 0 && !PinCurrentThread(cpu)) {
+        m_affinityFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    while (m_running) {
+        if (shard.Inbox.Empty()) {
+            if (++idleSpins < kWorkerSpinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(shard.ParkMutex);
+            shard.Sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            shard.ParkCondition.wait_for(lock, kWorkerParkTimeout,
+                [this, &shard] { return !m_running || !shard.Inbox.Empty(); });
+            shard.Sleeping.store(false, std::memory_order_relaxed);
+            idleSpins = 0;
+            continue;
+        }
+        idleSpins = 0;
+
+        shard.BatchSequence++;
+        {
+            std::lock_guard<std::mutex> lock(shard.Mutex);
+            for (size_t i = 0; i < kMaxBatch && shard.Inbox.TryPop(publication); i++) {
+                Deliver(shard, *publication);
+                publication.reset();
+            }
+        }
+
+        // Publishers blocked on a full inbox can retry now
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (shard.RoomWaiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(shard.RoomMutex);
+            shard.RoomCondition.notify_all();
+        }
+
+        // One wake-up per connection for the whole batch
+        for (const auto& channel : shard.Woken) {
+            channel->Notify();
+        }
+        shard.Woken.clear();
+    }
+}
+
+void TopicRouter::Deliver(Shard& shard, const Publication& publication) {
+    shard.PublicationSequence++;
+    SplitTopic(publication.Topic, shard.Segments);
+    shard.Matched.clear();
+    Match(shard, shard.Root, 0);
+
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    for (Subscriber* subscriber : shard.Matched) {
+        DispatchChannel& channel = *subscriber->Channel;
+        if (channel.Closed.load(std::memory_order_acquire)) {
+            continue;
+        }
+        if (!channel.PushFrame(publication.Frame)) {
+            dropped++;
+            continue;
+        }
+        delivered++;
+        if (subscriber->LastBatch != shard.BatchSequence) {
+            subscriber->LastBatch = shard.BatchSequence;
+            shard.Woken.push_back(subscriber->Channel);
+        }
+    }
+    m_deliveries.fetch_add(delivered, std::memory_order_relaxed);
+    if (dropped > 0) {
+        m_dropped.fetch_add(dropped, std::memory_order_relaxed);
+    }
+}
+
+void TopicRouter::Match(Shard& shard, const Node& node, size_t level) {
+    // "a/#" covers "a" itself and everything below it
+    Collect(shard, node.Remainder);
+    if (level == shard.Segments.size()) {
+        Collect(shard, node.Exact);
+        return;
+    }
+    auto child = node.Children.find(shard.Segments[level]);
+    if (child != node.Children.end()) {
+        Match(shard, *child->second, level + 1);
+    }
+    if (node.AnyLevel) {
+        Match(shard, *node.AnyLevel, level + 1);
+    }
+}
+
+void TopicRouter::Collect(Shard& shard, const SubscriberSet& set) {
+    for (Subscriber* subscriber : set.Members) {
+        if (subscriber->LastPublication != shard.PublicationSequence) {
+            subscriber->LastPublication = shard.PublicationSequence;
+            shard.Matched.push_back(subscriber);
+        }
+    }
+}
+
+bool TopicRouter::RemovePattern(Node& node, const std::vector<std::string_view>& segments, size_t level,
+                                Subscriber* subscriber) {
+    if (level + 1 == segments.size() && segments[level] == "#") {
+        return node.Remainder.Remove(subscriber);
+    }
+    if (level == segments.size()) {
+        return node.Exact.Remove(subscriber);
+    }
+
+    // Prune the branch once nothing below it is subscribed
+    std::unique_ptr<Node>* child = nullptr;
+    std::map<std::string, std::unique_ptr<Node>, std::less<>>::iterator named;
+    if (segments[level] == "+") {
+        child = &node.AnyLevel;
+    } else {
+        named = node.Children.find(segments[level]);
+        if (named == node.Children.end()) {
+            return false;
+        }
+        child = &named->second;
+    }
+    if (!*child) {
+        return false;
+    }
+    bool removed = RemovePattern(**child, segments, level + 1, subscriber);
+    if ((*child)->Empty()) {
+        if (segments[level] == "+") {
+            node.AnyLevel.reset();
+        } else {
+            node.Children.erase(named);
+        }
+    }
+    return removed;
+}
+
+void TopicRouter::SplitTopic(std::string_view topic, std::vector<std::string_view>& segments) {
+    segments.clear();
+    size_t start = 0;
+    for (;;) {
+        size_t slash = topic.find('/', start);
+        if (slash == std::string_view::npos) {
+            segments.push_back(topic.substr(start));
+            return;
+        }
+        segments.push_back(topic.substr(start, slash - start));
+        start = slash + 1;
+    }
+}
+
+} // namespace WebSocket
@@ -0,0 +1,497 @@
+#include "WebSocket/Trace.h"
+
+namespace WebSocket {
+
+namespace {
+
+const char kTraceMagic[8] = {'A', 'I', 'W', 'S', 'T', 'R', 'C', '1'};
+const uint8_t kEventChunk = 'E';
+const uint8_t kRecordChunk = 'R';
+
+// Event ids are 16 bits and 0 marks an unregistered site
+const size_t kMaxEvents = 65535;
+
+const char* LevelName(TRACE_LEVEL level) {
+    switch (level) {
+        case TRACE_LEVEL::ERR: return "ERROR";
+        case TRACE_LEVEL::WARN: return "WARN";
+        case TRACE_LEVEL::INFO: return "INFO";
+        case TRACE_LEVEL::VERBOSE: return "VERBOSE";
+        case TRACE_LEVEL::OFF: break;
+    }
+    return "OFF";
+}
+
+std::string RenderMessage(const TraceEventInfo* event, const TraceRecord& record) {
+    if (!event) {
+        return std::string();
+    }
+    std::string out;
+    size_t arg = 0;
+    const std::string& format = event->Format;
+    for (size_t i = 0; i < format.size(); i++) {
+        if (format[i] == '{') {
+            size_t close = format.find('}', i);
+            if (close != std::string::npos && close - i <= 2) {
+                std::string spec = format.substr(i + 1, close - i - 1);
+                if (spec == "s") {
+                    out += record.Text;
+                    i = close;
+                    continue;
+                }
+                if (spec.empty() || spec == "d") {
+                    if (arg < record.ArgCount) {
+                        uint64_t value = record.Args[arg++];
+                        out += spec.empty() ? std::to_string(value) : std::to_string(static_cast<int64_t>(value));
+                    }
+                    i = close;
+                    continue;
+                }
+            }
+        }
+        out += format[i];
+    }
+    return out;
+}
+
+std::string RenderLine(const TraceEventInfo* event, const TraceRecord& record) {
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "+%.6fms T%u %s ", record.Timestamp / 1e6,
+             static_cast<unsigned>(record.Thread), event ? LevelName(event->Level) : "?");
+    std::string line = prefix;
+    if (event) {
+        line += event->Category + "/" + event->Name;
+    } else {
+        line += "event#" + std::to_string(record.Event);
+    }
+    if (record.Phase != TRACE_PHASE::INSTANT) {
+        line += record.Phase == TRACE_PHASE::BEGIN ? " begin" : " end";
+    }
+    std::string message = RenderMessage(event, record);
+    if (!message.empty()) {
+        line += ": " + message;
+    }
+    return line;
+}
+
+void AppendJsonString(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+bool ReadBytes(FILE* file, void* data, size_t size) {
+    return fread(data, 1, size, file) == size;
+}
+
+bool ReadString(FILE* file, std::string& text) {
+    uint16_t length = 0;
+    if (!ReadBytes(file, &length, sizeof(length))) {
+        return false;
+    }
+    text.resize(length);
+    return length == 0 || ReadBytes(file, &text[0], length);
+}
+
+void WriteString(FILE* file, const std::string& text) {
+    uint16_t length = static_cast<uint16_t>(std::min<size_t>(text.size(), 0xFFFF));
+    fwrite(&length, sizeof(length), 1, file);
+    fwrite(text.data(), 1, length, file);
+}
+
+} // namespace
+
+// Buffer states; a retired buffer is handed out again once drained
+enum BUFFER_STATE : int {
+    BUFFER_IN_USE,
+    BUFFER_RETIRED,
+    BUFFER_FREE
+};
+
+struct Tracer::ThreadBuffer {
+    explicit ThreadBuffer(size_t capacity) : Queue(capacity), Capacity(capacity) {}
+
+    SpscQueue<TraceRecord> Queue;       // The owning thread pushes, the drain thread pops
+    size_t Capacity;
+    std::atomic<int> State{BUFFER_IN_USE};
+    uint32_t Thread = 0;
+};
+
+// Retires the thread's buffer when the thread exits
+struct Tracer::BufferLease {
+    ThreadBuffer* Buffer = nullptr;
+
+    ~BufferLease() {
+        if (Buffer) {
+            Buffer->State.store(BUFFER_RETIRED, std::memory_order_release);
+        }
+    }
+};
+
+std::atomic<int> Tracer::s_level{0};
+
+Tracer& Tracer::Instance() {
+    // Leaked so threads tracing during static teardown still find it
+    static Tracer* tracer = new Tracer();
+    return *tracer;
+}
+
+Tracer::Tracer()
+    : m_epoch(std::chrono::steady_clock::now()),
+      m_wallClockEpochNs(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count()),
+      m_events(1) {
+}
+
+Result Tracer::Start(const TraceOptions& options) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running) {
+            return Result(ERROR_CODE::INVALID_PARAMETER, "Tracer is already running");
+        }
+        if (!options.Path.empty()) {
+            m_file = fopen(options.Path.c_str(), "wb");
+            if (!m_file) {
+                return Result(ERROR_CODE::INVALID_PARAMETER, "Cannot open trace file " + options.Path);
+            }
+            fwrite(kTraceMagic, 1, sizeof(kTraceMagic), m_file);
+            fwrite(&m_wallClockEpochNs, sizeof(m_wallClockEpochNs), 1, m_file);
+            m_eventsWritten = 1;
+        }
+        m_options = options;
+        m_options.ThreadBufferRecords = std::max<size_t>(options.ThreadBufferRecords, 2);
+        m_options.MaxMemoryRecords = std::max<size_t>(options.MaxMemoryRecords, 1);
+        m_memory.clear();
+        m_memoryNext = 0;
+        m_running = true;
+    }
+
+    // Records left over from an earlier session are not part of this one
+    {
+        std::lock_guard<std::mutex> drainLock(m_drainMutex);
+        std::vector<ThreadBuffer*> buffers;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& buffer : m_buffers) {
+                buffers.push_back(buffer.get());
+            }
+        }
+        TraceRecord discarded;
+        for (ThreadBuffer* buffer : buffers) {
+            while (buffer->Queue.TryPop(discarded)) {
+            }
+        }
+    }
+
+    int level = std::min(static_cast<int>(options.Level), AIWEBSOCKETS_TRACE_LEVEL);
+    m_drainThread = std::thread(&Tracer::DrainLoop, this);
+    s_level.store(level, std::memory_order_relaxed);
+    return Result();
+}
+
+void Tracer::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        s_level.store(0, std::memory_order_relaxed);
+        m_running = false;
+    }
+    m_wake.notify_all();
+    if (m_drainThread.joinable()) {
+        m_drainThread.join();
+    }
+
+    Drain();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+void Tracer::Flush() {
+    Drain();
+}
+
+TraceLog Tracer::Snapshot() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TraceLog log;
+    log.WallClockEpochNs = m_wallClockEpochNs;
+    log.Events = m_events;
+    log.Records.reserve(m_memory.size());
+    log.Records.insert(log.Records.end(), m_memory.begin() + m_memoryNext, m_memory.end());
+    log.Records.insert(log.Records.end(), m_memory.begin(), m_memory.begin() + m_memoryNext);
+    return log;
+}
+
+TraceStats Tracer::Stats() const {
+    TraceStats stats;
+    stats.Drained = m_drained.load(std::memory_order_relaxed);
+    stats.Dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.Threads = m_nextThread.load(std::memory_order_relaxed) - 1;
+    return stats;
+}
+
+uint16_t Tracer::RegisterSite(TraceSite& site, const char* format) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint16_t id = site.Id.load(std::memory_order_acquire);
+    if (id != 0) {
+        return id;
+    }
+    if (m_events.size() > kMaxEvents) {
+        return 0;
+    }
+    TraceEventInfo info;
+    info.Level = site.Level;
+    info.Category = site.Category;
+    info.Name = site.Name;
+    info.Format = format ? format : "";
+    m_events.push_back(std::move(info));
+    id = static_cast<uint16_t>(m_events.size() - 1);
+    site.Id.store(id, std::memory_order_release);
+    return id;
+}
+
+void Tracer::Write(TraceRecord& record) {
+    static thread_local BufferLease lease;
+    if (record.Event == 0) {
+        return;
+    }
+    if (!lease.Buffer) {
+        lease.Buffer = AcquireBuffer();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - m_epoch;
+    record.Timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    record.Thread = lease.Buffer->Thread;
+    if (!lease.Buffer->Queue.TryPush(std::move(record))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+Tracer::ThreadBuffer* Tracer::AcquireBuffer() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ThreadBuffer* buffer = nullptr;
+    // Buffers sized for an earlier session stay parked
+    auto reusable = std::find_if(m_freeBuffers.begin(), m_freeBuffers.end(), [this](ThreadBuffer* free) {
+        return free->Capacity == m_options.ThreadBufferRecords;
+    });
+    if (reusable != m_freeBuffers.end()) {
+        buffer = *reusable;
+        m_freeBuffers.erase(reusable);
+    } else {
+        m_buffers.push_back(std::make_unique<ThreadBuffer>(m_options.ThreadBufferRecords));
+        buffer = m_buffers.back().get();
+    }
+    buffer->State.store(BUFFER_IN_USE, std::memory_order_relaxed);
+    buffer->Thread = m_nextThread.fetch_add(1, std::memory_order_relaxed);
+    return buffer;
+}
+
+void Tracer::DrainLoop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_for(lock, m_options.DrainInterval, [this] { return !m_running; });
+            if (!m_running) {
+                break;
+            }
+        }
+        Drain();
+    }
+}
+
+void Tracer::Drain() {
+    std::lock_guard<std::mutex> drainLock(m_drainMutex);
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        buffers.reserve(m_buffers.size());
+        for (auto& buffer : m_buffers) {
+            buffers.push_back(buffer.get());
+        }
+    }
+
+    m_batch.clear();
+    std::vector<ThreadBuffer*> retired;
+    TraceRecord record;
+    for (ThreadBuffer* buffer : buffers) {
+        // Read the state first: once a retired buffer is empty, nobody refills it
+        bool wasRetired = buffer->State.load(std::memory_order_acquire) == BUFFER_RETIRED;
+        while (buffer->Queue.TryPop(record)) {
+            m_batch.push_back(record);
+        }
+        if (wasRetired) {
+            retired.push_back(buffer);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (ThreadBuffer* buffer : retired) {
+        buffer->State.store(BUFFER_FREE, std::memory_order_relaxed);
+        m_freeBuffers.push_back(buffer);
+    }
+    if (m_batch.empty()) {
+        return;
+    }
+    m_drained.fetch_add(m_batch.size(), std::memory_order_relaxed);
+
+    if (m_file) {
+        WriteFileChunks(m_batch);
+    } else {
+        for (const TraceRecord& drained : m_batch) {
+            if (m_memory.size() < m_options.MaxMemoryRecords) {
+                m_memory.push_back(drained);
+            } else {
+                m_memory[m_memoryNext] = drained;
+                m_memoryNext = (m_memoryNext + 1) % m_memory.size();
+            }
+        }
+    }
+    if (m_options.Echo) {
+        for (const TraceRecord& drained : m_batch) {
+            const TraceEventInfo* event = drained.Event < m_events.size() ? &m_events[drained.Event] : nullptr;
+            fprintf(stderr, "%s\n", RenderLine(event, drained).c_str());
+        }
+    }
+}
+
+void Tracer::WriteFileChunks(const std::vector<TraceRecord>& records) {
+    // Event definitions go out before the first record that uses them
+    for (; m_eventsWritten < m_events.size(); m_eventsWritten++) {
+        const TraceEventInfo& event = m_events[m_eventsWritten];
+        uint16_t id = static_cast<uint16_t>(m_eventsWritten);
+        uint8_t level = static_cast<uint8_t>(event.Level);
+        fwrite(&kEventChunk, 1, 1, m_file);
+        fwrite(&id, sizeof(id), 1, m_file);
+        fwrite(&level, sizeof(level), 1, m_file);
+        WriteString(m_file, event.Category);
+        WriteString(m_file, event.Name);
+        WriteString(m_file, event.Format);
+    }
+    uint32_t count = static_cast<uint32_t>(records.size());
+    fwrite(&kRecordChunk, 1, 1, m_file);
+    fwrite(&count, sizeof(count), 1, m_file);
+    fwrite(records.data(), sizeof(TraceRecord), records.size(), m_file);
+    fflush(m_file);
+}
+
+const TraceEventInfo* TraceLog::Event(uint16_t id) const {
+    return id != 0 && id < Events.size() ? &Events[id] : nullptr;
+}
+
+std::string TraceLog::Message(const TraceRecord& record) const {
+    return RenderMessage(Event(record.Event), record);
+}
+
+std::string TraceLog::Format(const TraceRecord& record) const {
+    return RenderLine(Event(record.Event), record);
+}
+
+std::string TraceLog::ToChromeTraceJson() const {
+    std::string out = "{\"traceEvents\":[";
+    bool first = true;
+    for (const TraceRecord& record : Records) {
+        const TraceEventInfo* event = Event(record.Event);
+        if (!event) {
+            continue;
+        }
+        out += first ? "\n" : ",\n";
+        first = false;
+
+        char timing[96];
+        const char* phase = record.Phase == TRACE_PHASE::BEGIN ? "B" : record.Phase == TRACE_PHASE::END ? "E" : "i";
+        snprintf(timing, sizeof(timing), "\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u", phase,
+                 record.Timestamp / 1000.0, static_cast<unsigned>(record.Thread));
+        out += "{\"name\":";
+        AppendJsonString(out, event->Name);
+        out += ",\"cat\":";
+        AppendJsonString(out, event->Category);
+        out += ',';
+        out += timing;
+        if (record.Phase == TRACE_PHASE::INSTANT) {
+            out += ",\"s\":\"t\"";
+        }
+        out += ",\"args\":{\"level\":";
+        AppendJsonString(out, LevelName(event->Level));
+        std::string message = Message(record);
+        if (!message.empty()) {
+            out += ",\"message\":";
+            AppendJsonString(out, message);
+        }
+        out += "}}";
+    }
+    out += "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return out;
+}
+
+Result TraceLog::ReadFile(const std::string& path, TraceLog& log) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return Result(ERROR_CODE::INVALID_PARAMETER, "Cannot open trace file " + path);
+    }
+    log = TraceLog();
+    log.Events.resize(1);
+
+    char magic[sizeof(kTraceMagic)];
+    if (!ReadBytes(file, magic, sizeof(magic)) || memcmp(magic, kTraceMagic, sizeof(magic)) != 0 ||
+        !ReadBytes(file, &log.WallClockEpochNs, sizeof(log.WallClockEpochNs))) {
+        fclose(file);
+        return Result(ERROR_CODE::INVALID_PARAMETER, "Not a trace file: " + path);
+    }
+
+    // A file cut short by a crash still yields every complete chunk
+    uint8_t chunk = 0;
+    while (ReadBytes(file, &chunk, 1)) {
+        if (chunk == kEventChunk) {
+            uint16_t id = 0;
+            uint8_t level = 0;
+            TraceEventInfo event;
+            if (!ReadBytes(file, &id, sizeof(id)) || !ReadBytes(file, &level, sizeof(level)) ||
+                !ReadString(file, event.Category) || !ReadString(file, event.Name) || !ReadString(file, event.Format)) {
+                break;
+            }
+            event.Level = static_cast<TRACE_LEVEL>(level);
+            if (log.Events.size() <= id) {
+                log.Events.resize(static_cast<size_t>(id) + 1);
+            }
+            log.Events[id] = std::move(event);
+        } else if (chunk == kRecordChunk) {
+            uint32_t count = 0;
+            if (!ReadBytes(file, &count, sizeof(count))) {
+                break;
+            }
+            size_t start = log.Records.size();
+            log.Records.resize(start + count);
+            size_t read = fread(&log.Records[start], sizeof(TraceRecord), count, file);
+            log.Records.resize(start + read);
+            if (read != count) {
+                break;
+            }
+        } else {
+            fclose(file);
+            return Result(ERROR_CODE::INVALID_PARAMETER, "Corrupt trace file: " + path);
+        }
+    }
+    fclose(file);
+    return Result();
+}
+
+} // namespace WebSocket
@@ -1,12 +1,58 @@
 #include "WebSocket/WebSocketClientLite.h"
 #include "WebSocket/WebSocketProtocol.h"
-#include <iostream>
-#include <sstream>
+#include "WebSocket/Connector.h"
+#include "WebSocket/Trace.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string_view>
+
+#ifndef _WIN32
+#include <errno.h>
+#endif
 
 namespace WebSocket {
 
+namespace {
+
+const size_t kReadChunk = 64 * 1024;
+const size_t kMaxHandshakeResponse = 16 * 1024;
+const int kHandshakeTimeoutMs = 5000;
+const int kSendTimeoutMs = 5000;
+
+int RemainingMs(std::chrono::steady_clock::time_point deadline) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    return static_cast<int>(std::max<long long>(remaining.count(), 0));
+}
+
+// Local connections need neither name resolution nor a connect timeout
+std::pair<Result, std::unique_ptr<Socket>> ConnectUnixSocket(const std::string& path) {
+    auto connection = std::make_unique<Socket>();
+    Result result = connection->Create(SOCKET_FAMILY::UNIX, SOCKET_TYPE::TCP);
+    if (result.IsSuccess()) {
+        result = connection->Connect(path, 0);
+    }
+    if (result.IsSuccess()) {
+        result = connection->Blocking(false);
+    }
+    if (result.IsError()) {
+        return {result, nullptr};
+    }
+    return {Result(), std::move(connection)};
+}
+
+} // namespace
+
 WebSocketClientLite::WebSocketClientLite(const std::string& host, uint16_t port)
     : m_serverHost(host), m_serverPort(port), m_connected(false) {
+    // Masking keys only need to be unpredictable to intermediaries, not cryptographically strong
+    std::random_device rd;
+    m_maskState = (static_cast<uint64_t>(rd()) << 32) ^ rd() ^ reinterpret_cast<uintptr_t>(this);
+    if (m_maskState == 0) {
+        m_maskState = 0x9E3779B97F4A7C15ULL;
+    }
 }
 
 WebSocketClientLite::~WebSocketClientLite() {
@@ -22,11 +68,26 @@ WebSocketClientLite& WebSocketClientLite::SetServer(const std::string& host, uin
     return *this;
 }
 
+WebSocketClientLite& WebSocketClientLite::SetPath(const std::string& path) {
+    m_path = path.empty() ? "/" : path;
+    return *this;
+}
+
+WebSocketClientLite& WebSocketClientLite::SetMaxMessageSize(size_t maxMessageSize) {
+    m_maxMessageSize = maxMessageSize;
+    return *this;
+}
+
 WebSocketClientLite& WebSocketClientLite::OnMessage(const std::function<void(const std::string&)>& callback) {
     m_onMessage = callback;
     return *this;
 }
 
+WebSocketClientLite& WebSocketClientLite::OnBinary(const std::function<void(const std::vector<uint8_t>&)>& callback) {
+    m_onBinary = callback;
+    return *this;
+}
+
 WebSocketClientLite& WebSocketClientLite::OnConnect(const std::function<void()>& callback) {
     m_onConnect = callback;
     return *this;
@@ -46,88 +107,23 @@ Result WebSocketClientLite::Connect() {
     if (m_connected) {
         return Result(ERROR_CODE::INVALID_PARAMETER, "Already connected");
     }
-    
-    // Create socket
-    m_socket = std::make_unique<Socket>();
-    auto createResult = m_socket->Create(SOCKET_FAMILY::IPV4, SOCKET_TYPE::TCP);
-    if (!createResult.IsSuccess()) {
-        m_socket.reset();
-        if (m_onError) {
-            m_onError(createResult);
-        }
-        return createResult;
-    }
-    
-    // Set socket to non-blocking mode BEFORE connecting
-    auto blockingResult = m_socket->Blocking(false);
-    if (!blockingResult.IsSuccess()) {
-        std::cout << "⚠️ Warning: Failed to set non-blocking mode: " << blockingResult.GetErrorMessage() << std::endl;
-    }
-    
-    // Connect to server (non-blocking)
-    auto connectResult = m_socket->Connect(m_serverHost, m_serverPort);
+
+    // Resolve and connect through the shared connector (IPv6/IPv4 Happy Eyeballs, DNS cache)
+    ConnectOptions options;
+    options.TimeoutMs = 5000;
+    options.NonBlocking = true;
+    auto [connectResult, connection] = Socket::IsUnixAddress(m_serverHost)
+        ? ConnectUnixSocket(m_serverHost)
+        : Connector::Shared().Connect(m_serverHost, m_serverPort, options);
     if (!connectResult.IsSuccess()) {
-        // For non-blocking sockets, connect might return "in progress"
-        int systemError = connectResult.GetSystemErrorCode();
-#ifdef _WIN32
-        if (systemError != WSAEWOULDBLOCK) {
-#else
-        if (systemError != EINPROGRESS) {
-#endif
-            m_socket.reset();
-            if (m_onError) {
-                m_onError(connectResult);
-            }
-            return connectResult;
-        }
-        
-        // For non-blocking connect, we need to wait for the connection to complete
-        std::cout << "🔄 Connecting to server (non-blocking)..." << std::endl;
-        
-        // Simple polling approach - in production, use select/poll/epoll
-        for (int i = 0; i < 100; ++i) { // Wait up to 5 seconds
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-            
-            // Check if socket is writable (connection completed)
-            // For simplicity, we'll just try the handshake
-            auto handshakeResult = PerformWebSocketHandshake();
-            if (handshakeResult.IsSuccess()) {
-                m_connected = true;
-                std::cout << "🔗 Connected to WebSocket server at " << m_serverHost << ":" << m_serverPort << " (non-blocking)" << std::endl;
-                
-                if (m_onConnect) {
-                    m_onConnect();
-                }
-                return Result();
-            }
-            
-            // Check if connection failed
-            if (handshakeResult.GetErrorCode() == ERROR_CODE::SOCKET_RECEIVE_FAILED) {
-                int handshakeSystemError = handshakeResult.GetSystemErrorCode();
-#ifdef _WIN32
-                if (handshakeSystemError != WSAEWOULDBLOCK && handshakeSystemError != WSAECONNREFUSED) {
-#else
-                if (handshakeSystemError != EAGAIN && handshakeSystemError != EWOULDBLOCK && handshakeSystemError != ECONNREFUSED) {
-#endif
-                    m_socket.reset();
-                    if (m_onError) {
-                        m_onError(handshakeResult);
-                    }
-                    return handshakeResult;
-                }
-            }
-        }
-        
-        // Connection timeout
-        m_socket.reset();
-        Result timeoutResult(ERROR_CODE::SOCKET_CONNECT_FAILED, "Connection timeout");
         if (m_onError) {
-            m_onError(timeoutResult);
+            m_onError(connectResult);
         }
-        return timeoutResult;
+        return connectResult;
     }
-    
-    // Perform WebSocket handshake
+    m_socket = std::move(connection);
+    ResetReceiveState();
+
     auto handshakeResult = PerformWebSocketHandshake();
     if (!handshakeResult.IsSuccess()) {
         m_socket->Close();
@@ -137,14 +133,21 @@ Result WebSocketClientLite::Connect() {
         }
         return handshakeResult;
     }
-    
+
     m_connected = true;
-    std::cout << "🔗 Connected to WebSocket server at " << m_serverHost << ":" << m_serverPort << " (non-blocking)" << std::endl;
-    
+    WS_TRACE_INFO("lite_client", "connected", "{s}:{}", m_serverHost, m_serverPort);
+
+    // Frames that arrived together with the handshake response
+    Result parseResult = ParseFrames();
+
     if (m_onConnect) {
         m_onConnect();
     }
-    
+    if (parseResult.IsError()) {
+        HandleConnectionLost(parseResult);
+        return parseResult;
+    }
+
     return Result();
 }
 
@@ -152,24 +155,25 @@ Result WebSocketClientLite::Disconnect() {
     if (!m_connected) {
         return Result();
     }
-    
+
     m_connected = false;
-    
+
     if (m_socket) {
-        // Send close frame
-        std::vector<uint8_t> closeFrame = {0x88, 0x00}; // Close frame
-        m_socket->Send(closeFrame);
-        
+        // Send close frame (1000 = normal closure)
+        const uint8_t closeCode[2] = {0x03, 0xE8};
+        SendFrame(WEBSOCKET_OPCODE::CLOSE, closeCode, sizeof(closeCode));
+
         m_socket->Close();
         m_socket.reset();
     }
-    
-    std::cout << "🔌 Disconnected from WebSocket server" << std::endl;
-    
+    ResetReceiveState();
+
+    WS_TRACE_INFO("lite_client", "disconnected", "{s}:{}", m_serverHost, m_serverPort);
+
     if (m_onDisconnect) {
         m_onDisconnect();
     }
-    
+
     return Result();
 }
 
@@ -177,150 +181,405 @@ Result WebSocketClientLite::SendMessage(const std::string& message) {
     if (!m_connected || !m_socket) {
         return Result(ERROR_CODE::INVALID_PARAMETER, "Not connected");
     }
-    
-    std::vector<uint8_t> data(message.begin(), message.end());
-    return SendWebSocketFrame(data, 0x1); // Text frame opcode
+
+    return SendFrame(WEBSOCKET_OPCODE::TEXT, reinterpret_cast<const uint8_t*>(message.data()), message.size());
 }
 
 Result WebSocketClientLite::SendBinary(const std::vector<uint8_t>& data) {
     if (!m_connected || !m_socket) {
         return Result(ERROR_CODE::INVALID_PARAMETER, "Not connected");
     }
-    
-    return SendWebSocketFrame(data, 0x2); // Binary frame opcode
+
+    return SendFrame(WEBSOCKET_OPCODE::BINARY, data.data(), data.size());
 }
 
-std::pair<Result, std::string> WebSocketClientLite::ReceiveMessage() {
+Result WebSocketClientLite::SendPing(const std::vector<uint8_t>& data) {
     if (!m_connected || !m_socket) {
-        return {Result(ERROR_CODE::INVALID_PARAMETER, "Not connected"), ""};
+        return Result(ERROR_CODE::INVALID_PARAMETER, "Not connected");
+    }
+    if (data.size() > 125) {
+        return Result(ERROR_CODE::WEBSOCKET_PAYLOAD_TOO_LARGE, "Control frame payload exceeds 125 bytes");
     }
-    
-    auto receiveResult = m_socket->Receive(4096);
-    if (!receiveResult.first.IsSuccess()) {
-        return {receiveResult.first, ""};
+
+    return SendFrame(WEBSOCKET_OPCODE::PING, data.data(), data.size());
+}
+
+Result WebSocketClientLite::SendFrame(WEBSOCKET_OPCODE opcode, const uint8_t* data, size_t length, bool fin) {
+    if (!m_socket) {
+        return Result(ERROR_CODE::INVALID_PARAMETER, "No socket available");
+    }
+
+    size_t headerSize = WebSocketProtocol::FrameHeaderSize(length, true);
+    m_sendBuffer.resize(headerSize + length);
+    uint8_t* frame = m_sendBuffer.data();
+
+    // First byte: FIN, RSV=000, opcode; second byte: MASK bit plus 7/16/64-bit length
+    frame[0] = static_cast<uint8_t>((fin ? 0x80 : 0x00) | (static_cast<uint8_t>(opcode) & 0x0F));
+    if (length < 126) {
+        frame[1] = static_cast<uint8_t>(0x80 | length);
+    } else if (length < 65536) {
+        frame[1] = 0x80 | 126;
+        frame[2] = static_cast<uint8_t>((length >> 8) & 0xFF);
+        frame[3] = static_cast<uint8_t>(length & 0xFF);
+    } else {
+        frame[1] = 0x80 | 127;
+        uint64_t extended = length;
+        for (int i = 0; i < 8; i++) {
+            frame[2 + i] = static_cast<uint8_t>((extended >> ((7 - i) * 8)) & 0xFF);
+        }
+    }
+
+    // RFC 6455 section 5.3: a fresh masking key for every frame
+    uint8_t* mask = frame + headerSize - 4;
+    uint32_t maskValue = NextMask();
+    memcpy(mask, &maskValue, sizeof(maskValue));
+
+    if (length > 0) {
+        memcpy(frame + headerSize, data, length);
+        WebSocketProtocol::ApplyMask(frame + headerSize, length, mask);
+    }
+
+    return SendAll(frame, headerSize + length);
+}
+
+std::pair<Result, std::string> WebSocketClientLite::ReceiveMessage(int timeoutMs) {
+    auto [result, message] = ReceiveFrame(timeoutMs);
+    return {result, std::string(message.Data.begin(), message.Data.end())};
+}
+
+std::pair<Result, WebSocketMessage> WebSocketClientLite::ReceiveFrame(int timeoutMs) {
+    WebSocketMessage message{WEBSOCKET_OPCODE::TEXT, {}};
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeoutMs, 0));
+    bool firstWait = true;
+
+    while (m_inbox.empty()) {
+        if (!m_connected || !m_socket) {
+            return {Result(ERROR_CODE::INVALID_PARAMETER, "Not connected"), message};
+        }
+
+        int waitMs = timeoutMs < 0 ? -1 : RemainingMs(deadline);
+        if (waitMs == 0 && !firstWait) {
+            return {Result(), message}; // Timed out
+        }
+        firstWait = false;
+
+        size_t bytesRead = 0;
+        Result result = ReadFrames(waitMs, bytesRead);
+        if (result.IsError()) {
+            HandleConnectionLost(result);
+            if (m_inbox.empty()) {
+                return {result, message};
+            }
+        }
     }
-    
-    std::string message(receiveResult.second.begin(), receiveResult.second.end());
-    return {Result(), message};
+
+    message = std::move(m_inbox.front());
+    m_inbox.pop_front();
+    return {Result(), std::move(message)};
 }
 
 void WebSocketClientLite::ProcessMessages() {
     if (!m_connected || !m_socket) {
         return;
     }
-    
-    auto receiveResult = m_socket->Receive(4096);
-    if (!receiveResult.first.IsSuccess()) {
-        Result error = receiveResult.first;
-        if (error.GetErrorCode() == ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED) {
-            m_connected = false;
-            std::cout << "🔌 Server closed connection" << std::endl;
-            if (m_onDisconnect) {
-                m_onDisconnect();
-            }
-        } else if (error.GetErrorCode() == ERROR_CODE::SOCKET_RECEIVE_FAILED) {
-            // Check if it's just a non-blocking "would block" situation
-            int systemError = error.GetSystemErrorCode();
-#ifdef _WIN32
-            if (systemError != WSAEWOULDBLOCK) {
-#else
-            if (systemError != EAGAIN && systemError != EWOULDBLOCK) {
-#endif
-                // Real error occurred
-                std::cout << "❌ Receive error: " << error.GetErrorMessage() << std::endl;
-                m_connected = false;
-                if (m_onDisconnect) {
-                    m_onDisconnect();
-                }
-                if (m_onError) {
-                    m_onError(error);
-                }
-            }
-            // Would block - just return, no message available
+
+    // Drain what the socket already holds without blocking
+    Result result;
+    size_t bytesRead = 0;
+    do {
+        result = ReadFrames(0, bytesRead);
+    } while (result.IsSuccess() && bytesRead == kReadChunk);
+
+    while (!m_inbox.empty()) {
+        WebSocketMessage message = std::move(m_inbox.front());
+        m_inbox.pop_front();
+        if (message.IsBinary() && m_onBinary) {
+            m_onBinary(message.Data);
+        } else if (m_onMessage) {
+            m_onMessage(std::string(message.Data.begin(), message.Data.end()));
+        }
+    }
+
+    if (result.IsError()) {
+        if (result.GetErrorCode() != ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED) {
+            WS_TRACE_WARN("lite_client", "receive_failed", "error code {} system error {}", result.GetErrorCode(),
+                          result.GetSystemErrorCode());
         } else {
-            // Other error
-            std::cout << "❌ WebSocket error: " << error.GetErrorMessage() << std::endl;
-            m_connected = false;
-            if (m_onDisconnect) {
-                m_onDisconnect();
+            WS_TRACE_INFO("lite_client", "server_closed", "{s}:{}", m_serverHost, m_serverPort);
+        }
+        HandleConnectionLost(result);
+    }
+}
+
+Result WebSocketClientLite::PerformWebSocketHandshake() {
+    std::string key = WebSocketProtocol::GenerateClientKey();
+
+    // A socket path is no host name; servers behind a Unix socket see a local Host
+    bool unixDomain = Socket::IsUnixAddress(m_serverHost);
+    std::string request = WebSocketProtocol::GenerateHandshakeRequest(unixDomain ? "localhost" : m_serverHost,
+                                                                      m_serverPort, m_path, key);
+
+    auto sendResult = SendAll(reinterpret_cast<const uint8_t*>(request.data()), request.size());
+    if (!sendResult.IsSuccess()) {
+        return sendResult;
+    }
+
+    // Read up to the end of the response headers; anything after it is already frame data
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kHandshakeTimeoutMs);
+    size_t headerEnd = std::string::npos;
+    while (headerEnd == std::string::npos) {
+        if (m_receiveEnd > kMaxHandshakeResponse) {
+            return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Handshake response too large");
+        }
+
+        int waitMs = RemainingMs(deadline);
+        auto [waitResult, readable] = m_socket->WaitReadable(waitMs);
+        if (waitResult.IsError()) {
+            return waitResult;
+        }
+        if (!readable) {
+            return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Handshake response timed out");
+        }
+
+        ReserveReceiveSpace(4096);
+        auto [receiveResult, received] = m_socket->ReceiveInto(m_receiveBuffer.data() + m_receiveEnd,
+                                                               m_receiveBuffer.size() - m_receiveEnd);
+        if (receiveResult.IsError()) {
+            if (Socket::WouldBlock(receiveResult)) {
+                continue;
             }
-            if (m_onError) {
-                m_onError(error);
+            return receiveResult;
+        }
+        if (received == 0) {
+            return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Connection closed during handshake");
+        }
+        m_receiveEnd += received;
+
+        const char* text = reinterpret_cast<const char*>(m_receiveBuffer.data());
+        std::string_view view(text, m_receiveEnd);
+        headerEnd = view.find("\r\n\r\n");
+    }
+
+    std::string response(reinterpret_cast<const char*>(m_receiveBuffer.data()), headerEnd + 4);
+    m_receiveStart = headerEnd + 4;
+
+    return WebSocketProtocol::ValidateHandshakeResponse(response, key);
+}
+
+Result WebSocketClientLite::SendAll(const uint8_t* data, size_t length) {
+    size_t totalSent = 0;
+    while (totalSent < length) {
+        auto [result, sent] = m_socket->SendRaw(data + totalSent, length - totalSent);
+        totalSent += sent;
+        if (result.IsSuccess()) {
+            if (totalSent < length) {
+                return Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED, "Connection closed while sending");
             }
+            break;
+        }
+        if (!Socket::WouldBlock(result)) {
+            return result;
         }
+
+        // Socket buffer full: wait for the peer to drain it
+        auto [waitResult, writable] = m_socket->WaitWritable(kSendTimeoutMs);
+        if (waitResult.IsError()) {
+            return waitResult;
+        }
+        if (!writable) {
+            return Result(ERROR_CODE::SOCKET_SEND_FAILED, "Send timed out");
+        }
+    }
+    return Result();
+}
+
+void WebSocketClientLite::ReserveReceiveSpace(size_t space) {
+    if (m_receiveBuffer.size() - m_receiveEnd >= space) {
         return;
     }
-    
-    if (m_onMessage && !receiveResult.second.empty()) {
-        std::string message(receiveResult.second.begin(), receiveResult.second.end());
-        m_onMessage(message);
+
+    // Slide unparsed bytes to the front before growing
+    if (m_receiveStart > 0) {
+        size_t pending = m_receiveEnd - m_receiveStart;
+        if (pending > 0) {
+            memmove(m_receiveBuffer.data(), m_receiveBuffer.data() + m_receiveStart, pending);
+        }
+        m_receiveStart = 0;
+        m_receiveEnd = pending;
+    }
+    if (m_receiveBuffer.size() - m_receiveEnd < space) {
+        m_receiveBuffer.resize(m_receiveEnd + space);
     }
 }
 
-Result WebSocketClientLite::PerformWebSocketHandshake() {
-    // Send WebSocket handshake request
-    std::stringstream request;
-    request << "GET / HTTP/1.1\r\n";
-    request << "Host: " << m_serverHost << ":" << m_serverPort << "\r\n";
-    request << "Upgrade: websocket\r\n";
-    request << "Connection: Upgrade\r\n";
-    request << "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"; // Sample key
-    request << "Sec-WebSocket-Version: 13\r\n";
-    request << "\r\n";
-    
-    std::string requestStr = request.str();
-    auto sendResult = m_socket->Send(std::vector<uint8_t>(requestStr.begin(), requestStr.end()));
-    if (!sendResult.IsSuccess()) {
-        return sendResult;
+Result WebSocketClientLite::ReadFrames(int timeoutMs, size_t& bytesRead) {
+    bytesRead = 0;
+
+    auto [waitResult, readable] = m_socket->WaitReadable(timeoutMs);
+    if (waitResult.IsError()) {
+        return waitResult;
     }
-    
-    // Receive handshake response
-    auto receiveResult = m_socket->Receive(4096);
-    if (!receiveResult.first.IsSuccess()) {
-        return receiveResult.first;
+    if (!readable) {
+        return Result();
     }
-    
-    std::string response(receiveResult.second.begin(), receiveResult.second.end());
-    
-    // Validate handshake response
-    if (response.find("HTTP/1.1 101") == std::string::npos) {
-        return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Invalid handshake response");
+
+    ReserveReceiveSpace(kReadChunk);
+    auto [receiveResult, received] = m_socket->ReceiveInto(m_receiveBuffer.data() + m_receiveEnd, kReadChunk);
+    if (receiveResult.IsError()) {
+        return Socket::WouldBlock(receiveResult) ? Result() : receiveResult;
     }
-    
-    if (response.find("Upgrade: websocket") == std::string::npos) {
-        return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Missing Upgrade header");
+    if (received == 0) {
+        return Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED, "Connection closed by server");
+    }
+
+    m_receiveEnd += received;
+    bytesRead = received;
+    return ParseFrames();
+}
+
+Result WebSocketClientLite::ParseFrames() {
+    WebSocketFrame frame;
+
+    while (m_receiveStart < m_receiveEnd) {
+        uint8_t* data = m_receiveBuffer.data() + m_receiveStart;
+        size_t available = m_receiveEnd - m_receiveStart;
+        size_t headerSize = 0;
+
+        if (WebSocketProtocol::ParseFrameHeader(data, available, frame, headerSize).IsError()) {
+            break; // Header not complete yet
+        }
+
+        if (frame.PayloadLength > m_maxMessageSize) {
+            const uint8_t tooBig[2] = {0x03, 0xF1}; // 1009 Message Too Big
+            SendFrame(WEBSOCKET_OPCODE::CLOSE, tooBig, sizeof(tooBig));
+            return Result(ERROR_CODE::WEBSOCKET_PAYLOAD_TOO_LARGE, "Incoming frame exceeds the message size limit");
+        }
+        if (frame.PayloadLength > available - headerSize) {
+            break; // Payload not complete yet; ReadFrames grows the buffer as needed
+        }
+
+        uint8_t* payload = data + headerSize;
+        size_t length = static_cast<size_t>(frame.PayloadLength);
+        m_receiveStart += headerSize + length;
+
+        // Servers must not mask, but unmasking is cheaper than rejecting
+        if (frame.Masked) {
+            WebSocketProtocol::ApplyMask(payload, length, frame.MaskingKey.data());
+        }
+
+        bool fragmented = m_fragmentOpcode != WEBSOCKET_OPCODE::CONTINUATION;
+        const char* protocolError = nullptr;
+
+        switch (frame.Opcode) {
+            case WEBSOCKET_OPCODE::TEXT:
+            case WEBSOCKET_OPCODE::BINARY:
+                if (fragmented) {
+                    protocolError = "New message started inside a fragmented message";
+                } else if (frame.Fin) {
+                    m_inbox.push_back(WebSocketMessage{frame.Opcode, std::vector<uint8_t>(payload, payload + length)});
+                } else {
+                    m_fragmentOpcode = frame.Opcode;
+                    m_fragments.assign(payload, payload + length);
+                }
+                break;
+
+            case WEBSOCKET_OPCODE::CONTINUATION:
+                if (!fragmented) {
+                    protocolError = "Continuation frame without a message to continue";
+                } else if (m_fragments.size() + length > m_maxMessageSize) {
+                    const uint8_t tooBig[2] = {0x03, 0xF1};
+                    SendFrame(WEBSOCKET_OPCODE::CLOSE, tooBig, sizeof(tooBig));
+                    return Result(ERROR_CODE::WEBSOCKET_PAYLOAD_TOO_LARGE, "Reassembled message exceeds the message size limit");
+                } else {
+                    m_fragments.insert(m_fragments.end(), payload, payload + length);
+                    if (frame.Fin) {
+                        m_inbox.push_back(WebSocketMessage{m_fragmentOpcode, std::move(m_fragments)});
+                        m_fragments.clear();
+                        m_fragmentOpcode = WEBSOCKET_OPCODE::CONTINUATION;
+                    }
+                }
+                break;
+
+            case WEBSOCKET_OPCODE::CLOSE:
+            case WEBSOCKET_OPCODE::PING:
+            case WEBSOCKET_OPCODE::PONG:
+                if (!frame.Fin || length > 125) {
+                    protocolError = "Fragmented or oversized control frame";
+                } else {
+                    Result controlResult = HandleControlFrame(frame, payload, length);
+                    if (controlResult.IsError()) {
+                        return controlResult;
+                    }
+                }
+                break;
+
+            default:
+                protocolError = "Reserved opcode";
+                break;
+        }
+
+        if (protocolError) {
+            const uint8_t protocolErrorCode[2] = {0x03, 0xEA}; // 1002 Protocol Error
+            SendFrame(WEBSOCKET_OPCODE::CLOSE, protocolErrorCode, sizeof(protocolErrorCode));
+            return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, protocolError);
+        }
+    }
+
+    if (m_receiveStart == m_receiveEnd) {
+        m_receiveStart = 0;
+        m_receiveEnd = 0;
     }
-    
     return Result();
 }
 
-Result WebSocketClientLite::SendWebSocketFrame(const std::vector<uint8_t>& data, int opcode) {
-    if (!m_socket) {
-        return Result(ERROR_CODE::INVALID_PARAMETER, "No socket available");
+Result WebSocketClientLite::HandleControlFrame(const WebSocketFrame& frame, uint8_t* payload, size_t length) {
+    switch (frame.Opcode) {
+        case WEBSOCKET_OPCODE::PING:
+            return SendFrame(WEBSOCKET_OPCODE::PONG, payload, length);
+
+        case WEBSOCKET_OPCODE::CLOSE:
+            // Echo the status code back, then treat the connection as closed
+            SendFrame(WEBSOCKET_OPCODE::CLOSE, payload, std::min<size_t>(length, 2));
+            return Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED, "Server closed the connection");
+
+        default:
+            return Result(); // Unsolicited pongs are ignored
     }
-    
-    // Simple WebSocket frame construction
-    std::vector<uint8_t> frame;
-    
-    // First byte: FIN=1, RSV=000, Opcode
-    frame.push_back(0x80 | opcode);
-    
-    // Payload length
-    if (data.size() < 126) {
-        frame.push_back(static_cast<uint8_t>(data.size()));
-    } else if (data.size() < 65536) {
-        frame.push_back(126);
-        frame.push_back(static_cast<uint8_t>(data.size() >> 8));
-        frame.push_back(static_cast<uint8_t>(data.size() & 0xFF));
-    } else {
-        // Not supporting very large frames in this simple implementation
-        return Result(ERROR_CODE::WEBSOCKET_PAYLOAD_TOO_LARGE, "Payload too large");
-    }
-    
-    // Payload
-    frame.insert(frame.end(), data.begin(), data.end());
-    
-    return m_socket->Send(frame);
+}
+
+void WebSocketClientLite::ResetReceiveState() {
+    m_receiveStart = 0;
+    m_receiveEnd = 0;
+    m_fragments.clear();
+    m_fragmentOpcode = WEBSOCKET_OPCODE::CONTINUATION;
+    m_inbox.clear();
+}
+
+void WebSocketClientLite::HandleConnectionLost(const Result& error) {
+    if (!m_connected) {
+        return;
+    }
+    m_connected = false;
+
+    if (m_socket) {
+        m_socket->Close();
+        m_socket.reset();
+    }
+
+    if (m_onDisconnect) {
+        m_onDisconnect();
+    }
+    if (m_onError && error.GetErrorCode() != ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED) {
+        m_onError(error);
+    }
+}
+
+uint32_t WebSocketClientLite::NextMask() {
+    // xorshift64*
+    m_maskState ^= m_maskState >> 12;
+    m_maskState ^= m_maskState << 25;
+    m_maskState ^= m_maskState >> 27;
+    return static_cast<uint32_t>((m_maskState * 0x2545F4914F6CDD1DULL) >> 32);
 }
 
 } // namespace WebSocket
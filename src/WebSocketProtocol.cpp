@@ -2,271 +2,468 @@
 #include <cstdio>
 #include <cstring>
 #include <random>
-#include <sstream>
-#include <iomanip>
 #include <algorithm>
 
-#ifdef _WIN32
-#include <windows.h>
-#include <wincrypt.h>
-#else
+#ifdef __linux__
 #include <openssl/sha.h>
-#include <openssl/rand.h>
 #endif
 
 namespace WebSocket {
 
 // Base64 encoding table
-static const char BASE64_CHARS[] = 
+static constexpr char BASE64_CHARS[] = 
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-std::string WebSocketProtocol::Base64Encode(const std::vector<uint8_t>& data) {
-    std::string result;
-    int val = 0, valb = -6;
-    for (uint8_t c : data) {
-        val = (val << 8) + c;
-        valb += 8;
-        while (valb >= 0) {
-            result.push_back(BASE64_CHARS[(val >> valb) & 0x3F]);
-            valb -= 6;
+namespace {
+
+const char kWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// Sextet value of each character; 0xFF for characters outside the alphabet
+struct Base64DecodeTable {
+    uint8_t Values[256];
+
+    constexpr Base64DecodeTable() : Values() {
+        for (int i = 0; i < 256; i++) {
+            Values[i] = 0xFF;
+        }
+        for (int i = 0; i < 64; i++) {
+            Values[static_cast<uint8_t>(BASE64_CHARS[i])] = static_cast<uint8_t>(i);
         }
     }
-    if (valb > -6) {
-        result.push_back(BASE64_CHARS[((val << 8) >> (valb + 8)) & 0x3F]);
-    }
-    while (result.size() % 4) {
-        result.push_back('=');
+};
+
+constexpr Base64DecodeTable kBase64Decode;
+
+/**
+ * SHA-1 (FIPS 180-4) fed in pieces, so the client key and the GUID are hashed
+ * without concatenating them. Runs on the stack; no platform crypto context is
+ * acquired per handshake, which is what made the old Windows path slow.
+ */
+class Sha1 {
+public:
+    void Update(const uint8_t* data, size_t length) {
+        m_length += length;
+        while (length > 0) {
+            size_t take = std::min(length, sizeof(m_block) - m_used);
+            memcpy(m_block + m_used, data, take);
+            m_used += take;
+            data += take;
+            length -= take;
+            if (m_used == sizeof(m_block)) {
+                Compress(m_block);
+                m_used = 0;
+            }
+        }
     }
-    return result;
-}
 
-std::vector<uint8_t> WebSocketProtocol::Base64Decode(const std::string& input) {
-    std::vector<uint8_t> result;
-    int val = 0, valb = -8;
-    for (char c : input) {
-        if (c == '=') break;
-        const char* pos = std::strchr(BASE64_CHARS, c);
-        if (!pos) continue;
-        val = (val << 6) + static_cast<int>(pos - BASE64_CHARS);
-        valb += 6;
-        if (valb >= 0) {
-            result.push_back(static_cast<uint8_t>((val >> valb) & 0xFF));
-            valb -= 8;
+    void Final(uint8_t digest[20]) {
+        uint64_t bits = m_length * 8;
+        m_block[m_used++] = 0x80;
+        if (m_used > 56) {
+            memset(m_block + m_used, 0, sizeof(m_block) - m_used);
+            Compress(m_block);
+            m_used = 0;
+        }
+        memset(m_block + m_used, 0, 56 - m_used);
+        for (int i = 0; i < 8; i++) {
+            m_block[56 + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        }
+        Compress(m_block);
+        for (int i = 0; i < 5; i++) {
+            digest[4 * i] = static_cast<uint8_t>(m_state[i] >> 24);
+            digest[4 * i + 1] = static_cast<uint8_t>(m_state[i] >> 16);
+            digest[4 * i + 2] = static_cast<uint8_t>(m_state[i] >> 8);
+            digest[4 * i + 3] = static_cast<uint8_t>(m_state[i]);
         }
     }
-    return result;
-}
 
-std::string WebSocketProtocol::SHA1Hash(const std::string& input) {
-#ifdef _WIN32
-    HCRYPTPROV hProv = 0;
-    HCRYPTHASH hHash = 0;
-    BYTE hash[20];
-    DWORD hashLen = 20;
-    
-    if (!CryptAcquireContext(&hProv, NULL, NULL, PROV_RSA_FULL, 0)) {
-        return "";
+private:
+    static uint32_t Rotl(uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); }
+
+    void Compress(const uint8_t* block) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) |
+                   (uint32_t(block[4 * i + 2]) << 8) | uint32_t(block[4 * i + 3]);
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = Rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3], e = m_state[4];
+        // One loop per round function keeps the inner loops branch-free
+        auto step = [&](uint32_t f, uint32_t k, uint32_t word) {
+            uint32_t temp = Rotl(a, 5) + f + e + k + word;
+            e = d;
+            d = c;
+            c = Rotl(b, 30);
+            b = a;
+            a = temp;
+        };
+        for (int i = 0; i < 20; i++) step((b & c) | (~b & d), 0x5A827999, w[i]);
+        for (int i = 20; i < 40; i++) step(b ^ c ^ d, 0x6ED9EBA1, w[i]);
+        for (int i = 40; i < 60; i++) step((b & c) | (b & d) | (c & d), 0x8F1BBCDC, w[i]);
+        for (int i = 60; i < 80; i++) step(b ^ c ^ d, 0xCA62C1D6, w[i]);
+        m_state[0] += a;
+        m_state[1] += b;
+        m_state[2] += c;
+        m_state[3] += d;
+        m_state[4] += e;
     }
-    
-    if (!CryptCreateHash(hProv, CALG_SHA1, 0, 0, &hHash)) {
-        CryptReleaseContext(hProv, 0);
-        return "";
+
+    uint32_t m_state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint8_t m_block[64];
+    size_t m_used = 0;
+    uint64_t m_length = 0;
+};
+
+// SHA-1 of the client key followed by the GUID
+void AcceptDigest(std::string_view clientKey, uint8_t digest[20]) {
+#ifdef __linux__
+    // libcrypto uses the CPU's SHA extensions where present; the message is assembled on the stack
+    uint8_t message[128];
+    size_t length = clientKey.size() + sizeof(kWebSocketGuid) - 1;
+    if (length <= sizeof(message)) {
+        memcpy(message, clientKey.data(), clientKey.size());
+        memcpy(message + clientKey.size(), kWebSocketGuid, sizeof(kWebSocketGuid) - 1);
+        SHA1(message, length, digest);
+        return;
     }
-    
-    if (!CryptHashData(hHash, (BYTE*)input.c_str(), (DWORD)input.length(), 0)) {
-        CryptDestroyHash(hHash);
-        CryptReleaseContext(hProv, 0);
-        return "";
+#endif
+    Sha1 sha;
+    sha.Update(reinterpret_cast<const uint8_t*>(clientKey.data()), clientKey.size());
+    sha.Update(reinterpret_cast<const uint8_t*>(kWebSocketGuid), sizeof(kWebSocketGuid) - 1);
+    sha.Final(digest);
+}
+
+char LowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Case-insensitive comparison against a lowercase literal
+bool EqualsLower(std::string_view text, std::string_view lower) {
+    if (text.size() != lower.size()) {
+        return false;
     }
-    
-    if (!CryptGetHashParam(hHash, HP_HASHVAL, hash, &hashLen, 0)) {
-        CryptDestroyHash(hHash);
-        CryptReleaseContext(hProv, 0);
-        return "";
+    for (size_t i = 0; i < text.size(); i++) {
+        if (LowerAscii(text[i]) != lower[i]) {
+            return false;
+        }
     }
-    
-    CryptDestroyHash(hHash);
-    CryptReleaseContext(hProv, 0);
-    
-    std::string result;
-    for (DWORD i = 0; i < hashLen; i++) {
-        result.push_back(hash[i]);
+    return true;
+}
+
+std::string_view TrimSpace(std::string_view text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && (text[begin] == ' ' || text[begin] == '\t')) begin++;
+    while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\t')) end--;
+    return text.substr(begin, end - begin);
+}
+
+// Calls fn with each trimmed, non-empty entry of a comma-separated list
+template <typename Fn>
+void ForEachListEntry(std::string_view list, Fn&& fn) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view entry = TrimSpace(list.substr(0, comma));
+        if (!entry.empty()) {
+            fn(entry);
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        list.remove_prefix(comma + 1);
     }
-    return result;
-#else
-    unsigned char hash[SHA_DIGEST_LENGTH];
-    SHA1((unsigned char*)input.c_str(), input.length(), hash);
-    return std::string((char*)hash, SHA_DIGEST_LENGTH);
-#endif
 }
 
-Result WebSocketProtocol::ValidateHandshakeRequest(const std::string& request, HandshakeInfo& info) {
-    // Parse request line
+bool ListContainsLower(std::string_view list, std::string_view lower) {
+    bool found = false;
+    ForEachListEntry(list, [&found, lower](std::string_view entry) { found = found || EqualsLower(entry, lower); });
+    return found;
+}
+
+/**
+ * Single pass over an upgrade request. Header names are matched in place,
+ * values trimmed as views, and onHeader sees every header line so callers
+ * that want copies can take them.
+ */
+template <typename OnHeader>
+Result ScanHandshakeRequest(std::string_view request, HandshakeRequestView& view, OnHeader&& onHeader) {
     size_t lineEnd = request.find("\r\n");
-    if (lineEnd == std::string::npos) {
+    if (lineEnd == std::string_view::npos) {
         return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Invalid HTTP request format");
     }
     
-    std::string requestLine = request.substr(0, lineEnd);
-    std::stringstream ss(requestLine);
-    std::string method, path, version;
-    
-    if (!(ss >> method >> path >> version)) {
+    // Request line: method, path and version separated by spaces
+    std::string_view requestLine = request.substr(0, lineEnd);
+    size_t methodEnd = requestLine.find(' ');
+    size_t versionStart = requestLine.rfind(' ');
+    if (methodEnd == std::string_view::npos || versionStart == methodEnd) {
         return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Invalid request line");
     }
-    
-    if (method != "GET") {
+    view.Path = TrimSpace(requestLine.substr(methodEnd + 1, versionStart - methodEnd - 1));
+    if (view.Path.empty()) {
+        return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Invalid request line");
+    }
+    if (requestLine.substr(0, methodEnd) != "GET") {
         return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Only GET method allowed");
     }
-    
-    if (version != "HTTP/1.1") {
+    if (requestLine.substr(versionStart + 1) != "HTTP/1.1") {
         return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Only HTTP/1.1 supported");
     }
     
-    // Parse headers
-    size_t pos = lineEnd + 2; // Skip \r\n
     bool hasUpgrade = false;
     bool hasConnection = false;
-    bool hasKey = false;
-    bool hasVersion = false;
-    
-    while (pos < request.length()) {
+    size_t pos = lineEnd + 2;
+    while (pos < request.size()) {
         size_t headerEnd = request.find("\r\n", pos);
-        if (headerEnd == std::string::npos) break;
-        
-        if (headerEnd == pos) break; // Empty line = end of headers
+        if (headerEnd == std::string_view::npos || headerEnd == pos) {
+            break;  // Incomplete line or the blank line ending the headers
+        }
+        std::string_view line = request.substr(pos, headerEnd - pos);
+        pos = headerEnd + 2;
         
-        std::string headerLine = request.substr(pos, headerEnd - pos);
-        size_t colonPos = headerLine.find(':');
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = TrimSpace(line.substr(colon + 1));
         
-        if (colonPos != std::string::npos) {
-            std::string name = headerLine.substr(0, colonPos);
-            std::string value = headerLine.substr(colonPos + 1);
-            
-            // Trim whitespace
-            while (!value.empty() && (value[0] == ' ' || value[0] == '\t')) value.erase(0, 1);
-            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.pop_back();
-            
-            // Convert to lowercase for comparison
-            std::string lowerName = name;
-            std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
-            
-            if (lowerName == "upgrade") {
-                if (value != "websocket") {
-                    return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Invalid Upgrade value");
-                }
-                hasUpgrade = true;
-            }
-            else if (lowerName == "connection") {
-                // Connection header can contain multiple values (e.g., "Upgrade, keep-alive")
-                if (value.find("Upgrade") == std::string::npos) {
-                    return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Connection must include Upgrade");
-                }
-                hasConnection = true;
-            }
-            else if (lowerName == "sec-websocket-key") {
-                if (value.empty() || value.length() < 16) {
-                    return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Invalid Sec-WebSocket-Key");
-                }
-                info.Key = value;
-                hasKey = true;
-            }
-            else if (lowerName == "sec-websocket-version") {
-                if (value != "13") {
-                    return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Unsupported WebSocket version");
-                }
-                info.Version = value;
-                hasVersion = true;
+        if (EqualsLower(name, "upgrade")) {
+            if (!EqualsLower(value, "websocket")) {
+                return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Invalid Upgrade value");
             }
-            else if (lowerName == "origin") {
-                info.Origin = value;
+            hasUpgrade = true;
+        } else if (EqualsLower(name, "connection")) {
+            // Can list several tokens, e.g. "keep-alive, Upgrade"
+            if (!ListContainsLower(value, "upgrade")) {
+                return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Connection must include Upgrade");
             }
-            else if (lowerName == "host") {
-                info.Host = value;
+            hasConnection = true;
+        } else if (EqualsLower(name, "sec-websocket-key")) {
+            if (value.size() < 16) {
+                return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Invalid Sec-WebSocket-Key");
             }
-            else if (lowerName == "sec-websocket-protocol") {
-                // Parse comma-separated protocols
-                std::stringstream protocols(value);
-                std::string protocol;
-                while (std::getline(protocols, protocol, ',')) {
-                    // Trim whitespace
-                    while (!protocol.empty() && (protocol[0] == ' ' || protocol[0] == '\t')) protocol.erase(0, 1);
-                    while (!protocol.empty() && (protocol.back() == ' ' || protocol.back() == '\t')) protocol.pop_back();
-                    if (!protocol.empty()) {
-                        info.Protocols.push_back(protocol);
-                    }
-                }
+            view.Key = value;
+        } else if (EqualsLower(name, "sec-websocket-version")) {
+            if (value != "13") {
+                return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Unsupported WebSocket version");
             }
-            else if (lowerName == "sec-websocket-extensions") {
-                // Parse extensions (simplified)
-                std::stringstream extensions(value);
-                std::string extension;
-                while (std::getline(extensions, extension, ',')) {
-                    // Trim whitespace
-                    while (!extension.empty() && (extension[0] == ' ' || extension[0] == '\t')) extension.erase(0, 1);
-                    while (!extension.empty() && (extension.back() == ' ' || extension.back() == '\t')) extension.pop_back();
-                    if (!extension.empty()) {
-                        info.Extensions.push_back(extension);
-                    }
-                }
-            }
-            
-            // Store all headers for reference
-            info.Headers.emplace_back(name, value);
+            view.Version = value;
+        } else if (EqualsLower(name, "origin")) {
+            view.Origin = value;
+        } else if (EqualsLower(name, "host")) {
+            view.Host = value;
+        } else if (EqualsLower(name, "sec-websocket-protocol")) {
+            view.Protocols = value;
+        } else if (EqualsLower(name, "sec-websocket-extensions")) {
+            view.Extensions = value;
         }
-        
-        pos = headerEnd + 2; // Skip \r\n
+        onHeader(name, value);
     }
     
-    // Validate required headers
     if (!hasUpgrade) {
         return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Missing Upgrade header");
     }
-    
     if (!hasConnection) {
         return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Missing Connection header");
     }
-    
-    if (!hasKey) {
+    if (view.Key.empty()) {
         return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Missing Sec-WebSocket-Key header");
     }
-    
-    if (!hasVersion) {
+    if (view.Version.empty()) {
         return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Missing Sec-WebSocket-Version header");
     }
-    
     return Result();
 }
 
-std::string WebSocketProtocol::GenerateHandshakeResponse(const HandshakeInfo& info) {
-    std::string acceptKey = GenerateWebSocketKey(info.Key);
-    
-    std::ostringstream response;
-    response << "HTTP/1.1 101 Switching Protocols\r\n";
-    response << "Upgrade: websocket\r\n";
-    response << "Connection: Upgrade\r\n";
-    response << "Sec-WebSocket-Accept: " << acceptKey << "\r\n";
-    
-    // Add selected subprotocol if negotiated
-    if (!info.Protocol.empty()) {
-        response << "Sec-WebSocket-Protocol: " << info.Protocol << "\r\n";
+} // namespace
+
+size_t WebSocketProtocol::Base64Encode(const uint8_t* data, size_t length, char* out) {
+    char* start = out;
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3) {
+        uint32_t triple = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+        out[0] = BASE64_CHARS[(triple >> 18) & 0x3F];
+        out[1] = BASE64_CHARS[(triple >> 12) & 0x3F];
+        out[2] = BASE64_CHARS[(triple >> 6) & 0x3F];
+        out[3] = BASE64_CHARS[triple & 0x3F];
+        out += 4;
     }
-    
-    // Add supported extensions (currently none, but framework ready)
-    if (!info.Extensions.empty()) {
-        // For now, we don't support any extensions, so we don't include this header
-        // In a full implementation, we'd negotiate extensions here
+    if (i < length) {
+        uint32_t triple = uint32_t(data[i]) << 16;
+        if (i + 1 < length) {
+            triple |= uint32_t(data[i + 1]) << 8;
+        }
+        out[0] = BASE64_CHARS[(triple >> 18) & 0x3F];
+        out[1] = BASE64_CHARS[(triple >> 12) & 0x3F];
+        out[2] = i + 1 < length ? BASE64_CHARS[(triple >> 6) & 0x3F] : '=';
+        out[3] = '=';
+        out += 4;
+    }
+    return static_cast<size_t>(out - start);
+}
+
+std::string WebSocketProtocol::Base64Encode(const std::vector<uint8_t>& data) {
+    std::string result((data.size() + 2) / 3 * 4, '\0');
+    Base64Encode(data.data(), data.size(), &result[0]);
+    return result;
+}
+
+std::vector<uint8_t> WebSocketProtocol::Base64Decode(const std::string& input) {
+    std::vector<uint8_t> result;
+    result.reserve(input.size() / 4 * 3);
+    uint32_t val = 0;
+    int bits = 0;
+    for (char c : input) {
+        if (c == '=') break;
+        uint8_t sextet = kBase64Decode.Values[static_cast<uint8_t>(c)];
+        if (sextet == 0xFF) continue;
+        val = ((val << 6) | sextet) & 0xFFFFFF;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            result.push_back(static_cast<uint8_t>(val >> bits));
+        }
+    }
+    return result;
+}
+
+std::string WebSocketProtocol::SHA1Hash(const std::string& input) {
+    Sha1 sha;
+    sha.Update(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    uint8_t digest[20];
+    sha.Final(digest);
+    return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+Result WebSocketProtocol::ParseHandshakeRequest(std::string_view request, HandshakeRequestView& view) {
+    return ScanHandshakeRequest(request, view, [](std::string_view, std::string_view) {});
+}
+
+bool WebSocketProtocol::IsUpgradeRequest(std::string_view request) {
+    bool hasUpgrade = false;
+    bool hasConnection = false;
+    bool hasKey = false;
+    size_t pos = request.find("\r\n");
+    while (pos != std::string_view::npos) {
+        pos += 2;
+        size_t headerEnd = request.find("\r\n", pos);
+        if (headerEnd == std::string_view::npos || headerEnd == pos) {
+            break;  // Incomplete line or the blank line ending the headers
+        }
+        std::string_view line = request.substr(pos, headerEnd - pos);
+        pos = headerEnd;
+        
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = TrimSpace(line.substr(colon + 1));
+        if (EqualsLower(name, "upgrade")) {
+            hasUpgrade = ListContainsLower(value, "websocket");
+        } else if (EqualsLower(name, "connection")) {
+            hasConnection = ListContainsLower(value, "upgrade");
+        } else if (EqualsLower(name, "sec-websocket-key")) {
+            hasKey = true;
+        }
+    }
+    return hasUpgrade && hasConnection && hasKey;
+}
+
+Result WebSocketProtocol::ValidateHandshakeRequest(const std::string& request, HandshakeInfo& info) {
+    HandshakeRequestView view;
+    Result result = ScanHandshakeRequest(request, view, [&info](std::string_view name, std::string_view value) {
+        if (EqualsLower(name, "sec-websocket-protocol")) {
+            ForEachListEntry(value, [&info](std::string_view entry) { info.Protocols.emplace_back(entry); });
+        } else if (EqualsLower(name, "sec-websocket-extensions")) {
+            ForEachListEntry(value, [&info](std::string_view entry) { info.Extensions.emplace_back(entry); });
+        }
+        // Store all headers for reference
+        info.Headers.emplace_back(std::string(name), std::string(value));
+    });
+    if (result.IsError()) {
+        return result;
     }
     
-    response << "\r\n";
+    info.Host.assign(view.Host);
+    info.Origin.assign(view.Origin);
+    info.Key.assign(view.Key);
+    info.Version.assign(view.Version);
+    return Result();
+}
+
+void WebSocketProtocol::ComputeAcceptKey(std::string_view clientKey, char* out) {
+    uint8_t digest[20];
+    AcceptDigest(clientKey, digest);
+    Base64Encode(digest, sizeof(digest), out);
+}
+
+namespace {
+
+const char kResponseHead[] =
+    "HTTP/1.1 101 Switching Protocols\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Accept: ";
+const char kResponseProtocol[] = "\r\nSec-WebSocket-Protocol: ";
+const char kResponseExtensions[] = "\r\nSec-WebSocket-Extensions: ";
+
+} // namespace
+
+size_t WebSocketProtocol::HandshakeResponseSize(size_t protocolLength, size_t extensionsLength) {
+    size_t size = sizeof(kResponseHead) - 1 + kAcceptKeySize + 4;  // Ends with "\r\n\r\n"
+    if (protocolLength > 0) {
+        size += sizeof(kResponseProtocol) - 1 + protocolLength;
+    }
+    if (extensionsLength > 0) {
+        size += sizeof(kResponseExtensions) - 1 + extensionsLength;
+    }
+    return size;
+}
+
+size_t WebSocketProtocol::WriteHandshakeResponse(std::string_view clientKey, std::string_view protocol,
+                                                 std::string_view extensions, char* out, size_t capacity) {
+    size_t size = HandshakeResponseSize(protocol.size(), extensions.size());
+    if (size > capacity) {
+        return 0;
+    }
     
-    return response.str();
+    char* p = out;
+    memcpy(p, kResponseHead, sizeof(kResponseHead) - 1);
+    p += sizeof(kResponseHead) - 1;
+    ComputeAcceptKey(clientKey, p);
+    p += kAcceptKeySize;
+    if (!protocol.empty()) {
+        memcpy(p, kResponseProtocol, sizeof(kResponseProtocol) - 1);
+        p += sizeof(kResponseProtocol) - 1;
+        memcpy(p, protocol.data(), protocol.size());
+        p += protocol.size();
+    }
+    if (!extensions.empty()) {
+        memcpy(p, kResponseExtensions, sizeof(kResponseExtensions) - 1);
+        p += sizeof(kResponseExtensions) - 1;
+        memcpy(p, extensions.data(), extensions.size());
+        p += extensions.size();
+    }
+    memcpy(p, "\r\n\r\n", 4);
+    return size;
+}
+
+std::string WebSocketProtocol::GenerateHandshakeResponse(const HandshakeInfo& info) {
+    // The requested extensions are not answered; servers negotiate them through ExtensionChain
+    std::string response(HandshakeResponseSize(info.Protocol.size()), '\0');
+    WriteHandshakeResponse(info.Key, info.Protocol, std::string_view(), &response[0], response.size());
+    return response;
 }
 
 std::string WebSocketProtocol::GenerateWebSocketKey(const std::string& clientKey) {
-    std::string magicString = clientKey + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
-    std::string hash = SHA1Hash(magicString);
-    return Base64Encode(std::vector<uint8_t>(hash.begin(), hash.end()));
+    char accept[kAcceptKeySize];
+    ComputeAcceptKey(clientKey, accept);
+    return std::string(accept, sizeof(accept));
 }
 
 std::string WebSocketProtocol::NegotiateSubProtocol(const std::vector<std::string>& clientProtocols, 
@@ -283,8 +480,22 @@ std::string WebSocketProtocol::NegotiateSubProtocol(const std::vector<std::strin
     return ""; // No common protocol found
 }
 
+std::string_view WebSocketProtocol::SelectSubProtocol(std::string_view offered, const std::vector<std::string>& supported) {
+    std::string_view selected;
+    ForEachListEntry(offered, [&selected, &supported](std::string_view entry) {
+        if (selected.empty() && std::find(supported.begin(), supported.end(), entry) != supported.end()) {
+            selected = entry;
+        }
+    });
+    return selected;
+}
+
 Result WebSocketProtocol::ParseFrame(const std::vector<uint8_t>& data, WebSocketFrame& frame, size_t& bytesConsumed) {
-    if (data.size() < 2) {
+    return ParseFrame(data.data(), data.size(), frame, bytesConsumed);
+}
+
+Result WebSocketProtocol::ParseFrameHeader(const uint8_t* data, size_t length, WebSocketFrame& frame, size_t& offset) {
+    if (length < 2) {
         return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, "Frame too short");
     }
     
@@ -299,17 +510,17 @@ Result WebSocketProtocol::ParseFrame(const std::vector<uint8_t>& data, WebSocket
     frame.Masked = (data[1] & 0x80) != 0;
     uint8_t payloadLen1 = data[1] & 0x7F;
     
-    size_t offset = 2;
+    offset = 2;
     
     // Parse extended payload length
     if (payloadLen1 == 126) {
-        if (data.size() < offset + 2) {
+        if (length < offset + 2) {
             return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, "Incomplete extended payload length");
         }
         frame.PayloadLength = (static_cast<uint64_t>(data[offset]) << 8) | data[offset + 1];
         offset += 2;
     } else if (payloadLen1 == 127) {
-        if (data.size() < offset + 8) {
+        if (length < offset + 8) {
             return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, "Incomplete extended payload length");
         }
         frame.PayloadLength = 0;
@@ -323,35 +534,72 @@ Result WebSocketProtocol::ParseFrame(const std::vector<uint8_t>& data, WebSocket
     
     // Parse masking key (if present)
     if (frame.Masked) {
-        if (data.size() < offset + 4) {
+        if (length < offset + 4) {
             return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, "Incomplete masking key");
         }
-        frame.MaskingKey.assign(data.begin() + offset, data.begin() + offset + 4);
+        memcpy(frame.MaskingKey.data(), data + offset, 4);
         offset += 4;
     } else {
-        frame.MaskingKey.clear();
+        frame.MaskingKey.fill(0);
     }
     
-    // Parse payload data
-    if (data.size() < offset + frame.PayloadLength) {
+    return Result();
+}
+
+Result WebSocketProtocol::ParseFrame(const uint8_t* data, size_t length, WebSocketFrame& frame, size_t& bytesConsumed) {
+    size_t offset = 0;
+    Result result = ParseFrameHeader(data, length, frame, offset);
+    if (result.IsError()) {
+        return result;
+    }
+    if (frame.PayloadLength > length - offset) {
         return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, "Incomplete payload data");
     }
     
-    frame.PayloadData.assign(data.begin() + offset, data.begin() + offset + frame.PayloadLength);
+    frame.PayloadData.assign(data + offset, data + offset + frame.PayloadLength);
     
     // Unmask payload if necessary
-    if (frame.Masked && !frame.MaskingKey.empty()) {
-        for (size_t i = 0; i < frame.PayloadData.size(); i++) {
-            frame.PayloadData[i] ^= frame.MaskingKey[i % 4];
-        }
+    if (frame.Masked && !frame.PayloadData.empty()) {
+        ApplyMask(frame.PayloadData.data(), frame.PayloadData.size(), frame.MaskingKey.data());
     }
     
     bytesConsumed = offset + frame.PayloadLength;
     return Result();
 }
 
+Result WebSocketProtocol::ParseFrame(const uint8_t* data, size_t length, WebSocketFrame& frame, size_t& bytesConsumed, BufferHandle& payload) {
+    size_t offset = 0;
+    Result result = ParseFrameHeader(data, length, frame, offset);
+    if (result.IsError()) {
+        return result;
+    }
+    if (frame.PayloadLength > length - offset) {
+        return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, "Incomplete payload data");
+    }
+    
+    // Payload goes to a pooled buffer and is unmasked there
+    size_t payloadLength = static_cast<size_t>(frame.PayloadLength);
+    payload = BufferPool::Acquire(payloadLength);
+    if (!payload.Valid()) {
+        return Result(ERROR_CODE::MEMORY_ALLOCATION_FAILED);
+    }
+    payload.Resize(payloadLength);
+    frame.PayloadData.clear();
+    
+    if (payloadLength > 0) {
+        memcpy(payload.Data(), data + offset, payloadLength);
+        if (frame.Masked) {
+            ApplyMask(payload.Data(), payloadLength, frame.MaskingKey.data());
+        }
+    }
+    
+    bytesConsumed = offset + payloadLength;
+    return Result();
+}
+
 std::vector<uint8_t> WebSocketProtocol::GenerateFrame(const WebSocketFrame& frame) {
     std::vector<uint8_t> result;
+    result.reserve(FrameHeaderSize(frame.PayloadLength, frame.Masked) + frame.PayloadData.size());
     
     // First byte
     uint8_t firstByte = 0;
@@ -382,7 +630,7 @@ std::vector<uint8_t> WebSocketProtocol::GenerateFrame(const WebSocketFrame& fram
     
     // Masking key (if needed)
     if (frame.Masked) {
-        if (frame.MaskingKey.size() != 4) {
+        if (frame.MaskingKey == std::array<uint8_t, 4>{}) {
             // Generate random masking key if not provided
             std::random_device rd;
             std::mt19937 gen(rd());
@@ -401,6 +649,125 @@ std::vector<uint8_t> WebSocketProtocol::GenerateFrame(const WebSocketFrame& fram
     return result;
 }
 
+void WebSocketProtocol::ApplyMask(uint8_t* data, size_t length, const uint8_t* mask, size_t maskOffset) {
+    // XOR eight bytes at a time; the 4-byte key repeats evenly within a 64-bit word
+    uint8_t pattern[8];
+    for (size_t i = 0; i < 8; i++) {
+        pattern[i] = mask[(maskOffset + i) & 3];
+    }
+    uint64_t key;
+    memcpy(&key, pattern, sizeof(key));
+    
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        word ^= key;
+        memcpy(data + i, &word, sizeof(word));
+    }
+    for (; i < length; i++) {
+        data[i] ^= pattern[i & 7];
+    }
+}
+
+std::string WebSocketProtocol::GenerateClientKey() {
+    // RFC 6455 section 4.1: a fresh random 16-byte nonce, base64-encoded
+    std::random_device rd;
+    std::vector<uint8_t> nonce(16);
+    for (size_t i = 0; i < nonce.size(); i += 4) {
+        uint32_t value = rd();
+        memcpy(nonce.data() + i, &value, sizeof(value));
+    }
+    return Base64Encode(nonce);
+}
+
+std::string WebSocketProtocol::GenerateHandshakeRequest(const std::string& host, uint16_t port, const std::string& path,
+                                                       const std::string& clientKey) {
+    std::string request;
+    request.reserve(160 + host.size() + path.size());
+    request += "GET " + path + " HTTP/1.1\r\n";
+    request += "Host: " + host + ":" + std::to_string(port) + "\r\n";
+    request += "Upgrade: websocket\r\n";
+    request += "Connection: Upgrade\r\n";
+    request += "Sec-WebSocket-Key: " + clientKey + "\r\n";
+    request += "Sec-WebSocket-Version: 13\r\n";
+    request += "\r\n";
+    return request;
+}
+
+Result WebSocketProtocol::ValidateHandshakeResponse(const std::string& response, const std::string& clientKey) {
+    if (response.compare(0, 12, "HTTP/1.1 101") != 0) {
+        return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Invalid handshake response");
+    }
+
+    std::string lower = response;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (lower.find("\r\nupgrade: websocket") == std::string::npos) {
+        return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Missing Upgrade header");
+    }
+
+    size_t acceptPos = lower.find("\r\nsec-websocket-accept:");
+    if (acceptPos == std::string::npos) {
+        return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Missing Sec-WebSocket-Accept header");
+    }
+    size_t valueStart = response.find_first_not_of(' ', acceptPos + 23);
+    size_t valueEnd = response.find("\r\n", valueStart);
+    std::string accept = response.substr(valueStart, valueEnd - valueStart);
+    while (!accept.empty() && accept.back() == ' ') {
+        accept.pop_back();
+    }
+    char expected[kAcceptKeySize];
+    ComputeAcceptKey(clientKey, expected);
+    if (accept != std::string_view(expected, sizeof(expected))) {
+        return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Sec-WebSocket-Accept does not match the key");
+    }
+
+    return Result();
+}
+
+size_t WebSocketProtocol::FrameHeaderSize(uint64_t payloadLength, bool masked) {
+    size_t size = 2;
+    if (payloadLength >= 65536) {
+        size += 8;
+    } else if (payloadLength >= 126) {
+        size += 2;
+    }
+    return masked ? size + 4 : size;
+}
+
+BufferHandle WebSocketProtocol::GenerateFrame(WEBSOCKET_OPCODE opcode, const uint8_t* payload, size_t length, bool fin,
+                                              uint8_t rsv) {
+    // Unmasked (server-to-client) frame written straight into a pooled buffer
+    size_t headerSize = FrameHeaderSize(length, false);
+    BufferHandle result = BufferPool::Acquire(headerSize + length);
+    if (!result.Valid()) {
+        return result;
+    }
+    
+    uint8_t* out = result.Data();
+    out[0] = static_cast<uint8_t>((fin ? 0x80 : 0x00) | (rsv & 0x70) | (static_cast<uint8_t>(opcode) & 0x0F));
+    if (length < 126) {
+        out[1] = static_cast<uint8_t>(length);
+    } else if (length < 65536) {
+        out[1] = 126;
+        out[2] = static_cast<uint8_t>((length >> 8) & 0xFF);
+        out[3] = static_cast<uint8_t>(length & 0xFF);
+    } else {
+        out[1] = 127;
+        uint64_t extended = length;
+        for (int i = 0; i < 8; i++) {
+            out[2 + i] = static_cast<uint8_t>((extended >> ((7 - i) * 8)) & 0xFF);
+        }
+    }
+    if (length > 0) {
+        memcpy(out + headerSize, payload, length);
+    }
+    
+    result.Resize(headerSize + length);
+    return result;
+}
+
 WebSocketFrame WebSocketProtocol::CreateTextFrame(const std::string& text, bool fin) {
     WebSocketFrame frame;
     frame.Fin = fin;
@@ -503,4 +870,122 @@ bool WebSocketProtocol::IsValidUTF8(const std::vector<uint8_t>& data) {
     return true;
 }
 
+FrameStreamDecoder::FrameStreamDecoder(uint64_t maxMessageSize) : m_maxMessageSize(maxMessageSize) {}
+
+void FrameStreamDecoder::Reset() {
+    m_inFrame = false;
+    m_frameRemaining = 0;
+    m_maskOffset = 0;
+    m_inMessage = false;
+    m_messageStarted = false;
+    m_messageRsv = 0;
+    m_messageSize = 0;
+}
+
+Result FrameStreamDecoder::Next(uint8_t* data, size_t length, size_t& consumed, Event& event) {
+    consumed = 0;
+    event = Event();
+    
+    if (!m_inFrame) {
+        // Work out the header size from the first two bytes before decoding it
+        if (length < 2) {
+            return Result();
+        }
+        uint8_t lengthCode = data[1] & 0x7F;
+        size_t headerSize = 2 + (lengthCode == 126 ? 2 : lengthCode == 127 ? 8 : 0) + ((data[1] & 0x80) ? 4 : 0);
+        if (length < headerSize) {
+            return Result();
+        }
+        size_t offset = 0;
+        Result headerResult = WebSocketProtocol::ParseFrameHeader(data, length, m_frame, offset);
+        if (headerResult.IsError()) {
+            return headerResult;
+        }
+        if (!WebSocketProtocol::IsValidOpcode(m_frame.Opcode)) {
+            return Result(ERROR_CODE::WEBSOCKET_INVALID_OPCODE, "Unknown opcode");
+        }
+        if (m_requireMask && !m_frame.Masked) {
+            return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, "Client frame is not masked");
+        }
+        uint8_t rsv = data[0] & 0x70;
+        uint8_t allowedRsv = m_frame.Opcode == WEBSOCKET_OPCODE::CONTINUATION ? m_allowedContinuationRsv : m_allowedRsv;
+        if (rsv != 0 && ((rsv & ~allowedRsv) != 0 || (static_cast<uint8_t>(m_frame.Opcode) & 0x08))) {
+            return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, "Reserved bits set without a negotiated extension");
+        }
+        
+        // Control frames are small and unfragmented; hand them out whole
+        if (static_cast<uint8_t>(m_frame.Opcode) & 0x08) {
+            if (!m_frame.Fin || m_frame.PayloadLength > 125) {
+                return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED, "Invalid control frame");
+            }
+            size_t payloadLength = static_cast<size_t>(m_frame.PayloadLength);
+            if (length - offset < payloadLength) {
+                return Result();
+            }
+            if (m_frame.Masked && payloadLength > 0) {
+                WebSocketProtocol::ApplyMask(data + offset, payloadLength, m_frame.MaskingKey.data());
+            }
+            event.Type = STREAM_EVENT::CONTROL;
+            event.Opcode = m_frame.Opcode;
+            event.Data = data + offset;
+            event.Length = payloadLength;
+            consumed = offset + payloadLength;
+            return Result();
+        }
+        
+        bool continuation = m_frame.Opcode == WEBSOCKET_OPCODE::CONTINUATION;
+        if (continuation != m_inMessage) {
+            return Result(ERROR_CODE::WEBSOCKET_FRAME_PARSE_FAILED,
+                continuation ? "Continuation frame without a message" : "New message before the last one finished");
+        }
+        if (!m_inMessage) {
+            m_inMessage = true;
+            m_messageStarted = false;
+            m_messageOpcode = m_frame.Opcode;
+            m_messageRsv = rsv;
+            m_messageSize = 0;
+        }
+        if (m_maxMessageSize > 0 && m_frame.PayloadLength > m_maxMessageSize - m_messageSize) {
+            return Result(ERROR_CODE::WEBSOCKET_PAYLOAD_TOO_LARGE, "Message exceeds the size limit");
+        }
+        
+        m_inFrame = true;
+        m_frameRemaining = m_frame.PayloadLength;
+        m_maskOffset = 0;
+        consumed = offset;
+        data += offset;
+        length -= offset;
+    }
+    
+    // Stream whatever part of the payload has arrived
+    size_t available = static_cast<size_t>(std::min<uint64_t>(length, m_frameRemaining));
+    if (available == 0 && m_frameRemaining > 0) {
+        return Result();
+    }
+    if (m_frame.Masked && available > 0) {
+        WebSocketProtocol::ApplyMask(data, available, m_frame.MaskingKey.data(), m_maskOffset);
+    }
+    m_maskOffset += available;
+    m_frameRemaining -= available;
+    m_messageSize += available;
+    consumed += available;
+    
+    event.Type = STREAM_EVENT::DATA;
+    event.Opcode = m_messageOpcode;
+    event.Data = data;
+    event.Length = available;
+    event.First = !m_messageStarted;
+    event.Rsv = m_messageRsv;
+    m_messageStarted = true;
+    if (m_frameRemaining == 0) {
+        m_inFrame = false;
+        event.FrameEnd = true;
+        if (m_frame.Fin) {
+            event.Last = true;
+            m_inMessage = false;
+        }
+    }
+    return Result();
+}
+
 } // namespace WebSocket
@@ -1,14 +1,18 @@
 #include "WebSocket/WebSocketServerLite.h"
 #include "WebSocket/WebSocketProtocol.h"
-#include <iostream>
+#include "WebSocket/Trace.h"
 #include <thread>
 #include <chrono>
 #include <map>
 #include <algorithm>
 #include <sstream>
+#include <cstring>
 
 namespace WebSocket {
 
+// Client threads receive into a stack buffer of this size
+static const size_t kReceiveBufferSize = 4096;
+
 WebSocketServerLite::WebSocketServerLite(uint16_t port, const std::string& bindAddress)
     : m_bindAddress(bindAddress), m_port(port), m_running(false), m_securityEnabled(true),
       m_maxConnections(50), m_maxConnectionsPerIP(5), m_maxConnectionsPerMinute(10) {
@@ -54,6 +58,31 @@ WebSocketServerLite& WebSocketServerLite::SetMaxConnectionsPerMinute(int maxPerM
     return *this;
 }
 
+WebSocketServerLite& WebSocketServerLite::SetMemoryBudget(size_t bytes) {
+    m_memoryBudget.SetLimit(bytes);
+    return *this;
+}
+
+WebSocketServerLite& WebSocketServerLite::SetSocketProfile(const SocketProfile& profile) {
+    if (m_running) {
+        throw std::runtime_error("Cannot change socket profile while server is running");
+    }
+    m_socketProfile = profile;
+    return *this;
+}
+
+WebSocketServerLite& WebSocketServerLite::SetSubProtocols(const std::vector<std::string>& protocols) {
+    m_subProtocols = protocols;
+    return *this;
+}
+
+WebSocketServerLite& WebSocketServerLite::AddExtension(std::shared_ptr<WebSocketExtension> extension) {
+    if (extension) {
+        m_extensions.push_back(std::move(extension));
+    }
+    return *this;
+}
+
 WebSocketServerLite& WebSocketServerLite::OnMessage(const std::function<void(const std::string&)>& callback) {
     m_onMessage = callback;
     return *this;
@@ -90,7 +119,7 @@ Result WebSocketServerLite::Stop() {
         m_serverSocket.reset();
     }
     
-    std::cout << "🛑 WebSocket Server stopped" << std::endl;
+    WS_TRACE_INFO("lite_server", "stopped", "port {}", m_port);
     return Result();
 }
 
@@ -108,9 +137,8 @@ Result WebSocketServerLite::StartNonBlocking() {
     }
     
     m_running = true;
-    std::cout << "🚀 WebSocket Server started on " << m_bindAddress << ":" << m_port << " (non-blocking)" << std::endl;
-    std::cout << "🔒 Security: " << (m_securityEnabled ? "ENABLED" : "DISABLED") << std::endl;
-    std::cout << "📊 Max connections: " << m_maxConnections << " (per IP: " << m_maxConnectionsPerIP << ")" << std::endl;
+    WS_TRACE_INFO("lite_server", "started", "{s}:{} security {} max connections {}", m_bindAddress, m_port,
+                  m_securityEnabled, m_maxConnections);
     
     return Result();
 }
@@ -120,33 +148,134 @@ void WebSocketServerLite::ProcessEvents() {
         return;
     }
     
-    // Accept new connections
-    auto acceptResult = m_serverSocket->Accept();
-    if (acceptResult.first.IsSuccess() && acceptResult.second) {
-        std::string clientIP = GetClientIP(*acceptResult.second); // No HTTP request yet for initial connection
+    // Accept every pending connection (accept4 with SOCK_NONBLOCK | SOCK_CLOEXEC)
+    auto acceptResult = m_serverSocket->AcceptBatch(m_acceptedSockets);
+    if (!acceptResult.IsSuccess() && m_onError) {
+        m_onError(acceptResult);
+    }
+    
+    for (auto& acceptedSocket : m_acceptedSockets) {
+        std::string clientIP = GetClientIP(*acceptedSocket); // No HTTP request yet for initial connection
         
         if (m_securityEnabled && !IsConnectionAllowed(clientIP)) {
-            std::cout << "🚫 Connection rejected: " << clientIP << " (security limits exceeded)" << std::endl;
-            acceptResult.second->Close();
-            return;
+            WS_TRACE_WARN("lite_server", "connection_rejected", "{s} exceeded security limits", clientIP);
+            acceptedSocket->Close();
+            continue;
+        }
+        
+        // The connection record and its thread's receive buffer
+        MemoryReservation memory(&m_memoryBudget);
+        if (!memory.TryGrow(sizeof(LiteConnection) + kReceiveBufferSize)) {
+            WS_TRACE_WARN("lite_server", "memory_budget", "{s} connection shed at {} bytes", clientIP, m_memoryBudget.Used());
+            acceptedSocket->Close();
+            continue;
         }
         
         // Handle connection in a separate thread
-        std::thread clientThread([this, client = acceptResult.second.release(), clientIP]() {
+        std::thread clientThread([this, client = acceptedSocket.release(), clientIP, memory = std::move(memory)]() mutable {
             std::unique_ptr<Socket> clientSocket(client);
-            HandleClientConnection(std::move(clientSocket));
+            HandleClientConnection(std::move(clientSocket), std::move(memory));
         });
         clientThread.detach();
     }
+    m_acceptedSockets.clear();
 }
 
 int WebSocketServerLite::GetCurrentConnectionCount() const {
     return currentConnections.load();
 }
 
+void WebSocketServerLite::ReadStats(const LiteConnection& connection, ConnectionHandle handle, bool tcpInfo, int64_t now,
+                                    ConnectionStats& stats) const {
+    stats.Handle = handle;
+    ReadConnectionCounters(connection.counters, now, stats);
+    stats.HasTcpInfo = false;
+    stats.Tcp = TcpInfo();
+    if (tcpInfo) {
+        auto [result, info] = connection.socket->GetTcpInfo();
+        stats.HasTcpInfo = result.IsSuccess();
+        stats.Tcp = info;
+    }
+}
+
+bool WebSocketServerLite::GetConnectionStats(ConnectionHandle connection, ConnectionStats& stats) const {
+    int64_t now = SteadyNowNs();
+    return m_connections.Find(connection, [&](const LiteConnection& registered) {
+        ReadStats(registered, connection, true, now, stats);
+        stats.ClientIP = registered.clientIP;
+    });
+}
+
+std::vector<ConnectionStats> WebSocketServerLite::GetAllConnectionStats(bool includeTcpInfo) const {
+    std::vector<ConnectionStats> all;
+    all.reserve(m_connections.Size());
+    int64_t now = SteadyNowNs();
+    m_connections.ForEach([&](ConnectionHandle handle, const LiteConnection& registered) {
+        all.emplace_back();
+        ReadStats(registered, handle, includeTcpInfo, now, all.back());
+        all.back().ClientIP = registered.clientIP;
+    });
+    return all;
+}
+
+std::vector<ConnectionStats> WebSocketServerLite::GetSlowestConnections(size_t count, CONNECTION_ORDER order) const {
+    SlowConnectionHeap heap(count, order);
+    ConnectionStats scratch;
+    bool tcpInfo = ConnectionOrderNeedsTcpInfo(order);
+    int64_t now = SteadyNowNs();
+    m_connections.ForEach([&](ConnectionHandle handle, const LiteConnection& registered) {
+        ReadStats(registered, handle, tcpInfo, now, scratch);
+        heap.Offer(scratch);
+    });
+    
+    std::vector<ConnectionStats> slowest;
+    for (ConnectionHandle handle : heap.Take()) {
+        ConnectionStats stats;
+        if (GetConnectionStats(handle, stats)) {
+            slowest.push_back(std::move(stats));
+        }
+    }
+    return slowest;
+}
+
+Result WebSocketServerLite::Ping(ConnectionHandle connection) {
+    Result result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+    // Client sockets are non-blocking, so the send cannot hold the slot lock for long
+    m_connections.Find(connection, [&result](LiteConnection& registered) {
+        if (!registered.counters.WebSocket.load(std::memory_order_relaxed)) {
+            return;
+        }
+        int64_t payload = registered.counters.BeginPing();
+        BufferHandle frame = WebSocketProtocol::GenerateFrame(
+            WEBSOCKET_OPCODE::PING, reinterpret_cast<const uint8_t*>(&payload), sizeof(payload));
+        std::lock_guard<std::mutex> lock(registered.sendMutex);
+        result = registered.socket->Send(frame);
+        if (result.IsSuccess()) {
+            registered.counters.Sent(frame.Size(), 1);
+        }
+    });
+    return result;
+}
+
+Result WebSocketServerLite::PauseRead(ConnectionHandle connection) {
+    bool found = m_connections.Find(connection, [](LiteConnection& registered) {
+        registered.counters.ReadPaused.store(true, std::memory_order_release);
+    });
+    return found ? Result() : Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+}
+
+Result WebSocketServerLite::ResumeRead(ConnectionHandle connection) {
+    bool found = m_connections.Find(connection, [](LiteConnection& registered) {
+        registered.counters.ReadPaused.store(false, std::memory_order_release);
+    });
+    return found ? Result() : Result(ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED);
+}
+
 Result WebSocketServerLite::InitializeServer() {
-    // Check if port is available
-    if (!Socket::IsPortAvailable(m_port, m_bindAddress)) {
+    bool unixDomain = Socket::IsUnixAddress(m_bindAddress);
+    
+    // Check if port is available (a Unix socket path is checked by Bind)
+    if (!unixDomain && !Socket::IsPortAvailable(m_port, m_bindAddress)) {
         return Result(ERROR_CODE::SOCKET_BIND_FAILED, "Port " + std::to_string(m_port) + " is already in use");
     }
     
@@ -155,7 +284,9 @@ Result WebSocketServerLite::InitializeServer() {
     
     // Determine socket family based on bind address
     SOCKET_FAMILY family = SOCKET_FAMILY::IPV4; // default
-    if (Socket::IsIPv6Address(m_bindAddress) || m_bindAddress == "::") {
+    if (unixDomain) {
+        family = SOCKET_FAMILY::UNIX;
+    } else if (Socket::IsIPv6Address(m_bindAddress) || m_bindAddress == "::") {
         family = SOCKET_FAMILY::IPV6;
     }
     
@@ -168,14 +299,19 @@ Result WebSocketServerLite::InitializeServer() {
     // Set socket to non-blocking mode FIRST
     auto blockingResult = m_serverSocket->Blocking(false);
     if (!blockingResult.IsSuccess()) {
-        std::cout << "⚠️ Warning: Failed to set non-blocking mode: " << blockingResult.GetErrorMessage() << std::endl;
+        WS_TRACE_WARN("lite_server", "listener_nonblocking_failed", "system error {}", blockingResult.GetSystemErrorCode());
         // Continue anyway, but this is a problem
     }
     
     // Set socket options
     auto reuseResult = m_serverSocket->ReuseAddress(true);
     if (!reuseResult.IsSuccess()) {
-        std::cout << "⚠️ Warning: Failed to set reuse address: " << reuseResult.GetErrorMessage() << std::endl;
+        WS_TRACE_WARN("lite_server", "reuse_address_failed", "system error {}", reuseResult.GetSystemErrorCode());
+    }
+    
+    auto profileResult = m_serverSocket->ApplyListenerProfile(m_socketProfile);
+    if (!profileResult.IsSuccess()) {
+        WS_TRACE_WARN("lite_server", "listener_profile_failed", "system error {}", profileResult.GetSystemErrorCode());
     }
     
     // Bind to address and port
@@ -192,59 +328,88 @@ Result WebSocketServerLite::InitializeServer() {
         return listenResult;
     }
     
-    std::cout << "✅ Server initialized in non-blocking mode" << std::endl;
     return Result();
 }
 
-void WebSocketServerLite::HandleClientConnection(std::unique_ptr<Socket> clientSocket) {
+void WebSocketServerLite::HandleClientConnection(std::unique_ptr<Socket> clientSocket, MemoryReservation memory) {
     if (!clientSocket) {
         return;
     }
     
     std::string clientIP = GetClientIP(*clientSocket);
     
-    // Set client socket to non-blocking mode
-    auto blockingResult = clientSocket->Blocking(false);
-    if (!blockingResult.IsSuccess()) {
-        std::cout << "⚠️ Warning: Failed to set client socket non-blocking: " << blockingResult.GetErrorMessage() << std::endl;
+    // Registered for statistics until this function returns, while the socket is still open
+    auto entry = std::make_unique<LiteConnection>();
+    entry->socket = clientSocket.get();
+    entry->clientIP = clientIP;
+    LiteConnection* connection = entry.get();
+    ConnectionHandle handle = m_connections.Insert(std::move(entry));
+    struct Registration {
+        ConnectionTable<LiteConnection>& Table;
+        ConnectionHandle Handle;
+        ~Registration() { Table.Remove(Handle); }
+    } registration{m_connections, handle};
+    // Returned before the connection unregisters; the server may be gone after that
+    MemoryReservation connectionMemory(std::move(memory));
+    
+    auto profileResult = clientSocket->ApplyProfile(m_socketProfile);
+    if (!profileResult.IsSuccess()) {
+        WS_TRACE_WARN("lite_server", "socket_profile_failed", "system error {}", profileResult.GetSystemErrorCode());
+    }
+    
+    // Sockets from AcceptBatch are already non-blocking
+    if (clientSocket->Blocking()) {
+        auto blockingResult = clientSocket->Blocking(false);
+        if (!blockingResult.IsSuccess()) {
+            WS_TRACE_WARN("lite_server", "client_nonblocking_failed", "system error {}", blockingResult.GetSystemErrorCode());
+        }
     }
     
-    std::cout << "🔗 Client connected from " << clientIP << " (non-blocking)" << std::endl;
+    WS_TRACE_INFO("lite_server", "client_connected", "{s}", clientIP);
     
     if (m_onConnect) {
         m_onConnect(clientIP);
     }
     
     try {
-        // Non-blocking receive loop
+        // Non-blocking receive loop; polling into a stack buffer keeps the idle spin allocation-free
         std::string accumulatedRequest;
         const size_t MAX_REQUEST_SIZE = 65536;
+        uint8_t receiveBuffer[kReceiveBufferSize];
         
         while (m_running) {
-            auto receiveResult = clientSocket->Receive(4096);
+            auto receiveResult = clientSocket->ReceiveInto(receiveBuffer, sizeof(receiveBuffer));
             
             if (receiveResult.first.IsSuccess()) {
-                if (receiveResult.second.empty()) {
+                if (receiveResult.second == 0) {
                     // Connection closed gracefully
                     break;
                 }
                 
-                accumulatedRequest.append(receiveResult.second.begin(), receiveResult.second.end());
+                connection->counters.Received(receiveResult.second);
+                if (!connectionMemory.TryGrow(receiveResult.second)) {
+                    WS_TRACE_WARN("lite_server", "memory_budget", "{s} request dropped", clientIP);
+                    break;
+                }
+                accumulatedRequest.append(reinterpret_cast<const char*>(receiveBuffer), receiveResult.second);
                 
                 // Check if we have complete headers
                 if (accumulatedRequest.find("\r\n\r\n") != std::string::npos) {
                     // Update client IP with HTTP header information (proxy detection)
                     std::string realClientIP = GetClientIP(*clientSocket, accumulatedRequest);
                     if (realClientIP != clientIP) {
-                        std::cout << "🔄 Updated client IP: " << clientIP << " -> " << realClientIP << " (proxy detected)" << std::endl;
+                        WS_TRACE_VERBOSE("lite_server", "proxy_client_ip", "{s}", realClientIP);
                         clientIP = realClientIP;
+                        m_connections.Find(handle, [&clientIP](LiteConnection& registered) {
+                            registered.clientIP = clientIP;
+                        });
                     }
                     break;
                 }
                 
                 // Check size limit
                 if (accumulatedRequest.size() > MAX_REQUEST_SIZE) {
-                    std::cout << "🚫 Request too large from " << clientIP << std::endl;
+                    WS_TRACE_WARN("lite_server", "request_too_large", "{s} sent {} bytes", clientIP, accumulatedRequest.size());
                     break;
                 }
             } else {
@@ -258,7 +423,7 @@ void WebSocketServerLite::HandleClientConnection(std::unique_ptr<Socket> clientS
                     if (systemError != EAGAIN && systemError != EWOULDBLOCK) {
 #endif
                         // Real error occurred
-                        std::cout << "❌ Receive error from " << clientIP << ": " << error.GetErrorMessage() << std::endl;
+                        WS_TRACE_WARN("lite_server", "receive_failed", "{s} system error {}", clientIP, systemError);
                         break;
                     }
                     // Would block - continue loop
@@ -266,7 +431,7 @@ void WebSocketServerLite::HandleClientConnection(std::unique_ptr<Socket> clientS
                     continue;
                 } else {
                     // Other error
-                    std::cout << "❌ Receive error from " << clientIP << ": " << error.GetErrorMessage() << std::endl;
+                    WS_TRACE_WARN("lite_server", "receive_failed", "{s} error code {}", clientIP, error.GetErrorCode());
                     break;
                 }
             }
@@ -274,27 +439,46 @@ void WebSocketServerLite::HandleClientConnection(std::unique_ptr<Socket> clientS
         
         // Validate HTTP request
         if (m_securityEnabled && !ValidateHTTPRequest(accumulatedRequest)) {
-            std::cout << "🚫 Invalid HTTP request from " << clientIP << std::endl;
+            WS_TRACE_WARN("lite_server", "invalid_request", "{s}", clientIP);
             SendHTTPResponse(*clientSocket, "400 Bad Request", "text/plain", "Bad Request");
             RemoveConnection(clientIP);
             return;
         }
         
         // Perform WebSocket handshake
-        auto handshakeResult = PerformWebSocketHandshake(*clientSocket, accumulatedRequest);
+        ExtensionChain extensions;
+        auto handshakeResult = PerformWebSocketHandshake(*clientSocket, accumulatedRequest, connection->counters, extensions);
         if (!handshakeResult.IsSuccess()) {
-            std::cout << "❌ WebSocket handshake failed: " << handshakeResult.GetErrorMessage() << std::endl;
+            WS_TRACE_WARN("lite_server", "handshake_failed", "{s} error code {}", clientIP, handshakeResult.GetErrorCode());
             SendHTTPResponse(*clientSocket, "400 Bad Request", "text/plain", "WebSocket handshake failed");
             RemoveConnection(clientIP);
             return;
         }
         
-        std::cout << "✅ WebSocket handshake successful for " << clientIP << std::endl;
+        WS_TRACE_VERBOSE("lite_server", "handshake_complete", "{s}", clientIP);
+        connection->counters.WebSocket.store(true, std::memory_order_relaxed);
         
-        // Handle WebSocket messages (non-blocking)
+        // Handle WebSocket messages (non-blocking). Frames are decoded as they
+        // arrive and fragments are joined into one message; only an
+        // incomplete header or control frame is kept for the next receive.
+        FrameStreamDecoder decoder;
+        decoder.SetAllowedRsv(extensions.RsvBits(), extensions.ContinuationRsvBits());
+        decoder.SetRequireMask(true);
+        std::string message;
+        MemoryReservation messageMemory(&m_memoryBudget);
+        size_t buffered = 0;
         while (m_running) {
-            // Simple frame receive implementation
-            auto receiveResult = clientSocket->Receive(4096);
+            if (connection->counters.ReadPaused.load(std::memory_order_acquire)) {
+                // New data stays in the kernel until ResumeRead; a close is still read
+                auto [waitResult, closed] = clientSocket->WaitClosed(1);
+                if (waitResult.IsError()) {
+                    break;
+                }
+                if (!closed) {
+                    continue;
+                }
+            }
+            auto receiveResult = clientSocket->ReceiveInto(receiveBuffer + buffered, sizeof(receiveBuffer) - buffered);
             if (!receiveResult.first.IsSuccess()) {
                 Result error = receiveResult.first;
                 if (error.GetErrorCode() == ERROR_CODE::WEBSOCKET_CONNECTION_CLOSED) {
@@ -308,7 +492,7 @@ void WebSocketServerLite::HandleClientConnection(std::unique_ptr<Socket> clientS
                     if (systemError != EAGAIN && systemError != EWOULDBLOCK) {
 #endif
                         // Real error
-                        std::cout << "❌ WebSocket receive error: " << error.GetErrorMessage() << std::endl;
+                        WS_TRACE_WARN("lite_server", "receive_failed", "{s} system error {}", clientIP, systemError);
                         break;
                     }
                     // Would block - continue
@@ -316,22 +500,101 @@ void WebSocketServerLite::HandleClientConnection(std::unique_ptr<Socket> clientS
                     continue;
                 } else {
                     // Other error
-                    std::cout << "❌ WebSocket error: " << error.GetErrorMessage() << std::endl;
+                    WS_TRACE_WARN("lite_server", "receive_failed", "{s} error code {}", clientIP, error.GetErrorCode());
+                    break;
+                }
+            }
+            
+            if (receiveResult.second == 0) {
+                break; // Peer closed the connection
+            }
+            connection->counters.Received(receiveResult.second);
+            
+            size_t length = buffered + receiveResult.second;
+            size_t offset = 0;
+            bool keepOpen = true;
+            while (keepOpen) {
+                FrameStreamDecoder::Event event;
+                size_t consumed = 0;
+                Result decodeResult = decoder.Next(receiveBuffer + offset, length - offset, consumed, event);
+                if (decodeResult.IsError()) {
+                    WS_TRACE_WARN("lite_server", "protocol_error", "{s} error code {}", clientIP, decodeResult.GetErrorCode());
+                    const uint8_t code[2] = {1002 >> 8, 1002 & 0xFF};
+                    BufferHandle close = WebSocketProtocol::GenerateFrame(WEBSOCKET_OPCODE::CLOSE, code, sizeof(code));
+                    std::lock_guard<std::mutex> lock(connection->sendMutex);
+                    if (clientSocket->Send(close).IsSuccess()) {
+                        connection->counters.Sent(close.Size(), 1);
+                    }
+                    keepOpen = false;
+                    break;
+                }
+                offset += consumed;
+                if (event.Type == STREAM_EVENT::NEED_MORE) {
+                    break;
+                }
+                if (event.Type == STREAM_EVENT::CONTROL || event.FrameEnd) {
+                    connection->counters.FramesIn.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (event.Type == STREAM_EVENT::CONTROL) {
+                    if (event.Opcode == WEBSOCKET_OPCODE::PING) {
+                        BufferHandle pong = WebSocketProtocol::GenerateFrame(WEBSOCKET_OPCODE::PONG, event.Data, event.Length);
+                        std::lock_guard<std::mutex> lock(connection->sendMutex);
+                        if (clientSocket->Send(pong).IsSuccess()) {
+                            connection->counters.Sent(pong.Size(), 1);
+                        }
+                    } else if (event.Opcode == WEBSOCKET_OPCODE::PONG) {
+                        connection->counters.CompletePing(event.Data, event.Length);
+                    } else if (event.Opcode == WEBSOCKET_OPCODE::CLOSE) {
+                        keepOpen = false;
+                    }
+                    continue;
+                }
+                if (!messageMemory.TryGrow(event.Length)) {
+                    WS_TRACE_WARN("lite_server", "memory_budget", "{s} message dropped at {} bytes", clientIP, message.size());
+                    keepOpen = false;
                     break;
                 }
+                message.append(reinterpret_cast<const char*>(event.Data), event.Length);
+                if (event.Last && event.Rsv != 0) {
+                    // Negotiated extensions transform whole messages
+                    std::vector<uint8_t> payload(message.begin(), message.end());
+                    Result extensionResult = extensions.Decode(event.Opcode, event.Rsv, payload);
+                    if (extensionResult.IsError()) {
+                        WS_TRACE_WARN("lite_server", "extension_error", "{s} error code {}", clientIP, extensionResult.GetErrorCode());
+                        keepOpen = false;
+                        break;
+                    }
+                    if (payload.size() > messageMemory.Bytes() && !messageMemory.TryGrow(payload.size() - messageMemory.Bytes())) {
+                        WS_TRACE_WARN("lite_server", "memory_budget", "{s} decoded message dropped", clientIP);
+                        keepOpen = false;
+                        break;
+                    }
+                    message.assign(payload.begin(), payload.end());
+                }
+                if (event.Last) {
+                    if (m_onMessage) {
+                        WS_TRACE_SCOPE("lite_server", "on_message");
+                        m_onMessage(message);
+                    }
+                    message.clear();
+                    messageMemory.Reset();
+                }
+            }
+            if (!keepOpen) {
+                break;
             }
             
-            if (m_onMessage && !receiveResult.second.empty()) {
-                std::string message(receiveResult.second.begin(), receiveResult.second.end());
-                m_onMessage(message);
+            buffered = length - offset;
+            if (buffered > 0) {
+                memmove(receiveBuffer, receiveBuffer + offset, buffered);
             }
         }
         
     } catch (const std::exception& e) {
-        std::cout << "❌ Exception in client handler: " << e.what() << std::endl;
+        WS_TRACE_ERROR("lite_server", "handler_exception", "{s}", e.what());
     }
     
-    std::cout << "🔌 Client disconnected: " << clientIP << std::endl;
+    WS_TRACE_INFO("lite_server", "client_disconnected", "{s}", clientIP);
     
     if (m_onDisconnect) {
         m_onDisconnect(clientIP);
@@ -386,7 +649,7 @@ bool WebSocketServerLite::ValidateHTTPRequest(const std::string& request) {
                 userAgentLower.find("nikto") != std::string::npos ||
                 userAgentLower.find("nmap") != std::string::npos ||
                 userAgentLower.find("masscan") != std::string::npos) {
-                std::cout << "🚫 Suspicious User-Agent blocked: " << userAgent << std::endl;
+                WS_TRACE_WARN("lite_server", "user_agent_blocked", "{s}", userAgent);
                 return false;
             }
         }
@@ -395,10 +658,26 @@ bool WebSocketServerLite::ValidateHTTPRequest(const std::string& request) {
     return true;
 }
 
-Result WebSocketServerLite::PerformWebSocketHandshake(Socket& clientSocket, const std::string& request) {
-    (void)clientSocket; // Suppress unused parameter warning
-    HandshakeInfo info;
-    return WebSocketProtocol::ValidateHandshakeRequest(request, info);
+Result WebSocketServerLite::PerformWebSocketHandshake(Socket& clientSocket, const std::string& request,
+                                                     ConnectionCounters& counters, ExtensionChain& extensions) {
+    HandshakeRequestView view;
+    auto validateResult = WebSocketProtocol::ParseHandshakeRequest(request, view);
+    if (!validateResult.IsSuccess()) {
+        return validateResult;
+    }
+    
+    std::string_view protocol = WebSocketProtocol::SelectSubProtocol(view.Protocols, m_subProtocols);
+    std::string accepted = extensions.Negotiate(view.Extensions, m_extensions);
+    char response[WebSocketProtocol::kHandshakeResponseSize];
+    size_t responseSize = WebSocketProtocol::WriteHandshakeResponse(view.Key, protocol, accepted, response, sizeof(response));
+    if (responseSize == 0) {
+        return Result(ERROR_CODE::WEBSOCKET_HANDSHAKE_FAILED, "Handshake response too large");
+    }
+    auto [sendResult, sent] = clientSocket.SendRaw(response, responseSize);
+    if (sendResult.IsSuccess()) {
+        counters.Sent(sent);
+    }
+    return sendResult;
 }
 
 void WebSocketServerLite::SendHTTPResponse(Socket& clientSocket, const std::string& status, const std::string& contentType, const std::string& body) {
@@ -460,7 +739,11 @@ std::string WebSocketServerLite::GetClientIP(const Socket& socket, const std::st
         }
     }
     
-    // Fallback to direct socket peer IP
+    // Fallback to direct socket peer IP; Unix socket peers have no address
+    if (socket.IsUnixDomain()) {
+        std::string path = socket.RemoteAddress();
+        return path.empty() ? "unix" : "unix:" + path;
+    }
     return socket.RemoteAddress();
 }
 
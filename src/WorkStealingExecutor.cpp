@@ -0,0 +1,293 @@
+#include "WebSocket/WorkStealingExecutor.h"
+#include "WebSocket/CpuTopology.h"
+#include <algorithm>
+
+namespace WebSocket {
+
+namespace {
+
+// Empty scans a worker makes before parking
+const int kWorkerSpinCount = 64;
+
+// Parked workers rescan this often even without a wake-up
+const auto kWorkerParkTimeout = std::chrono::milliseconds(100);
+
+// Identifies the executor and worker the current thread belongs to
+thread_local const WorkStealingExecutor* t_executor = nullptr;
+thread_local size_t t_workerIndex = 0;
+
+uint64_t NextRandom(uint64_t& state) {
+    // xorshift64
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+} // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(const ExecutorOptions& options)
+    : m_options(options),
+      m_injection(std::max<size_t>(options.MaxPendingTasks, 2)),
+      m_taskPool(64) {
+    if (m_options.Workers == 0) {
+        m_options.Workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (m_options.MaxPendingTasks == 0) {
+        m_options.MaxPendingTasks = 1;
+    }
+    m_workers.reserve(m_options.Workers);
+    for (size_t i = 0; i < m_options.Workers; i++) {
+        m_workers.push_back(std::make_unique<Worker>(m_options.DequeCapacity));
+        m_workers.back()->RandomState = 0x9E3779B97F4A7C15ull * (i + 1);
+    }
+    for (auto& bucket : m_latencyBuckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    Stop();
+}
+
+Result WorkStealingExecutor::Start() {
+    if (m_running) {
+        return Result();
+    }
+    m_running = true;
+    m_accepting = true;
+
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        Worker& worker = *m_workers[i];
+        try {
+            worker.Thread = std::thread(&WorkStealingExecutor::WorkerLoop, this, i);
+        } catch (const std::exception&) {
+            Stop();
+            return Result(ERROR_CODE::THREAD_CREATION_FAILED, "Failed to start executor worker");
+        }
+    }
+    return Result();
+}
+
+void WorkStealingExecutor::Stop() {
+    m_accepting = false;
+    m_running = false;
+    {
+        std::lock_guard<std::mutex> lock(m_parkMutex);
+        m_parkCondition.notify_all();
+    }
+    for (auto& worker : m_workers) {
+        if (worker->Thread.joinable()) {
+            worker->Thread.join();
+        }
+    }
+
+    // Submissions that raced with shutdown still run, here on the caller's thread
+    Task* task = nullptr;
+    while (m_injection.TryPop(task)) {
+        Run(task);
+    }
+    for (auto& worker : m_workers) {
+        while ((task = worker->Deque.Steal()) != nullptr) {
+            Run(task);
+        }
+    }
+}
+
+bool WorkStealingExecutor::TrySubmit(TaskFn function) {
+    if (!m_accepting.load(std::memory_order_acquire)) {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (m_pending.fetch_add(1, std::memory_order_acq_rel) >= m_options.MaxPendingTasks) {
+        m_pending.fetch_sub(1, std::memory_order_acq_rel);
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Task* task = m_taskPool.Acquire();
+    if (!task) {
+        m_pending.fetch_sub(1, std::memory_order_acq_rel);
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    task->Function = std::move(function);
+    task->Submitted = Clock::now();
+
+    // Work spawned by a task stays on its worker's deque, where it is warm
+    bool queued = IsWorkerThread() && m_workers[t_workerIndex]->Deque.Push(task);
+    if (!queued) {
+        Task* injected = task;
+        queued = m_injection.TryPush(std::move(injected));
+    }
+    if (!queued) {
+        m_taskPool.Release(task);
+        m_pending.fetch_sub(1, std::memory_order_acq_rel);
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_submitted.fetch_add(1, std::memory_order_relaxed);
+
+    // Pairs with the fence in WorkerLoop: either a parking worker sees the
+    // task or we see the sleeper and wake it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(m_parkMutex);
+        m_parkCondition.notify_one();
+    }
+    return true;
+}
+
+bool WorkStealingExecutor::IsWorkerThread() const {
+    return t_executor == this;
+}
+
+ExecutorStats WorkStealingExecutor::Stats() const {
+    ExecutorStats stats;
+    stats.Submitted = m_submitted.load(std::memory_order_relaxed);
+    stats.Completed = m_completed.load(std::memory_order_relaxed);
+    stats.Rejected = m_rejected.load(std::memory_order_relaxed);
+    stats.Stolen = m_stolen.load(std::memory_order_relaxed);
+    stats.Pending = m_pending.load(std::memory_order_relaxed);
+    stats.AffinityFailures = m_affinityFailures.load(std::memory_order_relaxed);
+
+    uint64_t counts[kLatencyBuckets];
+    uint64_t total = 0;
+    for (size_t i = 0; i < kLatencyBuckets; i++) {
+        counts[i] = m_latencyBuckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return stats;
+    }
+
+    stats.QueueLatencyMeanUs = m_latencyTotalNs.load(std::memory_order_relaxed) / 1000.0 / total;
+    stats.QueueLatencyMaxUs = m_latencyMaxNs.load(std::memory_order_relaxed) / 1000.0;
+
+    // Bucket b holds latencies below 2^b ns
+    auto percentile = [&](double fraction) {
+        uint64_t target = static_cast<uint64_t>(fraction * total);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kLatencyBuckets; i++) {
+            seen += counts[i];
+            if (seen > target) {
+                return std::min(static_cast<double>(uint64_t(1) << i) / 1000.0, stats.QueueLatencyMaxUs);
+            }
+        }
+        return stats.QueueLatencyMaxUs;
+    };
+    stats.QueueLatencyP50Us = percentile(0.50);
+    stats.QueueLatencyP99Us = percentile(0.99);
+    return stats;
+}
+
+void WorkStealingExecutor::WorkerLoop(size_t index) {
+    t_executor = this;
+    t_workerIndex = index;
+    Worker& worker = *m_workers[index];
+    int idleScans = 0;
+
+    // Pinned from the worker itself so its buffer cache follows it to the CPU's node
+    if (!m_options.CpuAffinity.empty() &&
+        !PinCurrentThread(m_options.CpuAffinity[index % m_options.CpuAffinity.size()])) {
+        m_affinityFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    for (;;) {
+        if (Task* task = FindTask(worker)) {
+            Run(task);
+            idleScans = 0;
+            continue;
+        }
+        // Nothing visible anywhere: the deques have been drained
+        if (!m_running.load(std::memory_order_acquire)) {
+            break;
+        }
+        if (++idleScans < kWorkerSpinCount) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_parkMutex);
+        m_sleepers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_running.load(std::memory_order_acquire) && !HasVisibleWork()) {
+            m_parkCondition.wait_for(lock, kWorkerParkTimeout);
+        }
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        idleScans = 0;
+    }
+
+    t_executor = nullptr;
+}
+
+WorkStealingExecutor::Task* WorkStealingExecutor::FindTask(Worker& worker) {
+    if (Task* task = worker.Deque.Pop()) {
+        return task;
+    }
+
+    Task* injected = nullptr;
+    if (m_injection.TryPop(injected)) {
+        return injected;
+    }
+
+    // Start at a random victim so thieves spread out instead of piling onto one deque
+    const size_t count = m_workers.size();
+    if (count > 1) {
+        size_t start = static_cast<size_t>(NextRandom(worker.RandomState) % count);
+        for (size_t i = 0; i < count; i++) {
+            Worker& victim = *m_workers[(start + i) % count];
+            if (&victim == &worker) {
+                continue;
+            }
+            if (Task* task = victim.Deque.Steal()) {
+                m_stolen.fetch_add(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void WorkStealingExecutor::Run(Task* task) {
+    auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - task->Submitted).count();
+    RecordLatency(waited > 0 ? static_cast<uint64_t>(waited) : 0);
+
+    try {
+        task->Function();
+    } catch (const std::exception&) {
+        // The task owns its error reporting; the executor keeps running
+    }
+
+    m_taskPool.Release(task);
+    m_completed.fetch_add(1, std::memory_order_relaxed);
+    m_pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void WorkStealingExecutor::RecordLatency(uint64_t nanoseconds) {
+    size_t bucket = 0;
+    while (bucket + 1 < kLatencyBuckets && (uint64_t(1) << bucket) <= nanoseconds) {
+        bucket++;
+    }
+    m_latencyBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_latencyTotalNs.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    uint64_t previous = m_latencyMaxNs.load(std::memory_order_relaxed);
+    while (nanoseconds > previous &&
+           !m_latencyMaxNs.compare_exchange_weak(previous, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+bool WorkStealingExecutor::HasVisibleWork() const {
+    if (m_injection.SizeApprox() > 0) {
+        return true;
+    }
+    for (const auto& worker : m_workers) {
+        if (worker->Deque.SizeApprox() > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace WebSocket